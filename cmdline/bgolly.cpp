@@ -4,6 +4,7 @@
 #include "qlifealgo.h"
 #include "hlifealgo.h"
 #include "generationsalgo.h"
+#include "qgenalgo.h"
 #include "ltlalgo.h"
 #include "jvnalgo.h"
 #include "superalgo.h"
@@ -13,6 +14,7 @@
 #include "viewport.h"
 #include "liferender.h"
 #include "writepattern.h"
+#include "oscar.h"
 #include <stdlib.h>
 #include <iostream>
 #include <cstdio>
@@ -135,6 +137,9 @@ char *renderscale = (char *)"1" ;
 char *testscript = 0 ;
 int outputgzip, outputismc ;
 int numberoffset ; // where to insert file name numbers
+int oscargens ;
+int hashload = -1, hashgc = -1, hashadapt ;
+int hugepages ;
 options options[] = {
   { "-m", "--generation", "How far to run", 'I', &maxgen },
   { "-i", "--stepsize", "Step size", 'I', &inc },
@@ -161,6 +166,16 @@ options options[] = {
 //                                                        'i', &stepfactor },
   { "",   "--autofit", "Autofit before each render", 'b', &autofit },
   { "",   "--exec", "Run testing script", 's', &testscript },
+  { "",   "--oscar", "Detect period, running at most this many gens", 'i',
+                                                               &oscargens },
+  { "",   "--hashload", "Max hash load factor, in percent (default 70)", 'i',
+                                                               &hashload },
+  { "",   "--hashgc", "Garbage collect before hash resize (0 or 1)", 'i',
+                                                               &hashgc },
+  { "",   "--hashadapt", "Raise hash load factor when memory is short", 'b',
+                                                               &hashadapt },
+  { "",   "--hugepages", "HashLife memory: 1 huge pages, 2 also NUMA interleave",
+                                                          'i', &hugepages },
   { 0, 0, 0, 0, 0 }
 } ;
 
@@ -489,6 +504,15 @@ struct edgescmd : public cmdbase {
       cout << " " << b.tostring() << endl ;
    }
 } edges_inst ;
+struct oscarcmd : public cmdbase {
+   oscarcmd() : cmdbase("oscar", "i") {}
+   virtual void doit() {
+      oscar detector ;
+      detector.run(*imp, iargs[0]) ;
+      cout << imp->getGeneration().tostring() << ": " ;
+      cout << detector.describe() << endl ;
+   }
+} oscar_inst ;
 
 void runtestscript(const char *testscript) {
    FILE *cmdfile = 0 ;
@@ -522,6 +546,7 @@ int main(int argc, char *argv[]) {
    qlifealgo::doInitializeAlgoInfo(staticAlgoInfo::tick()) ;
    hlifealgo::doInitializeAlgoInfo(staticAlgoInfo::tick()) ;
    generationsalgo::doInitializeAlgoInfo(staticAlgoInfo::tick()) ;
+   qgenalgo::doInitializeAlgoInfo(staticAlgoInfo::tick()) ;
    ltlalgo::doInitializeAlgoInfo(staticAlgoInfo::tick()) ;
    jvnalgo::doInitializeAlgoInfo(staticAlgoInfo::tick()) ;
    superalgo::doInitializeAlgoInfo(staticAlgoInfo::tick()) ;
@@ -590,6 +615,7 @@ case 's':
    }
    if (timeline && hyperxxx)
       lifefatal("Cannot use both timeline and exponentially increasing steps") ;
+   setbigallocmode(hugepages) ;
    imp = createUniverse() ;
    if (progress)
       lifeerrors::seterrorhandler(&progerrors_instance) ;
@@ -598,6 +624,12 @@ case 's':
    if (verbose) {
       hlifealgo::setVerbose(1) ;
    }
+   if (hashload >= 0)
+      lifealgo::setMaxLoadFactor(hashload / 100.0) ;
+   if (hashgc >= 0)
+      lifealgo::setGCBeforeResize(hashgc) ;
+   if (hashadapt)
+      lifealgo::setAdaptiveLoad(1) ;
    imp->setMaxMemory(maxmem) ;
    timestamp() ;
    if (testscript) {
@@ -622,6 +654,13 @@ case 's':
       hyperxxx = 0 ;
       inc = 1 ;     // only step by 1
    }
+   if (oscargens > 0) {
+      oscar detector ;
+      detector.run(*imp, oscargens) ;
+      cout << imp->getGeneration().tostring() << ": " ;
+      cout << detector.describe() << endl ;
+      exit(0) ;
+   }
    if (inc != 0)
       imp->setIncrement(inc) ;
    if (timeline) {
@@ -674,8 +713,6 @@ case 's':
       if (timeline) imp->extendtimeline() ;
       if (maxgen < 0 && outfilename != 0)
          writepat(fc++) ;
-      if (timeline && imp->getframecount() + 2 > MAX_FRAME_COUNT)
-         imp->pruneframes() ;
       if (hyperxxx)
          imp->setIncrement(imp->getGeneration()) ;
    }
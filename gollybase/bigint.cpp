@@ -13,27 +13,81 @@ using namespace std ;
 /**
  *   Static data.
  */
-static const int MAX_SIMPLE = 0x3fffffff ;
-static const int MIN_SIMPLE = -0x40000000 ;
+static const G_INT64 MAX_SIMPLE = G_MAKEINT64(0x3fffffffffffffff) ;
+static const G_INT64 MIN_SIMPLE = -MAX_SIMPLE - 1 ;
 char *bigint::printbuf ;
 int *bigint::work ;
 int bigint::printbuflen ;
 int bigint::workarrlen ;
 char bigint::sepchar = ',' ;
 int bigint::sepcount = 3 ;
+/**
+ *   The arrays are kept on free lists by size, so the hot paths that
+ *   copy, grow and shrink big values (population counts, generation
+ *   counts, viewport coordinates) don't go to the heap every time.
+ *   Arrays are always a power of two in size, at least 4, so there's
+ *   a list for each of 4, 8, ... up to 4<<(POOLCLASSES-1) ints; bigger
+ *   arrays are rare enough to go straight to the heap.  We keep at
+ *   most POOLMAX arrays of each size.  A free array's first ints hold
+ *   the pointer to the next one.
+ *
+ *   An array can be bigger than its used size implies (shifting right
+ *   shrinks a value in place), so an array may be freed onto a list
+ *   for smaller arrays; that's harmless.
+ */
+static const int POOLCLASSES = 6 ;
+static const int POOLMAX = 1024 ;
+static int *poolhead[POOLCLASSES] ;
+static int poolcount[POOLCLASSES] ;
+// which list an array with this many used elements (plus the count)
+// can go on; it is at least that big
+static inline int arrclass(int used) {
+   int c = 0 ;
+   while ((4 << c) <= used)
+      c++ ;
+   return c ;
+}
+static int *newarr(int sz) {
+   int c = 0 ;
+   while ((4 << c) < sz)
+      c++ ;
+   if (c < POOLCLASSES && poolhead[c]) {
+      int *r = poolhead[c] ;
+      poolhead[c] = *(int **)r ;
+      poolcount[c]-- ;
+      return r ;
+   }
+   return new int[sz] ;
+}
+static void freearr(int *p) {
+   if (p == 0)       // bigint memory "initialized" with zero; see operator=
+      return ;
+   int c = arrclass(p[0]) ;
+   if (c < POOLCLASSES && poolcount[c] < POOLMAX) {
+      *(int **)p = poolhead[c] ;
+      poolhead[c] = p ;
+      poolcount[c]++ ;
+   } else
+      delete [] p ;
+}
+/**
+ *   Fill in a (non-canonical) array of size 3 with a value that fits
+ *   in 63 bits.
+ */
+static void tosmallarr(G_INT64 i, int *w) {
+   w[0] = 3 ;
+   w[1] = (int)(i & 0x7fffffff) ;
+   w[2] = (int)((i >> 31) & 0x7fffffff) ;
+   w[3] = (i < 0 ? -1 : 0) ;
+}
 /**
  *   Routines.
  */
-bigint::bigint(G_INT64 i) {
-   if (i <= INT_MAX && i >= INT_MIN)
-      fromint((int)i) ;
+void bigint::fromint64(G_INT64 i) {
+   if (i <= MAX_SIMPLE && i >= MIN_SIMPLE)
+      v.i = (G_INT64)(((unsigned G_INT64)i << 1) | 1) ;
    else {
-      v.i = 0 ;
-      vectorize(0) ;
-      v.p[0] = 3 ;
-      v.p[1] = (int)(i & 0x7fffffff) ;
-      v.p[2] = (int)((i >> 31) & 0x7fffffff) ;
-      v.p[3] = 0 ;
+      vectorize(i & MAX_SIMPLE) ;
       ripple((int)(i >> 62), 3) ;
    }
 }
@@ -44,15 +98,15 @@ bigint::bigint(G_INT64 i) {
 bigint::bigint(const char *s) {
    if (*s == '2' && s[1] == '^') {
       long x = atol(s+2) ;
-      if (x < 31)
-         fromint(1 << x) ;
+      if (x < 62)
+         fromint64(G_MAKEINT64(1) << x) ;
       else {
          int sz = 2 + int((x + 1) / 31) ;
          int asz = sz ;
          while (asz & (asz - 1))
             asz &= asz - 1 ;
          asz *= 2 ;
-         v.p = new int[asz] ;
+         setarr(newarr(asz)) ;
          v.p[0] = sz ;
          for (int i=1; i<=sz; i++)
             v.p[i] = 0 ;
@@ -83,7 +137,7 @@ static int *copyarr(int *p) {
    while (sz & (sz - 1))
       sz &= sz - 1 ;
    sz *= 2 ;
-   int *r = new int[sz] ;
+   int *r = newarr(sz) ;
    memcpy(r, p, sizeof(int) * (p[0] + 1)) ;
 #ifdef SLOWCHECK
    for (int i=p[0]+1; i<sz; i++)
@@ -95,7 +149,7 @@ bigint::bigint(const bigint &a) {
    if (a.v.i & 1)
       v.i = a.v.i ;
    else
-      v.p = copyarr(a.v.p) ;
+      setarr(copyarr(a.v.p)) ;
 }
 /**
  *   We special-case the p=0 case so we can "initialize" bigint memory
@@ -103,22 +157,29 @@ bigint::bigint(const bigint &a) {
  */
 bigint &bigint::operator=(const bigint &b) {
    if (&b != this) {
+      // reuse our array if it's big enough
+      if (0 == (v.i & 1) && v.p && 0 == (b.v.i & 1) &&
+          arrclass(v.p[0]) >= arrclass(b.v.p[0])) {
+         memcpy(v.p, b.v.p, sizeof(int) * (b.v.p[0] + 1)) ;
+         return *this ;
+      }
       if (0 == (v.i & 1))
          if (v.p)
-            delete [] v.p ;
+            freearr(v.p) ;
       if (b.v.i & 1)
          v.i = b.v.i ;
       else
-         v.p = copyarr(b.v.p) ;
+         setarr(copyarr(b.v.p)) ;
    }
    return *this ;
 }
 bigint::~bigint() {
    if (0 == (v.i & 1))
-      delete [] v.p ;
+      freearr(v.p) ;
 }
 bigint::bigint(const bigint &a, const bigint &b, const bigint &c, const bigint &d) {
-   const int checkmask = 0xf0000001 ;
+   // all four direct and 0..2^59-1, so the sum can't overflow
+   const G_INT64 checkmask = (G_INT64)G_MAKEINT64(0xf000000000000001) ;
    if ((a.v.i & checkmask) == 1 && (b.v.i & checkmask) == 1 &&
        (c.v.i & checkmask) == 1 && (d.v.i & checkmask) == 1) {
       // hot path
@@ -132,25 +193,26 @@ bigint::bigint(const bigint &a, const bigint &b, const bigint &c, const bigint &
    *this += d ;
 }
 const char *bigint::tostring(char sep) const {
-   int lenreq = 32 ;
-   if ((v.i & 1) == 0)
-      lenreq = size() * 32 ;
+   int sz = 3 ;
+   if (0 == (v.i & 1))
+      sz = size() ;
+   int lenreq = sz * 32 ;
    if (lenreq > printbuflen) {
      if (printbuf)
          delete [] printbuf ;
       printbuf = new char[2 * lenreq] ;
       printbuflen = 2 * lenreq ;
    }
-   int sz = 1 ;
-   if (0 == (v.i & 1))
-      sz = size() ;
    ensurework(sz) ;
    int neg = sign() < 0 ;
    if (v.i & 1) {
+      // at most 2^62, so this can't overflow
+      G_INT64 a = v.i >> 1 ;
       if (neg)
-         work[0] = -(v.i >> 1) ;
-      else
-         work[0] = v.i >> 1 ;
+         a = -a ;
+      work[0] = (int)(a & 0x7fffffff) ;
+      work[1] = (int)((a >> 31) & 0x7fffffff) ;
+      work[2] = (int)(a >> 62) ;
    } else {
       if (neg) {
          int carry = 1 ;
@@ -202,14 +264,14 @@ void bigint::grow(int osz, int nsz) {
    if (bdiffs > osz) {
       while (bdiffs & (bdiffs - 1))
          bdiffs &= bdiffs - 1 ;
-      int *nv = new int[2*bdiffs] ;
+      int *nv = newarr(2*bdiffs) ;
       for (int i=0; i<=osz; i++)
          nv[i] = v.p[i] ;
 #ifdef SLOWCHECK
       for (int i=osz+1; i<2*bdiffs; i++)
          nv[i] = 0xdeadbeef ;
 #endif
-      delete [] v.p ;
+      freearr(v.p) ;
       v.p = nv ;
    }
    int av = v.p[osz] ;
@@ -221,27 +283,40 @@ void bigint::grow(int osz, int nsz) {
    v.p[0] = nsz ;
 }
 bigint& bigint::operator+=(const bigint &a) {
-   if (a.v.i & 1)
-      add_smallint(a.v.i >> 1) ;
-   else {
+   if (a.v.i & 1) {
+      if (v.i & 1) {
+         // both are under 2^62 in magnitude so this can't overflow
+         fromint64((v.i >> 1) + (a.v.i >> 1)) ;
+      } else {
+         int w[4] ;
+         tosmallarr(a.v.i >> 1, w) ;
+         ripple(w, 0) ;
+      }
+   } else {
       if (v.i & 1)
          vectorize(v.i >> 1) ;
-      ripple(a, 0) ;
+      ripple(a.v.p, 0) ;
    }
    return *this ;
 }
 bigint& bigint::operator-=(const bigint &a) {
-   if (a.v.i & 1)
-      add_smallint(-(a.v.i >> 1)) ;
-   else {
+   if (a.v.i & 1) {
+      if (v.i & 1) {
+         fromint64((v.i >> 1) - (a.v.i >> 1)) ;
+      } else {
+         int w[4] ;
+         tosmallarr(a.v.i >> 1, w) ;
+         ripplesub(w, 1) ;
+      }
+   } else {
       if (v.i & 1)
          vectorize(v.i >> 1) ;
-      ripplesub(a, 1) ;
+      ripplesub(a.v.p, 1) ;
    }
    return *this ;
 }
 int bigint::sign() const {
-   int si = v.i ;
+   G_INT64 si = v.i ;
    if (0 == (si & 1))
       si = v.p[size()] ;
    if (si > 0)
@@ -255,7 +330,7 @@ int bigint::size() const {
 }
 void bigint::add_smallint(int a) {
    if (v.i & 1)
-      fromint((v.i >> 1) + a) ;
+      fromint64((v.i >> 1) + a) ;
    else
       ripple(a, 1) ;
 }
@@ -266,14 +341,13 @@ void bigint::shrink(int pos) {
       v.p[pos] = v.p[pos+1] ;
       v.p[0] = pos ;
    }
-   if (pos == 1) {
-      int c = v.p[1] ;
-      delete [] v.p ;
-      v.i = 1 | (c << 1) ;
-   } else if (pos == 2 && ((v.p[2] ^ v.p[1]) & 0x40000000) == 0) {
-      int c = v.p[1] + (v.p[2] << 31) ;
-      delete [] v.p ;
-      v.i = 1 | (c << 1) ;
+   if (pos <= 3) {
+      // a sign word and at most two 31-bit words always fit directly
+      G_INT64 c = v.p[pos] ;
+      for (int i=pos-1; i>0; i--)
+         c = c * G_MAKEINT64(0x80000000) + v.p[i] ;
+      freearr(v.p) ;
+      fromint64(c) ;
    }
 }
 void grow(int osz, int nsz) ;
@@ -300,8 +374,8 @@ void bigint::ripple(int carry, int pos) {
       v.p[pos+1] = -((c >> 31) & 1) ;
    }
 }
-void bigint::ripple(const bigint &a, int carry) {
-   int asz = a.size() ;
+void bigint::ripple(const int *a, int carry) {
+   int asz = a[0] ;
    int tsz = size() ;
    int pos = 1 ;
    if (tsz < asz) { // gotta resize
@@ -309,14 +383,14 @@ void bigint::ripple(const bigint &a, int carry) {
       tsz = asz ;
    }
    while (pos < asz) {
-      int c = v.p[pos] + a.v.p[pos] + carry ;
+      int c = v.p[pos] + a[pos] + carry ;
       carry = (c >> 31) & 1 ;
       v.p[pos++] = c & 0x7fffffff;
    }
-   ripple(carry + a.v.p[pos], pos) ;
+   ripple(carry + a[pos], pos) ;
 }
-void bigint::ripplesub(const bigint &a, int carry) {
-   int asz = a.size() ;
+void bigint::ripplesub(const int *a, int carry) {
+   int asz = a[0] ;
    int tsz = size() ;
    int pos = 1 ;
    if (tsz < asz) { // gotta resize
@@ -324,30 +398,16 @@ void bigint::ripplesub(const bigint &a, int carry) {
       tsz = asz ;
    }
    while (pos < asz) {
-      int c = v.p[pos] + (0x7fffffff ^ a.v.p[pos]) + carry ;
+      int c = v.p[pos] + (0x7fffffff ^ a[pos]) + carry ;
       carry = (c >> 31) & 1 ;
       v.p[pos++] = c & 0x7fffffff;
    }
-   ripple(carry + ~a.v.p[pos], pos) ;
+   ripple(carry + ~a[pos], pos) ;
 }
 // make sure it's in vector form; may leave it not canonical!
-void bigint::vectorize(int i) {
-   v.p = new int[4] ;
-   v.p[0] = 2 ;
-   v.p[1] = i & 0x7fffffff ;
-   if (i < 0)
-      v.p[2] = -1 ;
-   else
-      v.p[2] = 0 ;
-#ifdef SLOWCHECK
-   v.p[3] = 0xdeadbeef ;
-#endif
-}
-void bigint::fromint(int i) {
-   if (i <= MAX_SIMPLE && i >= MIN_SIMPLE)
-      v.i = (i << 1) | 1 ;
-   else
-      vectorize(i) ;
+void bigint::vectorize(G_INT64 i) {
+   setarr(newarr(4)) ;
+   tosmallarr(i, v.p) ;
 }
 void bigint::ensurework(int sz) const {
    sz += 3 ;
@@ -365,12 +425,14 @@ void bigint::mul_smallint(int a) {
       return ;
    }
    if (v.i & 1) {
-      if ((v.i >> 1) <= MAX_SIMPLE / a) {
-         c = (v.i >> 1) * a ;
-         fromint((v.i >> 1) * a) ;
+      // if |value| <= MAX_SIMPLE/|a| the product fits directly
+      G_INT64 lim = MAX_SIMPLE / (a < 0 ? -a : a) ;
+      G_INT64 i = v.i >> 1 ;
+      if (i <= lim && i >= -lim) {
+         fromint64(i * a) ;
          return ;
       }
-      vectorize(v.i >> 1) ;
+      vectorize(i) ;
    }
    int sz = size() ;
    int carry = 0 ;
@@ -396,8 +458,7 @@ void bigint::mul_smallint(int a) {
 }
 void bigint::div_smallint(int a) {
    if (v.i & 1) {
-      int r = (v.i >> 1) / a ;
-      fromint(r) ;
+      fromint64((v.i >> 1) / a) ;
       return ;
    }
    if (v.p[v.p[0]] < 0)
@@ -414,15 +475,16 @@ void bigint::div_smallint(int a) {
 }
 int bigint::mod_smallint(int a) {
    if (v.i & 1)
-      return (((v.i >> 1) % a) + a) % a ;
+      return (int)((((v.i >> 1) % a) + a) % a) ;
    int pos = v.p[0] ;
-   int mm = (2 * ((1 << 30) % a) % a) ;
-   int r = 0 ;
+   // mm * r + v.p[pos] doesn't fit in an int
+   G_INT64 mm = (2 * ((1 << 30) % a) % a) ;
+   G_INT64 r = 0 ;
    while (pos > 0) {
       r = (mm * r + v.p[pos]) % a ;
       pos-- ;
    }
-   return (r + a) % a ;
+   return (int)((r + a) % a) ;
 }
 void bigint::div2() {
    if (v.i & 1) {
@@ -440,8 +502,8 @@ void bigint::div2() {
 }
 bigint& bigint::operator>>=(int i) {
    if (v.i & 1) {
-      if (i > 31)
-         v.i = ((v.i >> 31) | 1) ;
+      if (i > 63)
+         v.i = ((v.i >> 63) | 1) ;
       else
          v.i = ((v.i >> i) | 1) ;
       return *this ;
@@ -473,8 +535,8 @@ bigint& bigint::operator<<=(int i) {
    if (v.i & 1) {
       if (v.i == 1)
          return *this ;
-      if (i < 30 && (v.i >> 31) == (v.i >> (31 - i))) {
-         v.i = ((v.i & ~1) << i) | 1 ;
+      if (i < 62 && (v.i >> 63) == (v.i >> (63 - i))) {
+         v.i = (G_INT64)(((unsigned G_INT64)(v.i & ~1) << i) | 1) ;
          return *this ;
       }
       vectorize(v.i >> 1) ;
@@ -509,19 +571,19 @@ void bigint::mulpow2(int p) {
 }
 int bigint::even() const {
    if (v.i & 1)
-      return 1-((v.i >> 1) & 1) ;
+      return 1-(int)((v.i >> 1) & 1) ;
    else
       return 1-(v.p[1] & 1) ;
 }
 int bigint::odd() const {
    if (v.i & 1)
-      return ((v.i >> 1) & 1) ;
+      return (int)((v.i >> 1) & 1) ;
    else
       return (v.p[1] & 1) ;
 }
 int bigint::low31() const {
    if (v.i & 1)
-      return ((v.i >> 1) & 0x7fffffff) ;
+      return (int)((v.i >> 1) & 0x7fffffff) ;
    else
       return v.p[1] ;
 }
@@ -687,17 +749,30 @@ double bigint::toscinot() const
  *   Return an int.
  */
 int bigint::toint() const {
+   // outside the int range, like the arrays, give the low 31 bits
+   // and the sign
    if (v.i & 1)
-      return (v.i >> 1) ;
+      return (int)((v.i >> 1) & 0x7fffffff) | (v.i < 0 ? INT_MIN : 0) ;
    return (v.p[v.p[0]] << 31) | v.p[1] ;
 }
+/**
+ *   Return a 64-bit int, if it fits in 63 bits; that's exactly the
+ *   values we hold directly.
+ */
+int bigint::toint64(G_INT64 &r) const {
+   if (v.i & 1) {
+      r = v.i >> 1 ;
+      return 1 ;
+   }
+   return 0 ;
+}
 /**
  *   How many bits required to represent this, approximately?
  *   Should overestimate but not by too much.
  */
 int bigint::bitsreq() const {
    if (v.i & 1)
-      return 31 ;
+      return ((v.i >> 31) == (v.i >> 63)) ? 31 : 63 ;
    return v.p[0] * 31 ;
 }
 /**
@@ -708,7 +783,7 @@ int bigint::lowbitset() const {
    if (v.i & 1) {
       if (v.i == 1)
          return -1 ;
-      for (int i=1; i<32; i++)
+      for (int i=1; i<64; i++)
          if ((v.i >> i) & 1)
             return i-1 ;
    }
@@ -731,10 +806,10 @@ void bigint::tochararr(char *fillme, int n) const {
    while (n > 0) {
       int w = 0 ;
       if (v.i & 1) {
-         if (at == 0)
-            w = v.i >> 1 ;
+         if (at < 3)
+            w = (int)(v.i >> (31 * at + 1)) ;
          else
-            w = v.i >> 31 ;
+            w = (int)(v.i >> 63) ;
       } else {
          if (at < v.p[0])
             w = v.p[at+1] ;
@@ -3,13 +3,12 @@
 
 /**
  *   Class bigint manages signed bigints using a very Lisp-ish approach.
- *   Integers from -0x40000000 through 0x3fffffff are represented
- *   by a direct instance of this four-byte class, with the lowest
- *   bit set.  Integers outside that range use a pointer to an
- *   integer array; the first element is how many elements of
- *   that array are used.  The array itself is always a power of
- *   two in size, the smallest power of two greater than
- *   the number of used elements.
+ *   Integers from -2^62 through 2^62-1 are represented by a direct
+ *   instance of this eight-byte class, with the lowest bit set.
+ *   Integers outside that range use a pointer to an integer array;
+ *   the first element is how many elements of that array are used.
+ *   The array itself is always a power of two in size, the smallest
+ *   power of two greater than the number of used elements.
  *
  *   The value of the bigint, when represented as a vector, is
  *   always sum 1<=i<=v.p[0] 2^(31*(i-1))*v.p[i]
@@ -20,7 +19,10 @@
  *   class, with +=, -=, and the like operators that will not
  *   allocate/free unnecessarily.
  *
- *   We'll add mempool support soon.
+ *   Population counts, generation counts and coordinates almost
+ *   always fit in 62 bits, so they never touch an array at all; the
+ *   arrays come from per-size free lists (see bigint.cpp), so even
+ *   the bigger values are mostly cheap.
  *
  *   If we are using an int array, each holds 31 bits of the number.
  *   All elements except the last are in the range 0..2^31-1; the
@@ -41,13 +43,13 @@
  *   the comparisons can be done simply; specifically, we always
  *   have a single canonical representation of each number.
  *
- *   We never use an array size smaller than 4.
+ *   We never use an array size smaller than 4.  Internally a value
+ *   may briefly be an array of size 2 or 3 (see vectorize), but
+ *   shrink always turns those back into direct values.
  *
  *   Nonnegative numbers are represented as follows:
  *
- *   0..2^30-1     Directly, shifted left one with the low bit set
- *   2^30..2^31-1  siz=2, low 31 bits then 0; array size is 4
- *   2^31..2^62-1  size=3, two 31-bit words then 0; array size is 4
+ *   0..2^62-1     Directly, shifted left one with the low bit set
  *   2^62..2^93-1  size=4, three 31-bit words then 0; array size is 8
  *   ...
  *   2^155..2^186-1  size=7, six 31-bit words than 0; array size is 8
@@ -55,9 +57,7 @@
  *
  *   Negative numbers are analogous:
  *
- *   -1..-2^30     Directly, shifted left one with the low bit set
- *   -2^30-1..-2^31  siz=2, low 31 bits then -1; array size is 4
- *   -2^31-1..-2^62  size=3, two 31-bit words then -1; array size is 4
+ *   -1..-2^62     Directly, shifted left one with the low bit set
  *   -2^62-1..-2^93  size=4, three 31-bit words then -1; array size is 8
  *   ...
  *   -2^155-1..-2^186  size=7, six 31-bit words than -1; array size is 8
@@ -90,9 +90,9 @@
 class bigint {
 public:
    bigint() { v.i = 1 ; }
-   bigint(short i) { v.i = ((int)i << 1) + 1 ; }
+   bigint(short i) { v.i = ((G_INT64)i << 1) + 1 ; }
    bigint(int i) { fromint(i) ; }
-   bigint(G_INT64 i) ;
+   bigint(G_INT64 i) { fromint64(i) ; }
    bigint(const char *s) ;
    bigint(const bigint &a) ;
    // create a new bigint by adding four other bigints; fastpath for popcount
@@ -125,11 +125,13 @@ public:
    // note: a should be a small positive int, say 1..10,000
    void div2() ;
    // note:  a may only be a *31* bit int, not just 0 or 1
-   // note:  may only be called on arrayed bigints
    void add_smallint(int a) ;
    double todouble() const ;
    double toscinot() const ;
    int toint() const ;
+   // if -2^62 <= value < 2^62, set r to it and return 1; else return 0
+   // (so the difference of two such values can't overflow)
+   int toint64(G_INT64 &r) const ;
    // static values predefined
    static const bigint zero, one, two, three, minint, maxint ;
    // editing limits
@@ -147,14 +149,19 @@ private:
    // note:  carry may be any legal 31-bit int
    // note:  may only be called on arrayed bigints
    void ripple(int carry, int pos) ;
-   void ripple(const bigint &a, int carry) ;
-   void ripplesub(const bigint &a, int carry) ;
+   // add or subtract the value in array a (which needn't be canonical)
+   void ripple(const int *a, int carry) ;
+   void ripplesub(const int *a, int carry) ;
    // make sure it's in vector form; may leave it not canonical!
-   void vectorize(int i) ;
-   void fromint(int i) ;
+   void vectorize(G_INT64 i) ;
+   void fromint(int i) { v.i = ((G_INT64)i << 1) | 1 ; }
+   void fromint64(G_INT64 i) ;
+   // switch to the given array; on 32-bit systems the pointer only
+   // fills half of v, so the rest must be cleared to keep the low bit 0
+   void setarr(int *p) { v.i = 0 ; v.p = p ; }
    void ensurework(int sz) const ;
    union {
-      int i ;
+      G_INT64 i ;
       int *p ;
    } v ;
    static char *printbuf ;
@@ -28,7 +28,7 @@ state generationsalgo::slowcalc(state nw, state n, state ne, state w, state c,
    state result = 0 ;
 
    // get the lookup table
-   char *lookup = rule3x3 ;
+   char *lookup = genrules.rule3x3 ;
 
    // create array index
    int index = ((nw == 1) ? 256 : 0) | ((n == 1) ? 128 : 0) | ((ne == 1) ? 64 : 0)
@@ -73,7 +73,7 @@ void generationsalgo::doInitializeAlgoInfo(staticAlgoInfo &ai) {
    }
 }
 
-generationsalgo::generationsalgo() {
+generationsrules::generationsrules() {
    int i ;
 
    // base64 encoding characters
@@ -141,7 +141,7 @@ generationsalgo::generationsalgo() {
    initRule() ;
 }
 
-generationsalgo::~generationsalgo() {
+generationsrules::~generationsrules() {
 }
 
 // returns a count of the number of bits set in given int
@@ -155,7 +155,7 @@ static int bitcount(int v) {
 }
 
 // initialize
-void generationsalgo::initRule() {
+void generationsrules::initRule() {
    // default to Moore neighbourhood totalistic rule
    neighbormask = MOORE ; 
    neighbors = 8 ;
@@ -163,7 +163,7 @@ void generationsalgo::initRule() {
    using_map = false ;
 
    // we may need this to be >2 here so it's recognized as multistate
-   maxCellStates = 3 ;
+   numstates = 3 ;
 
    // one bit for each neighbor count
    // s = survival, b = birth
@@ -182,7 +182,7 @@ void generationsalgo::initRule() {
 }
 
 // set 3x3 grid based on totalistic value
-void generationsalgo::setTotalistic(int value, bool survival) {
+void generationsrules::setTotalistic(int value, bool survival) {
    int mask = 0 ;
    int nbrs = 0 ;
    int nhood = 0 ;
@@ -221,19 +221,19 @@ void generationsalgo::setTotalistic(int value, bool survival) {
 }
 
 // flip bits
-int generationsalgo::flipBits(int x) {
+int generationsrules::flipBits(int x) {
    return ((x & 0x07) << 6) | ((x & 0x1c0) >> 6) | (x & 0x38) ;
 }
 
 // rotate 90
-int generationsalgo::rotateBits90Clockwise(int x) {
+int generationsrules::rotateBits90Clockwise(int x) {
    return ((x & 0x4) << 6) | ((x & 0x20) << 2) | ((x & 0x100) >> 2)
                         | ((x & 0x2) << 4) | (x & 0x10) | ((x & 0x80) >> 4)
                         | ((x & 0x1) << 2) | ((x & 0x8) >> 2) | ((x & 0x40) >> 6) ;
 }
 
 // set symmetrical neighborhood into 3x3 map
-void generationsalgo::setSymmetrical512(int x, int b) {
+void generationsrules::setSymmetrical512(int x, int b) {
    int y = x ;
    int i = 0 ;
 
@@ -254,7 +254,7 @@ void generationsalgo::setSymmetrical512(int x, int b) {
 }
 
 // set symmetrical neighborhood
-void generationsalgo::setSymmetrical(int value, bool survival, int lindex, int normal) {
+void generationsrules::setSymmetrical(int value, bool survival, int lindex, int normal) {
    int xorbit = 0 ;
    int nindex = value - 1 ;
    int x = 0 ;
@@ -295,7 +295,7 @@ void generationsalgo::setSymmetrical(int value, bool survival, int lindex, int n
 }
 
 // set totalistic birth or survival rule from a string
-void generationsalgo::setTotalisticRuleFromString(const char *rule, bool survival) {
+void generationsrules::setTotalisticRuleFromString(const char *rule, bool survival) {
    char current ;
 
    // process each character in the rule string
@@ -312,7 +312,7 @@ void generationsalgo::setTotalisticRuleFromString(const char *rule, bool surviva
 }
 
 // set rule from birth or survival string
-void generationsalgo::setRuleFromString(const char *rule, bool survival) {
+void generationsrules::setRuleFromString(const char *rule, bool survival) {
    // current and next character
    char current ;
    char next ;
@@ -389,7 +389,7 @@ void generationsalgo::setRuleFromString(const char *rule, bool survival) {
 }
 
 // create the rule map from the base64 encoded map
-void generationsalgo::createRuleMapFromMAP(const char *base64) {
+void generationsrules::createRuleMapFromMAP(const char *base64) {
    // set the number of characters to read
    int power2 = 1 << (neighbors + 1) ;
    int fullchars = power2 / 6 ;
@@ -457,7 +457,7 @@ void generationsalgo::createRuleMapFromMAP(const char *base64) {
 }
 
 // create the rule map from birth and survival strings
-void generationsalgo::createRuleMap(const char *birth, const char *survival) {
+void generationsrules::createRuleMap(const char *birth, const char *survival) {
    // clear the rule array
    memset(rule3x3, 0, ALL3X3) ;
 
@@ -479,7 +479,7 @@ void generationsalgo::createRuleMap(const char *birth, const char *survival) {
 }
 
 // add canonical letter representation
-int generationsalgo::addLetters(int count, int p) {
+int generationsrules::addLetters(int count, int p) {
    int bits ;            // bitmask of letters defined at this count
    int negative = 0 ;    // whether negative
    int setbits ;         // how many bits are defined
@@ -543,7 +543,7 @@ int generationsalgo::addLetters(int count, int p) {
 }
 
 // AKT: store valid rule in canonical format for getrule()
-void generationsalgo::createCanonicalName(const char *base64) {
+void generationsrules::createCanonicalName(lifealgo *algo, const char *base64) {
    int p = 0 ;
    int np = 0 ;
    int i = 0 ;
@@ -638,7 +638,7 @@ void generationsalgo::createCanonicalName(const char *base64) {
    // output state count
    char states[4] ;
    memset(states, 0, sizeof(states)) ;
-   sprintf(states, "%d", maxCellStates) ;
+   sprintf(states, "%d", numstates) ;
    i = 0 ;
    while (states[i]) canonrule[p++] = states[i++] ;
 
@@ -654,22 +654,19 @@ void generationsalgo::createCanonicalName(const char *base64) {
    }
 
    // check for bounded grid
-   if (gridwd > 0 || gridht > 0) {
+   if (algo->gridwd > 0 || algo->gridht > 0) {
       // algo->setgridsize() was successfully called above, so append suffix
-      const char* bounds = canonicalsuffix() ;
+      const char* bounds = algo->canonicalsuffix() ;
       i = 0 ;
       while (bounds[i]) canonrule[p++] = bounds[i++] ;
    }
 
    // null terminate
    canonrule[p] = 0 ;
-
-   // set canonical rule
-   ghashbase::setrule(canonrule) ;
 }
 
 // remove character from a string in place
-void generationsalgo::removeChar(char *string, char skip) {
+void generationsrules::removeChar(char *string, char skip) {
    int src = 0 ;
    int dst = 0 ;
    char c = string[src++] ;
@@ -687,7 +684,7 @@ void generationsalgo::removeChar(char *string, char skip) {
 }
 
 // check whether non-totalistic letters are valid for defined neighbor counts
-bool generationsalgo::lettersValid(const char *part) {
+bool generationsrules::lettersValid(const char *part) {
    char c ;
    int nindex = 0 ;
    int currentCount = -1 ;
@@ -723,7 +720,7 @@ bool generationsalgo::lettersValid(const char *part) {
 }
 
 // set rule
-const char *generationsalgo::setrule(const char *rulestring) {
+const char *generationsrules::setrule(const char *rulestring, lifealgo *algo) {
    char *r = (char *)rulestring ;
    char tidystring[MAXRULESIZE] ;  // tidy version of rule string
    char *t = (char *)tidystring ;
@@ -845,7 +842,7 @@ const char *generationsalgo::setrule(const char *rulestring) {
       }
 
       // set the number of cell states
-      maxCellStates = num_states ;
+      numstates = num_states ;
 
       // map looks valid
       using_map = true ;
@@ -1009,7 +1006,7 @@ const char *generationsalgo::setrule(const char *rulestring) {
       }
    
       // set the number of cell states
-      maxCellStates = num_states ;
+      numstates = num_states ;
    
       // underscore only valid for non-totalistic rules
       if (underscore_used && totalistic) {
@@ -1136,12 +1133,12 @@ const char *generationsalgo::setrule(const char *rulestring) {
 
    // AKT: check for rule suffix like ":T200,100" to specify a bounded universe
    if (colonpos) {
-      const char* err = setgridsize(colonpos) ;
+      const char* err = algo->setgridsize(colonpos) ;
       if (err) return err ;
    } else {
       // universe is unbounded
-      gridwd = 0 ;
-      gridht = 0 ;
+      algo->gridwd = 0 ;
+      algo->gridht = 0 ;
    }
 
    // check for map
@@ -1160,21 +1157,36 @@ const char *generationsalgo::setrule(const char *rulestring) {
    }
 
    // save the canonical rule name
-   createCanonicalName(bpos) ;
+   createCanonicalName(algo, bpos) ;
+
+   // exit with success
+   return 0 ;
+}
+
+generationsalgo::generationsalgo() {
+   maxCellStates = genrules.numstates ;
+}
+
+generationsalgo::~generationsalgo() {
+}
+
+const char* generationsalgo::setrule(const char *s) {
+   const char *err = genrules.setrule(s, this) ;
+   if (err) return err ;
+   maxCellStates = genrules.numstates ;
 
    // set grid_type
-   if (neighbormask == HEXAGONAL)
+   if (genrules.isHexagonal())
       grid_type = HEX_GRID;
-   else if (neighbormask == VON_NEUMANN)
+   else if (genrules.isVonNeumann())
       grid_type = VN_GRID;
    else // neighbormask == MOORE
       grid_type = SQUARE_GRID;
 
-   // exit with success
-   return 0 ;
+   // set canonical rule
+   return ghashbase::setrule(genrules.getrule()) ;
 }
 
 const char* generationsalgo::getrule() {
-   return canonrule ;
+   return genrules.getrule() ;
 }
-
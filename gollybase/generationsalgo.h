@@ -5,19 +5,22 @@
 #define GENERALGO_H
 #include "ghashbase.h"
 /**
- *   Our Generations algo class.
+ *   This class implements the rules supported by the Generations
+ *   algorithms (the hashed one below and the bit-plane one in
+ *   qgenalgo.h).  Like liferules, setrule gets the algorithm whose
+ *   bounded grid suffix (if any) it should parse.  A cell in state 1
+ *   is alive in the next generation if rule3x3 says so, where the
+ *   index has a bit for each live (state 1) cell in the 3x3 block
+ *   (256 = NW, 128 = N, 64 = NE, 32 = W, 16 = center ... 1 = SE);
+ *   other non-zero states decay to the next state and then to 0.
  */
-class generationsalgo : public ghashbase {
+class generationsrules {
 public:
-   generationsalgo() ;
-   virtual ~generationsalgo() ;
-   virtual state slowcalc(state nw, state n, state ne, state w, state c,
-                          state e, state sw, state s, state se) ;
-   virtual const char* setrule(const char* s) ;
-   virtual const char* getrule() ;
-   virtual const char* DefaultRule() ;
-   virtual int NumCellStates() ;
-   static void doInitializeAlgoInfo(staticAlgoInfo &) ;
+   generationsrules() ;
+   ~generationsrules() ;
+   // string returned by setrule is any error
+   const char *setrule(const char *s, lifealgo *algo) ;
+   const char *getrule() { return canonrule ; }
 
    enum neighborhood_masks {
       MOORE = 0x1ff,         // all 8 neighbors
@@ -28,6 +31,9 @@ public:
    bool isHexagonal() const { return neighbormask == HEXAGONAL ; }
    bool isVonNeumann() const { return neighbormask == VON_NEUMANN ; }
 
+   int numstates ;                    // number of cell states (2..256)
+   char rule3x3[ALL3X3] ;             // all 3x3 cell mappings 012345678->4'
+
 private:
    char canonrule[MAXRULESIZE] ;      // canonical version of valid rule passed into setrule
    neighborhood_masks neighbormask ;  // neighborhood masks in 3x3 table
@@ -43,7 +49,6 @@ private:
    const char *valid_rule_letters ;   // all valid letters
    const char *rule_letters[4] ;      // valid rule letters per neighbor count
    const int *rule_neighborhoods[4] ; // isotropic neighborhoods per neighbor count
-   char rule3x3[ALL3X3] ;             // all 3x3 cell mappings 012345678->4'
    const char *base64_characters ;    // base 64 encoding characters
 
    void initRule() ;
@@ -56,10 +61,32 @@ private:
    void setRuleFromString(const char *rule, bool survival) ;
    void createRuleMapFromMAP(const char *base64) ;
    void createRuleMap(const char *birth, const char *survival) ;
-   void createCanonicalName(const char *base64) ;
+   void createCanonicalName(lifealgo *algo, const char *base64) ;
    void removeChar(char *string, char skip) ;
    bool lettersValid(const char *part) ;
    int addLetters(int count, int p) ;
 } ;
 
+/**
+ *   Our Generations algo class.
+ */
+class generationsalgo : public ghashbase {
+public:
+   generationsalgo() ;
+   virtual ~generationsalgo() ;
+   virtual state slowcalc(state nw, state n, state ne, state w, state c,
+                          state e, state sw, state s, state se) ;
+   virtual const char* setrule(const char* s) ;
+   virtual const char* getrule() ;
+   virtual const char* DefaultRule() ;
+   virtual int NumCellStates() ;
+   static void doInitializeAlgoInfo(staticAlgoInfo &) ;
+
+   bool isHexagonal() const { return genrules.isHexagonal() ; }
+   bool isVonNeumann() const { return genrules.isVonNeumann() ; }
+
+private:
+   generationsrules genrules ;
+} ;
+
 #endif
@@ -56,6 +56,16 @@ g_uintptr_t ghnode_hash(void *a, void *b, void *c, void *d) {
 }
 #endif
 #define ghleaf_hash(a,b,c,d) (65537*(d)+257*(c)+17*(b)+5*(a))
+/*
+ *   In adaptive mode we don't give up on the table when it can't grow;
+ *   we let it get twice as full and try again then (a gc may have
+ *   made room by then, and if not the load just keeps rising).
+ */
+g_uintptr_t ghashbase::raisedhashlimit() {
+   if (hashlimit > G_MAX / 2)
+      return G_MAX ;
+   return 2 * hashlimit ;
+}
 /*
  *   Resize the hash.  The max load factor defined here does not actually
  *   yield the maximum load factor the hash will see, because when we
@@ -70,21 +80,26 @@ g_uintptr_t ghnode_hash(void *a, void *b, void *c, void *d) {
  *   tweaked in the case where you absolutely want as many nodes as
  *   possible in memory, and are willing to use a large load factor to
  *   permit this; with the move-to-front heuristic, the code actually
- *   handles a large load factor fairly well.
+ *   handles a large load factor fairly well.  (The factor, and whether
+ *   we gc before resizing, are runtime settings; see lifealgo.h.)
  */
-double ghashbase::maxloadfactor = 0.7 ;
 void ghashbase::resize() {
-#ifndef NOGCBEFORERESIZE
-   if (okaytogc) {
+   if (gcbeforeresize && okaytogc) {
       do_gc(0) ;
    }
-#endif
    g_uintptr_t i, nhashprime = nexthashsize(2 * hashprime) ;
    ghnode *p, **nhashtab ;
    if (hashprime > (totalthings >> 2)) {
       if (alloced > maxmem ||
           nhashprime * sizeof(ghnode *) > (maxmem - alloced)) {
-         hashlimit = G_MAX ;
+         hashlimit = adaptiveload ? raisedhashlimit() : G_MAX ;
+         return ;
+      }
+      // in adaptive mode, once the bigger table would take more than
+      // half of what memory remains, we'd rather have the nodes
+      if (adaptiveload &&
+          nhashprime * sizeof(ghnode *) > ((maxmem - alloced) >> 1)) {
+         hashlimit = raisedhashlimit() ;
          return ;
       }
    }
@@ -94,6 +109,14 @@ void ghashbase::resize() {
    }
    nhashtab = (ghnode **)calloc(nhashprime, sizeof(ghnode *)) ;
    if (nhashtab == 0) {
+     if (adaptiveload) {
+       hashlimit = raisedhashlimit() ;
+       if (verbose) {
+         strcpy(statusline+strlen(statusline), " no memory; load raised.") ;
+         lifestatus(statusline) ;
+       }
+       return ;
+     }
      lifewarning("Out of memory; running in a somewhat slower mode; "
                  "try reducing the hash memory limit after restarting.") ;
      hashlimit = G_MAX ;
@@ -486,6 +509,7 @@ ghashbase::ghashbase() {
    if (hashtab == 0)
      lifefatal("Out of memory (1).") ;
    alloced = hashprime * sizeof(ghnode *) ;
+   hashmemo.setcounter(&alloced) ;
    ngens = 0 ;
    stacksize = 0 ;
    halvesdone = 0 ;
@@ -517,6 +541,9 @@ ghashbase::ghashbase() {
    inGC = 0 ;
    cacheinvalid = 0 ;
    gccount = 0 ;
+   gclive = 0 ;
+   editmemo = 0 ;
+   overlaymemo = 0 ;
    gcstep = 0 ;
    running_hperf.clear() ;
    inc_hperf = running_hperf ;
@@ -602,12 +629,21 @@ void ghashbase::step() {
    }
 }
 void ghashbase::setcurrentstate(void *n) {
+   ensure_hashed() ;
    if (root != (ghnode *)n) {
       root = (ghnode *)n ;
       depth = ghnode_depth(root) ;
       popValid = 0 ;
    }
 }
+/*
+ *   Kept states are only worth it if they'll mostly share nodes with
+ *   the live pattern; once the nodes surviving a gc fill half of our
+ *   memory we tell the caller to save the pattern elsewhere.
+ */
+int ghashbase::cankeepstate() {
+   return gccount == 0 || 2 * gclive * sizeof(ghnode) <= maxmem ;
+}
 /*
  *   Set the max memory
  */
@@ -627,10 +663,22 @@ void ghashbase::setMaxMemory(int newmemlimit) {
    hashlimit = (g_uintptr_t)(maxloadfactor * hashprime) ;
 }
 /**
- *   Clear everything.
+ *   Clear everything.  The hash table keeps all its nodes (so results
+ *   computed for earlier patterns can be found again); we just go back to
+ *   the empty pattern at generation 0 and let the next gc collect any
+ *   nodes nothing uses any more.
  */
 void ghashbase::clearall() {
-   lifefatal("clearall not implemented yet") ;
+   poller->bailIfCalculating() ;
+   ensure_hashed() ;
+   clearstack() ;
+   depth = 1 ;
+   root = zeroghnode(depth) ;
+   generation = 0 ;
+   population = 0 ;
+   popValid = 1 ;
+   needPop = 0 ;
+   clipped_cells.clear() ;
 }
 /*
  *   This routine expands our universe by a factor of two, maintaining
@@ -1224,6 +1272,59 @@ void ghashbase::calcPopulation() {
    population = calcpop(root, depth) ;
    aftercalcpop2(root, depth) ;
 }
+/*
+ *   The pattern hash of a ghnode relative to its upper left corner,
+ *   memoized in a side table since ghnodes never change.  The children
+ *   of a ghnode at a given depth are 2^depth cells on a side.
+ */
+phash ghashbase::ghnodehash(ghnode *n, int depth) {
+   if (n == zeroghnode(depth))
+      return 0 ;
+   phash *m = hashmemo.lookup(n) ;
+   if (m)
+      return *m ;
+   phash h ;
+   if (depth == 0) {
+      ghleaf *l = (ghleaf *)n ;
+      h = patternhash::add(l->nw, patternhash::mul(patternhash::X, l->ne)) ;
+      h = patternhash::add(h, patternhash::mul(patternhash::Y,
+             patternhash::add(l->sw, patternhash::mul(patternhash::X, l->se)))) ;
+   } else {
+      phash xs = patternhash::xpow2(depth) ;
+      phash ys = patternhash::ypow2(depth) ;
+      depth-- ;
+      phash top = patternhash::add(ghnodehash(n->nw, depth),
+                     patternhash::mul(xs, ghnodehash(n->ne, depth))) ;
+      phash bot = patternhash::add(ghnodehash(n->sw, depth),
+                     patternhash::mul(xs, ghnodehash(n->se, depth))) ;
+      h = patternhash::add(top, patternhash::mul(ys, bot)) ;
+   }
+   hashmemo.insert(n, h) ;
+   return h ;
+}
+/*
+ *   Only the ghnodes created since the last call need to be hashed, then
+ *   we move the origin from the root's corner to the bounding box.
+ */
+int ghashbase::gethash() {
+   ensure_hashed() ;
+   if (root == zeroghnode(depth))
+      return patternhash::fold(0) ;
+   bigint top, left, bottom, right ;
+   findedges(&top, &left, &bottom, &right) ;
+   // the upper left corner of the root is at (-2^depth, 1-2^depth)
+   bigint half = 1 ;
+   half.mulpow2(depth) ;
+   bigint ex = 0, ey = 1 ;
+   ex -= half ;
+   ex -= left ;
+   ey -= half ;
+   ey -= top ;
+   phash h = ghnodehash(root, depth) ;
+   h = patternhash::mul(h, patternhash::pow(patternhash::X, ex)) ;
+   h = patternhash::mul(h, patternhash::pow(patternhash::Y, ey)) ;
+   return patternhash::fold(h) ;
+}
 /*
  *   Is the universe empty?
  */
@@ -1282,6 +1383,12 @@ void ghashbase::gc_mark(ghnode *root, int invalidate) {
       }
    }
 }
+/*
+ *   The side table only keeps the ghnodes that survive a gc.
+ */
+static int gcmarked(const void *n) {
+   return marked((const ghnode *)n) ;
+}
 /**
  *   If the invalidate flag is set, we want to kill *all* cache entries
  *   and recalculate all leaves.
@@ -1313,6 +1420,13 @@ void ghashbase::do_gc(int invalidate) {
    }
    for (i=0; i<timeline.framecount; i++)
       gc_mark((ghnode *)timeline.frames[i], invalidate) ;
+   vector<void *> kept = getkeptstates() ;
+   for (i=0; i<(int)kept.size(); i++)
+      gc_mark((ghnode *)kept[i], invalidate) ;
+   if (alloced > maxmem)
+      hashmemo.release() ;  // only a cache, so don't grow past the limit
+   else
+      hashmemo.retain(gcmarked) ;
    hashpop = 0 ;
    memset(hashtab, 0, sizeof(ghnode *) * hashprime) ;
    freeghnodes = 0 ;
@@ -1337,6 +1451,9 @@ void ghashbase::do_gc(int invalidate) {
          }
       }
    }
+   gclive = hashpop ;
+   if (kept.size() > 0 && !cankeepstate())
+      keptoverbudget = 1 ;
    inGC = 0 ;
    if (verbose) {
      double perc = (double)freed_ghnodes / (double)totalthings * 100.0 ;
@@ -1633,13 +1750,20 @@ const char *ghashbase::readmacrocell(char *line) {
                   timeline.expo = texpo ;
                }
 	    } else if (strncmp(line, "#FRAME ", 7) == 0) {
-	       int frameind = 0 ;
+	       // a thinned timeline also gives each frame's generation
+	       int frameind = 0, genpos = 0 ;
 	       g_uintptr_t nodeind = 0 ;
-	       n = sscanf(line+7, "%d %" PRIuPTR, &frameind, &nodeind) ;
+	       n = sscanf(line+7, "%d %" PRIuPTR "%n", &frameind, &nodeind, &genpos) ;
 	       if (n != 2 || frameind > MAX_FRAME_COUNT || frameind < 0 ||
 		   nodeind > i || timeline.framecount != frameind)
 		  return "Bad FRAME line" ;
 	       timeline.frames.push_back(ind[nodeind]) ;
+	       p = line + 7 + genpos ;
+	       while (*p && *p <= ' ')
+		 p++ ;
+	       if ('0' <= *p && *p <= '9')
+		  timeline.next = bigint(p) ;
+	       timeline.gens.push_back(timeline.next) ;
 	       timeline.framecount++ ;
 	       timeline.end = timeline.next ;
 	       timeline.next += timeline.inc ;
@@ -1883,10 +2007,16 @@ const char *ghashbase::writeNativeFormat(std::ostream &os, char *comments) {
          << ' ' << timeline.framecount
          << ' ' << timeline.start.tostring()
          << ' ' << timeline.base << '^' << timeline.expo << '\n' ;
+      bigint uniformgen = timeline.start ;
       for (int i=0; i<timeline.framecount; i++) {
          ghnode *frame = (ghnode*)timeline.frames[i] ;
          writecell_2p2(os, frame, depths[i]) ;
-         os << "#FRAME " << i << ' ' << (g_uintptr_t)frame->next << '\n' ;
+         os << "#FRAME " << i << ' ' << (g_uintptr_t)frame->next ;
+         // only thinned timelines need each frame's generation
+         if (timeline.gens[i] != uniformgen)
+            os << ' ' << timeline.gens[i].tostring() ;
+         os << '\n' ;
+         uniformgen += timeline.inc ;
       }
    }
    writecell_2p2(os, root, depth) ;
@@ -1901,6 +2031,580 @@ const char *ghashbase::writeNativeFormat(std::ostream &os, char *comments) {
    inGC = 0 ;
    return 0 ;
 }
+/*
+ *   Rectangle editing.  Everything here works on the hashed tree one
+ *   subtree at a time and memoizes what it does to each ghnode, so a
+ *   rectangle full of repeated structure costs about as much as the
+ *   distinct ghnodes along its edges rather than its area.  We never gc
+ *   in the middle of an edit (okaytogc is off), so the memo tables can
+ *   hold plain ghnode pointers.
+ */
+const bigint &ghashbase::nodesize(int depth) {
+   while ((int)editsizes.size() <= depth) {
+      bigint s = 1 ;
+      s.mulpow2((int)editsizes.size() + 1) ;
+      editsizes.push_back(s) ;
+   }
+   return editsizes[depth] ;
+}
+/*
+ *   Grow a tree to the given depth, keeping it centered.
+ */
+ghnode *ghashbase::padnode(ghnode *n, int depth, int newdepth) {
+   while (depth < newdepth) {
+      n = pushroot(n) ;
+      depth++ ;
+   }
+   return n ;
+}
+void ghashbase::setcliprect(const bigint &top, const bigint &left,
+                            const bigint &bottom, const bigint &right) {
+   clipl = left ;
+   clipr = right ;
+   clipr += bigint::one ;
+   clipb = bigint::zero ;
+   clipb -= bottom ;
+   clipt = bigint::one ;
+   clipt -= top ;
+}
+/*
+ *   Keep the cells of a leaf inside (or outside) the clip rectangle,
+ *   given which edges cut it; an edge that cuts a 2x2 leaf must run
+ *   through its middle.
+ */
+ghnode *ghashbase::clipleaf(ghleaf *l, int cut, int inside) {
+   state c[4] = { l->sw, l->se, l->nw, l->ne } ;
+   for (int i=0; i<4; i++) {
+      int in = !((cut & 1) && (i & 1) == 0) && !((cut & 2) && (i & 1)) &&
+               !((cut & 4) && (i & 2) == 0) && !((cut & 8) && (i & 2)) ;
+      if (in != inside)
+         c[i] = 0 ;
+   }
+   return (ghnode *)find_ghleaf(c[2], c[3], c[0], c[1]) ;
+}
+/*
+ *   Keep only the cells inside (or outside) the clip rectangle; x and y
+ *   are the lower left corner of the ghnode.  A ghnode that an edge cuts
+ *   through always meets it at the same offset (ghnodes are aligned to
+ *   their size), so which edges cut it is all the memo key needs.
+ */
+ghnode *ghashbase::clipnode(ghnode *n, int depth, const bigint &x,
+                            const bigint &y, int inside) {
+   ghnode *z = zeroghnode(depth) ;
+   if (n == z)
+      return n ;
+   const bigint &s = nodesize(depth) ;
+   bigint x1 = x ;
+   x1 += s ;
+   bigint y1 = y ;
+   y1 += s ;
+   if (x1 <= clipl || x >= clipr || y1 <= clipb || y >= clipt)
+      return inside ? z : n ;
+   int cut = (x < clipl) | ((x1 > clipr) << 1) |
+             ((y < clipb) << 2) | ((y1 > clipt) << 3) ;
+   if (cut == 0)
+      return inside ? n : z ;
+   ghnode **m = editmemo[cut].lookup(n) ;
+   if (m)
+      return *m ;
+   ghnode *r ;
+   if (depth == 0) {
+      r = clipleaf((ghleaf *)n, cut, inside) ;
+   } else {
+      const bigint &h = nodesize(depth-1) ;
+      bigint xh = x ;
+      xh += h ;
+      bigint yh = y ;
+      yh += h ;
+      r = find_ghnode(clipnode(n->nw, depth-1, x, yh, inside),
+                      clipnode(n->ne, depth-1, xh, yh, inside),
+                      clipnode(n->sw, depth-1, x, y, inside),
+                      clipnode(n->se, depth-1, xh, y, inside)) ;
+   }
+   editmemo[cut].insert(n, r) ;
+   return r ;
+}
+ghnode *ghashbase::cliproot(ghnode *n, int depth, int inside) {
+   for (int i=0; i<16; i++)
+      editmemo[i].clear() ;
+   nodesize(depth) ;
+   bigint x = bigint::zero ;
+   x -= nodesize(depth-1) ;
+   return clipnode(n, depth, x, x, inside) ;
+}
+/*
+ *   Flip or rotate a whole tree about its center.  A leaf's cells move
+ *   just like the children of a ghnode.
+ */
+ghnode *ghashbase::transformnode(ghnode *n, int depth, TRectOp op) {
+   if (op == MOVE_ONLY || n == zeroghnode(depth))
+      return n ;
+   ghnode **m = editmemo[0].lookup(n) ;
+   if (m)
+      return *m ;
+   ghnode *r = 0 ;
+   if (depth == 0) {
+      ghleaf *l = (ghleaf *)n ;
+      switch (op) {
+         case FLIP_TOP_BOTTOM:
+            r = (ghnode *)find_ghleaf(l->sw, l->se, l->nw, l->ne) ; break ;
+         case FLIP_LEFT_RIGHT:
+            r = (ghnode *)find_ghleaf(l->ne, l->nw, l->se, l->sw) ; break ;
+         case ROTATE_CW:
+            r = (ghnode *)find_ghleaf(l->sw, l->nw, l->se, l->ne) ; break ;
+         case ROTATE_ACW:
+            r = (ghnode *)find_ghleaf(l->ne, l->se, l->nw, l->sw) ; break ;
+         case MOVE_ONLY:
+            r = n ; break ;
+      }
+   } else {
+      ghnode *nw = transformnode(n->nw, depth-1, op) ;
+      ghnode *ne = transformnode(n->ne, depth-1, op) ;
+      ghnode *sw = transformnode(n->sw, depth-1, op) ;
+      ghnode *se = transformnode(n->se, depth-1, op) ;
+      switch (op) {
+         case FLIP_TOP_BOTTOM: r = find_ghnode(sw, se, nw, ne) ; break ;
+         case FLIP_LEFT_RIGHT: r = find_ghnode(ne, nw, se, sw) ; break ;
+         case ROTATE_CW: r = find_ghnode(sw, nw, se, ne) ; break ;
+         case ROTATE_ACW: r = find_ghnode(ne, se, nw, sw) ; break ;
+         case MOVE_ONLY: r = n ; break ;
+      }
+   }
+   editmemo[0].insert(n, r) ;
+   return r ;
+}
+/*
+ *   Return the ghnode half the size of n whose lower left corner is at
+ *   the offset in shiftxbits and shiftybits from n's lower left corner.
+ *   Only the low depth bits of the offset matter at each depth, so the
+ *   result depends on n alone.
+ */
+ghnode *ghashbase::windownode(ghnode *n, int depth) {
+   if (n == zeroghnode(depth))
+      return zeroghnode(depth-1) ;
+   ghnode **m = editmemo[0].lookup(n) ;
+   if (m)
+      return *m ;
+   ghnode *r ;
+   int gx = shiftxbits[depth-1] ;
+   int gy = shiftybits[depth-1] ;
+   if (depth == 1) {
+      state g[4][4] ;
+      ghleaf *c[4] = { (ghleaf *)n->sw, (ghleaf *)n->se,
+                       (ghleaf *)n->nw, (ghleaf *)n->ne } ;
+      for (int k=0; k<4; k++) {
+         int x = 2 * (k & 1) ;
+         int y = 2 * (k >> 1) ;
+         g[x][y] = c[k]->sw ;
+         g[x+1][y] = c[k]->se ;
+         g[x][y+1] = c[k]->nw ;
+         g[x+1][y+1] = c[k]->ne ;
+      }
+      r = (ghnode *)find_ghleaf(g[gx][gy+1], g[gx+1][gy+1],
+                                g[gx][gy], g[gx+1][gy]) ;
+   } else {
+      ghnode *g[4][4] ;
+      ghnode *c[4] = { n->sw, n->se, n->nw, n->ne } ;
+      for (int k=0; k<4; k++) {
+         int x = 2 * (k & 1) ;
+         int y = 2 * (k >> 1) ;
+         g[x][y] = c[k]->sw ;
+         g[x+1][y] = c[k]->se ;
+         g[x][y+1] = c[k]->nw ;
+         g[x+1][y+1] = c[k]->ne ;
+      }
+      ghnode *w[2][2] ;
+      for (int i=0; i<2; i++)
+         for (int j=0; j<2; j++) {
+            int x = gx + i ;
+            int y = gy + j ;
+            w[i][j] = windownode(find_ghnode(g[x][y+1], g[x+1][y+1],
+                                             g[x][y], g[x+1][y]), depth-1) ;
+         }
+      r = find_ghnode(w[0][1], w[1][1], w[0][0], w[1][0]) ;
+   }
+   editmemo[0].insert(n, r) ;
+   return r ;
+}
+/*
+ *   Move a whole tree by dx,dy, returning a tree deep enough to hold
+ *   the result.
+ */
+ghnode *ghashbase::shiftnode(ghnode *n, int depth, const bigint &dx,
+                             const bigint &dy, int &newdepth) {
+   bigint m = dx ;
+   if (m.sign() < 0) {
+      m = bigint::zero ;
+      m -= dx ;
+   }
+   bigint my = dy ;
+   if (my.sign() < 0) {
+      my = bigint::zero ;
+      my -= dy ;
+   }
+   if (my > m)
+      m = my ;
+   m += nodesize(depth-1) ;
+   // the moved tree must fit in the result with a cell to spare, so
+   // the window we cut out of the padded tree never touches its edge
+   int nd = depth ;
+   while (nodesize(nd-1) <= m)
+      nd++ ;
+   n = padnode(n, depth, nd+1) ;
+   bigint ox = nodesize(nd-1) ;
+   ox -= dx ;
+   bigint oy = nodesize(nd-1) ;
+   oy -= dy ;
+   shiftxbits.resize(nd+1) ;
+   shiftybits.resize(nd+1) ;
+   ox.tochararr(&shiftxbits[0], nd+1) ;
+   oy.tochararr(&shiftybits[0], nd+1) ;
+   editmemo[0].clear() ;
+   newdepth = nd ;
+   return windownode(n, nd+1) ;
+}
+/*
+ *   Combine two trees of the same depth; where both have a live cell
+ *   the one in b wins.  The memo only remembers the last b each a was
+ *   combined with, which is nearly always enough since b is usually
+ *   empty where a isn't.
+ */
+ghnode *ghashbase::overlaynode(ghnode *a, ghnode *b, int depth) {
+   ghnode *z = zeroghnode(depth) ;
+   if (b == z || a == b)
+      return a ;
+   if (a == z)
+      return b ;
+   ghnodepair *m = overlaymemo->lookup(a) ;
+   if (m && m->b == b)
+      return m->r ;
+   ghnode *r ;
+   if (depth == 0) {
+      ghleaf *la = (ghleaf *)a ;
+      ghleaf *lb = (ghleaf *)b ;
+      r = (ghnode *)find_ghleaf(lb->nw ? lb->nw : la->nw,
+                                lb->ne ? lb->ne : la->ne,
+                                lb->sw ? lb->sw : la->sw,
+                                lb->se ? lb->se : la->se) ;
+   } else {
+      r = find_ghnode(overlaynode(a->nw, b->nw, depth-1),
+                      overlaynode(a->ne, b->ne, depth-1),
+                      overlaynode(a->sw, b->sw, depth-1),
+                      overlaynode(a->se, b->se, depth-1)) ;
+   }
+   ghnodepair p ;
+   p.b = b ;
+   p.r = r ;
+   overlaymemo->insert(a, p) ;
+   return r ;
+}
+/*
+ *   Combine the states of one cell for combinenode; a live cell keeps
+ *   its own state (a's, for an xor where only a is live); where both are
+ *   live an or takes b's, as copyrect would.
+ */
+static state combinestate(state a, state b, lifealgo::TCombineOp op) {
+   switch (op) {
+      case lifealgo::COMBINE_AND: return b ? a : 0 ;
+      case lifealgo::COMBINE_XOR: return a ? (b ? 0 : a) : b ;
+      case lifealgo::COMBINE_SUBTRACT: return b ? 0 : a ;
+      case lifealgo::COMBINE_OR: return b ? b : a ;
+   }
+   return a ;
+}
+/*
+ *   Combine two trees of the same depth cell by cell; like overlaynode
+ *   this only remembers the last b each a was combined with.
+ */
+ghnode *ghashbase::combinenode(ghnode *a, ghnode *b, int depth,
+                               TCombineOp op) {
+   ghnode *z = zeroghnode(depth) ;
+   if (a == z)
+      return op == COMBINE_XOR || op == COMBINE_OR ? b : z ;
+   if (b == z)
+      return op == COMBINE_AND ? z : a ;
+   if (a == b)
+      return op == COMBINE_AND || op == COMBINE_OR ? a : z ;
+   ghnodepair *m = overlaymemo->lookup(a) ;
+   if (m && m->b == b)
+      return m->r ;
+   ghnode *r ;
+   if (depth == 0) {
+      ghleaf *la = (ghleaf *)a ;
+      ghleaf *lb = (ghleaf *)b ;
+      r = (ghnode *)find_ghleaf(combinestate(la->nw, lb->nw, op),
+                                combinestate(la->ne, lb->ne, op),
+                                combinestate(la->sw, lb->sw, op),
+                                combinestate(la->se, lb->se, op)) ;
+   } else {
+      r = find_ghnode(combinenode(a->nw, b->nw, depth-1, op),
+                      combinenode(a->ne, b->ne, depth-1, op),
+                      combinenode(a->sw, b->sw, depth-1, op),
+                      combinenode(a->se, b->se, depth-1, op)) ;
+   }
+   ghnodepair p ;
+   p.b = b ;
+   p.r = r ;
+   overlaymemo->insert(a, p) ;
+   return r ;
+}
+/*
+ *   Copy a tree from another universe into our hash table.
+ */
+ghnode *ghashbase::importnode(ghnode *n, int depth) {
+   ghnode **m = editmemo[0].lookup(n) ;
+   if (m)
+      return *m ;
+   ghnode *r ;
+   if (depth == 0) {
+      ghleaf *l = (ghleaf *)n ;
+      r = (ghnode *)find_ghleaf(l->nw, l->ne, l->sw, l->se) ;
+   } else {
+      r = find_ghnode(importnode(n->nw, depth-1), importnode(n->ne, depth-1),
+                      importnode(n->sw, depth-1), importnode(n->se, depth-1)) ;
+   }
+   editmemo[0].insert(n, r) ;
+   return r ;
+}
+/*
+ *   Copy just the part of another universe's tree that lies inside the
+ *   clip rectangle into our hash table, like clipnode with inside set.
+ *   Subtrees outside the rectangle are never visited, so the cost
+ *   depends on the rectangle, not on the size of the source pattern.
+ */
+ghnode *ghashbase::importclipnode(ghnode *n, int depth, const bigint &x,
+                                  const bigint &y) {
+   const bigint &s = nodesize(depth) ;
+   bigint x1 = x ;
+   x1 += s ;
+   bigint y1 = y ;
+   y1 += s ;
+   if (x1 <= clipl || x >= clipr || y1 <= clipb || y >= clipt)
+      return zeroghnode(depth) ;
+   int cut = (x < clipl) | ((x1 > clipr) << 1) |
+             ((y < clipb) << 2) | ((y1 > clipt) << 3) ;
+   if (cut == 0)
+      return importnode(n, depth) ;
+   ghnode **m = editmemo[cut].lookup(n) ;
+   if (m)
+      return *m ;
+   ghnode *r ;
+   if (depth == 0) {
+      r = clipleaf((ghleaf *)n, cut, 1) ;
+   } else {
+      const bigint &h = nodesize(depth-1) ;
+      bigint xh = x ;
+      xh += h ;
+      bigint yh = y ;
+      yh += h ;
+      r = find_ghnode(importclipnode(n->nw, depth-1, x, yh),
+                      importclipnode(n->ne, depth-1, xh, yh),
+                      importclipnode(n->sw, depth-1, x, y),
+                      importclipnode(n->se, depth-1, xh, y)) ;
+   }
+   editmemo[cut].insert(n, r) ;
+   return r ;
+}
+/*
+ *   Make the combination of the two trees our new pattern.
+ */
+void ghashbase::seteditroot(ghnode *rest, int restdepth, ghnode *sel,
+                            int seldepth) {
+   nodememo<ghnodepair> memo ;
+   overlaymemo = &memo ;
+   int d = restdepth > seldepth ? restdepth : seldepth ;
+   ghnode *r = overlaynode(padnode(rest, restdepth, d),
+                           padnode(sel, seldepth, d), d) ;
+   overlaymemo = 0 ;
+   root = popzeros(r) ;
+   depth = ghnode_depth(root) ;
+   popValid = 0 ;
+}
+int ghashbase::transformrect(TRectOp op, const bigint &top,
+                             const bigint &left, const bigint &bottom,
+                             const bigint &right, const bigint &newtop,
+                             const bigint &newleft) {
+   ensure_hashed() ;
+   nodememo<ghnode *> memos[16] ;
+   editmemo = memos ;
+   setcliprect(top, left, bottom, right) ;
+   ghnode *sel = cliproot(root, depth, 1) ;
+   ghnode *rest = cliproot(root, depth, 0) ;
+   editmemo[0].clear() ;
+   sel = transformnode(sel, depth, op) ;
+   // find where the rectangle's lower left corner went, and how big
+   // the new rectangle is
+   bigint tx, ty ;
+   bigint wd = clipr ;
+   wd -= clipl ;
+   bigint ht = clipt ;
+   ht -= clipb ;
+   switch (op) {
+      case FLIP_TOP_BOTTOM:
+         tx = clipl ;
+         ty = bigint::zero ;
+         ty -= clipt ;
+         break ;
+      case FLIP_LEFT_RIGHT:
+         tx = bigint::zero ;
+         tx -= clipr ;
+         ty = clipb ;
+         break ;
+      case ROTATE_CW:
+         tx = clipb ;
+         ty = bigint::zero ;
+         ty -= clipr ;
+         break ;
+      case ROTATE_ACW:
+         tx = bigint::zero ;
+         tx -= clipt ;
+         ty = clipl ;
+         break ;
+      case MOVE_ONLY:
+         tx = clipl ;
+         ty = clipb ;
+         break ;
+   }
+   if (op == ROTATE_CW || op == ROTATE_ACW) {
+      bigint t = wd ;
+      wd = ht ;
+      ht = t ;
+   }
+   bigint newbottom = newtop ;
+   newbottom += ht ;
+   newbottom -= bigint::one ;
+   bigint newright = newleft ;
+   newright += wd ;
+   newright -= bigint::one ;
+   setcliprect(newtop, newleft, newbottom, newright) ;
+   bigint dx = clipl ;
+   dx -= tx ;
+   bigint dy = clipb ;
+   dy -= ty ;
+   int seldepth ;
+   sel = shiftnode(sel, depth, dx, dy, seldepth) ;
+   rest = cliproot(rest, depth, 0) ;
+   seteditroot(rest, depth, sel, seldepth) ;
+   editmemo = 0 ;
+   return 1 ;
+}
+int ghashbase::copyrect(lifealgo *src, const bigint &top, const bigint &left,
+                        const bigint &bottom, const bigint &right,
+                        int replace) {
+   ghashbase *s = dynamic_cast<ghashbase *>(src) ;
+   if (s == 0 || s->NumCellStates() > NumCellStates())
+      return 0 ;
+   ensure_hashed() ;
+   s->ensure_hashed() ;
+   nodememo<ghnode *> memos[16] ;
+   editmemo = memos ;
+   setcliprect(top, left, bottom, right) ;
+   ghnode *sel ;
+   if (s != this) {
+      nodesize(s->depth) ;
+      bigint x = bigint::zero ;
+      x -= nodesize(s->depth-1) ;
+      sel = importclipnode(s->root, s->depth, x, x) ;
+   } else {
+      sel = cliproot(root, depth, 1) ;
+   }
+   ghnode *rest = replace ? cliproot(root, depth, 0) : root ;
+   seteditroot(rest, depth, sel, s->depth) ;
+   editmemo = 0 ;
+   return 1 ;
+}
+int ghashbase::clearrect(const bigint &top, const bigint &left,
+                         const bigint &bottom, const bigint &right) {
+   ensure_hashed() ;
+   nodememo<ghnode *> memos[16] ;
+   editmemo = memos ;
+   setcliprect(top, left, bottom, right) ;
+   ghnode *rest = cliproot(root, depth, 0) ;
+   seteditroot(rest, depth, zeroghnode(depth), depth) ;
+   editmemo = 0 ;
+   return 1 ;
+}
+int ghashbase::combine(lifealgo *src, TCombineOp op) {
+   ghashbase *s = dynamic_cast<ghashbase *>(src) ;
+   if (s == 0 || s->NumCellStates() > NumCellStates())
+      return 0 ;
+   ensure_hashed() ;
+   s->ensure_hashed() ;
+   nodememo<ghnode *> memos[16] ;
+   editmemo = memos ;
+   ghnode *b = s->root ;
+   if (s != this)
+      b = importnode(b, s->depth) ;
+   editmemo = 0 ;
+   combineroot(b, s->depth, op) ;
+   return 1 ;
+}
+int ghashbase::combinewith(void *state, TCombineOp op) {
+   ensure_hashed() ;
+   ghnode *b = (ghnode *)state ;
+   combineroot(b, ghnode_depth(b), op) ;
+   return 1 ;
+}
+void ghashbase::combineroot(ghnode *b, int bdepth, TCombineOp op) {
+   nodememo<ghnodepair> memo ;
+   overlaymemo = &memo ;
+   int d = depth > bdepth ? depth : bdepth ;
+   ghnode *r = combinenode(padnode(root, depth, d), padnode(b, bdepth, d),
+                           d, op) ;
+   overlaymemo = 0 ;
+   root = popzeros(r) ;
+   depth = ghnode_depth(root) ;
+   popValid = 0 ;
+}
+/*
+ *   Build a tree holding the cells of a getcells-style buffer; llx and
+ *   lly are the lower left corner of the node.
+ */
+ghnode *ghashbase::buildnode(const unsigned char *buf, int x, int y, int w,
+                             int h, int depth, G_INT64 llx, G_INT64 lly) {
+   G_INT64 s = (G_INT64)1 << (depth + 1) ;
+   if (llx + s <= x || llx >= (G_INT64)x + w ||
+       lly + s <= 1 - (G_INT64)y - h || lly >= 1 - (G_INT64)y)
+      return zeroghnode(depth) ;
+   if (depth == 0) {
+      state c[4] = { 0, 0, 0, 0 } ;   // sw, se, nw, ne
+      for (int i=0; i<4; i++) {
+         G_INT64 row = -(lly + (i >> 1)) - y ;
+         G_INT64 col = llx + (i & 1) - x ;
+         if (row >= 0 && row < h && col >= 0 && col < w) {
+            int v = buf[(size_t)row * w + col] ;
+            if (v < maxCellStates)
+               c[i] = (state)v ;
+         }
+      }
+      return (ghnode *)find_ghleaf(c[2], c[3], c[0], c[1]) ;
+   }
+   G_INT64 hs = s >> 1 ;
+   return find_ghnode(buildnode(buf, x, y, w, h, depth-1, llx, lly+hs),
+                      buildnode(buf, x, y, w, h, depth-1, llx+hs, lly+hs),
+                      buildnode(buf, x, y, w, h, depth-1, llx, lly),
+                      buildnode(buf, x, y, w, h, depth-1, llx+hs, lly)) ;
+}
+void ghashbase::setcells(const unsigned char *buf, int x, int y, int w,
+                         int h) {
+   if (w <= 0 || h <= 0)
+      return ;
+   ensure_hashed() ;
+   nodememo<ghnode *> memos[16] ;
+   editmemo = memos ;
+   setcliprect(bigint(y), bigint(x), bigint(y + h - 1), bigint(x + w - 1)) ;
+   ghnode *rest = cliproot(root, depth, 0) ;
+   // the smallest tree (centered like the root) that holds the rectangle
+   int d = 1 ;
+   while (-((G_INT64)1 << d) > x || ((G_INT64)1 << d) < (G_INT64)x + w ||
+          -((G_INT64)1 << d) > 1 - (G_INT64)y - h ||
+          ((G_INT64)1 << d) < 1 - (G_INT64)y)
+      d++ ;
+   ghnode *sel = buildnode(buf, x, y, w, h, d, -((G_INT64)1 << d),
+                           -((G_INT64)1 << d)) ;
+   seteditroot(rest, depth, sel, d) ;
+   editmemo = 0 ;
+}
 char ghashbase::statusline[120] ;
 void ghashbase::doInitializeAlgoInfo(staticAlgoInfo &ai) {
    ai.setDefaultBaseStep(8) ;
@@ -6,6 +6,8 @@
 #include "lifealgo.h"
 #include "liferules.h"
 #include "util.h"
+#include "patternhash.h"
+#include "nodememo.h"
 /*
  *   This class forms the basis of all hashlife-type algorithms except
  *   the highly-optimized hlifealgo (which is most appropriate for
@@ -76,13 +78,15 @@ public:
    virtual void setGeneration(bigint gen) { generation = gen ; }
    virtual const bigint &getPopulation() ;
    virtual int isEmpty() ;
+   virtual int gethash() ;
    virtual int hyperCapable() { return 1 ; }
    virtual void setMaxMemory(int m) ;
    virtual int getMaxMemory() { return (int)(maxmem >> 20) ; }
+   virtual g_uintptr_t getMemoryUsed() { return alloced ; }
    virtual const char *setrule(const char *) ;
    virtual const char *getrule() { return "" ; }
    virtual void step() ;
-   virtual void* getcurrentstate() { return root ; }
+   virtual void* getcurrentstate() { ensure_hashed() ; return root ; }
    virtual void setcurrentstate(void *n) ;
    /*
     *   The contract of draw() is that it render every pixel in the
@@ -95,6 +99,16 @@ public:
    virtual void findedges(bigint *t, bigint *l, bigint *b, bigint *r) ;
    virtual const char *readmacrocell(char *line) ;
    virtual const char *writeNativeFormat(std::ostream &os, char *comments) ;
+   virtual int rectCapable() { return 1 ; }
+   virtual int transformrect(TRectOp op, const bigint &top, const bigint &left,
+                             const bigint &bottom, const bigint &right,
+                             const bigint &newtop, const bigint &newleft) ;
+   virtual int copyrect(lifealgo *src, const bigint &top, const bigint &left,
+                        const bigint &bottom, const bigint &right, int replace) ;
+   virtual int clearrect(const bigint &top, const bigint &left,
+                         const bigint &bottom, const bigint &right) ;
+   virtual int combine(lifealgo *src, TCombineOp op) ;
+   virtual void setcells(const unsigned char *buf, int x, int y, int w, int h) ;
    static void doInitializeAlgoInfo(staticAlgoInfo &) ;
    
 private:
@@ -125,7 +139,6 @@ private:
 #ifndef PRIMEMOD
    g_uintptr_t hashmask ;
 #endif
-   static double maxloadfactor ;
    ghnode **hashtab ;
    int halvesdone ;
    int gsp ;
@@ -151,15 +164,33 @@ private:
    char *llxb, *llyb ;
    int hashed ;
    int cacheinvalid ;
+   nodememo<phash> hashmemo ; // pattern hashes of ghnodes
+   /*
+    *   Rectangle editing works on whole subtrees, memoizing the result
+    *   for each ghnode it meets; these hold the rectangle being clipped
+    *   (in our coordinates, with y upwards and the right and top edges
+    *   excluded), the bits of the offset being shifted by, and the
+    *   memo tables for the current operation.
+    */
+   struct ghnodepair {
+      ghnode *b, *r ;
+   } ;
+   bigint clipl, clipb, clipr, clipt ;
+   vector<bigint> editsizes ;
+   vector<char> shiftxbits, shiftybits ;
+   nodememo<ghnode *> *editmemo ;
+   nodememo<ghnodepair> *overlaymemo ;
    g_uintptr_t cellcounter ; // used when writing
    g_uintptr_t writecells ; // how many to write
    int gccount ; // how many gcs total this pattern
+   g_uintptr_t gclive ; // how many nodes survived the last gc
    int gcstep ; // how many gcs this step
    hperf running_hperf, step_hperf, inc_hperf ;
    int softinterrupt ;
    static char statusline[] ;
 //
    void resize() ;
+   g_uintptr_t raisedhashlimit() ;
    ghnode *find_ghnode(ghnode *nw, ghnode *ne, ghnode *sw, ghnode *se) ;
 #ifdef USEPREFETCH
    ghnode *find_ghnode(ghsetup_t &su) ;
@@ -190,6 +221,7 @@ private:
    void aftercalcpop2(ghnode *root, int depth) ;
    void afterwritemc(ghnode *root, int depth) ;
    void calcPopulation() ;
+   phash ghnodehash(ghnode *n, int depth) ;
    ghnode *save(ghnode *n) ;
    void pop(int n) ;
    void clearstack() ;
@@ -203,12 +235,39 @@ private:
    int log2(unsigned int n) ;
    ghnode *runpattern() ;
    void renderbm(int x, int y) ;
+   void blitbm(int x, int y, unsigned char *pix) ;
    void fill_ll(int d) ;
    void drawghnode(ghnode *n, int llx, int lly, int depth, ghnode *z) ;
+   void drawchunks() ;
+   void drawchunkrange(int first, int step) ;
+   static void drawjob(void *arg, int i, int n) ;
    void ensure_hashed() ;
+   virtual int cankeepstate() ;
+   virtual int combinewith(void *state, TCombineOp op) ;
    g_uintptr_t writecell(std::ostream &os, ghnode *root, int depth) ;
    g_uintptr_t writecell_2p1(ghnode *root, int depth) ;
    g_uintptr_t writecell_2p2(std::ostream &os, ghnode *root, int depth) ;
+   const bigint &nodesize(int depth) ;
+   ghnode *padnode(ghnode *n, int depth, int newdepth) ;
+   void setcliprect(const bigint &top, const bigint &left,
+                    const bigint &bottom, const bigint &right) ;
+   ghnode *clipnode(ghnode *n, int depth, const bigint &x, const bigint &y,
+                    int inside) ;
+   ghnode *cliproot(ghnode *n, int depth, int inside) ;
+   ghnode *clipleaf(ghleaf *l, int cut, int inside) ;
+   ghnode *importclipnode(ghnode *n, int depth, const bigint &x,
+                          const bigint &y) ;
+   ghnode *transformnode(ghnode *n, int depth, TRectOp op) ;
+   ghnode *windownode(ghnode *n, int depth) ;
+   ghnode *shiftnode(ghnode *n, int depth, const bigint &dx, const bigint &dy,
+                     int &newdepth) ;
+   ghnode *overlaynode(ghnode *a, ghnode *b, int depth) ;
+   ghnode *combinenode(ghnode *a, ghnode *b, int depth, TCombineOp op) ;
+   void combineroot(ghnode *b, int bdepth, TCombineOp op) ;
+   ghnode *importnode(ghnode *n, int depth) ;
+   ghnode *buildnode(const unsigned char *buf, int x, int y, int w, int h,
+                     int depth, G_INT64 llx, G_INT64 lly) ;
+   void seteditroot(ghnode *rest, int restdepth, ghnode *sel, int seldepth) ;
    void drawpixel(int x, int y);
    void draw4x4_1(state sw, state se, state nw, state ne, int llx, int lly) ;
    void draw4x4_1(ghnode *n, ghnode *z, int llx, int lly) ;
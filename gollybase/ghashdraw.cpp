@@ -24,10 +24,47 @@ const int bpp = 4 ;                          // bytes per pixel (RGBA)
 const int rowoff = (pmsize*bpp) ;            // row offset, in bytes
 const int ibufsize = (pmsize*pmsize*bpp) ;   // buffer size, in bytes
 static unsigned char ipixbuf[ibufsize] ;     // shared buffer for pixels
-static unsigned char *pixbuf = ipixbuf ;
+// the pixmap this thread is drawing into (ipixbuf or a chunk's)
+static thread_local unsigned char *pixbuf = ipixbuf ;
 
 // rowett: RGBA view of pixbuf
-static unsigned int *pixRGBAbuf = (unsigned int *)ipixbuf;
+static thread_local unsigned int *pixRGBAbuf = (unsigned int *)ipixbuf;
+
+// pixbuf holds one state byte per pixel rather than RGBA
+static bool statepix ;
+
+/*
+ *   As in hlifedraw.cpp, the screen is drawn in 256x256 chunks.  We
+ *   walk the tree down to the chunks that have something in them and
+ *   queue those, then a batch at a time draw the chunks into their own
+ *   pixmaps (using the job pool if we can; the tree doesn't change
+ *   while we draw) and hand them to the renderer in order.
+ */
+struct ghdrawchunk {
+   ghnode *q[4] ;       // the sw, se, nw and ne quadrants
+   ghnode *z ;          // the zero node at the quadrants' depth
+   int depth, half ;    // the quadrants' depth and size in pixels
+   int x, y ;           // lower left corner for blitbm
+} ;
+const int maxbatch = 32 ;                 // chunks drawn before blitting
+static vector<ghdrawchunk> chunks ;
+static int batchstart, batchend ;         // the chunks being drawn
+static vector<unsigned char> chunkpix ;   // ibufsize bytes per chunk
+
+static void queuechunk(ghnode *sw, ghnode *se, ghnode *nw, ghnode *ne,
+                       int depth, ghnode *z, int half, int x, int y) {
+   ghdrawchunk c ;
+   c.q[0] = sw ;
+   c.q[1] = se ;
+   c.q[2] = nw ;
+   c.q[3] = ne ;
+   c.z = z ;
+   c.depth = depth ;
+   c.half = half ;
+   c.x = x ;
+   c.y = y ;
+   chunks.push_back(c) ;
+}
 
 // AKT: arrays of RGB colors for each cell state (set by getcolors call)
 static unsigned char* cellred;
@@ -56,7 +93,7 @@ void ghashbase::draw4x4_1(state sw, state se, state nw, state ne,
                           int llx, int lly) {
    // sw,se,nw,ne contain cell states (0..255)
    int i = (pmsize-1+lly) * pmsize - llx;
-   if (renderer->justState() || pmag > 1) {
+   if (statepix) {
       // store state info
       pixbuf[i] = sw;
       pixbuf[i+1] = se;
@@ -102,7 +139,7 @@ void ghashbase::draw4x4_1(ghnode *n, ghnode *z, int llx, int lly) {
 
 // AKT: kill all cells in pixbuf
 void ghashbase::killpixels() {
-   if (renderer->justState() || pmag > 1) {
+   if (statepix) {
       // pixblit assumes pixbuf contains pmsize*pmsize bytes where each byte
       // is a cell state, so it's easy to kill all cells
       memset(pixbuf, 0, pmsize*pmsize);
@@ -111,7 +148,7 @@ void ghashbase::killpixels() {
       if (deada == 0) {
          // dead cells are 100% transparent so we can use fast method
          // (RGB values are irrelevant if alpha is 0)
-         memset(pixbuf, 0, sizeof(ipixbuf));
+         memset(pixbuf, 0, ibufsize);
       } else {
          // use slower method
          unsigned int deadRGBA = cellRGBA[0];
@@ -130,6 +167,11 @@ void ghashbase::killpixels() {
 }
 
 void ghashbase::renderbm(int x, int y) {
+   blitbm(x, y, pixbuf) ;
+   killpixels();
+}
+
+void ghashbase::blitbm(int x, int y, unsigned char *pix) {
    // x,y is lower left corner
    int rx = x ;
    int ry = y ;
@@ -143,10 +185,9 @@ void ghashbase::renderbm(int x, int y) {
    }
    ry = uviewh - ry - rh ;
    if (renderer->justState())
-      renderer->stateblit(rx, ry, rw, rh, pixbuf) ;
+      renderer->stateblit(rx, ry, rw, rh, pix) ;
    else
-      renderer->pixblit(rx, ry, rw, rh, pixbuf, pmag);
-   killpixels();
+      renderer->pixblit(rx, ry, rw, rh, pix, pmag);
 }
 
 /*
@@ -166,11 +207,7 @@ void ghashbase::drawghnode(ghnode *n, int llx, int lly, int depth, ghnode *z) {
       sw >>= 1 ;
       depth-- ;
       if (sw == (pmsize >> 1)) {
-         drawghnode(n->sw, 0, 0, depth, z) ;
-         drawghnode(n->se, -(pmsize/2), 0, depth, z) ;
-         drawghnode(n->nw, 0, -(pmsize/2), depth, z) ;
-         drawghnode(n->ne, -(pmsize/2), -(pmsize/2), depth, z) ;
-         renderbm(-llx, -lly) ;
+         queuechunk(n->sw, n->se, n->nw, n->ne, depth, z, pmsize/2, -llx, -lly) ;
       } else {
          drawghnode(n->sw, llx, lly, depth, z) ;
          drawghnode(n->se, llx-sw, lly, depth, z) ;
@@ -191,6 +228,47 @@ void ghashbase::drawghnode(ghnode *n, int llx, int lly, int depth, ghnode *z) {
       }
    }
 }
+/*
+ *   Draw every step'th chunk of the batch starting at first, each into
+ *   its own pixmap.
+ */
+void ghashbase::drawchunkrange(int first, int step) {
+   for (int i=batchstart+first; i<batchend; i+=step) {
+      ghdrawchunk &c = chunks[i] ;
+      pixbuf = &chunkpix[(size_t)(i - batchstart) * ibufsize] ;
+      pixRGBAbuf = (unsigned int *)pixbuf ;
+      killpixels() ;
+      drawghnode(c.q[0], 0, 0, c.depth, c.z) ;
+      drawghnode(c.q[1], -c.half, 0, c.depth, c.z) ;
+      drawghnode(c.q[2], 0, -c.half, c.depth, c.z) ;
+      drawghnode(c.q[3], -c.half, -c.half, c.depth, c.z) ;
+   }
+   pixbuf = ipixbuf ;
+   pixRGBAbuf = (unsigned int *)ipixbuf ;
+}
+
+void ghashbase::drawjob(void *arg, int i, int n) {
+   ((ghashbase *)arg)->drawchunkrange(i, n) ;
+}
+
+/*
+ *   Draw the queued chunks and pass them to the renderer.
+ */
+void ghashbase::drawchunks() {
+   int nchunks = (int)chunks.size() ;
+   int nbatch = min(nchunks, maxbatch) ;
+   if (chunkpix.size() < (size_t)nbatch * ibufsize)
+      chunkpix.resize((size_t)nbatch * ibufsize) ;
+   for (batchstart=0; batchstart<nchunks; batchstart=batchend) {
+      batchend = min(nchunks, batchstart + maxbatch) ;
+      int njobs = jobcount(batchend - batchstart, 2) ;
+      runjobs(drawjob, this, njobs) ;
+      for (int i=batchstart; i<batchend; i++)
+         blitbm(chunks[i].x, chunks[i].y,
+                &chunkpix[(size_t)(i - batchstart) * ibufsize]) ;
+   }
+   chunks.clear() ;
+}
 /*
  *   Fill in the llxb and llyb bits from the viewport information.
  *   Allocate if necessary.  This arithmetic should be done carefully.
@@ -281,6 +359,7 @@ void ghashbase::draw(viewport &viewarg, liferender &rendererarg) {
    }
 
    // AKT: must call killpixels after setting pmag
+   statepix = renderer->justState() || pmag > 1 ;
    killpixels();
 
    int d = depth ;
@@ -358,11 +437,7 @@ void ghashbase::draw(viewport &viewarg, liferender &rendererarg) {
       maxd = 1 << (d - mag + 2) ;
       if (maxd <= pmsize) {
          maxd >>= 1 ;
-         drawghnode(sw, 0, 0, d, z) ;
-         drawghnode(se, -maxd, 0, d, z) ;
-         drawghnode(nw, 0, -maxd, d, z) ;
-         drawghnode(ne, -maxd, -maxd, d, z) ;
-         renderbm(-llx, -lly) ;
+         queuechunk(sw, se, nw, ne, d, z, maxd, -llx, -lly) ;
       } else {
          maxd >>= 1 ;
          drawghnode(sw, llx, lly, d, z) ;
@@ -370,6 +445,7 @@ void ghashbase::draw(viewport &viewarg, liferender &rendererarg) {
          drawghnode(nw, llx, lly-maxd, d, z) ;
          drawghnode(ne, llx-maxd, lly-maxd, d, z) ;
       }
+      drawchunks() ;
    }
 bail:
    renderer = 0 ;
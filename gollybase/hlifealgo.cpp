@@ -116,6 +116,16 @@ g_uintptr_t node_hash(void *a, void *b, void *c, void *d) {
 }
 #endif
 #define leaf_hash(a,b,c,d) (65537*(d)+257*(c)+17*(b)+5*(a))
+/*
+ *   In adaptive mode we don't give up on the table when it can't grow;
+ *   we let it get twice as full and try again then (a gc may have
+ *   made room by then, and if not the load just keeps rising).
+ */
+g_uintptr_t hlifealgo::raisedhashlimit() {
+   if (hashlimit > G_MAX / 2)
+      return G_MAX ;
+   return 2 * hashlimit ;
+}
 /*
  *   Resize the hash.  The max load factor defined here does not actually
  *   yield the maximum load factor the hash will see, because when we
@@ -130,21 +140,26 @@ g_uintptr_t node_hash(void *a, void *b, void *c, void *d) {
  *   tweaked in the case where you absolutely want as many nodes as
  *   possible in memory, and are willing to use a large load factor to
  *   permit this; with the move-to-front heuristic, the code actually
- *   handles a large load factor fairly well.
+ *   handles a large load factor fairly well.  (The factor, and whether
+ *   we gc before resizing, are runtime settings; see lifealgo.h.)
  */
-double hlifealgo::maxloadfactor = 0.7 ;
 void hlifealgo::resize() {
-#ifndef NOGCBEFORERESIZE
-   if (okaytogc) {
+   if (gcbeforeresize && okaytogc) {
       do_gc(0) ; // faster resizes if we do a gc first
    }
-#endif
    g_uintptr_t i, nhashprime = nexthashsize(2 * hashprime) ;
    node *p, **nhashtab ;
    if (hashprime > (totalthings >> 2)) {
       if (alloced > maxmem ||
           nhashprime * sizeof(node *) > (maxmem - alloced)) {
-         hashlimit = G_MAX ;
+         hashlimit = adaptiveload ? raisedhashlimit() : G_MAX ;
+         return ;
+      }
+      // in adaptive mode, once the bigger table would take more than
+      // half of what memory remains, we'd rather have the nodes
+      if (adaptiveload &&
+          nhashprime * sizeof(node *) > ((maxmem - alloced) >> 1)) {
+         hashlimit = raisedhashlimit() ;
          return ;
       }
    }
@@ -152,8 +167,16 @@ void hlifealgo::resize() {
      sprintf(statusline, "Resizing hash to %" PRIuPTR "...", nhashprime) ;
      lifestatus(statusline) ;
    }
-   nhashtab = (node **)calloc(nhashprime, sizeof(node *)) ;
+   nhashtab = (node **)bigalloc(nhashprime * sizeof(node *), allocmode) ;
    if (nhashtab == 0) {
+     if (adaptiveload) {
+       hashlimit = raisedhashlimit() ;
+       if (verbose) {
+         strcpy(statusline+strlen(statusline), " no memory; load raised.") ;
+         lifestatus(statusline) ;
+       }
+       return ;
+     }
      lifewarning("Out of memory; running in a somewhat slower mode; "
                  "try reducing the hash memory limit after restarting.") ;
      hashlimit = G_MAX ;
@@ -181,7 +204,7 @@ void hlifealgo::resize() {
          p = np ;
       }
    }
-   free(hashtab) ;
+   bigfree(hashtab, ohashprime * sizeof(node *), allocmode) ;
    hashtab = nhashtab ;
    hashlimit = (g_uintptr_t)(maxloadfactor * hashprime) ;
    if (verbose) {
@@ -526,25 +549,37 @@ leaf *hlifealgo::dorecurs_leaf_quarter(leaf *n, leaf *ne,
 }
 /*
  *   We keep free nodes in a linked list for allocation, and we allocate
- *   them 1000 at a time.
+ *   them 1000 at a time.  In the huge page modes, once a universe has
+ *   used HUGEBLOCKS_AFTER bytes we switch to a huge page's worth at a
+ *   time, so small universes (scratch ones, patterns held by scripts)
+ *   don't each tie up a huge page.  The first node of each block links
+ *   the blocks and keeps the block's size in res.
  */
+const g_uintptr_t HUGEBLOCKS_AFTER = 64 << 20 ;
+static inline int blocksize(node *block) {
+   return (int)(g_uintptr_t)block->res ;
+}
 node *hlifealgo::newnode() {
    node *r ;
    if (freenodes == 0) {
       int i ;
-      freenodes = (node *)calloc(1001, sizeof(node)) ;
+      if (allocmode != BIGALLOC_PLAIN && alloced >= HUGEBLOCKS_AFTER)
+         blocknodes = (int)(BIGALLOC_HUGEPAGE / sizeof(node)) ;
+      freenodes = (node *)bigalloc(blocknodes * sizeof(node), allocmode) ;
       if (freenodes == 0)
          lifefatal("Out of memory; try reducing the hash memory limit.") ;
-      alloced += 1001 * sizeof(node) ;
+      alloced += blocknodes * sizeof(node) ;
       freenodes->next = nodeblocks ;
+      freenodes->res = (node *)(g_uintptr_t)blocknodes ;
       nodeblocks = freenodes++ ;
-      for (i=0; i<999; i++) {
+      for (i=0; i<blocknodes-2; i++) {
          freenodes[1].next = freenodes ;
          freenodes++ ;
       }
-      totalthings += 1000 ;
+      totalthings += blocknodes - 1 ;
    }
-   if (freenodes->next == 0 && alloced + 1000 * sizeof(node) > maxmem &&
+   if (freenodes->next == 0 &&
+       alloced + (blocknodes - 1) * sizeof(node) > maxmem &&
        okaytogc) {
       do_gc(0) ;
    }
@@ -589,10 +624,15 @@ hlifealgo::hlifealgo() {
 #endif
    hashlimit = (g_uintptr_t)(maxloadfactor * hashprime) ;
    hashpop = 0 ;
-   hashtab = (node **)calloc(hashprime, sizeof(node *)) ;
+   allocmode = getbigallocmode() ;
+   blocknodes = 1001 ;
+   hashtab = (node **)bigalloc(hashprime * sizeof(node *), allocmode) ;
    if (hashtab == 0)
      lifefatal("Out of memory (1).") ;
    alloced = hashprime * sizeof(node *) ;
+   hashmemo.setcounter(&alloced) ;
+   summarymemo.setcounter(&alloced) ;
+   drawmemo.setcounter(&alloced) ;
    ngens = 0 ;
    stacksize = 0 ;
    halvesdone = 0 ;
@@ -624,7 +664,11 @@ hlifealgo::hlifealgo() {
    needPop = 0 ;
    inGC = 0 ;
    cacheinvalid = 0 ;
+   drawmemomag = -1 ;
    gccount = 0 ;
+   gclive = 0 ;
+   editmemo = 0 ;
+   overlaymemo = 0 ;
    gcstep = 0 ;
    running_hperf.clear() ;
    inc_hperf = running_hperf ;
@@ -635,11 +679,11 @@ hlifealgo::hlifealgo() {
  *   Destructor frees memory.
  */
 hlifealgo::~hlifealgo() {
-   free(hashtab) ;
+   bigfree(hashtab, hashprime * sizeof(node *), allocmode) ;
    while (nodeblocks) {
       node *r = nodeblocks ;
       nodeblocks = nodeblocks->next ;
-      free(r) ;
+      bigfree(r, blocksize(r) * sizeof(node), allocmode) ;
    }
    if (zeronodea)
       free(zeronodea) ;
@@ -710,12 +754,21 @@ void hlifealgo::step() {
    }
 }
 void hlifealgo::setcurrentstate(void *n) {
+   ensure_hashed() ;
    if (root != (node *)n) {
       root = (node *)n ;
       depth = node_depth(root) ;
       popValid = 0 ;
    }
 }
+/*
+ *   Kept states are only worth it if they'll mostly share nodes with
+ *   the live pattern; once the nodes surviving a gc fill half of our
+ *   memory we tell the caller to save the pattern elsewhere.
+ */
+int hlifealgo::cankeepstate() {
+   return gccount == 0 || 2 * gclive * sizeof(node) <= maxmem ;
+}
 /*
  *   Set the max memory
  */
@@ -735,10 +788,22 @@ void hlifealgo::setMaxMemory(int newmemlimit) {
    hashlimit = (g_uintptr_t)(maxloadfactor * hashprime) ;
 }
 /**
- *   Clear everything.
+ *   Clear everything.  The hash table keeps all its nodes (so results
+ *   computed for earlier patterns can be found again); we just go back to
+ *   the empty pattern at generation 0 and let the next gc collect any
+ *   nodes nothing uses any more.
  */
 void hlifealgo::clearall() {
-   lifefatal("clearall not implemented yet") ;
+   poller->bailIfCalculating() ;
+   ensure_hashed() ;
+   clearstack() ;
+   depth = 3 ;
+   root = zeronode(depth) ;
+   generation = 0 ;
+   population = 0 ;
+   popValid = 1 ;
+   needPop = 0 ;
+   clipped_cells.clear() ;
 }
 /*
  *   This routine expands our universe by a factor of two, maintaining
@@ -1353,9 +1418,142 @@ void hlifealgo::calcPopulation() {
    int depth ;
    ensure_hashed() ;
    depth = node_depth(root) ;
+   nodesummary s = summarize(root, depth) ;
+   if (s.pop >= 0) {
+      population = bigint(s.pop) ;
+      return ;
+   }
    population = calcpop(root, depth) ;
    aftercalcpop2(root, depth) ;
 }
+/*
+ *   Get the summary of a node, using the summaries of its children.
+ *   Leaves are cheap enough to summarize that we don't bother keeping
+ *   them.
+ */
+static const G_INT64 maxsummarypop = G_MAKEINT64(1) << 61 ;
+nodesummary hlifealgo::summarize(node *n, int depth) {
+   nodesummary s ;
+   s.pop = 0 ;
+   s.minx = s.miny = s.maxx = s.maxy = 0 ;
+   if (n == zeronode(depth))
+      return s ;
+   if (depth == 2) {
+      leaf *l = (leaf *)n ;
+      unsigned short q[4] = { l->nw, l->ne, l->sw, l->se } ;
+      s.minx = s.miny = 8 ;
+      s.maxx = s.maxy = -1 ;
+      for (int i=0; i<4; i++) {
+         for (int b=0; q[i]; b++, q[i] <<= 1) {
+            if (q[i] & 0x8000) {
+               int x = ((i & 1) << 2) + (b & 3) ;
+               int y = ((i & 2) << 1) + (b >> 2) ;
+               s.pop++ ;
+               if (x < s.minx) s.minx = x ;
+               if (x > s.maxx) s.maxx = x ;
+               if (y < s.miny) s.miny = y ;
+               if (y > s.maxy) s.maxy = y ;
+            }
+         }
+      }
+      return s ;
+   }
+   nodesummary *m = summarymemo.lookup(n) ;
+   if (m)
+      return *m ;
+   node *kids[4] = { n->nw, n->ne, n->sw, n->se } ;
+   // the box coordinates must fit comfortably in 64 bits
+   int boxok = (depth <= 60) ;
+   G_INT64 half = boxok ? (G_MAKEINT64(1) << depth) : 0 ;
+   int first = 1 ;
+   for (int i=0; i<4; i++) {
+      nodesummary k = summarize(kids[i], depth-1) ;
+      if (k.pop == 0)
+         continue ;
+      if (k.pop < 0 || s.pop < 0 || s.pop + k.pop >= maxsummarypop)
+         s.pop = -1 ;
+      else
+         s.pop += k.pop ;
+      if (!boxok || k.minx < 0) {
+         boxok = 0 ;
+         continue ;
+      }
+      G_INT64 dx = (i & 1) ? half : 0 ;
+      G_INT64 dy = (i & 2) ? half : 0 ;
+      if (first || k.minx + dx < s.minx) s.minx = k.minx + dx ;
+      if (first || k.maxx + dx > s.maxx) s.maxx = k.maxx + dx ;
+      if (first || k.miny + dy < s.miny) s.miny = k.miny + dy ;
+      if (first || k.maxy + dy > s.maxy) s.maxy = k.maxy + dy ;
+      first = 0 ;
+   }
+   if (!boxok)
+      s.minx = -1 ;
+   summarymemo.insert(n, s) ;
+   return s ;
+}
+/*
+ *   The pattern hash of a node relative to its upper left corner,
+ *   memoized in a side table since nodes never change.  The children
+ *   of a node at a given depth are 2^depth cells on a side.
+ */
+static phash leafweight[8][8] ;
+phash hlifealgo::nodehash(node *n, int depth) {
+   if (n == zeronode(depth))
+      return 0 ;
+   phash *m = hashmemo.lookup(n) ;
+   if (m)
+      return *m ;
+   phash h = 0 ;
+   if (depth == 2) {
+      if (leafweight[0][0] == 0)
+         for (int y=0; y<8; y++)
+            for (int x=0; x<8; x++)
+               leafweight[y][x] = patternhash::mul(
+                                     patternhash::pow(patternhash::X, x),
+                                     patternhash::pow(patternhash::Y, y)) ;
+      leaf *l = (leaf *)n ;
+      unsigned short q[4] = { l->nw, l->ne, l->sw, l->se } ;
+      for (int i=0; i<4; i++)
+         for (int b=0; q[i]; b++, q[i] <<= 1)
+            if (q[i] & 0x8000)
+               h = patternhash::add(h,
+                      leafweight[((i & 2) << 1) + (b >> 2)][((i & 1) << 2) + (b & 3)]) ;
+   } else {
+      phash xs = patternhash::xpow2(depth) ;
+      phash ys = patternhash::ypow2(depth) ;
+      depth-- ;
+      phash top = patternhash::add(nodehash(n->nw, depth),
+                     patternhash::mul(xs, nodehash(n->ne, depth))) ;
+      phash bot = patternhash::add(nodehash(n->sw, depth),
+                     patternhash::mul(xs, nodehash(n->se, depth))) ;
+      h = patternhash::add(top, patternhash::mul(ys, bot)) ;
+   }
+   hashmemo.insert(n, h) ;
+   return h ;
+}
+/*
+ *   Only the nodes created since the last call need to be hashed, then
+ *   we move the origin from the root's corner to the bounding box.
+ */
+int hlifealgo::gethash() {
+   ensure_hashed() ;
+   if (root == zeronode(depth))
+      return patternhash::fold(0) ;
+   bigint top, left, bottom, right ;
+   findedges(&top, &left, &bottom, &right) ;
+   // the upper left corner of the root is at (-2^depth, 1-2^depth)
+   bigint half = 1 ;
+   half.mulpow2(depth) ;
+   bigint ex = 0, ey = 1 ;
+   ex -= half ;
+   ex -= left ;
+   ey -= half ;
+   ey -= top ;
+   phash h = nodehash(root, depth) ;
+   h = patternhash::mul(h, patternhash::pow(patternhash::X, ex)) ;
+   h = patternhash::mul(h, patternhash::pow(patternhash::Y, ey)) ;
+   return patternhash::fold(h) ;
+}
 /*
  *   Is the universe empty?
  */
@@ -1414,6 +1612,12 @@ void hlifealgo::gc_mark(node *root, int invalidate) {
       }
    }
 }
+/*
+ *   The side tables only keep the nodes that survive a gc.
+ */
+static int gcmarked(const void *n) {
+   return marked((const node *)n) ;
+}
 /**
  *   If the invalidate flag is set, we want to kill *all* cache entries
  *   and recalculate all leaves.
@@ -1445,12 +1649,26 @@ void hlifealgo::do_gc(int invalidate) {
    }
    for (i=0; i<timeline.framecount; i++)
       gc_mark((node *)timeline.frames[i], invalidate) ;
+   vector<void *> kept = getkeptstates() ;
+   for (i=0; i<(int)kept.size(); i++)
+      gc_mark((node *)kept[i], invalidate) ;
+   if (alloced > maxmem) {
+      // the side tables are only caches, so give their memory back
+      // rather than keep growing past the limit
+      hashmemo.release() ;
+      summarymemo.release() ;
+      drawmemo.release() ;
+   } else {
+      hashmemo.retain(gcmarked) ;
+      summarymemo.retain(gcmarked) ;
+      drawmemo.retain(gcmarked) ;
+   }
    hashpop = 0 ;
    memset(hashtab, 0, sizeof(node *) * hashprime) ;
    freenodes = 0 ;
    for (p=nodeblocks; p; p=p->next) {
       poller->poll() ;
-      for (pp=p+1, i=1; i<1001; i++, pp++) {
+      for (pp=p+1, i=1; i<blocksize(p); i++, pp++) {
          if (marked(pp)) {
             g_uintptr_t h = 0 ;
             if (pp->nw) { /* yes, it's a node */
@@ -1471,11 +1689,15 @@ void hlifealgo::do_gc(int invalidate) {
          }
       }
    }
+   gclive = hashpop ;
+   if (kept.size() > 0 && !cankeepstate())
+      keptoverbudget = 1 ;
    inGC = 0 ;
    if (verbose) {
      double perc = (double)freed_nodes / (double)totalthings * 100.0 ;
      sprintf(statusline+strlen(statusline), " freed %g percent (%" PRIuPTR ").",
                                                    perc, freed_nodes) ;
+     strcpy(statusline+strlen(statusline), bigallocstats(1)) ;
      lifestatus(statusline) ;
    }
    if (needPop) {
@@ -1546,7 +1768,7 @@ void hlifealgo::new_ngens(int newval) {
             clearcache(p, node_depth(p), clearto) ;
    for (p=nodeblocks; p; p=p->next) {
       poller->poll() ;
-      for (pp=p+1, i=1; i<1001; i++, pp++)
+      for (pp=p+1, i=1; i<(g_uintptr_t)blocksize(p); i++, pp++)
          clearmark(pp) ;
    }
    halvesdone = 0 ;
@@ -1768,13 +1990,20 @@ default:       return "Illegal character in readmacrocell." ;
                   timeline.expo = texpo ;
                }
 	    } else if (strncmp(line, "#FRAME ", 7) == 0) {
-	       int frameind = 0 ;
+	       // a thinned timeline also gives each frame's generation
+	       int frameind = 0, genpos = 0 ;
 	       g_uintptr_t nodeind = 0 ;
-	       n = sscanf(line+7, "%d %" PRIuPTR, &frameind, &nodeind) ;
+	       n = sscanf(line+7, "%d %" PRIuPTR "%n", &frameind, &nodeind, &genpos) ;
 	       if (n != 2 || frameind > MAX_FRAME_COUNT || frameind < 0 ||
 		   nodeind > i || timeline.framecount != frameind)
 		  return "Bad FRAME line" ;
 	       timeline.frames.push_back(make_internal_node(ind[nodeind])) ;
+	       p = line + 7 + genpos ;
+	       while (*p && *p <= ' ')
+		 p++ ;
+	       if ('0' <= *p && *p <= '9')
+		  timeline.next = bigint(p) ;
+	       timeline.gens.push_back(timeline.next) ;
 	       timeline.framecount++ ;
 	       timeline.end = timeline.next ;
 	       timeline.next += timeline.inc ;
@@ -2118,10 +2347,16 @@ const char *hlifealgo::writeNativeFormat(std::ostream &os, char *comments) {
          << ' ' << timeline.framecount
          << ' ' << timeline.start.tostring()
          << ' ' << timeline.base << '^' << timeline.expo << '\n' ;
+     bigint uniformgen = timeline.start ;
      for (int i=0; i<timeline.framecount; i++) {
        node *frame = (node*)timeline.frames[i] ;
        writecell_2p2(os, frame, depths[i]) ;
-       os << "#FRAME " << i << ' ' << (g_uintptr_t)frame->next << '\n' ;
+       os << "#FRAME " << i << ' ' << (g_uintptr_t)frame->next ;
+       // only thinned timelines need each frame's generation
+       if (timeline.gens[i] != uniformgen)
+          os << ' ' << timeline.gens[i].tostring() ;
+       os << '\n' ;
+       uniformgen += timeline.inc ;
      }
    }
    writecell_2p2(os, root, depth) ;
@@ -2136,6 +2371,617 @@ const char *hlifealgo::writeNativeFormat(std::ostream &os, char *comments) {
    inGC = 0 ;
    return 0 ;
 }
+/*
+ *   Rectangle editing.  Everything here works on the hashed tree one
+ *   subtree at a time and memoizes what it does to each node, so a
+ *   rectangle full of repeated structure costs about as much as the
+ *   distinct nodes along its edges rather than its area.  We never gc
+ *   in the middle of an edit (okaytogc is off), so the memo tables can
+ *   hold plain node pointers.
+ *
+ *   Within a leaf we number the cells from the lower left, so cell
+ *   (x, y) is bit 8*y+x of a 64-bit word.
+ */
+static unsigned long long leafcells(leaf *l) {
+   unsigned short q[4] = { l->sw, l->se, l->nw, l->ne } ;
+   unsigned long long r = 0 ;
+   for (int k=0; k<4; k++)
+      for (int y=0; y<4; y++)
+         for (int x=0; x<4; x++)
+            if (q[k] & (1 << (3 - x + 4 * y)))
+               r |= 1ULL << (8 * (y + 4 * (k >> 1)) + x + 4 * (k & 1)) ;
+   return r ;
+}
+node *hlifealgo::leafofcells(unsigned long long cells) {
+   unsigned short q[4] = { 0, 0, 0, 0 } ;
+   for (int k=0; k<4; k++)
+      for (int y=0; y<4; y++)
+         for (int x=0; x<4; x++)
+            if ((cells >> (8 * (y + 4 * (k >> 1)) + x + 4 * (k & 1))) & 1)
+               q[k] |= 1 << (3 - x + 4 * y) ;
+   return (node *)find_leaf(q[2], q[3], q[0], q[1]) ;
+}
+/*
+ *   The width of a node at the given depth.
+ */
+const bigint &hlifealgo::nodesize(int depth) {
+   while ((int)editsizes.size() <= depth) {
+      bigint s = 1 ;
+      s.mulpow2((int)editsizes.size() + 1) ;
+      editsizes.push_back(s) ;
+   }
+   return editsizes[depth] ;
+}
+/*
+ *   Grow a tree to the given depth, keeping it centered.
+ */
+node *hlifealgo::padnode(node *n, int depth, int newdepth) {
+   while (depth < newdepth) {
+      n = pushroot(n) ;
+      depth++ ;
+   }
+   return n ;
+}
+void hlifealgo::setcliprect(const bigint &top, const bigint &left,
+                            const bigint &bottom, const bigint &right) {
+   clipl = left ;
+   clipr = right ;
+   clipr += bigint::one ;
+   clipb = bigint::zero ;
+   clipb -= bottom ;
+   clipt = bigint::one ;
+   clipt -= top ;
+}
+/*
+ *   The cells of a leaf (at x, y) inside the clip rectangle, given
+ *   which edges cut it.
+ */
+unsigned long long hlifealgo::clipmask(int cut, const bigint &x,
+                                       const bigint &y) {
+   int lx = 0, hx = 8, ly = 0, hy = 8 ;
+   bigint t ;
+   if (cut & 1) {
+      t = clipl ;
+      t -= x ;
+      lx = t.toint() ;
+   }
+   if (cut & 2) {
+      t = clipr ;
+      t -= x ;
+      hx = t.toint() ;
+   }
+   if (cut & 4) {
+      t = clipb ;
+      t -= y ;
+      ly = t.toint() ;
+   }
+   if (cut & 8) {
+      t = clipt ;
+      t -= y ;
+      hy = t.toint() ;
+   }
+   unsigned long long mask = 0 ;
+   for (int j=ly; j<hy; j++)
+      for (int i=lx; i<hx; i++)
+         mask |= 1ULL << (8 * j + i) ;
+   return mask ;
+}
+/*
+ *   Keep only the cells inside (or outside) the clip rectangle; x and y
+ *   are the lower left corner of the node.  A node that an edge cuts
+ *   through always meets it at the same offset (nodes are aligned to
+ *   their size), so which edges cut it is all the memo key needs.
+ */
+node *hlifealgo::clipnode(node *n, int depth, const bigint &x,
+                          const bigint &y, int inside) {
+   node *z = zeronode(depth) ;
+   if (n == z)
+      return n ;
+   const bigint &s = nodesize(depth) ;
+   bigint x1 = x ;
+   x1 += s ;
+   bigint y1 = y ;
+   y1 += s ;
+   if (x1 <= clipl || x >= clipr || y1 <= clipb || y >= clipt)
+      return inside ? z : n ;
+   int cut = (x < clipl) | ((x1 > clipr) << 1) |
+             ((y < clipb) << 2) | ((y1 > clipt) << 3) ;
+   if (cut == 0)
+      return inside ? n : z ;
+   node **m = editmemo[cut].lookup(n) ;
+   if (m)
+      return *m ;
+   node *r ;
+   if (depth == 2) {
+      unsigned long long mask = clipmask(cut, x, y) ;
+      if (!inside)
+         mask = ~mask ;
+      r = leafofcells(leafcells((leaf *)n) & mask) ;
+   } else {
+      const bigint &h = nodesize(depth-1) ;
+      bigint xh = x ;
+      xh += h ;
+      bigint yh = y ;
+      yh += h ;
+      r = find_node(clipnode(n->nw, depth-1, x, yh, inside),
+                    clipnode(n->ne, depth-1, xh, yh, inside),
+                    clipnode(n->sw, depth-1, x, y, inside),
+                    clipnode(n->se, depth-1, xh, y, inside)) ;
+   }
+   editmemo[cut].insert(n, r) ;
+   return r ;
+}
+node *hlifealgo::cliproot(node *n, int depth, int inside) {
+   for (int i=0; i<16; i++)
+      editmemo[i].clear() ;
+   nodesize(depth) ;
+   bigint x = bigint::zero ;
+   x -= nodesize(depth-1) ;
+   return clipnode(n, depth, x, x, inside) ;
+}
+/*
+ *   Flip or rotate a whole tree about its center.
+ */
+node *hlifealgo::transformnode(node *n, int depth, TRectOp op) {
+   if (op == MOVE_ONLY || n == zeronode(depth))
+      return n ;
+   node **m = editmemo[0].lookup(n) ;
+   if (m)
+      return *m ;
+   node *r = 0 ;
+   if (depth == 2) {
+      unsigned long long c = leafcells((leaf *)n), t = 0 ;
+      for (int y=0; y<8; y++)
+         for (int x=0; x<8; x++)
+            if ((c >> (8 * y + x)) & 1) {
+               int nx = x, ny = y ;
+               switch (op) {
+                  case FLIP_TOP_BOTTOM: ny = 7 - y ; break ;
+                  case FLIP_LEFT_RIGHT: nx = 7 - x ; break ;
+                  case ROTATE_CW: nx = y ; ny = 7 - x ; break ;
+                  case ROTATE_ACW: nx = 7 - y ; ny = x ; break ;
+                  case MOVE_ONLY: break ;
+               }
+               t |= 1ULL << (8 * ny + nx) ;
+            }
+      r = leafofcells(t) ;
+   } else {
+      node *nw = transformnode(n->nw, depth-1, op) ;
+      node *ne = transformnode(n->ne, depth-1, op) ;
+      node *sw = transformnode(n->sw, depth-1, op) ;
+      node *se = transformnode(n->se, depth-1, op) ;
+      switch (op) {
+         case FLIP_TOP_BOTTOM: r = find_node(sw, se, nw, ne) ; break ;
+         case FLIP_LEFT_RIGHT: r = find_node(ne, nw, se, sw) ; break ;
+         case ROTATE_CW: r = find_node(sw, nw, se, ne) ; break ;
+         case ROTATE_ACW: r = find_node(ne, se, nw, sw) ; break ;
+         case MOVE_ONLY: r = n ; break ;
+      }
+   }
+   editmemo[0].insert(n, r) ;
+   return r ;
+}
+/*
+ *   Return the node half the size of n whose lower left corner is at
+ *   the offset in shiftxbits and shiftybits from n's lower left corner.
+ *   Only the low depth bits of the offset matter at each depth, so the
+ *   result depends on n alone.
+ */
+node *hlifealgo::windownode(node *n, int depth) {
+   if (n == zeronode(depth))
+      return zeronode(depth-1) ;
+   node **m = editmemo[0].lookup(n) ;
+   if (m)
+      return *m ;
+   node *r ;
+   if (depth == 3) {
+      int ox = shiftxbits[0] | (shiftxbits[1] << 1) | (shiftxbits[2] << 2) ;
+      int oy = shiftybits[0] | (shiftybits[1] << 1) | (shiftybits[2] << 2) ;
+      unsigned long long q[4] = { leafcells((leaf *)n->sw),
+                                  leafcells((leaf *)n->se),
+                                  leafcells((leaf *)n->nw),
+                                  leafcells((leaf *)n->ne) } ;
+      unsigned long long t = 0 ;
+      for (int y=0; y<8; y++)
+         for (int x=0; x<8; x++) {
+            int sx = x + ox ;
+            int sy = y + oy ;
+            if ((q[(sx >> 3) + 2 * (sy >> 3)] >> (8 * (sy & 7) + (sx & 7))) & 1)
+               t |= 1ULL << (8 * y + x) ;
+         }
+      r = leafofcells(t) ;
+   } else {
+      node *g[4][4] ;
+      node *c[4] = { n->sw, n->se, n->nw, n->ne } ;
+      for (int k=0; k<4; k++) {
+         int x = 2 * (k & 1) ;
+         int y = 2 * (k >> 1) ;
+         g[x][y] = c[k]->sw ;
+         g[x+1][y] = c[k]->se ;
+         g[x][y+1] = c[k]->nw ;
+         g[x+1][y+1] = c[k]->ne ;
+      }
+      int gx = shiftxbits[depth-1] ;
+      int gy = shiftybits[depth-1] ;
+      node *w[2][2] ;
+      for (int i=0; i<2; i++)
+         for (int j=0; j<2; j++) {
+            int x = gx + i ;
+            int y = gy + j ;
+            w[i][j] = windownode(find_node(g[x][y+1], g[x+1][y+1],
+                                           g[x][y], g[x+1][y]), depth-1) ;
+         }
+      r = find_node(w[0][1], w[1][1], w[0][0], w[1][0]) ;
+   }
+   editmemo[0].insert(n, r) ;
+   return r ;
+}
+/*
+ *   Move a whole tree by dx,dy, returning a tree deep enough to hold
+ *   the result.
+ */
+node *hlifealgo::shiftnode(node *n, int depth, const bigint &dx,
+                           const bigint &dy, int &newdepth) {
+   bigint m = dx ;
+   if (m.sign() < 0) {
+      m = bigint::zero ;
+      m -= dx ;
+   }
+   bigint my = dy ;
+   if (my.sign() < 0) {
+      my = bigint::zero ;
+      my -= dy ;
+   }
+   if (my > m)
+      m = my ;
+   m += nodesize(depth-1) ;
+   // the moved tree must fit in the result with a cell to spare, so
+   // the window we cut out of the padded tree never touches its edge
+   int nd = depth ;
+   while (nodesize(nd-1) <= m)
+      nd++ ;
+   n = padnode(n, depth, nd+1) ;
+   bigint ox = nodesize(nd-1) ;
+   ox -= dx ;
+   bigint oy = nodesize(nd-1) ;
+   oy -= dy ;
+   shiftxbits.resize(nd+1) ;
+   shiftybits.resize(nd+1) ;
+   ox.tochararr(&shiftxbits[0], nd+1) ;
+   oy.tochararr(&shiftybits[0], nd+1) ;
+   editmemo[0].clear() ;
+   newdepth = nd ;
+   return windownode(n, nd+1) ;
+}
+/*
+ *   Combine two trees of the same depth, keeping the live cells of both.
+ *   The memo only remembers the last b each a was combined with, which
+ *   is nearly always enough since b is usually empty where a isn't.
+ */
+node *hlifealgo::overlaynode(node *a, node *b, int depth) {
+   node *z = zeronode(depth) ;
+   if (b == z || a == b)
+      return a ;
+   if (a == z)
+      return b ;
+   nodepair *m = overlaymemo->lookup(a) ;
+   if (m && m->b == b)
+      return m->r ;
+   node *r ;
+   if (depth == 2) {
+      leaf *la = (leaf *)a ;
+      leaf *lb = (leaf *)b ;
+      r = (node *)find_leaf(la->nw | lb->nw, la->ne | lb->ne,
+                            la->sw | lb->sw, la->se | lb->se) ;
+   } else {
+      r = find_node(overlaynode(a->nw, b->nw, depth-1),
+                    overlaynode(a->ne, b->ne, depth-1),
+                    overlaynode(a->sw, b->sw, depth-1),
+                    overlaynode(a->se, b->se, depth-1)) ;
+   }
+   nodepair p ;
+   p.b = b ;
+   p.r = r ;
+   overlaymemo->insert(a, p) ;
+   return r ;
+}
+/*
+ *   Combine two trees of the same depth cell by cell; like overlaynode
+ *   this only remembers the last b each a was combined with.
+ */
+node *hlifealgo::combinenode(node *a, node *b, int depth, TCombineOp op) {
+   node *z = zeronode(depth) ;
+   if (a == z)
+      return op == COMBINE_XOR || op == COMBINE_OR ? b : z ;
+   if (b == z)
+      return op == COMBINE_AND ? z : a ;
+   if (a == b)
+      return op == COMBINE_AND || op == COMBINE_OR ? a : z ;
+   nodepair *m = overlaymemo->lookup(a) ;
+   if (m && m->b == b)
+      return m->r ;
+   node *r ;
+   if (depth == 2) {
+      unsigned long long ca = leafcells((leaf *)a) ;
+      unsigned long long cb = leafcells((leaf *)b) ;
+      switch (op) {
+         case COMBINE_AND: ca &= cb ; break ;
+         case COMBINE_XOR: ca ^= cb ; break ;
+         case COMBINE_SUBTRACT: ca &= ~cb ; break ;
+         case COMBINE_OR: ca |= cb ; break ;
+      }
+      r = leafofcells(ca) ;
+   } else {
+      r = find_node(combinenode(a->nw, b->nw, depth-1, op),
+                    combinenode(a->ne, b->ne, depth-1, op),
+                    combinenode(a->sw, b->sw, depth-1, op),
+                    combinenode(a->se, b->se, depth-1, op)) ;
+   }
+   nodepair p ;
+   p.b = b ;
+   p.r = r ;
+   overlaymemo->insert(a, p) ;
+   return r ;
+}
+/*
+ *   Copy a tree from another universe into our hash table.
+ */
+node *hlifealgo::importnode(node *n, int depth) {
+   node **m = editmemo[0].lookup(n) ;
+   if (m)
+      return *m ;
+   node *r ;
+   if (depth == 2) {
+      leaf *l = (leaf *)n ;
+      r = (node *)find_leaf(l->nw, l->ne, l->sw, l->se) ;
+   } else {
+      r = find_node(importnode(n->nw, depth-1), importnode(n->ne, depth-1),
+                    importnode(n->sw, depth-1), importnode(n->se, depth-1)) ;
+   }
+   editmemo[0].insert(n, r) ;
+   return r ;
+}
+/*
+ *   Copy just the part of another universe's tree that lies inside the
+ *   clip rectangle into our hash table, like clipnode with inside set.
+ *   Subtrees outside the rectangle are never visited, so the cost
+ *   depends on the rectangle, not on the size of the source pattern.
+ */
+node *hlifealgo::importclipnode(node *n, int depth, const bigint &x,
+                                const bigint &y) {
+   const bigint &s = nodesize(depth) ;
+   bigint x1 = x ;
+   x1 += s ;
+   bigint y1 = y ;
+   y1 += s ;
+   if (x1 <= clipl || x >= clipr || y1 <= clipb || y >= clipt)
+      return zeronode(depth) ;
+   int cut = (x < clipl) | ((x1 > clipr) << 1) |
+             ((y < clipb) << 2) | ((y1 > clipt) << 3) ;
+   if (cut == 0)
+      return importnode(n, depth) ;
+   node **m = editmemo[cut].lookup(n) ;
+   if (m)
+      return *m ;
+   node *r ;
+   if (depth == 2) {
+      r = leafofcells(leafcells((leaf *)n) & clipmask(cut, x, y)) ;
+   } else {
+      const bigint &h = nodesize(depth-1) ;
+      bigint xh = x ;
+      xh += h ;
+      bigint yh = y ;
+      yh += h ;
+      r = find_node(importclipnode(n->nw, depth-1, x, yh),
+                    importclipnode(n->ne, depth-1, xh, yh),
+                    importclipnode(n->sw, depth-1, x, y),
+                    importclipnode(n->se, depth-1, xh, y)) ;
+   }
+   editmemo[cut].insert(n, r) ;
+   return r ;
+}
+/*
+ *   Make the combination of the two trees our new pattern.
+ */
+void hlifealgo::seteditroot(node *rest, int restdepth, node *sel,
+                            int seldepth) {
+   nodememo<nodepair> memo ;
+   overlaymemo = &memo ;
+   int d = restdepth > seldepth ? restdepth : seldepth ;
+   node *r = overlaynode(padnode(rest, restdepth, d),
+                         padnode(sel, seldepth, d), d) ;
+   overlaymemo = 0 ;
+   root = popzeros(r) ;
+   depth = node_depth(root) ;
+   popValid = 0 ;
+}
+int hlifealgo::transformrect(TRectOp op, const bigint &top,
+                             const bigint &left, const bigint &bottom,
+                             const bigint &right, const bigint &newtop,
+                             const bigint &newleft) {
+   ensure_hashed() ;
+   nodememo<node *> memos[16] ;
+   editmemo = memos ;
+   setcliprect(top, left, bottom, right) ;
+   node *sel = cliproot(root, depth, 1) ;
+   node *rest = cliproot(root, depth, 0) ;
+   editmemo[0].clear() ;
+   sel = transformnode(sel, depth, op) ;
+   // find where the rectangle's lower left corner went, and how big
+   // the new rectangle is
+   bigint tx, ty ;
+   bigint wd = clipr ;
+   wd -= clipl ;
+   bigint ht = clipt ;
+   ht -= clipb ;
+   switch (op) {
+      case FLIP_TOP_BOTTOM:
+         tx = clipl ;
+         ty = bigint::zero ;
+         ty -= clipt ;
+         break ;
+      case FLIP_LEFT_RIGHT:
+         tx = bigint::zero ;
+         tx -= clipr ;
+         ty = clipb ;
+         break ;
+      case ROTATE_CW:
+         tx = clipb ;
+         ty = bigint::zero ;
+         ty -= clipr ;
+         break ;
+      case ROTATE_ACW:
+         tx = bigint::zero ;
+         tx -= clipt ;
+         ty = clipl ;
+         break ;
+      case MOVE_ONLY:
+         tx = clipl ;
+         ty = clipb ;
+         break ;
+   }
+   if (op == ROTATE_CW || op == ROTATE_ACW) {
+      bigint t = wd ;
+      wd = ht ;
+      ht = t ;
+   }
+   bigint newbottom = newtop ;
+   newbottom += ht ;
+   newbottom -= bigint::one ;
+   bigint newright = newleft ;
+   newright += wd ;
+   newright -= bigint::one ;
+   setcliprect(newtop, newleft, newbottom, newright) ;
+   bigint dx = clipl ;
+   dx -= tx ;
+   bigint dy = clipb ;
+   dy -= ty ;
+   int seldepth ;
+   sel = shiftnode(sel, depth, dx, dy, seldepth) ;
+   rest = cliproot(rest, depth, 0) ;
+   seteditroot(rest, depth, sel, seldepth) ;
+   editmemo = 0 ;
+   return 1 ;
+}
+int hlifealgo::copyrect(lifealgo *src, const bigint &top, const bigint &left,
+                        const bigint &bottom, const bigint &right,
+                        int replace) {
+   hlifealgo *s = dynamic_cast<hlifealgo *>(src) ;
+   if (s == 0)
+      return 0 ;
+   ensure_hashed() ;
+   s->ensure_hashed() ;
+   nodememo<node *> memos[16] ;
+   editmemo = memos ;
+   setcliprect(top, left, bottom, right) ;
+   node *sel ;
+   if (s != this) {
+      nodesize(s->depth) ;
+      bigint x = bigint::zero ;
+      x -= nodesize(s->depth-1) ;
+      sel = importclipnode(s->root, s->depth, x, x) ;
+   } else {
+      sel = cliproot(root, depth, 1) ;
+   }
+   node *rest = replace ? cliproot(root, depth, 0) : root ;
+   seteditroot(rest, depth, sel, s->depth) ;
+   editmemo = 0 ;
+   return 1 ;
+}
+int hlifealgo::clearrect(const bigint &top, const bigint &left,
+                         const bigint &bottom, const bigint &right) {
+   ensure_hashed() ;
+   nodememo<node *> memos[16] ;
+   editmemo = memos ;
+   setcliprect(top, left, bottom, right) ;
+   node *rest = cliproot(root, depth, 0) ;
+   seteditroot(rest, depth, zeronode(depth), depth) ;
+   editmemo = 0 ;
+   return 1 ;
+}
+int hlifealgo::combine(lifealgo *src, TCombineOp op) {
+   hlifealgo *s = dynamic_cast<hlifealgo *>(src) ;
+   if (s == 0)
+      return 0 ;
+   ensure_hashed() ;
+   s->ensure_hashed() ;
+   nodememo<node *> memos[16] ;
+   editmemo = memos ;
+   node *b = s->root ;
+   if (s != this)
+      b = importnode(b, s->depth) ;
+   editmemo = 0 ;
+   combineroot(b, s->depth, op) ;
+   return 1 ;
+}
+int hlifealgo::combinewith(void *state, TCombineOp op) {
+   ensure_hashed() ;
+   node *b = (node *)state ;
+   combineroot(b, node_depth(b), op) ;
+   return 1 ;
+}
+void hlifealgo::combineroot(node *b, int bdepth, TCombineOp op) {
+   nodememo<nodepair> memo ;
+   overlaymemo = &memo ;
+   int d = depth > bdepth ? depth : bdepth ;
+   node *r = combinenode(padnode(root, depth, d), padnode(b, bdepth, d),
+                         d, op) ;
+   overlaymemo = 0 ;
+   root = popzeros(r) ;
+   depth = node_depth(root) ;
+   popValid = 0 ;
+}
+/*
+ *   Build a tree holding the cells of a getcells-style buffer; llx and
+ *   lly are the lower left corner of the node.
+ */
+node *hlifealgo::buildnode(const unsigned char *buf, int x, int y, int w,
+                           int h, int depth, G_INT64 llx, G_INT64 lly) {
+   G_INT64 s = (G_INT64)1 << (depth + 1) ;
+   if (llx + s <= x || llx >= (G_INT64)x + w ||
+       lly + s <= 1 - (G_INT64)y - h || lly >= 1 - (G_INT64)y)
+      return zeronode(depth) ;
+   if (depth == 2) {
+      unsigned long long cells = 0 ;
+      for (int j=0; j<8; j++) {
+         G_INT64 row = -(lly + j) - y ;
+         if (row < 0 || row >= h)
+            continue ;
+         const unsigned char *p = buf + (size_t)row * w ;
+         for (int i=0; i<8; i++) {
+            G_INT64 col = llx + i - x ;
+            if (col >= 0 && col < w && p[col])
+               cells |= 1ULL << (8 * j + i) ;
+         }
+      }
+      return leafofcells(cells) ;
+   }
+   G_INT64 hs = s >> 1 ;
+   return find_node(buildnode(buf, x, y, w, h, depth-1, llx, lly+hs),
+                    buildnode(buf, x, y, w, h, depth-1, llx+hs, lly+hs),
+                    buildnode(buf, x, y, w, h, depth-1, llx, lly),
+                    buildnode(buf, x, y, w, h, depth-1, llx+hs, lly)) ;
+}
+void hlifealgo::setcells(const unsigned char *buf, int x, int y, int w,
+                         int h) {
+   if (w <= 0 || h <= 0)
+      return ;
+   ensure_hashed() ;
+   nodememo<node *> memos[16] ;
+   editmemo = memos ;
+   setcliprect(bigint(y), bigint(x), bigint(y + h - 1), bigint(x + w - 1)) ;
+   node *rest = cliproot(root, depth, 0) ;
+   // the smallest tree (centered like the root) that holds the rectangle
+   int d = 3 ;
+   while (-((G_INT64)1 << d) > x || ((G_INT64)1 << d) < (G_INT64)x + w ||
+          -((G_INT64)1 << d) > 1 - (G_INT64)y - h ||
+          ((G_INT64)1 << d) < 1 - (G_INT64)y)
+      d++ ;
+   node *sel = buildnode(buf, x, y, w, h, d, -((G_INT64)1 << d),
+                         -((G_INT64)1 << d)) ;
+   seteditroot(rest, depth, sel, d) ;
+   editmemo = 0 ;
+}
 char hlifealgo::statusline[200] ;
 static lifealgo *creator() { return new hlifealgo() ; }
 void hlifealgo::doInitializeAlgoInfo(staticAlgoInfo &ai) {
@@ -6,6 +6,8 @@
 #include "lifealgo.h"
 #include "liferules.h"
 #include "util.h"
+#include "patternhash.h"
+#include "nodememo.h"
 /*
  *   Into instances of this node structure is where almost all of the
  *   memory allocated by this program goes.  Thus, it is imperative we
@@ -132,6 +134,19 @@ struct leaf {
  *   returns a zero value.
  */
 #define is_node(n) (((node *)(n))->nw)
+/*
+ *   The population and bounding box of a node, relative to its upper
+ *   left corner (with y increasing downwards).  We keep these for the
+ *   nodes in the current pattern in a side table, so they don't make
+ *   the nodes any bigger.  A pop of -1 means the population is too big
+ *   for a 64-bit int, and a minx of -1 means the bounding box is unknown
+ *   (because the node is too deep); the caller must then fall back to
+ *   walking the tree.  The box is meaningless if pop is zero.
+ */
+struct nodesummary {
+   G_INT64 pop ;
+   G_INT64 minx, miny, maxx, maxy ;
+} ;
 /*
  *   For explicit prefetching we retain some state on our lookup
  *   calculations.
@@ -153,7 +168,7 @@ public:
    // note that for hlifealgo, clearall() releases no memory; it retains
    // the full cache information but just sets the current pattern to
    // the empty pattern.
-   virtual void clearall() ; // not implemented
+   virtual void clearall() ;
    virtual int setcell(int x, int y, int newstate) ;
    virtual int getcell(int x, int y) ;
    virtual int nextcell(int x, int y, int &state) ;
@@ -163,13 +178,15 @@ public:
    virtual void setGeneration(bigint gen) { generation = gen ; }
    virtual const bigint &getPopulation() ;
    virtual int isEmpty() ;
+   virtual int gethash() ;
    virtual int hyperCapable() { return 1 ; }
    virtual void setMaxMemory(int m) ;
    virtual int getMaxMemory() { return (int)(maxmem >> 20) ; }
+   virtual g_uintptr_t getMemoryUsed() { return alloced ; }
    virtual const char *setrule(const char *s) ;
    virtual const char *getrule() { return hliferules.getrule() ; }
    virtual void step() ;
-   virtual void* getcurrentstate() { return root ; }
+   virtual void* getcurrentstate() { ensure_hashed() ; return root ; }
    virtual void setcurrentstate(void *n) ;
    /*
     *   The contract of draw() is that it render every pixel in the
@@ -182,6 +199,16 @@ public:
    virtual void findedges(bigint *t, bigint *l, bigint *b, bigint *r) ;
    virtual const char *readmacrocell(char *line) ;
    virtual const char *writeNativeFormat(std::ostream &os, char *comments) ;
+   virtual int rectCapable() { return 1 ; }
+   virtual int transformrect(TRectOp op, const bigint &top, const bigint &left,
+                             const bigint &bottom, const bigint &right,
+                             const bigint &newtop, const bigint &newleft) ;
+   virtual int copyrect(lifealgo *src, const bigint &top, const bigint &left,
+                        const bigint &bottom, const bigint &right, int replace) ;
+   virtual int clearrect(const bigint &top, const bigint &left,
+                         const bigint &bottom, const bigint &right) ;
+   virtual int combine(lifealgo *src, TCombineOp op) ;
+   virtual void setcells(const unsigned char *buf, int x, int y, int w, int h) ;
    static void doInitializeAlgoInfo(staticAlgoInfo &) ;
 private:
 /*
@@ -211,7 +238,6 @@ private:
 #ifndef PRIMEMOD
    g_uintptr_t hashmask ;
 #endif
-   static double maxloadfactor ;
    node **hashtab ;
    int halvesdone ;
    int gsp ;
@@ -220,6 +246,8 @@ private:
    int okaytogc ;
    g_uintptr_t totalthings ;
    node *nodeblocks ;
+   int allocmode ;            // bigalloc mode, fixed when we're created
+   int blocknodes ;           // nodes in the next block, counting the link
    char *ruletable ;
    bigint population ;
    bigint setincrement ;
@@ -238,9 +266,29 @@ private:
    char *llxb, *llyb ;
    int hashed ;
    int cacheinvalid ;
+   nodememo<phash> hashmemo ;           // pattern hashes of nodes
+   nodememo<nodesummary> summarymemo ;  // populations and bounding boxes
+   nodememo<unsigned long long> drawmemo ; // 8x8 pixel bitmaps of nodes
+   int drawmemomag ;                    // the mag drawmemo was built for
+   /*
+    *   Rectangle editing works on whole subtrees, memoizing the result
+    *   for each node it meets; these hold the rectangle being clipped
+    *   (in our coordinates, with y upwards and the right and top edges
+    *   excluded), the bits of the offset being shifted by, and the
+    *   memo tables for the current operation.
+    */
+   struct nodepair {
+      node *b, *r ;
+   } ;
+   bigint clipl, clipb, clipr, clipt ;
+   vector<bigint> editsizes ;
+   vector<char> shiftxbits, shiftybits ;
+   nodememo<node *> *editmemo ;
+   nodememo<nodepair> *overlaymemo ;
    g_uintptr_t cellcounter ; // used when writing
    g_uintptr_t writecells ; // how many to write
    int gccount ; // how many gcs total this pattern
+   g_uintptr_t gclive ; // how many nodes survived the last gc
    int gcstep ; // how many gcs this step
    hperf running_hperf, step_hperf, inc_hperf ;
    int softinterrupt ;
@@ -248,6 +296,7 @@ private:
 //
    void leafres(leaf *n) ;
    void resize() ;
+   g_uintptr_t raisedhashlimit() ;
    node *find_node(node *nw, node *ne, node *sw, node *se) ;
 #ifdef USEPREFETCH
    node *find_node(setup_t &su) ;
@@ -282,6 +331,8 @@ private:
    void aftercalcpop2(node *root, int depth) ;
    void afterwritemc(node *root, int depth) ;
    void calcPopulation() ;
+   phash nodehash(node *n, int depth) ;
+   nodesummary summarize(node *n, int depth) ;
    node *save(node *n) ;
    void pop(int n) ;
    void clearstack() ;
@@ -295,12 +346,41 @@ private:
    int log2(unsigned int n) ;
    node *runpattern() ;
    void renderbm(int x, int y) ;
+   void blitbm(int x, int y, unsigned char *pix) ;
    void fill_ll(int d) ;
    void drawnode(node *n, int llx, int lly, int depth, node *z) ;
+   void drawtile(node *n, int llx, int lly, int depth, node *z) ;
+   void drawchunks() ;
+   void drawchunkrange(int first, int step) ;
+   static void drawjob(void *arg, int i, int n) ;
    void ensure_hashed() ;
+   virtual int cankeepstate() ;
+   virtual int combinewith(void *state, TCombineOp op) ;
    g_uintptr_t writecell(std::ostream &os, node *root, int depth) ;
    g_uintptr_t writecell_2p1(node *root, int depth) ;
    g_uintptr_t writecell_2p2(std::ostream &os, node *root, int depth) ;
+   const bigint &nodesize(int depth) ;
+   node *leafofcells(unsigned long long cells) ;
+   node *padnode(node *n, int depth, int newdepth) ;
+   void setcliprect(const bigint &top, const bigint &left,
+                    const bigint &bottom, const bigint &right) ;
+   node *clipnode(node *n, int depth, const bigint &x, const bigint &y,
+                  int inside) ;
+   node *cliproot(node *n, int depth, int inside) ;
+   unsigned long long clipmask(int cut, const bigint &x, const bigint &y) ;
+   node *importclipnode(node *n, int depth, const bigint &x,
+                        const bigint &y) ;
+   node *transformnode(node *n, int depth, TRectOp op) ;
+   node *windownode(node *n, int depth) ;
+   node *shiftnode(node *n, int depth, const bigint &dx, const bigint &dy,
+                   int &newdepth) ;
+   node *overlaynode(node *a, node *b, int depth) ;
+   node *combinenode(node *a, node *b, int depth, TCombineOp op) ;
+   void combineroot(node *b, int bdepth, TCombineOp op) ;
+   node *importnode(node *n, int depth) ;
+   node *buildnode(const unsigned char *buf, int x, int y, int w, int h,
+                   int depth, G_INT64 llx, G_INT64 lly) ;
+   void seteditroot(node *rest, int restdepth, node *sel, int seldepth) ;
    void unpack8x8(unsigned short nw, unsigned short ne,
                   unsigned short sw, unsigned short se,
                   unsigned int *top, unsigned int *bot) ;
@@ -6,6 +6,7 @@
  *   no matter what the magnification or renderer.
  */
 #include "hlifealgo.h"
+#include "util.h"
 #include <vector>
 #include <cstring>
 #include <cstdio>
@@ -16,8 +17,58 @@ const int logbmsize = 8 ;                 // 8=256x256
 const int bmsize = (1<<logbmsize) ;
 const int byteoff = (bmsize/8) ;
 const int ibufsize = (bmsize*bmsize/32) ;
+const int pixsize = (bmsize*bmsize*4) ;   // bytes in a 256x256 RGBA pixmap
 static unsigned int ibigbuf[ibufsize] ;   // a shared buffer for 256x256 pixels
-static unsigned char *bigbuf = (unsigned char *)ibigbuf ;
+// the 256x256 buffer this thread is drawing into (ibigbuf or a chunk)
+static thread_local unsigned char *bigbuf = (unsigned char *)ibigbuf ;
+
+/*
+ *   The screen is drawn in 256x256 chunks.  We first walk the tree down
+ *   to the chunks that have something in them and queue those.  Then,
+ *   a batch at a time, the chunks are drawn and turned into pixels (by
+ *   the job pool if we can, each chunk into its own buffers; the tree
+ *   doesn't change while we draw so this is safe), and the pixels are
+ *   handed to the renderer in order from the main thread.  Batches keep
+ *   the pixel buffers from growing with the size of the screen.
+ */
+struct drawchunk {
+   node *q[4] ;         // the sw, se, nw and ne quadrants
+   node *z ;            // the zero node at the quadrants' depth
+   int depth, half ;    // the quadrants' depth and size in pixels
+   int x, y ;           // lower left corner for renderbm
+} ;
+const int maxbatch = 32 ;                 // chunks drawn before blitting
+static vector<drawchunk> chunks ;
+static int batchstart, batchend ;         // the chunks being drawn
+static vector<unsigned int> chunkbits ;   // ibufsize words per chunk
+static vector<unsigned char> chunkpix ;   // pixsize bytes per chunk
+static bool statepix ;                    // one state byte per pixel?
+
+/*
+ *   Cached node bitmaps made while drawing in several threads are kept
+ *   in per-job lists and added to drawmemo afterwards.
+ */
+struct drawntile {
+   node *n ;
+   unsigned long long bits ;
+} ;
+static vector<vector<drawntile> > jobtiles ;
+static thread_local vector<drawntile> *newtiles = 0 ;
+
+static void queuechunk(node *sw, node *se, node *nw, node *ne,
+                       int depth, node *z, int half, int x, int y) {
+   drawchunk c ;
+   c.q[0] = sw ;
+   c.q[1] = se ;
+   c.q[2] = nw ;
+   c.q[3] = ne ;
+   c.z = z ;
+   c.depth = depth ;
+   c.half = half ;
+   c.x = x ;
+   c.y = y ;
+   chunks.push_back(c) ;
+}
 
 // AKT: 256x256 pixmap where each pixel is 4 RGBA bytes
 static unsigned char pixbuf[bmsize*bmsize*4];
@@ -77,24 +128,15 @@ void draw4x4_4(unsigned short bits1, unsigned short bits2, int llx, int lly) {
    p[-3*byteoff] = (unsigned char)(((bits1 >> 8) & 0xf0) + ((bits2 >> 12) & 0xf)) ;
 }
 
-void hlifealgo::renderbm(int x, int y) {
-   // x,y is lower left corner
-   int rx = x ;
-   int ry = y ;
-   int rw = bmsize ;
-   int rh = bmsize ;
-   if (pmag > 1) {
-      rx *= pmag ;
-      ry *= pmag ;
-      rw *= pmag ;
-      rh *= pmag ;
-   }
-   ry = uviewh - ry - rh ;
-   
-   unsigned char *bigptr = bigbuf;
-   if (renderer->justState() || pmag > 1) {
+/*
+ *   Turn a 256x256 bitmap into pixels for the renderer, one state byte
+ *   per pixel or RGBA, and clear the bitmap for next time.
+ */
+static void expandbm(unsigned char *bigptr, unsigned char *pix) {
+   unsigned char *bits = bigptr ;
+   if (statepix) {
       // convert each bigbuf byte into 8 bytes of state data
-      unsigned char *pixptr = pixbuf;
+      unsigned char *pixptr = pix;
 
       for (int i = 0; i < ibufsize * 4; i++) {
          unsigned char byte = *bigptr++;
@@ -110,7 +152,7 @@ void hlifealgo::renderbm(int x, int y) {
    } else {
       // convert each bigbuf byte into 32 bytes of pixel data (8 * RGBA)
       // get RGBA view of pixel buffer
-      unsigned int *pixptr = (unsigned int *)pixbuf;
+      unsigned int *pixptr = (unsigned int *)pix;
 
       for (int i = 0; i < ibufsize * 4; i++) {
          unsigned char byte = *bigptr++;
@@ -124,12 +166,31 @@ void hlifealgo::renderbm(int x, int y) {
          *pixptr++ = (byte & 1) ? liveRGBA : deadRGBA;
       }
    }
+   memset(bits, 0, sizeof(ibigbuf)) ;
+}
+
+void hlifealgo::renderbm(int x, int y) {
+   expandbm(bigbuf, pixbuf) ;
+   blitbm(x, y, pixbuf) ;
+}
+
+void hlifealgo::blitbm(int x, int y, unsigned char *pix) {
+   // x,y is lower left corner
+   int rx = x ;
+   int ry = y ;
+   int rw = bmsize ;
+   int rh = bmsize ;
+   if (pmag > 1) {
+      rx *= pmag ;
+      ry *= pmag ;
+      rw *= pmag ;
+      rh *= pmag ;
+   }
+   ry = uviewh - ry - rh ;
    if (renderer->justState())
-      renderer->stateblit(rx, ry, rw, rh, pixbuf) ;
+      renderer->stateblit(rx, ry, rw, rh, pix) ;
    else
-      renderer->pixblit(rx, ry, rw, rh, pixbuf, pmag);
-   
-   memset(bigbuf, 0, sizeof(ibigbuf)) ;
+      renderer->pixblit(rx, ry, rw, rh, pix, pmag);
 }
 
 /*
@@ -144,16 +205,14 @@ void hlifealgo::drawnode(node *n, int llx, int lly, int depth, node *z) {
       return ;
    if (n == z) {
       // don't do anything
+   } else if (depth > 2 && sw == 8) {
+      drawtile(n, llx, lly, depth, z) ;
    } else if (depth > 2 && sw > 2) {
       z = z->nw ;
       sw >>= 1 ;
       depth-- ;
       if (sw == (bmsize >> 1)) {
-         drawnode(n->sw, 0, 0, depth, z) ;
-         drawnode(n->se, -(bmsize/2), 0, depth, z) ;
-         drawnode(n->nw, 0, -(bmsize/2), depth, z) ;
-         drawnode(n->ne, -(bmsize/2), -(bmsize/2), depth, z) ;
-         renderbm(-llx, -lly) ;
+         queuechunk(n->sw, n->se, n->nw, n->ne, depth, z, bmsize/2, -llx, -lly) ;
       } else {
          drawnode(n->sw, llx, lly, depth, z) ;
          drawnode(n->se, llx-sw, lly, depth, z) ;
@@ -179,6 +238,101 @@ void hlifealgo::drawnode(node *n, int llx, int lly, int depth, node *z) {
    }
 }
 
+/*
+ *   When zoomed out, draw a node that covers 8x8 pixels from its cached
+ *   bitmap if we have one.  Patterns are full of repeated subtrees and
+ *   the cache lasts from one frame to the next (until the nodes are
+ *   freed or the scale changes), so most of the time we don't have to
+ *   walk down to the pixel level at all.  Otherwise we draw the node as
+ *   usual and then copy the pixels back out of bigbuf; nothing else
+ *   draws in the node's area so that's all its own.  The left edge of
+ *   such a node is always at a multiple of 8 pixels, so each row of the
+ *   bitmap is exactly one byte of bigbuf.
+ */
+void hlifealgo::drawtile(node *n, int llx, int lly, int depth, node *z) {
+   unsigned char *p = bigbuf + ((bmsize-1+lly) << (logbmsize-3)) + ((-llx) >> 3) ;
+   unsigned long long *m = drawmemo.lookup(n) ;
+   if (m) {
+      unsigned long long bits = *m ;
+      for (int i=0; i<8; i++, bits >>= 8)
+         p[-i*byteoff] |= (unsigned char)bits ;
+      return ;
+   }
+   z = z->nw ;
+   depth-- ;
+   drawnode(n->sw, llx, lly, depth, z) ;
+   drawnode(n->se, llx-4, lly, depth, z) ;
+   drawnode(n->nw, llx, lly-4, depth, z) ;
+   drawnode(n->ne, llx-4, lly-4, depth, z) ;
+   unsigned long long bits = 0 ;
+   for (int i=7; i>=0; i--)
+      bits = (bits << 8) | p[-i*byteoff] ;
+   if (newtiles) {
+      drawntile t ;
+      t.n = n ;
+      t.bits = bits ;
+      newtiles->push_back(t) ;
+   } else {
+      drawmemo.insert(n, bits) ;
+   }
+}
+
+/*
+ *   Draw every step'th chunk of the batch starting at first, and turn
+ *   each one into pixels.
+ */
+void hlifealgo::drawchunkrange(int first, int step) {
+   newtiles = (step > 1 ? &jobtiles[first] : 0) ;
+   for (int i=batchstart+first; i<batchend; i+=step) {
+      drawchunk &c = chunks[i] ;
+      bigbuf = (unsigned char *)&chunkbits[(i - batchstart) * ibufsize] ;
+      drawnode(c.q[0], 0, 0, c.depth, c.z) ;
+      drawnode(c.q[1], -c.half, 0, c.depth, c.z) ;
+      drawnode(c.q[2], 0, -c.half, c.depth, c.z) ;
+      drawnode(c.q[3], -c.half, -c.half, c.depth, c.z) ;
+      expandbm(bigbuf, &chunkpix[(size_t)(i - batchstart) * pixsize]) ;
+   }
+   bigbuf = (unsigned char *)ibigbuf ;
+   newtiles = 0 ;
+}
+
+void hlifealgo::drawjob(void *arg, int i, int n) {
+   ((hlifealgo *)arg)->drawchunkrange(i, n) ;
+}
+
+/*
+ *   Draw the queued chunks and pass them to the renderer.  The chunk
+ *   bitmaps are cleared as they're turned into pixels, so they're
+ *   ready for next time.
+ */
+void hlifealgo::drawchunks() {
+   int nchunks = (int)chunks.size() ;
+   int nbatch = min(nchunks, maxbatch) ;
+   if (chunkbits.size() < (size_t)nbatch * ibufsize) {
+      chunkbits.resize((size_t)nbatch * ibufsize, 0) ;
+      chunkpix.resize((size_t)nbatch * pixsize) ;
+   }
+   for (batchstart=0; batchstart<nchunks; batchstart=batchend) {
+      batchend = min(nchunks, batchstart + maxbatch) ;
+      int njobs = jobcount(batchend - batchstart, 2) ;
+      if (njobs > 1) {
+         jobtiles.resize(njobs) ;
+         runjobs(drawjob, this, njobs) ;
+         for (int t=0; t<njobs; t++) {
+            for (int i=0; i<(int)jobtiles[t].size(); i++)
+               drawmemo.insert(jobtiles[t][i].n, jobtiles[t][i].bits) ;
+            jobtiles[t].clear() ;
+         }
+      } else {
+         drawchunkrange(0, 1) ;
+      }
+      for (int i=batchstart; i<batchend; i++)
+         blitbm(chunks[i].x, chunks[i].y,
+                &chunkpix[(size_t)(i - batchstart) * pixsize]) ;
+   }
+   chunks.clear() ;
+}
+
 /*
  *   Fill in the llxb and llyb bits from the viewport information.
  *   Allocate if necessary.  This arithmetic should be done carefully.
@@ -282,6 +436,11 @@ void hlifealgo::draw(viewport &viewarg, liferender &rendererarg) {
       viewh = uviewh ;
       vieww = uvieww ;
    }
+   statepix = renderer->justState() || pmag > 1 ;
+   if (mag != drawmemomag) {
+      drawmemo.clear() ;
+      drawmemomag = mag ;
+   }
    int d = depth ;
    fill_ll(d) ;
    int maxd = vieww ;
@@ -357,11 +516,7 @@ void hlifealgo::draw(viewport &viewarg, liferender &rendererarg) {
       maxd = 1 << (d - mag + 2) ;
       if (maxd <= bmsize) {
          maxd >>= 1 ;
-         drawnode(sw, 0, 0, d, z) ;
-         drawnode(se, -maxd, 0, d, z) ;
-         drawnode(nw, 0, -maxd, d, z) ;
-         drawnode(ne, -maxd, -maxd, d, z) ;
-         renderbm(-llx, -lly) ;
+         queuechunk(sw, se, nw, ne, d, z, maxd, -llx, -lly) ;
       } else {
          maxd >>= 1 ;
          drawnode(sw, llx, lly, d, z) ;
@@ -369,6 +524,7 @@ void hlifealgo::draw(viewport &viewarg, liferender &rendererarg) {
          drawnode(nw, llx, lly-maxd, d, z) ;
          drawnode(ne, llx-maxd, lly-maxd, d, z) ;
       }
+      drawchunks() ;
    }
 bail:
    renderer = 0 ;
@@ -435,6 +591,22 @@ void hlifealgo::findedges(bigint *ptop, bigint *pleft, bigint *pbottom, bigint *
       *pright = 0 ;
       return ;
    }
+   // usually the root's bounding box is already known
+   nodesummary s = summarize(root, currdepth) ;
+   if (s.minx >= 0) {
+      // the upper left corner of the root is at (-2^depth, 1-2^depth)
+      bigint half = 1 ;
+      half.mulpow2(currdepth) ;
+      *pleft = bigint(s.minx) ;
+      *pleft -= half ;
+      *pright = bigint(s.maxx) ;
+      *pright -= half ;
+      *ptop = bigint(s.miny + 1) ;
+      *ptop -= half ;
+      *pbottom = bigint(s.maxy + 1) ;
+      *pbottom -= half ;
+      return ;
+   }
    vector<node *> top, left, bottom, right ;
    top.push_back(root) ;
    left.push_back(root) ;
@@ -9,6 +9,7 @@
    #define stricmp strcasecmp
 #endif
 #include <string>
+#include <cstdlib>
 
 using namespace std ;
 
@@ -16,6 +17,34 @@ using namespace std ;
 const char* RULE_STRINGS[] = { "JvN29", "Nobili32", "Hutton32" };
 const int N_STATES[] = { 29, 32, 32 };
 
+/**
+ *   Hutton32's rules don't split up by neighbor the way JvN29's and
+ *   Nobili32's do (see nbrbits below), and a full table of 32^5 entries
+ *   would take too long to fill in each time the rule is set.  So instead
+ *   its results are remembered as they are found, in a table indexed by
+ *   all five states holding the new state plus one (0 means not known
+ *   yet).  Patterns only ever see a tiny part of the table, and because
+ *   it's calloc'ed the pages that are never touched cost no memory.
+ *   The table is shared by all Hutton32 universes and isn't counted
+ *   against maxmem; it's freed when the last of them goes away.
+ */
+static unsigned char *huttonmemo = 0 ;
+static int huttonusers = 0 ;
+
+void jvnalgo::usehuttonmemo(bool use) {
+   if (use == usinghuttonmemo)
+      return ;
+   usinghuttonmemo = use ;
+   if (use) {
+      // if this fails slowcalc just works out every result
+      if (huttonusers++ == 0)
+         huttonmemo = (unsigned char *)calloc(1 << 25, 1) ;
+   } else if (--huttonusers == 0) {
+      free(huttonmemo) ;
+      huttonmemo = 0 ;
+   }
+}
+
 int jvnalgo::NumCellStates() {
    return N_STATES[current_rule];
 }
@@ -51,6 +80,8 @@ const char* jvnalgo::setrule(const char *s)
       gridht = 0;
    }
 
+   usehuttonmemo(current_rule == Hutton32);
+
    maxCellStates = N_STATES[current_rule];
    ghashbase::setrule(RULE_STRINGS[current_rule]);
    return NULL;
@@ -180,16 +211,90 @@ static int bits(state mcode, state code, state dir) {
 
 static state cres[] = {0x22, 0x23, 0x40, 0x41, 0x42, 0x43, 0x10, 0x20, 0x21} ;
 
+/**
+ *   The new state of an (uncompressed) cell c under JvN29 or Nobili32,
+ *   given the bits its four neighbors contribute.
+ */
+static state nextstate(state c, int mbits, bool nobili) {
+   if (c < CONF) {
+      if (mbits & (BIT_OEXC | BIT_SEXC))
+         c = 2 * c + 1 ;
+      else
+         c = 2 * c ;
+      if (c > 8)
+         c = cres[c-9] ;
+   } else if (c & CONF) {
+      if (mbits & BIT_SEXC)
+         c = 0 ;
+      else if (nobili && (mbits & BIT_CROSS) == BIT_CROSS) {
+         if (mbits & BIT_OEXC)
+            c = (state)((mbits & BIT_OEXC) + CONF + 0x80) ;
+         else
+            c = CONF ;
+      } else {
+         if (c & CROSSEXC) {// was a cross, is no more
+            c = (c & ~(CROSSEXC | CDEXC)) ;
+         }
+         if ((mbits & BIT_OEXC) && !(mbits & BIT_ONEXC))
+            c = ((c & CDEXC) >> 7) + (CDEXC | CONF) ;
+         else if ((mbits & BIT_ANY_OUT) || !nobili)
+            c = ((c & CDEXC) >> 7) + CONF ;
+         else
+            /* no change */ ;
+      }
+   } else {
+      if (((c & OTRANS) && (mbits & BIT_SEXC)) ||
+          ((c & STRANS) && (mbits & BIT_OEXC)))
+         c = 0 ;
+      else if (mbits & (BIT_SEXC_OTHER | BIT_OEXC_OTHER | BIT_CEXC))
+         c |= 128 ;
+      else
+         c &= 127 ;
+   }
+   return c ;
+}
+
+/**
+ *   Under JvN29 and Nobili32 each neighbor's effect on a cell depends
+ *   only on the two of them, and the effects are simply ORed together.
+ *   So rather than work them out for every cell we keep a table of the
+ *   bits for every (direction, cell, neighbor) and another of the new
+ *   state for every (rule, cell, bits), all in compressed states.
+ *   That makes slowcalc five lookups, four of them independent.
+ */
+const int MBITS = 2 * BIT_SEXC_OTHER ;          // all possible mbits
+static short nbrbits[4][32][32] ;               // [dir][c][neighbor]
+static state jvnnext[2][32][MBITS] ;            // [nobili][c][mbits]
+
+static void initjvn() {
+   static bool done = false ;
+   if (done)
+      return ;
+   for (int i=0; i<256; i++)
+      compress[i] = 255 ;
+   for (unsigned int i=0; i<sizeof(uncompress)/sizeof(uncompress[0]); i++)
+      compress[uncompress[i]] = (state)i ;
+   for (int dir=0; dir<4; dir++)
+      for (int c=0; c<32; c++)
+         for (int nb=0; nb<32; nb++)
+            nbrbits[dir][c][nb] = (short)bits(uncompress[c], uncompress[nb], (state)dir) ;
+   for (int nobili=0; nobili<2; nobili++)
+      for (int c=0; c<32; c++)
+         for (int mbits=0; mbits<MBITS; mbits++)
+            jvnnext[nobili][c][mbits] =
+               compress[nextstate(uncompress[c], mbits, nobili != 0)] ;
+   done = true ;
+}
+
 jvnalgo::jvnalgo() {
-  for (int i=0; i<256; i++)
-    compress[i] = 255 ;
-  for (unsigned int i=0; i<sizeof(uncompress)/sizeof(uncompress[0]); i++)
-     compress[uncompress[i]] = (state)i ;
+  initjvn() ;
   current_rule = JvN29 ;
+  usinghuttonmemo = false ;
   maxCellStates = N_STATES[current_rule] ;
 }
 
 jvnalgo::~jvnalgo() {
+   usehuttonmemo(false) ;
 }
 
 state slowcalc_Hutton32(state c,state n,state s,state e,state w);
@@ -199,50 +304,19 @@ state jvnalgo::slowcalc(state, state n, state, state w, state c, state e,
                         state, state s, state) {
    if(current_rule == JvN29 || current_rule == Nobili32)
    {
-	   c = uncompress[c] ;
-	   int mbits = bits(c, uncompress[n], SOUTH) |
-	     bits(c, uncompress[w], EAST) |
-	     bits(c, uncompress[e], WEST) |
-	     bits(c, uncompress[s], NORTH) ;
-	   if (c < CONF) {
-	      if (mbits & (BIT_OEXC | BIT_SEXC))
-		 c = 2 * c + 1 ;
-	      else
-		 c = 2 * c ;
-	      if (c > 8)
-		 c = cres[c-9] ;
-	   } else if (c & CONF) {
-	      if (mbits & BIT_SEXC)
-		 c = 0 ;
-	      else if (current_rule == Nobili32 && (mbits & BIT_CROSS) == BIT_CROSS) {
-		 if (mbits & BIT_OEXC)
-		    c = (state)((mbits & BIT_OEXC) + CONF + 0x80) ;
-		 else
-		    c = CONF ;
-	      } else {
-		 if (c & CROSSEXC) {// was a cross, is no more
-		    c = (c & ~(CROSSEXC | CDEXC)) ;
-		 }
-		 if ((mbits & BIT_OEXC) && !(mbits & BIT_ONEXC))
-		    c = ((c & CDEXC) >> 7) + (CDEXC | CONF) ;
-		 else if ((mbits & BIT_ANY_OUT) || current_rule == JvN29)
-		    c = ((c & CDEXC) >> 7) + CONF ;
-		 else
-		    /* no change */ ;
-	      }
-	   } else {
-	      if (((c & OTRANS) && (mbits & BIT_SEXC)) ||
-		  ((c & STRANS) && (mbits & BIT_OEXC)))
-		 c = 0 ;
-	      else if (mbits & (BIT_SEXC_OTHER | BIT_OEXC_OTHER | BIT_CEXC))
-		 c |= 128 ;
-	      else
-		 c &= 127 ;
-	   }
-	   return compress[c] ;
+      int mbits = nbrbits[SOUTH][c][n] | nbrbits[EAST][c][w] |
+                  nbrbits[WEST][c][e] | nbrbits[NORTH][c][s] ;
+      return jvnnext[current_rule == Nobili32][c][mbits] ;
    }
    else // Hutton32
-   	return slowcalc_Hutton32(c,n,s,e,w);
+   {
+      if (huttonmemo == 0)
+         return slowcalc_Hutton32(c,n,s,e,w);
+      unsigned char &r = huttonmemo[((((c << 5 | n) << 5 | s) << 5 | e) << 5) | w] ;
+      if (r == 0)
+         r = (unsigned char)(slowcalc_Hutton32(c,n,s,e,w) + 1) ;
+      return r - 1 ;
+   }
 }
 
 // XPM data for the 31 7x7 icons used in JvN algo
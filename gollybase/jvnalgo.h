@@ -19,6 +19,8 @@ public:
    virtual int NumCellStates() ;
    static void doInitializeAlgoInfo(staticAlgoInfo &) ;
 private:
+   void usehuttonmemo(bool use) ;
    enum { JvN29, Nobili32, Hutton32 } current_rule ;
+   bool usinghuttonmemo ;
 };
 #endif
@@ -2,14 +2,86 @@
 // See docs/License.html for the copyright notice.
 
 #include "lifealgo.h"
+#include "patternhash.h"
 #include "util.h"       // for lifestatus
 #include "string.h"
 using namespace std ;
+/*
+ *   Kept states are shared by all algorithms so tickets stay unique
+ *   even after the algorithm that issued them has been deleted.
+ */
+struct keptstate {
+   int ticket ;
+   lifealgo *owner ;
+   void *state ;
+} ;
+static vector<keptstate> keptstates ;
+static int lastticket = 0 ;
 lifealgo::~lifealgo() {
+   for (size_t i=keptstates.size(); i>0; i--)
+      if (keptstates[i-1].owner == this)
+         keptstates.erase(keptstates.begin() + (i-1)) ;
    poller = 0 ;
    maxCellStates = 2 ;
 }
 int lifealgo::verbose ;
+double lifealgo::maxloadfactor = 0.7 ;
+#ifdef NOGCBEFORERESIZE
+int lifealgo::gcbeforeresize = 0 ;
+#else
+int lifealgo::gcbeforeresize = 1 ;
+#endif
+int lifealgo::adaptiveload = 0 ;
+void lifealgo::setMaxLoadFactor(double f) {
+   if (f < MIN_LOAD_FACTOR)
+      f = MIN_LOAD_FACTOR ;
+   else if (f > MAX_LOAD_FACTOR)
+      f = MAX_LOAD_FACTOR ;
+   maxloadfactor = f ;
+}
+/*
+ *   Algorithms that can't maintain the hash incrementally get this
+ *   version, which visits every live cell in the bounding box.
+ */
+int lifealgo::gethash() {
+   if (isEmpty())
+      return patternhash::fold(0) ;
+   bigint top, left, bottom, right ;
+   findedges(&top, &left, &bottom, &right) ;
+   if (top < bigint::min_coord || left < bigint::min_coord ||
+       bottom > bigint::max_coord || right > bigint::max_coord) {
+      // too big to scan, so fall back to the population and the size
+      bigint wd = right, ht = bottom ;
+      wd -= left ;
+      ht -= top ;
+      phash h = patternhash::pow(patternhash::X, wd) ;
+      h = patternhash::mul(h, patternhash::pow(patternhash::Y, ht)) ;
+      h = patternhash::add(h, getPopulation().low31()) ;
+      return patternhash::fold(h) ;
+   }
+   int x = left.toint(), y = top.toint() ;
+   int r = right.toint(), b = bottom.toint() ;
+   phash h = 0, yw = 1 ;
+   int v = 0 ;
+   for (int cy=y; cy<=b; cy++) {
+      int lastx = x ;
+      phash xw = yw ;
+      for (int cx=x; cx<=r; cx++) {
+         int skip = nextcell(cx, cy, v) ;
+         if (skip < 0)
+            break ;
+         cx += skip ;
+         if (cx > r)
+            break ;
+         xw = patternhash::mul(xw, patternhash::pow(patternhash::X,
+                                                  (unsigned int)(cx - lastx))) ;
+         lastx = cx ;
+         h = patternhash::add(h, patternhash::mul(xw, v)) ;
+      }
+      yw = patternhash::mul(yw, patternhash::Y) ;
+   }
+   return patternhash::fold(h) ;
+}
 /*
  *   Right now, the base/expo should match the current increment.
  *   We do not check this.
@@ -26,6 +98,7 @@ int lifealgo::startrecording(int basearg, int expoarg) {
     timeline.base = basearg ;
     timeline.expo = expoarg ;
     timeline.frames.push_back(now) ;
+    timeline.gens.push_back(generation) ;
     timeline.framecount = 1 ;
     timeline.end = timeline.start = generation ;
     timeline.inc = increment ;
@@ -33,70 +106,187 @@ int lifealgo::startrecording(int basearg, int expoarg) {
   timeline.next = timeline.end ;
   timeline.next += timeline.inc ;
   timeline.recording = 1 ;
+  timeline.full = 0 ;
   return timeline.framecount ;
 }
 pair<int, int> lifealgo::stoprecording() {
   timeline.recording = 0 ;
+  timeline.full = 0 ;
   timeline.next = 0 ;
   return make_pair(timeline.base, timeline.expo) ;
 }
+/*
+ *   If an algorithm can't save another frame (QuickLife's frames count
+ *   against its memory limit) we thin the timeline to free some and try
+ *   again.  If that fails too the timeline is marked as full and stops
+ *   growing; the caller should stop recording.
+ */
 void lifealgo::extendtimeline() {
-  if (timeline.recording && generation == timeline.next) {
+  if (timeline.recording && !timeline.full && generation == timeline.next) {
     void *now = getcurrentstate() ;
-    if (now && timeline.framecount < MAX_FRAME_COUNT) {
+    if (now == 0 && timeline.framecount > 2) {
+      thinframes() ;
+      now = getcurrentstate() ;
+    }
+    if (now == 0) {
+      timeline.full = 1 ;
+    } else {
       timeline.frames.push_back(now) ;
+      timeline.gens.push_back(generation) ;
       timeline.framecount++ ;
       timeline.end = timeline.next ;
       timeline.next += timeline.inc ;
+      if (timeline.framecount >= MAX_FRAME_COUNT)
+        thinframes() ;
     }
   }
 }
+/*
+ *   Drop frames so the timeline keeps recent history in full detail
+ *   and older history in less and less detail.  Going back from the
+ *   newest frame, we keep perlevel frames spaced inc apart, then
+ *   perlevel frames spaced 2*inc apart, then 4*inc, and so on; the
+ *   first frame is always kept.  We halve perlevel until at least a
+ *   quarter of the frames go, so recording costs amortized constant
+ *   time per frame however long it runs.
+ */
+void lifealgo::thinframes() {
+   int n = timeline.framecount ;
+   if (n < 3)
+      return ;
+   vector<char> keep(n) ;
+   int kept = n ;
+   for (int perlevel = n / 2 ; perlevel > 0 && 4 * kept > 3 * n ;
+                                                         perlevel /= 2) {
+      bigint spacing = timeline.inc ;
+      int last = n - 1 ;
+      int atlevel = 1 ;
+      kept = 2 ;
+      for (int i=0; i<n; i++)
+         keep[i] = (i == 0 || i == n - 1) ;
+      for (int i=n-2; i>0; i--) {
+         bigint gap = timeline.gens[last] ;
+         gap -= timeline.gens[i] ;
+         if (gap < spacing)
+            continue ;
+         keep[i] = 1 ;
+         kept++ ;
+         last = i ;
+         if (++atlevel >= perlevel) {
+            spacing += spacing ;
+            atlevel = 0 ;
+         }
+      }
+   }
+   int j = 0 ;
+   for (int i=0; i<n; i++)
+      if (keep[i]) {
+         timeline.frames[j] = timeline.frames[i] ;
+         timeline.gens[j] = timeline.gens[i] ;
+         j++ ;
+      }
+   timeline.frames.resize(j) ;
+   timeline.gens.resize(j) ;
+   timeline.framecount = j ;
+   releaseframes() ;
+}
 /*
  *   Note that this *also* changes inc, so don't call unless this is
  *   what you want to do.  It does not update or change the base or
  *   expo if the base != 2, so they can get out of sync.
  *
- *   Currently this is only used by bgolly, and it will only work
- *   properly if the increment argument is a power of two.
+ *   Recording timelines are thinned by thinframes instead, so nothing
+ *   in Golly calls this now.  It will only work properly if the
+ *   increment argument is a power of two.
  */
 void lifealgo::pruneframes() {
    if (timeline.framecount > 1) {
-      for (int i=2; i<timeline.framecount; i += 2)
+      for (int i=2; i<timeline.framecount; i += 2) {
          timeline.frames[i >> 1]  = timeline.frames[i] ;
+         timeline.gens[i >> 1]  = timeline.gens[i] ;
+      }
       timeline.framecount = (timeline.framecount + 1) >> 1 ;
       timeline.frames.resize(timeline.framecount) ;
+      timeline.gens.resize(timeline.framecount) ;
       timeline.inc += timeline.inc ;
-      timeline.end = timeline.inc ;
-      timeline.end.mul_smallint(timeline.framecount-1) ;
-      timeline.end += timeline.start ;
+      timeline.end = timeline.gens[timeline.framecount-1] ;
       timeline.next = timeline.end ;
       timeline.next += timeline.inc ;
       if (timeline.base == 2)
          timeline.expo++ ;
+      releaseframes() ;
    }
 }
 int lifealgo::gotoframe(int i) {
   if (i < 0 || i >= timeline.framecount)
     return 0 ;
   setcurrentstate(timeline.frames[i]) ;
-  // AKT: avoid mul_smallint(i) crashing with divide-by-zero if i is 0
-  if (i > 0) {
-    generation = timeline.inc ;
-    generation.mul_smallint(i) ;
-  } else {
-    generation = 0;
-  }
-  generation += timeline.start ;
+  generation = timeline.gens[i] ;
   return timeline.framecount ;
 }
 void lifealgo::destroytimeline() {
   timeline.frames.clear() ;
+  timeline.gens.clear() ;
   timeline.recording = 0 ;
+  timeline.full = 0 ;
   timeline.framecount = 0 ;
   timeline.end = 0 ;
   timeline.start = 0 ;
   timeline.inc = 0 ;
   timeline.next = 0 ;
+  releaseframes() ;
+}
+int lifealgo::keepstate() {
+   if (!cankeepstate())
+      return 0 ;
+   void *now = getcurrentstate() ;
+   if (now == 0)
+      return 0 ;
+   keptstate k ;
+   k.ticket = ++lastticket ;
+   k.owner = this ;
+   k.state = now ;
+   keptstates.push_back(k) ;
+   return k.ticket ;
+}
+int lifealgo::restorestate(int ticket) {
+   for (size_t i=0; i<keptstates.size(); i++)
+      if (keptstates[i].ticket == ticket && keptstates[i].owner == this) {
+         setcurrentstate(keptstates[i].state) ;
+         return 1 ;
+      }
+   return 0 ;
+}
+int lifealgo::ownsstate(int ticket) {
+   for (size_t i=0; i<keptstates.size(); i++)
+      if (keptstates[i].ticket == ticket)
+         return keptstates[i].owner == this ;
+   return 0 ;
+}
+void lifealgo::forgetstate(int ticket) {
+   for (size_t i=0; i<keptstates.size(); i++)
+      if (keptstates[i].ticket == ticket) {
+         keptstates.erase(keptstates.begin() + i) ;
+         return ;
+      }
+}
+int lifealgo::keptstatesoverbudget() {
+   int r = keptoverbudget ;
+   keptoverbudget = 0 ;
+   return r ;
+}
+int lifealgo::combinekept(int ticket, TCombineOp op) {
+   for (size_t i=0; i<keptstates.size(); i++)
+      if (keptstates[i].ticket == ticket && keptstates[i].owner == this)
+         return combinewith(keptstates[i].state, op) ;
+   return 0 ;
+}
+vector<void *> lifealgo::getkeptstates() {
+   vector<void *> r ;
+   for (size_t i=0; i<keptstates.size(); i++)
+      if (keptstates[i].owner == this)
+         r.push_back(keptstates[i].state) ;
+   return r ;
 }
 
 // -----------------------------------------------------------------------------
@@ -884,6 +1074,16 @@ void lifealgo::getcells(unsigned char *buf, int x, int y, int w, int h) {
    draw(vp, hsr) ;
 }
 
+void lifealgo::setcells(const unsigned char *buf, int x, int y, int w, int h) {
+   ClearRect(y, x, y + h - 1, x + w - 1) ;
+   for (int j=0; j<h; j++) {
+      const unsigned char *row = buf + (size_t)j * w ;
+      for (int i=0; i<w; i++)
+         if (row[i])
+            setcell(x + i, y + j, row[i]) ;
+   }
+}
+
 // -----------------------------------------------------------------------------
 
 int staticAlgoInfo::nextAlgoId = 0 ;
@@ -26,25 +26,36 @@
 using std::vector;
 #include <iostream>
 
-// this must not be increased beyond 32767, because we use a bigint
-// multiply that only supports multiplicands up to that size.
+// the most frames a timeline keeps at once; when a recording timeline
+// reaches this many frames the older ones are thinned out (see thinframes)
+// so recording can continue indefinitely
 const int MAX_FRAME_COUNT = 32000 ;
 
+// limits for lifealgo::setMaxLoadFactor; chained hashing with
+// move-to-front copes with loads well above 1
+const double MIN_LOAD_FACTOR = 0.1 ;
+const double MAX_LOAD_FACTOR = 16.0 ;
+
 /**
- *   Timeline support is pretty generic.
+ *   Timeline support is pretty generic.  Each frame remembers its own
+ *   generation, because once a timeline has been thinned the frames are
+ *   no longer evenly spaced.
  */
 class timeline_t {
 public:
-   timeline_t() : recording(0), framecount(0), savetimeline(1),
-                  start(0), inc(0), next(0), end(0), frames() {}
+   timeline_t() : recording(0), framecount(0), savetimeline(1), full(0),
+                  start(0), inc(0), next(0), end(0), frames(), gens() {}
    int recording, framecount, base, expo, savetimeline ;
+   int full ;     // set if a recording timeline couldn't save a frame
    bigint start, inc, next, end ;
    vector<void *> frames ;
+   vector<bigint> gens ;
 } ;
 
 class lifealgo {
 public:
-   lifealgo() : generation(0), increment(0), timeline(), grid_type(SQUARE_GRID)
+   lifealgo() : generation(0), increment(0), timeline(), grid_type(SQUARE_GRID),
+                keptoverbudget(0)
       {  poller = &default_poller ;
          gridwd = gridht = 0 ;      // default is an unbounded universe
          unbounded = true ;         // most algorithms use an unbounded universe
@@ -56,6 +67,9 @@ public:
    virtual int getcell(int x, int y) = 0 ;
    virtual int nextcell(int x, int y, int &v) = 0 ;
    void getcells(unsigned char *buf, int x, int y, int w, int h) ;
+   // the reverse of getcells: set every cell in the rectangle from buf
+   // (one state per byte, a row at a time); call endofpattern afterwards
+   virtual void setcells(const unsigned char *buf, int x, int y, int w, int h) ;
    // call after setcell/clearcell calls
    virtual void endofpattern() = 0 ;
    virtual void setIncrement(bigint inc) = 0 ;
@@ -65,10 +79,16 @@ public:
    const bigint &getGeneration() { return generation ; }
    virtual const bigint &getPopulation() = 0 ;
    virtual int isEmpty() = 0 ;
+   // return a translation-invariant hash value for the entire pattern
+   // (see patternhash.h); the default implementation scans the bounding
+   // box with nextcell() but algorithms can usually do much better
+   virtual int gethash() ;
    // can we do the gen count doubling? only hashlife
    virtual int hyperCapable() = 0 ;
    virtual void setMaxMemory(int m) = 0 ;          // never alloc more than this
    virtual int getMaxMemory() = 0 ;
+   // bytes allocated so far, or 0 if the algorithm doesn't keep count
+   virtual g_uintptr_t getMemoryUsed() { return 0 ; }
    virtual const char *setrule(const char *) = 0 ; // new rules; returns err msg
    virtual const char *getrule() = 0 ;             // get current rule set
    virtual void step() = 0 ;                       // do inc gens
@@ -85,30 +105,95 @@ public:
    static void setVerbose(int v) { verbose = v ; }
    static int getVerbose() { return verbose ; }
 
+   // Hash table tuning for the hashing algorithms (HashLife and the
+   // ghashbase ones); like verbosity, these are shared by all universes.
+   // The max load factor is how full the node hash may get before we
+   // double it; gcbeforeresize does a gc before each doubling (cheaper
+   // rehash, but costly for patterns where little is garbage).  In
+   // adaptive mode, once memory nears the limit we stop spending it on
+   // the hash table and let the load factor rise instead.  Changes take
+   // effect at a universe's next resize or setMaxMemory call.
+   static void setMaxLoadFactor(double f) ;
+   static double getMaxLoadFactor() { return maxloadfactor ; }
+   static void setGCBeforeResize(int v) { gcbeforeresize = v ; }
+   static int getGCBeforeResize() { return gcbeforeresize ; }
+   static void setAdaptiveLoad(int v) { adaptiveload = v ; }
+   static int getAdaptiveLoad() { return adaptiveload ; }
+
    virtual const char* DefaultRule() { return "B3/S23"; }
    // return number of cell states in this universe (2..256)
    virtual int NumCellStates() { return 2; }
    // return number of states to use when setting random cells
    virtual int NumRandomizedCellStates() { return NumCellStates() ; }
 
-   // timeline support
+   // timeline support; getcurrentstate returns 0 if the algorithm
+   // can't save frames
    virtual void* getcurrentstate() = 0 ;
    virtual void setcurrentstate(void *) = 0 ;
+   // called when frames have been dropped from the timeline, so
+   // algorithms that allocate frames can free the ones no longer used
+   virtual void releaseframes() {}
+   virtual int timelineCapable() { return hyperCapable() ; }
    int startrecording(int base, int expo) ;
    pair<int, int> stoprecording() ;
    pair<int, int> getbaseexpo()
                        { return make_pair(timeline.base, timeline.expo) ; }
    void extendtimeline() ;
    void pruneframes() ;
+   void thinframes() ;
    const bigint &gettimelinestart() { return timeline.start ; }
    const bigint &gettimelineend() { return timeline.end ; }
    const bigint &gettimelineinc() { return timeline.inc ; }
    int getframecount() { return timeline.framecount ; }
+   const bigint &getframegen(int i) { return timeline.gens[i] ; }
    int isrecording() { return timeline.recording ; }
+   // true if recording can't go on because no more frames could be saved
+   int istimelinefull() { return timeline.full ; }
    int gotoframe(int i) ;
    void destroytimeline() ;
    void savetimelinewithframe(int yesno) { timeline.savetimeline = yesno ; }
 
+   // kept states let the GUI hold on to earlier patterns (for undo and
+   // reset) without writing them to files; keepstate returns a ticket,
+   // or 0 if the algorithm can't (or would rather not) keep the current
+   // pattern in memory, in which case the caller should save it some
+   // other way.  restorestate returns 0 if the ticket isn't ours.
+   int keepstate() ;
+   int restorestate(int ticket) ;
+   int ownsstate(int ticket) ;
+   static void forgetstate(int ticket) ;
+   // returns true (once) if a gc found our kept states pinning so much
+   // memory that it could free too little; the caller should save the
+   // oldest ones some other way and forget them
+   int keptstatesoverbudget() ;
+
+   // rectangle editing for algorithms that can work on whole subtrees
+   // rather than single cells, so the rectangles can be any size; edges
+   // are inclusive.  transformrect clears the given rectangle and then
+   // fills the rectangle at newtop,newleft with a flipped or rotated copy
+   // of what was there (or just a copy for MOVE_ONLY).  copyrect copies
+   // the live cells in a rectangle of another universe of the same kind
+   // (killing the cells already in that rectangle if replace is set).
+   // combine replaces our whole pattern with the cells live in both it
+   // and src's pattern, in just one of them, in ours but not src's, or
+   // in either (src's state winning); combinekept does the same with one
+   // of our own kept states.  They return 0 if the algorithm can't do
+   // this, in which case the caller must use getcell/setcell.
+   enum TRectOp { FLIP_TOP_BOTTOM, FLIP_LEFT_RIGHT, ROTATE_CW, ROTATE_ACW,
+                  MOVE_ONLY } ;
+   enum TCombineOp { COMBINE_AND, COMBINE_XOR, COMBINE_SUBTRACT,
+                     COMBINE_OR } ;
+   virtual int rectCapable() { return 0 ; }
+   virtual int transformrect(TRectOp, const bigint &, const bigint &,
+                             const bigint &, const bigint &,
+                             const bigint &, const bigint &) { return 0 ; }
+   virtual int copyrect(lifealgo *, const bigint &, const bigint &,
+                        const bigint &, const bigint &, int) { return 0 ; }
+   virtual int clearrect(const bigint &, const bigint &,
+                         const bigint &, const bigint &) { return 0 ; }
+   virtual int combine(lifealgo *, TCombineOp) { return 0 ; }
+   int combinekept(int ticket, TCombineOp op) ;
+
    // support for a bounded universe with various topologies:
    // plane, cylinder, torus, Klein bottle, cross-surface, sphere
    unsigned int gridwd, gridht ;    // bounded universe if either is > 0
@@ -150,11 +235,21 @@ public:
 protected:
    lifepoll *poller ;
    static int verbose ;
+   static double maxloadfactor ;
+   static int gcbeforeresize, adaptiveload ;
    int maxCellStates ; // keep up to date; setcell depends on it
    bigint generation ;
    bigint increment ;
    timeline_t timeline ;
    TGridType grid_type ;
+   // algorithms that support kept states must override this to say
+   // whether there's room for another one, and must treat the states
+   // returned by getkeptstates as live (like timeline frames)
+   virtual int cankeepstate() { return 0 ; }
+   vector<void *> getkeptstates() ;
+   int keptoverbudget ;   // set by gc, cleared by keptstatesoverbudget
+   // combinekept calls this with the kept state
+   virtual int combinewith(void *, TCombineOp) { return 0 ; }
 
 private:
    // following are called by CreateBorderCells() to join edges in various ways
@@ -0,0 +1,106 @@
+// This file is part of Golly.
+// See docs/License.html for the copyright notice.
+
+/**
+ *   A small open-addressed table mapping nodes to values derived from
+ *   them (hashes, populations, bounding boxes and so on), so the hashing
+ *   algorithms can memoize per-node information without making their
+ *   nodes any bigger.  Since nodes never change, an entry stays valid
+ *   until the node is freed; the owner must call retain() during each
+ *   garbage collection (while the live nodes are marked) or clear() if
+ *   nodes might be freed some other way.  The values must be plain old
+ *   data.  If the owner gives us a counter (its alloced, say) we keep
+ *   it up to date with the size of our table.
+ */
+#ifndef NODEMEMO_H
+#define NODEMEMO_H
+#include "platform.h"
+#include "util.h"
+#include <cstdlib>
+#include <string.h>
+template <class T> class nodememo {
+public:
+   nodememo() : tab(0), size(0), pop(0), counter(0) {}
+   ~nodememo() {
+      if (tab)
+         free(tab) ;
+   }
+   // return the value for this key, or 0 if there isn't one
+   T *lookup(const void *key) const {
+      if (pop == 0)
+         return 0 ;
+      g_uintptr_t i = slot(key) ;
+      while (tab[i].key) {
+         if (tab[i].key == key)
+            return &(tab[i].val) ;
+         i = (i + 1) & (size - 1) ;
+      }
+      return 0 ;
+   }
+   void insert(const void *key, const T &val) {
+      if (2 * (pop + 1) > size)
+         rebuild(size == 0 ? 1024 : 2 * size, 0) ;
+      g_uintptr_t i = slot(key) ;
+      while (tab[i].key) {
+         if (tab[i].key == key) {
+            tab[i].val = val ;
+            return ;
+         }
+         i = (i + 1) & (size - 1) ;
+      }
+      tab[i].key = key ;
+      tab[i].val = val ;
+      pop++ ;
+   }
+   void clear() {
+      if (pop)
+         memset(tab, 0, size * sizeof(entry)) ;
+      pop = 0 ;
+   }
+   // throw away the entries for nodes that keep() says are going away
+   void retain(int (*keep)(const void *key)) {
+      if (pop)
+         rebuild(size, keep) ;
+   }
+   // give the table's memory back; it regrows as entries are added
+   void release() {
+      if (tab)
+         free(tab) ;
+      if (counter)
+         *counter -= size * sizeof(entry) ;
+      tab = 0 ;
+      size = 0 ;
+      pop = 0 ;
+   }
+   void setcounter(g_uintptr_t *c) { counter = c ; }
+   g_uintptr_t memused() const { return size * sizeof(entry) ; }
+private:
+   struct entry {
+      const void *key ;
+      T val ;
+   } ;
+   g_uintptr_t slot(const void *key) const {
+      g_uintptr_t k = (g_uintptr_t)key ;
+      return ((k >> 3) * 2654435761U + (k >> 17)) & (size - 1) ;
+   }
+   void rebuild(g_uintptr_t nsize, int (*keep)(const void *key)) {
+      entry *otab = tab ;
+      g_uintptr_t osize = size ;
+      tab = (entry *)calloc(nsize, sizeof(entry)) ;
+      if (tab == 0)
+         lifefatal("Out of memory in nodememo.") ;
+      if (counter)
+         *counter = *counter + nsize * sizeof(entry) - osize * sizeof(entry) ;
+      size = nsize ;
+      pop = 0 ;
+      for (g_uintptr_t i=0; i<osize; i++)
+         if (otab[i].key && (keep == 0 || keep(otab[i].key)))
+            insert(otab[i].key, otab[i].val) ;
+      if (otab)
+         free(otab) ;
+   }
+   entry *tab ;
+   g_uintptr_t size, pop ;
+   g_uintptr_t *counter ;
+} ;
+#endif
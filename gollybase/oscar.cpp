@@ -0,0 +1,140 @@
+// This file is part of Golly.
+// See docs/License.html for the copyright notice.
+
+#include "oscar.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string.h>
+oscar::oscar() {
+   reset() ;
+}
+void oscar::reset() {
+   minima.clear() ;
+   hasB0notS8 = 0 ;
+   found = empty = 0 ;
+   period = dx = dy = 0 ;
+   desc[0] = 0 ;
+}
+/*
+ *   B0-and-not-S8 rules are emulated by using different rules for odd
+ *   and even generations, so it's possible to have identical patterns
+ *   at gen G and gen G+p if p is odd.  We use the same test as oscar.lua.
+ */
+static int isB0notS8(const char *rule) {
+   char r[200] ;
+   strncpy(r, rule, sizeof(r)-1) ;
+   r[sizeof(r)-1] = 0 ;
+   char *colon = strchr(r, ':') ;
+   if (colon)
+      *colon = 0 ;
+   int len = (int)strlen(r) ;
+   return len > 0 && strncmp(r, "B0", 2) == 0 && strchr(r+1, '/') != 0 &&
+          r[len-1] != '8' ;
+}
+int oscar::check(lifealgo &imp) {
+   if (found)
+      return 1 ;
+   if (minima.size() == 0)
+      hasB0notS8 = isB0notS8(imp.getrule()) ;
+   if (imp.isEmpty()) {
+      found = empty = 1 ;
+      period = dx = dy = 0 ;
+      return 1 ;
+   }
+   sample s ;
+   imp.findedges(&s.t, &s.l, &s.b, &s.r) ;
+   s.hash = imp.gethash() ;
+   s.gen = imp.getGeneration() ;
+   s.pop = imp.getPopulation() ;
+   // determine where to insert the sample into the list of minima
+   unsigned int pos = 0 ;
+   while (pos < minima.size()) {
+      sample &m = minima[pos] ;
+      if (s.hash > m.hash) {
+         pos++ ;
+      } else if (s.hash < m.hash) {
+         // shorten the list and append the sample below
+         minima.resize(pos) ;
+         break ;
+      } else {
+         // the pattern is probably periodic, but just in case this is a
+         // hash collision we also compare the population and box size
+         // (we can't trust an unchanged root node, since a gc may have
+         // freed the old one and reused its address)
+         bigint wd = s.r, mwd = m.r, ht = s.b, mht = m.b ;
+         wd -= s.l ;
+         mwd -= m.l ;
+         ht -= s.t ;
+         mht -= m.t ;
+         if (s.pop == m.pop && wd == mwd && ht == mht) {
+            bigint p = s.gen ;
+            p -= m.gen ;
+            bigint bx = s.l, by = s.t ;
+            bx -= m.l ;
+            by -= m.t ;
+            if (hasB0notS8 && p.odd() && bx == bigint::zero &&
+                by == bigint::zero)
+               return 0 ;
+            found = 1 ;
+            period = p.toint() ;
+            dx = bx.toint() ;
+            dy = by.toint() ;
+            return 1 ;
+         }
+         // look at next matching hash value or insert if no more
+         pos++ ;
+      }
+   }
+   minima.insert(minima.begin() + pos, s) ;
+   return 0 ;
+}
+int oscar::run(lifealgo &imp, int maxgens) {
+   bigint saveinc = imp.getIncrement() ;
+   bool boundedgrid = imp.unbounded && (imp.gridwd > 0 || imp.gridht > 0) ;
+   imp.setIncrement(1) ;
+   for (int i=0; ; i++) {
+      if (check(imp) || i >= maxgens)
+         break ;
+      if (boundedgrid && !imp.CreateBorderCells())
+         break ;
+      imp.step() ;
+      if (boundedgrid && !imp.DeleteBorderCells())
+         break ;
+   }
+   imp.setIncrement(saveinc) ;
+   return found ;
+}
+const char *oscar::describe() {
+   int adx = abs(dx), ady = abs(dy) ;
+   if (!found) {
+      strcpy(desc, "No period detected.") ;
+   } else if (empty) {
+      strcpy(desc, "The pattern is empty.") ;
+   } else if (adx == 0 && ady == 0) {
+      if (period == 1)
+         strcpy(desc, "The pattern is stable.") ;
+      else
+         sprintf(desc, "Oscillator detected (period = %d)", period) ;
+   } else {
+      char speed[40] ;
+      const char *kind = "Spaceship" ;
+      speed[0] = 0 ;
+      if (adx == 0 || ady == 0) {
+         // orthogonal spaceship
+         if (adx > 1 || ady > 1)
+            sprintf(speed, "%d", adx + ady) ;
+      } else if (adx == ady) {
+         // diagonal spaceship
+         if (adx > 1)
+            sprintf(speed, "%d", adx) ;
+      } else {
+         kind = "Knightship" ;
+         sprintf(speed, "%d,%d", ady, adx) ;
+      }
+      if (period == 1)
+         sprintf(desc, "%s detected (speed = %sc)", kind, speed) ;
+      else
+         sprintf(desc, "%s detected (speed = %sc/%d)", kind, speed, period) ;
+   }
+   return desc ;
+}
@@ -0,0 +1,47 @@
+// This file is part of Golly.
+// See docs/License.html for the copyright notice.
+
+/**
+ *   An oscillator and spaceship detector that works with any lifealgo.
+ *   This is a native version of the oscar.lua and oscar.py scripts.
+ *
+ *   We use Gabriel Nivasch's "keep minima" algorithm.  For each
+ *   generation we get a translation-invariant hash of the pattern and
+ *   keep all of the record-breaking minimal hashes in a list, with the
+ *   oldest first.  If the current hash matches one of the saved hashes
+ *   (and the population and bounding box size also match) the pattern
+ *   is almost certainly periodic, and the saved generation and position
+ *   give us the period and the displacement.
+ */
+#ifndef OSCAR_H
+#define OSCAR_H
+#include "lifealgo.h"
+class oscar {
+public:
+   oscar() ;
+   // forget all saved generations
+   void reset() ;
+   // examine the current generation; returns 1 if the pattern is empty
+   // or a period has been found, 0 otherwise
+   int check(lifealgo &imp) ;
+   // check and step by one generation until a period is found or maxgens
+   // generations have been run; returns 1 if found
+   int run(lifealgo &imp, int maxgens) ;
+   // the results of a successful check
+   int found ;          // 1 if empty, stable, oscillating or moving
+   int empty ;          // 1 if the pattern is empty
+   int period ;         // 1 if stable, 0 if empty
+   int dx, dy ;         // displacement (x increases to the right, y down)
+   // describe the result in the same words as oscar.lua
+   const char *describe() ;
+private:
+   struct sample {
+      int hash ;
+      bigint gen, pop ;
+      bigint t, l, b, r ;
+   } ;
+   vector<sample> minima ;
+   int hasB0notS8 ;
+   char desc[100] ;
+} ;
+#endif
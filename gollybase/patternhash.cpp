@@ -0,0 +1,71 @@
+// This file is part of Golly.
+// See docs/License.html for the copyright notice.
+
+#include "patternhash.h"
+#include <vector>
+using std::vector ;
+const phash patternhash::P ;
+const phash patternhash::X ;
+const phash patternhash::Y ;
+phash patternhash::pow(phash a, unsigned int e) {
+   phash r = 1 ;
+   while (e) {
+      if (e & 1)
+         r = mul(r, a) ;
+      a = mul(a, a) ;
+      e >>= 1 ;
+   }
+   return r ;
+}
+/*
+ *   We consume the exponent 31 bits at a time (low31() is cheap), so
+ *   this costs time proportional to the number of bits in e.
+ */
+phash patternhash::pow(phash a, const bigint &e) {
+   bigint ee = e ;
+   if (ee < bigint::zero) {
+      a = inverse(a) ;
+      ee = 0 ;
+      ee -= e ;
+   }
+   phash r = 1 ;
+   while (ee > bigint::zero) {
+      r = mul(r, pow(a, (unsigned int)ee.low31())) ;
+      ee >>= 31 ;
+      if (ee > bigint::zero)
+         for (int i=0; i<31; i++)
+            a = mul(a, a) ;
+   }
+   return r ;
+}
+phash patternhash::inverse(phash a) {
+   // a^(P-2) is the inverse of a, since P is prime
+   phash r = 1 ;
+   phash e = P - 2 ;
+   while (e) {
+      if (e & 1)
+         r = mul(r, a) ;
+      a = mul(a, a) ;
+      e >>= 1 ;
+   }
+   return r ;
+}
+static vector<phash> xpows, ypows ;
+static phash getpow2(vector<phash> &pows, phash base, int k) {
+   if (pows.size() == 0)
+      pows.push_back(base) ;
+   while ((int)pows.size() <= k)
+      pows.push_back(patternhash::mul(pows.back(), pows.back())) ;
+   return pows[k] ;
+}
+phash patternhash::xpow2(int k) {
+   return getpow2(xpows, X, k) ;
+}
+phash patternhash::ypow2(int k) {
+   return getpow2(ypows, Y, k) ;
+}
+int patternhash::fold(phash h) {
+   h ^= h >> 31 ;
+   h *= 0x9e3779b97f4a7c15ULL ;
+   return (int)(h >> 32) ;
+}
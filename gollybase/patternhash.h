@@ -0,0 +1,53 @@
+// This file is part of Golly.
+// See docs/License.html for the copyright notice.
+
+/**
+ *   Translation-invariant pattern hashing.  The hash of a pattern is
+ *
+ *      H = sum over live cells of state * X^x * Y^y   (mod 2^61-1)
+ *
+ *   where (x,y) is the position of the cell relative to some origin,
+ *   with x increasing to the right and y increasing downwards.  Moving
+ *   the origin just multiplies H by a power of X and Y, so an algorithm
+ *   can build the hash of a quadtree node or tile from the hashes of its
+ *   pieces, keep those hashes across generations, and then normalize the
+ *   hash of the whole pattern to its bounding box without looking at the
+ *   cells again.  Every algorithm computes the same value for the same
+ *   pattern (see lifealgo::gethash).
+ */
+#ifndef PATTERNHASH_H
+#define PATTERNHASH_H
+#include "bigint.h"
+#include "platform.h"
+typedef unsigned long long phash ;
+class patternhash {
+public:
+   static const phash P = 0x1fffffffffffffffULL ; // 2^61-1, a prime
+   static const phash X = 0x0a3b1c5d7e9f2461ULL ;
+   static const phash Y = 0x1b2d3f4e5a6c7d83ULL ;
+   static phash add(phash a, phash b) {
+      phash r = a + b ;
+      return r >= P ? r - P : r ;
+   }
+   // this avoids needing a 128-bit product, which MSVC doesn't have
+   static phash mul(phash a, phash b) {
+      phash alo = a & 0xffffffffULL, ahi = a >> 32 ;
+      phash blo = b & 0xffffffffULL, bhi = b >> 32 ;
+      phash lo = alo * blo ;
+      phash mid = alo * bhi + ahi * blo ;
+      phash r = ((ahi * bhi) << 3) + (mid >> 29) +
+                ((mid & 0x1fffffffULL) << 32) + (lo >> 61) + (lo & P) ;
+      r = (r & P) + (r >> 61) ;
+      return r >= P ? r - P : r ;
+   }
+   static phash pow(phash a, unsigned int e) ;
+   // a^e for any e; a negative exponent uses the inverse of a
+   static phash pow(phash a, const bigint &e) ;
+   static phash inverse(phash a) ;
+   // X^(2^k) and Y^(2^k), cached
+   static phash xpow2(int k) ;
+   static phash ypow2(int k) ;
+   // reduce a hash to the int returned by lifealgo::gethash
+   static int fold(phash h) ;
+} ;
+#endif
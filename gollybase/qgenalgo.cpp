@@ -0,0 +1,591 @@
+// This file is part of Golly.
+// See docs/License.html for the copyright notice.
+
+#include "qgenalgo.h"
+#include "util.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <algorithm>
+
+using namespace std ;
+
+typedef unsigned long long bits64 ;
+static const int TS = QGENTILESIZE ;
+static const bits64 LEFTBIT = 1ULL << 63 ;
+
+// tiles beyond these can't be reached with int cell coordinates
+static const int MINTILE = INT_MIN >> QGENTILEBITS ;
+static const int MAXTILE = INT_MAX >> QGENTILEBITS ;
+
+static inline int tilehash(int x, int y) {
+   unsigned int h = (unsigned int)x * 0x9e3779b1u ^ (unsigned int)y * 0x85ebca77u ;
+   return (int)(h ^ (h >> 15)) ;
+}
+
+qgenalgo::qgenalgo() {
+   nplanes = 0 ;
+   planewords = TS ;
+   hashmask = 255 ;
+   hashtab = (qgentile **)calloc(hashmask + 1, sizeof(qgentile *)) ;
+   if (hashtab == 0)
+      lifefatal("Out of memory in qgenalgo.") ;
+   rowindexvalid = false ;
+   population = 0 ;
+   popValid = true ;
+   maxmemory = 0 ;
+   usedmemory = (hashmask + 1) * sizeof(qgentile *) ;
+   generation = 0 ;
+   increment = 1 ;
+   maxCellStates = genrules.numstates ;
+   memset(ruletable, 0, sizeof(ruletable)) ;
+   counting = false ;
+   for (int i=0; i<8; i++)
+      nbmask[i] = 0 ;
+   for (int i=0; i<9; i++)
+      birth[i] = survival[i] = false ;
+}
+
+qgenalgo::~qgenalgo() {
+   for (size_t i=0; i<tiles.size(); i++)
+      free(tiles[i]) ;
+   for (size_t i=0; i<freetiles.size(); i++)
+      free(freetiles[i]) ;
+   free(hashtab) ;
+}
+
+void qgenalgo::clearall() {
+   for (size_t i=0; i<tiles.size(); i++)
+      freetile(tiles[i]) ;
+   tiles.clear() ;
+   population = 0 ;
+   popValid = true ;
+}
+
+/*
+ *   Set the max memory; 0 means no limit.
+ */
+void qgenalgo::setMaxMemory(int newmemlimit) {
+   if (newmemlimit == 0) {
+      maxmemory = 0 ;
+      return ;
+   }
+   if (newmemlimit < 10)
+      newmemlimit = 10 ;
+#ifndef GOLLY64BIT
+   else if (newmemlimit > 4000)
+      newmemlimit = 4000 ;
+#endif
+   g_uintptr_t newlimit = ((g_uintptr_t)newmemlimit) << 20 ;
+   if (usedmemory > newlimit) {
+      lifewarning("Sorry, more memory currently used than allowed.") ;
+      return ;
+   }
+   maxmemory = newlimit ;
+}
+
+/*
+ *   Count memory we're about to allocate.  Like QuickLife we can't
+ *   free anything to make room, so going over the limit is fatal.
+ */
+void qgenalgo::usememory(g_uintptr_t bytes) {
+   usedmemory += bytes ;
+   if (maxmemory != 0 && usedmemory > maxmemory)
+      lifefatal("exceeded user-specified memory limit") ;
+}
+
+qgentile *qgenalgo::findtile(int x, int y) {
+   qgentile *t = hashtab[tilehash(x, y) & hashmask] ;
+   while (t && (t->x != x || t->y != y))
+      t = t->hnext ;
+   return t ;
+}
+
+/*
+ *   Find the tile at x,y, making an empty one if there isn't one yet.
+ *   The tile and both generations of its bit-planes are one allocation.
+ */
+qgentile *qgenalgo::gettile(int x, int y) {
+   qgentile *t = findtile(x, y) ;
+   if (t)
+      return t ;
+   if (freetiles.size() > 0) {
+      t = freetiles.back() ;
+      freetiles.pop_back() ;
+   } else {
+      usememory(sizeof(qgentile) + 2 * planewords * sizeof(bits64)) ;
+      t = (qgentile *)malloc(sizeof(qgentile) + 2 * planewords * sizeof(bits64)) ;
+      if (t == 0)
+         lifefatal("Out of memory in qgenalgo.") ;
+      t->cur = (bits64 *)(t + 1) ;
+      t->nxt = t->cur + planewords ;
+   }
+   memset(t->cur, 0, planewords * sizeof(bits64)) ;
+   t->x = x ;
+   t->y = y ;
+   int h = tilehash(x, y) & hashmask ;
+   t->hnext = hashtab[h] ;
+   hashtab[h] = t ;
+   tiles.push_back(t) ;
+   rowindexvalid = false ;
+   if ((int)tiles.size() > hashmask)
+      rehash(2 * (hashmask + 1)) ;
+   return t ;
+}
+
+/*
+ *   Take a tile out of the hash table and keep it for reuse.  The caller
+ *   has to take it out of the tiles vector.
+ */
+void qgenalgo::freetile(qgentile *t) {
+   qgentile **pp = &hashtab[tilehash(t->x, t->y) & hashmask] ;
+   while (*pp != t)
+      pp = &(*pp)->hnext ;
+   *pp = t->hnext ;
+   freetiles.push_back(t) ;
+   rowindexvalid = false ;
+}
+
+void qgenalgo::rehash(int newsize) {
+   usememory((newsize - (hashmask + 1)) * sizeof(qgentile *)) ;
+   qgentile **newtab = (qgentile **)calloc(newsize, sizeof(qgentile *)) ;
+   if (newtab == 0)
+      lifefatal("Out of memory in qgenalgo.") ;
+   free(hashtab) ;
+   hashtab = newtab ;
+   hashmask = newsize - 1 ;
+   for (size_t i=0; i<tiles.size(); i++) {
+      qgentile *t = tiles[i] ;
+      int h = tilehash(t->x, t->y) & hashmask ;
+      t->hnext = hashtab[h] ;
+      hashtab[h] = t ;
+   }
+}
+
+/*
+ *   A rule with more states needs more decay planes; copy every tile
+ *   into a bigger allocation.  We never drop planes (until the universe
+ *   is destroyed) because the GUI reads the old states after a rule
+ *   change to see which ones need reducing.
+ */
+void qgenalgo::addplanes(int np) {
+   int newwords = (1 + np) * TS ;
+   g_uintptr_t oldbytes = sizeof(qgentile) + 2 * planewords * sizeof(bits64) ;
+   g_uintptr_t newbytes = sizeof(qgentile) + 2 * newwords * sizeof(bits64) ;
+   for (size_t i=0; i<freetiles.size(); i++)
+      free(freetiles[i]) ;
+   usedmemory -= freetiles.size() * oldbytes ;
+   freetiles.clear() ;
+   for (size_t i=0; i<tiles.size(); i++) {
+      qgentile *t = tiles[i] ;
+      usememory(newbytes) ;
+      qgentile *nt = (qgentile *)malloc(sizeof(qgentile) + 2 * newwords * sizeof(bits64)) ;
+      if (nt == 0)
+         lifefatal("Out of memory in qgenalgo.") ;
+      nt->x = t->x ;
+      nt->y = t->y ;
+      nt->cur = (bits64 *)(nt + 1) ;
+      nt->nxt = nt->cur + newwords ;
+      memset(nt->cur, 0, newwords * sizeof(bits64)) ;
+      memcpy(nt->cur, t->cur, planewords * sizeof(bits64)) ;
+      free(t) ;
+      usedmemory -= oldbytes ;
+      tiles[i] = nt ;
+   }
+   nplanes = np ;
+   planewords = newwords ;
+   rowindexvalid = false ;
+   rehash(hashmask + 1) ;
+}
+
+int qgenalgo::tilestate(qgentile *t, int col, int row) {
+   bits64 bit = LEFTBIT >> col ;
+   bits64 *p = t->cur + row ;
+   if (p[0] & bit)
+      return 1 ;
+   int d = 0 ;
+   for (int i=nplanes; i>0; i--)
+      d = (d << 1) | ((p[i * TS] & bit) ? 1 : 0) ;
+   return d ? d + 1 : 0 ;
+}
+
+int qgenalgo::setcell(int x, int y, int newstate) {
+   if (newstate < 0 || newstate >= maxCellStates)
+      return -1 ;
+   qgentile *t = newstate ? gettile(x >> QGENTILEBITS, y >> QGENTILEBITS)
+                          : findtile(x >> QGENTILEBITS, y >> QGENTILEBITS) ;
+   if (t == 0)
+      return 0 ;
+   bits64 bit = LEFTBIT >> (x & (TS - 1)) ;
+   bits64 *p = t->cur + (y & (TS - 1)) ;
+   if (newstate == 1)
+      p[0] |= bit ;
+   else
+      p[0] &= ~bit ;
+   int d = newstate > 1 ? newstate - 1 : 0 ;
+   for (int i=1; i<=nplanes; i++, d >>= 1) {
+      if (d & 1)
+         p[i * TS] |= bit ;
+      else
+         p[i * TS] &= ~bit ;
+   }
+   popValid = false ;
+   return 0 ;
+}
+
+int qgenalgo::getcell(int x, int y) {
+   qgentile *t = findtile(x >> QGENTILEBITS, y >> QGENTILEBITS) ;
+   if (t == 0)
+      return 0 ;
+   return tilestate(t, x & (TS - 1), y & (TS - 1)) ;
+}
+
+static bool rowless(const qgentile *a, const qgentile *b) {
+   return a->y < b->y || (a->y == b->y && a->x < b->x) ;
+}
+
+void qgenalgo::buildrowindex() {
+   rowindex = tiles ;
+   sort(rowindex.begin(), rowindex.end(), rowless) ;
+   rowindexvalid = true ;
+}
+
+/*
+ *   Callers scan a row with nextcell/setcell, so keep the tiles sorted
+ *   by row and find the first one at or right of x with a binary search.
+ *   Only adding or removing a tile spoils the index.
+ */
+int qgenalgo::nextcell(int x, int y, int &v) {
+   if (!rowindexvalid)
+      buildrowindex() ;
+   int tx = x >> QGENTILEBITS ;
+   int ty = y >> QGENTILEBITS ;
+   int row = y & (TS - 1) ;
+   size_t lo = 0, hi = rowindex.size() ;
+   while (lo < hi) {
+      size_t mid = (lo + hi) / 2 ;
+      qgentile *t = rowindex[mid] ;
+      if (t->y < ty || (t->y == ty && t->x < tx))
+         lo = mid + 1 ;
+      else
+         hi = mid ;
+   }
+   for (size_t i=lo; i<rowindex.size() && rowindex[i]->y == ty; i++) {
+      qgentile *t = rowindex[i] ;
+      bits64 w = 0 ;
+      for (int p=0; p<=nplanes; p++)
+         w |= t->cur[p * TS + row] ;
+      if (t->x == tx)
+         w &= ~0ULL >> (x & (TS - 1)) ;
+      if (w) {
+         int col = qgenleftcol(w) ;
+         v = tilestate(t, col, row) ;
+         return t->x * TS + col - x ;
+      }
+   }
+   return -1 ;
+}
+
+const bigint &qgenalgo::getPopulation() {
+   if (!popValid) {
+      G_INT64 pop = 0 ;
+      for (size_t i=0; i<tiles.size(); i++) {
+         bits64 *cur = tiles[i]->cur ;
+         for (int r=0; r<TS; r++) {
+            bits64 w = 0 ;
+            for (int p=0; p<=nplanes; p++)
+               w |= cur[p * TS + r] ;
+            pop += qgenpopcount(w) ;
+         }
+      }
+      population = bigint(pop) ;
+      popValid = true ;
+   }
+   return population ;
+}
+
+int qgenalgo::isEmpty() {
+   return getPopulation() == 0 ;
+}
+
+static const char *DEFAULTRULE = "12/34/3" ;
+const char *qgenalgo::DefaultRule() {
+   return DEFAULTRULE ;
+}
+
+const char *qgenalgo::setrule(const char *s) {
+   poller->bailIfCalculating() ;
+   const char *err = genrules.setrule(s, this) ;
+   if (err)
+      return err ;
+   maxCellStates = genrules.numstates ;
+
+   // decay counts go up to maxCellStates-2
+   int np = 0 ;
+   while ((1 << np) < maxCellStates - 1)
+      np++ ;
+   if (np > nplanes)
+      addplanes(np) ;
+   maketables() ;
+
+   if (genrules.isHexagonal())
+      grid_type = HEX_GRID ;
+   else if (genrules.isVonNeumann())
+      grid_type = VN_GRID ;
+   else
+      grid_type = SQUARE_GRID ;
+   return 0 ;
+}
+
+/*
+ *   Work out whether the rule only depends on how many of some set of
+ *   neighbors are live (this is true for all totalistic rules, including
+ *   the hexagonal and von Neumann ones) so dogen can count neighbors
+ *   with adders instead of looking up every cell.
+ */
+void qgenalgo::maketables() {
+   static const int nbbits[8] = { 256, 128, 64, 32, 8, 4, 2, 1 } ;
+   for (int i=0; i<ALL3X3; i++)
+      ruletable[i] = genrules.rule3x3[i] ? 1 : 0 ;
+   int used = 0 ;
+   for (int i=0; i<ALL3X3; i++)
+      for (int j=0; j<8; j++)
+         if (ruletable[i] != ruletable[i ^ nbbits[j]])
+            used |= nbbits[j] ;
+   for (int j=0; j<8; j++)
+      nbmask[j] = (used & nbbits[j]) ? ~0ULL : 0 ;
+   int result[2][9] ;
+   for (int k=0; k<9; k++)
+      result[0][k] = result[1][k] = -1 ;
+   counting = true ;
+   for (int i=0; i<ALL3X3 && counting; i++) {
+      int center = (i >> 4) & 1 ;
+      int count = 0 ;
+      for (int j=0; j<8; j++)
+         if (i & used & nbbits[j])
+            count++ ;
+      if (result[center][count] < 0)
+         result[center][count] = ruletable[i] ;
+      else if (result[center][count] != ruletable[i])
+         counting = false ;
+   }
+   for (int k=0; k<9; k++) {
+      birth[k] = result[0][k] == 1 ;
+      survival[k] = result[1][k] == 1 ;
+   }
+}
+
+/*
+ *   Compute the next generation of one tile into its nxt planes.
+ */
+void qgenalgo::calctile(qgentile *t) {
+   // gather the live rows from -1 to TS, plus the same rows shifted so
+   // each cell lines up with its west and east neighbors
+   bits64 mid[TS + 2], west[TS + 2], east[TS + 2] ;
+   for (int j=0; j<3; j++) {
+      int ty = t->y + j - 1 ;
+      qgentile *l = findtile(t->x - 1, ty) ;
+      qgentile *m = j == 1 ? t : findtile(t->x, ty) ;
+      qgentile *r = findtile(t->x + 1, ty) ;
+      int first = j == 0 ? TS - 1 : 0 ;
+      int last = j == 1 ? TS - 1 : first ;
+      int dest = j == 0 ? 0 : (j == 1 ? 1 : TS + 1) ;
+      for (int row=first; row<=last; row++, dest++) {
+         bits64 lw = l ? l->cur[row] : 0 ;
+         bits64 mw = m ? m->cur[row] : 0 ;
+         bits64 rw = r ? r->cur[row] : 0 ;
+         mid[dest] = mw ;
+         west[dest] = (mw >> 1) | (lw << 63) ;
+         east[dest] = (mw << 1) | (rw >> 63) ;
+      }
+   }
+   bits64 *cur = t->cur ;
+   bits64 *nxt = t->nxt ;
+   int deadcount = maxCellStates - 1 ;     // first decay count that is dead
+   for (int r=0; r<TS; r++) {
+      bits64 c = mid[r + 1] ;
+      bits64 decaying = 0 ;
+      for (int p=1; p<=nplanes; p++)
+         decaying |= cur[p * TS + r] ;
+      bits64 live ;
+      if (counting) {
+         bits64 a0 = west[r] & nbmask[0], a1 = mid[r] & nbmask[1], a2 = east[r] & nbmask[2] ;
+         bits64 b0 = west[r + 1] & nbmask[3], b2 = east[r + 1] & nbmask[4] ;
+         bits64 c0 = west[r + 2] & nbmask[5], c1 = mid[r + 2] & nbmask[6], c2 = east[r + 2] & nbmask[7] ;
+         // add up the neighbors: first the three rows, then their sums
+         // and carries, giving the count in ones + 2*twos + 4*fours + 8*eights
+         bits64 s1 = a0 ^ a1 ^ a2, k1 = (a0 & a1) | (a2 & (a0 ^ a1)) ;
+         bits64 s2 = c0 ^ c1 ^ c2, k2 = (c0 & c1) | (c2 & (c0 ^ c1)) ;
+         bits64 s3 = b0 ^ b2, k3 = b0 & b2 ;
+         bits64 ones = s1 ^ s2 ^ s3, k4 = (s1 & s2) | (s3 & (s1 ^ s2)) ;
+         bits64 t1 = k1 ^ k2 ^ k3, k5 = (k1 & k2) | (k3 & (k1 ^ k2)) ;
+         bits64 twos = t1 ^ k4, k6 = t1 & k4 ;
+         bits64 fours = k5 ^ k6, eights = k5 & k6 ;
+         bits64 born = 0, survive = 0 ;
+         for (int k=0; k<9; k++) {
+            if (!birth[k] && !survival[k])
+               continue ;
+            bits64 eq = ((k & 1) ? ones : ~ones) & ((k & 2) ? twos : ~twos) &
+                        ((k & 4) ? fours : ~fours) & ((k & 8) ? eights : ~eights) ;
+            if (birth[k])
+               born |= eq ;
+            if (survival[k])
+               survive |= eq ;
+         }
+         live = (c & survive) | (~c & ~decaying & born) ;
+      } else {
+         // look up each live or dead cell that has a live cell nearby
+         bits64 cand = (west[r] | mid[r] | east[r] | west[r + 1] | c | east[r + 1] |
+                        west[r + 2] | mid[r + 2] | east[r + 2]) & ~decaying ;
+         live = 0 ;
+         while (cand) {
+            int col = qgenleftcol(cand) ;
+            int sh = 63 - col ;
+            int index = (int)((((west[r] >> sh) & 1) << 8) | (((mid[r] >> sh) & 1) << 7) |
+                              (((east[r] >> sh) & 1) << 6) | (((west[r + 1] >> sh) & 1) << 5) |
+                              (((c >> sh) & 1) << 4) | (((east[r + 1] >> sh) & 1) << 3) |
+                              (((west[r + 2] >> sh) & 1) << 2) | (((mid[r + 2] >> sh) & 1) << 1) |
+                              ((east[r + 2] >> sh) & 1)) ;
+            if (ruletable[index])
+               live |= LEFTBIT >> col ;
+            cand &= ~(LEFTBIT >> col) ;
+         }
+      }
+      nxt[r] = live ;
+      if (nplanes == 0)
+         continue ;
+
+      // add one to every decay count, then kill the cells whose count
+      // reached deadcount (or overflowed), then start the dying cells at 1
+      bits64 carry = decaying ;
+      for (int p=1; p<=nplanes; p++) {
+         bits64 v = cur[p * TS + r] ;
+         nxt[p * TS + r] = v ^ carry ;
+         carry &= v ;
+      }
+      bits64 dead = carry ;
+      if ((deadcount >> nplanes) == 0) {
+         bits64 eq = ~carry ;
+         for (int p=nplanes; p>0; p--) {
+            bits64 v = nxt[p * TS + r] ;
+            if ((deadcount >> (p - 1)) & 1) {
+               eq &= v ;
+            } else {
+               dead |= eq & v ;
+               eq &= ~v ;
+            }
+         }
+         dead |= eq ;
+      }
+      for (int p=1; p<=nplanes; p++)
+         nxt[p * TS + r] &= ~dead ;
+      if (deadcount > 1)
+         nxt[TS + r] |= c & ~live ;
+   }
+}
+
+void qgenalgo::dogen() {
+   poller->reset_countdown() ;
+
+   // a cell can only be born next to a live cell, so make sure every
+   // edge of a tile with live cells on it has a tile beyond it
+   size_t n = tiles.size() ;
+   for (size_t i=0; i<n; i++) {
+      qgentile *t = tiles[i] ;
+      bits64 *live = t->cur ;
+      bits64 any = 0 ;
+      for (int r=0; r<TS; r++)
+         any |= live[r] ;
+      if (any == 0)
+         continue ;
+      int x = t->x, y = t->y ;
+      bool left = (any & LEFTBIT) && x > MINTILE ;
+      bool right = (any & 1) && x < MAXTILE ;
+      bool top = live[0] && y > MINTILE ;
+      bool bottom = live[TS - 1] && y < MAXTILE ;
+      if (top)
+         gettile(x, y - 1) ;
+      if (bottom)
+         gettile(x, y + 1) ;
+      if (left)
+         gettile(x - 1, y) ;
+      if (right)
+         gettile(x + 1, y) ;
+      if (top && left && (live[0] & LEFTBIT))
+         gettile(x - 1, y - 1) ;
+      if (top && right && (live[0] & 1))
+         gettile(x + 1, y - 1) ;
+      if (bottom && left && (live[TS - 1] & LEFTBIT))
+         gettile(x - 1, y + 1) ;
+      if (bottom && right && (live[TS - 1] & 1))
+         gettile(x + 1, y + 1) ;
+   }
+
+   n = tiles.size() ;
+   for (size_t i=0; i<n; i++)
+      calctile(tiles[i]) ;
+
+   // switch to the new generation, dropping tiles that are now empty
+   G_INT64 pop = 0 ;
+   size_t kept = 0 ;
+   for (size_t i=0; i<n; i++) {
+      qgentile *t = tiles[i] ;
+      bits64 *tmp = t->cur ;
+      t->cur = t->nxt ;
+      t->nxt = tmp ;
+      G_INT64 tilepop = 0 ;
+      for (int r=0; r<TS; r++) {
+         bits64 w = 0 ;
+         for (int p=0; p<=nplanes; p++)
+            w |= t->cur[p * TS + r] ;
+         if (w)
+            tilepop += qgenpopcount(w) ;
+      }
+      if (tilepop == 0) {
+         freetile(t) ;
+      } else {
+         tiles[kept++] = t ;
+         pop += tilepop ;
+      }
+   }
+   tiles.resize(kept) ;
+   population = bigint(pop) ;
+   popValid = true ;
+   generation += bigint::one ;
+}
+
+void qgenalgo::step() {
+   poller->bailIfCalculating() ;
+   bigint t = increment ;
+   while (t != 0) {
+      dogen() ;
+      if (poller->isInterrupted() || poller->poll())
+         break ;
+      t -= 1 ;
+      if (t > increment) // might change; make it happen now
+         t = increment ;
+   }
+}
+
+static lifealgo *creator() { return new qgenalgo() ; }
+
+void qgenalgo::doInitializeAlgoInfo(staticAlgoInfo &ai) {
+   ai.setAlgorithmName("QuickGen") ;
+   ai.setAlgorithmCreator(&creator) ;
+   ai.setDefaultBaseStep(10) ;
+   ai.setDefaultMaxMem(0) ;
+   ai.minstates = 2 ;
+   ai.maxstates = 256 ;
+   // init default color scheme (same as Generations)
+   ai.defgradient = true ;              // use gradient
+   ai.defr1 = 255 ;                     // start color = red
+   ai.defg1 = 0 ;
+   ai.defb1 = 0 ;
+   ai.defr2 = 255 ;                     // end color = yellow
+   ai.defg2 = 255 ;
+   ai.defb2 = 0 ;
+   // if not using gradient then set all states to white
+   for (int i=0 ; i<256 ; i++) {
+      ai.defr[i] = ai.defg[i] = ai.defb[i] = 255 ;
+   }
+}
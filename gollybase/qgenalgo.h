@@ -0,0 +1,151 @@
+// This file is part of Golly.
+// See docs/License.html for the copyright notice.
+
+/**
+ *   This is a "conventional" (non-hashing) algorithm for Generations
+ *   rules; it does for generationsalgo what qlifealgo does for hlifealgo.
+ *   Chaotic Generations patterns (Brian's Brain, Star Wars, ...) hash
+ *   badly, and this algorithm doesn't try.
+ */
+#ifndef QGENALGO_H
+#define QGENALGO_H
+#include "lifealgo.h"
+#include "generationsalgo.h"
+#include "util.h"         // for FASTPOPCOUNT
+#include <vector>
+/*
+ *   The universe is divided into 64x64 tiles and we only keep the tiles
+ *   that contain non-zero cells (or might get some in the next
+ *   generation).  Each row of a tile is a 64-bit word, with the most
+ *   significant bit the leftmost cell.
+ *
+ *   The live (state 1) cells are kept in one bit-plane.  A dying cell
+ *   counts up through states 2..n-1 and is then dead, so those states
+ *   are kept as a decay count d = state-1 spread over nplanes more
+ *   bit-planes (d is zero for live and dead cells).  That lets us
+ *   advance every dying cell in a row with a few bitwise operations.
+ *
+ *   The live cells are computed from the rule's rule3x3 table.  If the
+ *   table only depends on how many neighbors are live, we count the
+ *   neighbors of a row of cells at once with bit-sliced adders;
+ *   otherwise we look the table up for each cell that has a live cell
+ *   in its neighborhood.
+ */
+const int QGENTILEBITS = 6 ;
+const int QGENTILESIZE = 1 << QGENTILEBITS ;  // cells along a tile edge
+/*
+ *   Bit twiddling helpers.  Column 0 of a tile is the most significant
+ *   bit, so the leftmost cell in a non-zero row is its leading zero count.
+ */
+static inline int qgenpopcount(unsigned long long w) {
+#ifdef FASTPOPCOUNT
+   return FASTPOPCOUNT((unsigned int)w) + FASTPOPCOUNT((unsigned int)(w >> 32)) ;
+#else
+   int r = 0 ;
+   while (w) {
+      r++ ;
+      w &= w - 1 ;
+   }
+   return r ;
+#endif
+}
+
+static inline int qgenleftcol(unsigned long long w) {
+#ifdef __GNUC__
+   return __builtin_clzll(w) ;
+#else
+   int n = 0 ;
+   while (!(w & (1ULL << 63))) {
+      w <<= 1 ;
+      n++ ;
+   }
+   return n ;
+#endif
+}
+
+static inline int qgenrightcol(unsigned long long w) {
+#ifdef __GNUC__
+   return 63 - __builtin_ctzll(w) ;
+#else
+   int n = 63 ;
+   while (!(w & 1)) {
+      w >>= 1 ;
+      n-- ;
+   }
+   return n ;
+#endif
+}
+
+struct qgentile {
+   qgentile *hnext ;             // next tile in the same hash bucket
+   int x, y ;                    // tile coordinates (cell coordinates >> 6)
+   unsigned long long *cur ;     // bit-planes for this generation
+   unsigned long long *nxt ;     // bit-planes for the next generation
+} ;
+class qgenalgo : public lifealgo {
+public:
+   qgenalgo() ;
+   virtual ~qgenalgo() ;
+   virtual void clearall() ;
+   virtual int setcell(int x, int y, int newstate) ;
+   virtual int getcell(int x, int y) ;
+   virtual int nextcell(int x, int y, int &v) ;
+   virtual void endofpattern() {}
+   virtual void setIncrement(bigint inc) { increment = inc ; }
+   virtual void setIncrement(int inc) { increment = inc ; }
+   virtual void setGeneration(bigint gen) { generation = gen ; }
+   virtual const bigint &getPopulation() ;
+   virtual int isEmpty() ;
+   virtual int hyperCapable() { return 0 ; }
+   virtual void setMaxMemory(int m) ;
+   virtual int getMaxMemory() { return (int)(maxmemory >> 20) ; }
+   virtual g_uintptr_t getMemoryUsed() { return usedmemory ; }
+   virtual const char *setrule(const char *s) ;
+   virtual const char *getrule() { return genrules.getrule() ; }
+   virtual const char *DefaultRule() ;
+   virtual int NumCellStates() { return maxCellStates ; }
+   virtual void step() ;
+   virtual void *getcurrentstate() { return 0 ; }
+   virtual void setcurrentstate(void *) {}
+   virtual void draw(viewport &view, liferender &renderer) ;
+   virtual void fit(viewport &view, int force) ;
+   virtual void lowerRightPixel(bigint &x, bigint &y, int mag) ;
+   virtual void findedges(bigint *t, bigint *l, bigint *b, bigint *r) ;
+   virtual const char *writeNativeFormat(std::ostream &, char *) {
+      return "No native format for qgenalgo." ;
+   }
+   static void doInitializeAlgoInfo(staticAlgoInfo &) ;
+
+private:
+   generationsrules genrules ;
+   int nplanes ;                 // decay planes per tile (never shrinks)
+   int planewords ;              // words per generation: (1+nplanes)*64
+   vector<qgentile *> tiles ;    // all tiles, in no particular order
+   qgentile **hashtab ;          // tiles hashed on their coordinates
+   int hashmask ;                // hash table size - 1
+   vector<qgentile *> freetiles ;
+   vector<qgentile *> rowindex ; // tiles sorted by y then x, for nextcell
+   bool rowindexvalid ;
+   bigint population ;
+   bool popValid ;
+   g_uintptr_t maxmemory, usedmemory ; // tiles and hash table, in bytes
+
+   // the rule, as used by dogen
+   char ruletable[ALL3X3] ;      // copy of genrules.rule3x3
+   bool counting ;               // ruletable only depends on neighbor count?
+   unsigned long long nbmask[8] ; // all ones for each neighbor that counts
+   bool birth[9], survival[9] ;  // if counting, what each count does
+
+   void usememory(g_uintptr_t bytes) ;
+   qgentile *findtile(int x, int y) ;
+   qgentile *gettile(int x, int y) ;
+   void freetile(qgentile *t) ;
+   void rehash(int newsize) ;
+   void addplanes(int np) ;
+   void maketables() ;
+   void dogen() ;
+   void calctile(qgentile *t) ;
+   void buildrowindex() ;
+   int tilestate(qgentile *t, int col, int row) ;
+} ;
+#endif
@@ -0,0 +1,271 @@
+// This file is part of Golly.
+// See docs/License.html for the copyright notice.
+
+#include "qgenalgo.h"
+#include "util.h"
+#include <string.h>
+#include <stdlib.h>
+
+typedef unsigned long long bits64 ;
+static const int TS = QGENTILESIZE ;
+
+// A 256x256 pixmap is good for OpenGL and matches the size
+// used in the other drawing code.
+
+const int logpmsize = 8 ;                    // 8=256x256
+const int pmsize = (1<<logpmsize) ;          // pixmap wd and ht, in pixels
+static unsigned int pixRGBAbuf[pmsize*pmsize] ; // one block of RGBA pixels
+
+static unsigned int cellRGBA[256] ;          // cell colors in RGBA format
+
+// cell states for a whole tile, for stateblit and scaled pixblit calls
+static unsigned char tilestates[QGENTILESIZE*QGENTILESIZE] ;
+
+// when a pixel shows one or more cells, the view is first drawn into
+// viewstates (one byte per pixel, padded to whole pmsize blocks) and
+// then the blocks that have any live pixels are blitted
+static unsigned char *viewstates = 0 ;
+static int viewstatesize = 0 ;
+static unsigned char *blockdirty = 0 ;
+static int blockdirtysize = 0 ;
+
+// fill tilestates from a tile; returns false if the tile is empty
+
+static bool gettilestates(qgentile *t, int nplanes) {
+   bool any = false ;
+   memset(tilestates, 0, sizeof(tilestates)) ;
+   for (int r = 0; r < TS; r++) {
+      bits64 w = 0 ;
+      for (int p = 0; p <= nplanes; p++)
+         w |= t->cur[p * TS + r] ;
+      while (w) {
+         int col = qgenleftcol(w) ;
+         bits64 bit = (1ULL << 63) >> col ;
+         int state = 1 ;
+         if (!(t->cur[r] & bit)) {
+            int d = 0 ;
+            for (int p = nplanes; p > 0; p--)
+               d = (d << 1) | ((t->cur[p * TS + r] & bit) ? 1 : 0) ;
+            state = d + 1 ;
+         }
+         tilestates[r * TS + col] = (unsigned char) state ;
+         w &= ~bit ;
+         any = true ;
+      }
+   }
+   return any ;
+}
+
+// this is the top-level drawing routine
+
+void qgenalgo::draw(viewport &view, liferender &renderer) {
+   if (tiles.empty()) return ;
+
+   if (!renderer.justState()) {
+      // get cell colors and alpha values for dead and live pixels
+      unsigned char *cellred, *cellgreen, *cellblue ;
+      unsigned char deada, livea ;
+      renderer.getcolors(&cellred, &cellgreen, &cellblue, &deada, &livea) ;
+      unsigned char *rgbaptr = (unsigned char *)cellRGBA ;
+      for (int i = 0; i < maxCellStates; i++) {
+         *rgbaptr++ = cellred[i] ;
+         *rgbaptr++ = cellgreen[i] ;
+         *rgbaptr++ = cellblue[i] ;
+         *rgbaptr++ = i ? livea : deada ;
+      }
+   }
+
+   int vieww = view.getwidth() ;
+   int viewh = view.getheight() ;
+   int mag = view.getmag() ;
+
+   if (renderer.justState() || mag > 0) {
+      // each tile is blitted as a block of cell states
+      int pmag = mag > 0 ? 1 << mag : 1 ;
+      int size = TS * pmag ;
+      for (size_t i = 0; i < tiles.size(); i++) {
+         qgentile *t = tiles[i] ;
+         pair<int,int> pos = view.screenPosOf(bigint(t->x * TS), bigint(t->y * TS), this) ;
+         if (pos.first >= vieww || pos.second >= viewh ||
+             pos.first <= -size || pos.second <= -size)
+            continue ;
+         if (!gettilestates(t, nplanes))
+            continue ;
+         if (renderer.justState())
+            renderer.stateblit(pos.first, pos.second, TS, TS, tilestates) ;
+         else
+            renderer.pixblit(pos.first, pos.second, size, size, tilestates, pmag) ;
+      }
+      return ;
+   }
+
+   // a pixel shows 2^shrink by 2^shrink cells; zoomed out, any non-zero
+   // cell in that square draws the pixel in the state 1 color
+   int shrink = -mag ;
+   if (shrink > 62) shrink = 62 ;
+   G_INT64 unitmask = (1LL << shrink) - 1 ;
+   int blocksacross = (vieww + pmsize - 1) >> logpmsize ;
+   int blocksdown = (viewh + pmsize - 1) >> logpmsize ;
+   int stride = blocksacross * pmsize ;
+   int needed = stride * blocksdown * pmsize ;
+   if (needed > viewstatesize) {
+      free(viewstates) ;
+      viewstates = (unsigned char *)calloc(needed, 1) ;
+      if (viewstates == 0) {
+         viewstatesize = 0 ;
+         lifewarning("Not enough memory to draw the view.") ;
+         return ;
+      }
+      viewstatesize = needed ;
+   }
+   if (blocksacross * blocksdown > blockdirtysize) {
+      free(blockdirty) ;
+      blockdirtysize = blocksacross * blocksdown ;
+      blockdirty = (unsigned char *)calloc(blockdirtysize, 1) ;
+      if (blockdirty == 0) {
+         blockdirtysize = 0 ;
+         lifewarning("Not enough memory to draw the view.") ;
+         return ;
+      }
+   }
+
+   for (size_t i = 0; i < tiles.size(); i++) {
+      qgentile *t = tiles[i] ;
+      pair<int,int> pos = view.screenPosOf(bigint(t->x * TS), bigint(t->y * TS), this) ;
+      if (pos.first >= vieww || pos.second >= viewh ||
+          pos.first <= -TS || pos.second <= -TS)
+         continue ;
+      // pos is the pixel holding the tile's top left cell; these are
+      // how far into that pixel the cell is (see lowerRightPixel)
+      G_INT64 xoff = ((G_INT64)t->x * TS) & unitmask ;
+      G_INT64 yoff = ((G_INT64)t->y * TS - 1) & unitmask ;
+      for (int r = 0; r < TS; r++) {
+         bits64 w = 0 ;
+         for (int p = 0; p <= nplanes; p++)
+            w |= t->cur[p * TS + r] ;
+         if (w == 0) continue ;
+         int py = pos.second + (int)((yoff + r) >> shrink) ;
+         if (py < 0 || py >= viewh) continue ;
+         unsigned char *rowstates = viewstates + py * stride ;
+         unsigned char *rowdirty = blockdirty + (py >> logpmsize) * blocksacross ;
+         while (w) {
+            int col = qgenleftcol(w) ;
+            w &= ~((1ULL << 63) >> col) ;
+            int px = pos.first + (int)((xoff + col) >> shrink) ;
+            if (px < 0 || px >= vieww) continue ;
+            rowstates[px] = (unsigned char) (shrink ? 1 : tilestate(t, col, r)) ;
+            rowdirty[px >> logpmsize] = 1 ;
+         }
+      }
+   }
+
+   for (int by = 0; by < blocksdown; by++) {
+      for (int bx = 0; bx < blocksacross; bx++) {
+         if (!blockdirty[by * blocksacross + bx]) continue ;
+         blockdirty[by * blocksacross + bx] = 0 ;
+         unsigned char *states = viewstates + by * pmsize * stride + bx * pmsize ;
+         unsigned int *pixels = pixRGBAbuf ;
+         for (int j = 0; j < pmsize; j++) {
+            for (int i = 0; i < pmsize; i++)
+               *pixels++ = cellRGBA[states[i]] ;
+            memset(states, 0, pmsize) ;
+            states += stride ;
+         }
+         renderer.pixblit(bx * pmsize, by * pmsize, pmsize, pmsize,
+                          (unsigned char *)pixRGBAbuf, 1) ;
+      }
+   }
+}
+
+void qgenalgo::findedges(bigint *ptop, bigint *pleft, bigint *pbottom, bigint *pright) {
+   bool found = false ;
+   int top = 0, left = 0, bottom = 0, right = 0 ;
+   for (size_t i = 0; i < tiles.size(); i++) {
+      qgentile *t = tiles[i] ;
+      bits64 cols = 0 ;
+      int firstrow = -1, lastrow = -1 ;
+      for (int r = 0; r < TS; r++) {
+         bits64 w = 0 ;
+         for (int p = 0; p <= nplanes; p++)
+            w |= t->cur[p * TS + r] ;
+         if (w == 0) continue ;
+         if (firstrow < 0) firstrow = r ;
+         lastrow = r ;
+         cols |= w ;
+      }
+      if (firstrow < 0) continue ;
+      int ttop = t->y * TS + firstrow ;
+      int tbottom = t->y * TS + lastrow ;
+      int tleft = t->x * TS + qgenleftcol(cols) ;
+      int tright = t->x * TS + qgenrightcol(cols) ;
+      if (!found) {
+         top = ttop ; bottom = tbottom ; left = tleft ; right = tright ;
+         found = true ;
+      } else {
+         if (ttop < top) top = ttop ;
+         if (tbottom > bottom) bottom = tbottom ;
+         if (tleft < left) left = tleft ;
+         if (tright > right) right = tright ;
+      }
+   }
+   if (!found) {
+      // return impossible edges to indicate an empty pattern;
+      // not really a problem because caller should check first
+      *ptop = 1 ;
+      *pleft = 1 ;
+      *pbottom = 0 ;
+      *pright = 0 ;
+      return ;
+   }
+   *ptop = top ;
+   *pleft = left ;
+   *pbottom = bottom ;
+   *pright = right ;
+}
+
+void qgenalgo::fit(viewport &view, int force) {
+   if (isEmpty()) {
+      view.center() ;
+      view.setmag(MAX_MAG) ;
+      return ;
+   }
+
+   bigint top, left, bottom, right ;
+   findedges(&top, &left, &bottom, &right) ;
+
+   if (!force) {
+      // if all four of the above dimensions are in the viewport, don't change
+      if (view.contains(left, top) && view.contains(right, bottom))
+         return ;
+   }
+
+   bigint midx = right ;
+   midx -= left ;
+   midx += bigint::one ;
+   midx.div2() ;
+   midx += left ;
+
+   bigint midy = bottom ;
+   midy -= top ;
+   midy += bigint::one ;
+   midy.div2() ;
+   midy += top ;
+
+   int mag = MAX_MAG ;
+   for (;;) {
+      view.setpositionmag(midx, midy, mag) ;
+      if (view.contains(left, top) && view.contains(right, bottom))
+         break ;
+      mag-- ;
+   }
+}
+
+void qgenalgo::lowerRightPixel(bigint &x, bigint &y, int mag) {
+   if (mag >= 0) return ;
+   x >>= -mag ;
+   x <<= -mag ;
+   y -= 1 ;
+   y >>= -mag ;
+   y <<= -mag ;
+   y += 1 ;
+}
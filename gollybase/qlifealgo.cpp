@@ -12,6 +12,7 @@
 #include <string.h>
 #include <limits.h>
 #include <iostream>
+#include <algorithm>
 using namespace std ;
 /*
  *   The ai array is used to figure out the index number of the bit set in
@@ -199,6 +200,8 @@ qlifealgo::qlifealgo() {
       lifefatal("bad platform for this program") ;
    memused = 0 ;
    maxmemory = 0 ;
+   lastframe[0] = lastframe[1] = 0 ;
+   framememory = 0 ;
    clearall() ;
 }
 /*
@@ -243,6 +246,8 @@ void qlifealgo::clearall() {
  *   This subroutine frees a universe.
  */
 qlifealgo::~qlifealgo() {
+   for (int i=0; i<(int)allframes.size(); i++)
+      freeframe(allframes[i]) ;
    while (memused) {
       linkedmem *nu = memused->next ;
       free(memused) ;
@@ -428,7 +433,7 @@ int qlifealgo::p01(tile *p, tile *pr, tile *pd, tile *prd) {
    int i, recomp = (p->c[4] | pd->c[0] | (pr->c[4] >> 9) | (prd->c[0] >> 8)) & 0xff ;
    STAT(dq++) ;
    p->c[5] = 0 ;
-   p->flags |= 0xfff00000 ;
+   p->flags |= 0xfff00070 ;
 /*
  *   For each brick . . .
  */
@@ -564,7 +569,7 @@ int qlifealgo::p10(tile *plu, tile *pu, tile *pl, tile *p) {
    int i, recomp = (p->c[1] | pu->c[5] | (pl->c[1] >> 9) | (plu->c[5] >> 8)) & 0xff ;
    STAT(dq++) ;
    p->c[0] = 0 ;
-   p->flags |= 0x000fff00 ;
+   p->flags |= 0x000fff70 ;
    for (i=0; i<=3; i++) {
       brick *b = p->b[i], *lb = pl->b[i] ;
       if (recomp) {
@@ -1083,6 +1088,299 @@ supertile *qlifealgo::mdelete(supertile *p, int lev) {
    }
    return p ;
 }
+/*
+ *   The pattern hash of a tile or supertile, relative to its corner with
+ *   the smallest coordinates.  Like the population counts we keep the
+ *   values around, and the dirty bits tell us which ones need to be
+ *   recalculated.  Since y is negated internally the vertical weights
+ *   are powers of the inverse of Y.
+ */
+static const phash HASHINVALID = ~(phash)0 ;
+static phash cellweight[2][32] ;
+static phash levelweight[40][8] ;
+static void inithashweights() {
+   phash yinv = patternhash::inverse(patternhash::Y) ;
+   cellweight[0][0] = cellweight[1][0] = 1 ;
+   for (int i=1; i<32; i++) {
+      cellweight[0][i] = patternhash::mul(cellweight[0][i-1], patternhash::X) ;
+      cellweight[1][i] = patternhash::mul(cellweight[1][i-1], yinv) ;
+   }
+   for (int lev=1; lev<40; lev++) {
+      // odd levels stack subtiles horizontally, even levels vertically
+      int k = (lev & 1) ? 5 + 3 * ((lev - 1) >> 1) : 5 + 3 * ((lev - 2) >> 1) ;
+      phash step = (lev & 1) ? patternhash::xpow2(k) :
+                               patternhash::inverse(patternhash::ypow2(k)) ;
+      levelweight[lev][0] = 1 ;
+      for (int i=1; i<8; i++)
+         levelweight[lev][i] = patternhash::mul(levelweight[lev][i-1], step) ;
+   }
+}
+phash qlifealgo::tilehash(tile *p, int gm1) {
+   phash h = 0 ;
+   for (int i=0; i<4; i++) {
+      if (p->b[i] == emptybrick)
+         continue ;
+      for (int j=0; j<8; j++) {
+         unsigned int k = p->b[i]->d[j+gm1*8] ;
+         for (int bit=0; k; bit++, k <<= 1)
+            if (k & 0x80000000)
+               h = patternhash::add(h,
+                      patternhash::mul(cellweight[0][4 * j + (bit & 3)],
+                                       cellweight[1][8 * i + (bit >> 2)])) ;
+      }
+   }
+   return h ;
+}
+phash qlifealgo::superhash(supertile *p, int lev, int gm1) {
+   if (lev == 0) {
+      tile *pp = (tile *)p ;
+      if (pp->flags & 0x10) {
+         pp->hash[1-gm1] = HASHINVALID ;
+         pp->hash[gm1] = tilehash(pp, gm1) ;
+         pp->flags &= ~0x10 ;
+      } else if (pp->hash[gm1] == HASHINVALID) {
+         pp->hash[gm1] = tilehash(pp, gm1) ;
+      }
+      return pp->hash[gm1] ;
+   }
+   if (p->flags & 0x80000000) {
+      p->hash[1-gm1] = HASHINVALID ;
+      p->hash[gm1] = HASHINVALID ;
+      p->flags &= 0x7fffffff ;
+   }
+   if (p->hash[gm1] == HASHINVALID) {
+      phash h = 0 ;
+      for (int i=0; i<8; i++)
+         if (p->d[i] != nullroots[lev-1])
+            h = patternhash::add(h, patternhash::mul(levelweight[lev][i],
+                                           superhash(p->d[i], lev-1, gm1))) ;
+      p->hash[gm1] = h ;
+   }
+   return p->hash[gm1] ;
+}
+/*
+ *   Move the origin from the corner of the root to the corner of the
+ *   bounding box.  In odd generations the bricks are offset by one cell.
+ */
+int qlifealgo::gethash() {
+   if (isEmpty())
+      return patternhash::fold(0) ;
+   if (cellweight[0][0] == 0)
+      inithashweights() ;
+   int odd = generation.odd() ;
+   phash h = superhash(root, rootlev, odd) ;
+   bigint top, left, bottom, right ;
+   findedges(&top, &left, &bottom, &right) ;
+   bigint ex = bmin, ey = bmin ;
+   ex.add_smallint(odd) ;
+   ex -= left ;
+   ey.add_smallint(odd) ;
+   ey += top ;
+   h = patternhash::mul(h, patternhash::pow(patternhash::X, ex)) ;
+   h = patternhash::mul(h, patternhash::pow(cellweight[1][1], ey)) ;
+   return patternhash::fold(h) ;
+}
+/*
+ *   Make a frame node for p (at level lev) in the current generation,
+ *   sharing as much as we can with prev, the corresponding node of the
+ *   last frame of the same parity (at level prevlev; that frame's root
+ *   may be below ours, in which case it's in the middle, see uproot).
+ *   A prevlev of -1 means there is no last frame.  Returns a new
+ *   reference, or 0 if the subtree is empty.
+ */
+framenode *qlifealgo::snapshot(supertile *p, int lev, framenode *prev,
+                               int prevlev, int gm1) {
+   int i ;
+   if (p == nullroots[lev])
+      return 0 ;
+   if (lev == 0) {
+      tile *t = (tile *)p ;
+      int clean = (prevlev >= 0 && (t->flags & (0x20 << gm1)) == 0) ;
+      t->flags &= ~(0x20 << gm1) ;
+      if (clean) {
+         if (prev)
+            prev->refs++ ;
+         return prev ;
+      }
+      framebrick *fb[4] ;
+      int any = 0, same = (prev != 0) ;
+      for (i=0; i<4; i++) {
+         unsigned int *d = t->b[i]->d + 8 * gm1 ;
+         framebrick *pb = prev ? (framebrick *)prev->d[i] : 0 ;
+         fb[i] = 0 ;
+         if (t->b[i] != emptybrick &&
+             (d[0] | d[1] | d[2] | d[3] | d[4] | d[5] | d[6] | d[7])) {
+            if (pb && memcmp(pb->d, d, sizeof(pb->d)) == 0) {
+               fb[i] = pb ;
+            } else {
+               fb[i] = (framebrick *)malloc(sizeof(framebrick)) ;
+               if (fb[i] == 0)
+                  lifefatal("No memory for timeline.") ;
+               fb[i]->refs = 0 ;
+               memcpy(fb[i]->d, d, sizeof(fb[i]->d)) ;
+               framememory += sizeof(framebrick) ;
+            }
+            any = 1 ;
+         }
+         if (fb[i] != pb)
+            same = 0 ;
+      }
+      if (same) {
+         prev->refs++ ;
+         return prev ;
+      }
+      if (!any)
+         return 0 ;
+      framenode *n = (framenode *)calloc(1, sizeof(framenode)) ;
+      if (n == 0)
+         lifefatal("No memory for timeline.") ;
+      framememory += sizeof(framenode) ;
+      n->refs = 1 ;
+      for (i=0; i<4; i++) {
+         if (fb[i])
+            fb[i]->refs++ ;
+         n->d[i] = fb[i] ;
+      }
+      return n ;
+   }
+   framenode *c[8] ;
+   int any = 0, same = (prev != 0 && lev == prevlev) ;
+   for (i=0; i<8; i++) {
+      framenode *cp ;
+      if (lev > prevlev)
+         cp = (i == 4 ? prev : 0) ;
+      else
+         cp = (prev ? (framenode *)prev->d[i] : 0) ;
+      c[i] = snapshot(p->d[i], lev-1, cp, prevlev, gm1) ;
+      if (c[i])
+         any = 1 ;
+      if (!same || c[i] != prev->d[i])
+         same = 0 ;
+   }
+   if (same) {
+      // the children are all still referenced by prev
+      for (i=0; i<8; i++)
+         if (c[i])
+            c[i]->refs-- ;
+      prev->refs++ ;
+      return prev ;
+   }
+   if (!any)
+      return 0 ;
+   framenode *n = (framenode *)malloc(sizeof(framenode)) ;
+   if (n == 0)
+      lifefatal("No memory for timeline.") ;
+   framememory += sizeof(framenode) ;
+   n->refs = 1 ;
+   for (i=0; i<8; i++)
+      n->d[i] = c[i] ;
+   return n ;
+}
+void qlifealgo::releasenode(framenode *f, int lev) {
+   if (f == 0 || --f->refs > 0)
+      return ;
+   if (lev == 0) {
+      for (int i=0; i<4; i++) {
+         framebrick *fb = (framebrick *)f->d[i] ;
+         if (fb && --fb->refs == 0) {
+            free(fb) ;
+            framememory -= sizeof(framebrick) ;
+         }
+      }
+   } else {
+      for (int i=0; i<8; i++)
+         releasenode((framenode *)f->d[i], lev-1) ;
+   }
+   free(f) ;
+   framememory -= sizeof(framenode) ;
+}
+void qlifealgo::freeframe(qframe *f) {
+   releasenode(f->root, f->rootlev) ;
+   for (int i=0; i<2; i++)
+      if (lastframe[i] == f)
+         lastframe[i] = 0 ;
+   delete f ;
+}
+/*
+ *   Free the frames that are no longer in the timeline.
+ */
+void qlifealgo::releaseframes() {
+   vector<void *> keep(timeline.frames) ;
+   sort(keep.begin(), keep.end()) ;
+   int j = 0 ;
+   for (int i=0; i<(int)allframes.size(); i++) {
+      if (binary_search(keep.begin(), keep.end(), (void *)allframes[i]))
+         allframes[j++] = allframes[i] ;
+      else
+         freeframe(allframes[i]) ;
+   }
+   allframes.resize(j) ;
+}
+/*
+ *   The frames count against the memory limit; once they use it up we
+ *   return 0 so the timeline stops growing.
+ */
+void *qlifealgo::getcurrentstate() {
+   if (allframes.size() > timeline.frames.size())
+      releaseframes() ;
+   if (maxmemory != 0 && usedmemory + framememory > maxmemory)
+      return 0 ;
+   int gm1 = generation.odd() ;
+   qframe *f = new qframe ;
+   f->gen = generation ;
+   f->rootlev = rootlev ;
+   qframe *last = lastframe[gm1] ;
+   if (last && last->rootlev <= rootlev)
+      f->root = snapshot(root, rootlev, last->root, last->rootlev, gm1) ;
+   else
+      f->root = snapshot(root, rootlev, 0, -1, gm1) ;
+   allframes.push_back(f) ;
+   lastframe[gm1] = f ;
+   return f ;
+}
+supertile *qlifealgo::restoreframe(framenode *f, int lev, int gm1) {
+   if (f == 0)
+      return nullroots[lev] ;
+   if (lev == 0) {
+      tile *t = newtile() ;
+      for (int i=0; i<4; i++) {
+         framebrick *fb = (framebrick *)f->d[i] ;
+         if (fb) {
+            t->b[i] = newbrick() ;
+            memcpy(t->b[i]->d + 8 * gm1, fb->d, sizeof(fb->d)) ;
+         }
+      }
+      return (supertile *)t ;
+   }
+   supertile *p = newsupertile(lev) ;
+   for (int i=0; i<8; i++)
+      p->d[i] = restoreframe((framenode *)f->d[i], lev-1, gm1) ;
+   return p ;
+}
+/*
+ *   Rebuild the universe from a frame.  We set the generation here
+ *   because the layout depends on its parity.  Everything is marked as
+ *   changed, as if the rule had changed.
+ */
+void qlifealgo::setcurrentstate(void *state) {
+   qframe *f = (qframe *)state ;
+   bigint inc = increment ;
+   // clearall forgets these without freeing them
+   char *savellxb = llxb, *savellyb = llyb ;
+   int savellsize = llsize ;
+   clearall() ;
+   llxb = savellxb ;
+   llyb = savellyb ;
+   llsize = savellsize ;
+   increment = inc ;
+   generation = f->gen ;
+   while (rootlev < f->rootlev)
+      uproot() ;
+   if (f->root)
+      root = restoreframe(f->root, rootlev, generation.odd()) ;
+   markglobalchange() ;
+   lastframe[generation.odd()] = f ;
+}
 G_INT64 qlifealgo::popcount() {
    return find_set_bits(root, rootlev, generation.odd()) ;
 }
@@ -8,6 +8,7 @@
 #define QLIFEALGO_H
 #include "lifealgo.h"
 #include "liferules.h"
+#include "patternhash.h"
 #include <vector>
 /*
  *   The smallest unit of the universe is the `slice', which is a
@@ -79,18 +80,23 @@ struct brick { /* 64 bytes */
  *   The flags int is divided into two 12-bit fields, each holding a population
  *   count, and one eight-bit field, holding dirty flags.
  *
+ *   The two hash values hold the pattern hash (see patternhash.h) of each
+ *   generation, if dirty bit 4 is clear and the value isn't HASHINVALID.
+ *   Dirty bits 5 and 6 are used for timeline frames (see below).
+ *
  *   Note that tiles only point `down' to bricks, never to each other or to
  *   higher-level supertiles.
  *
  *   Tiles are numbered as level `0' of the universe tree.
  *
- *   The tiles are 32 bytes each; they can hold up to four bricks, so the
+ *   The tiles are 48 bytes each; they can hold up to four bricks, so the
  *   memory consumption of the tiles tends to be small.
  */
-struct tile { /* 32 bytes */
+struct tile { /* 48 bytes */
    struct brick *b[4] ;
    short c[6] ;
    int flags, localdeltaforward ;
+   phash hash[2] ;
 } ;
 /*
  *   Supertiles hold pointers to eight subtiles, which can either be 
@@ -117,8 +123,7 @@ struct tile { /* 32 bytes */
  *   of the eighth (first) subtile has changed.
  *
  *   Bit 18 through 27 correspond to the previous generation's bits 8 through
- *   17.  Bits 28 through 31 are the dirty bits; we currently use three of
- *   them.
+ *   17.  Bits 28 through 31 are the dirty bits; we use all four of them.
  *
  *   The above description corresponds to odd levels.  For even levels,
  *   since tiles are stacked vertically instead of horizontally, change
@@ -132,20 +137,49 @@ struct tile { /* 32 bytes */
  *   500M, so that a sum of the eight in unsigned arithmetic is guaranteed
  *   to never overflow.
  *
+ *   The two hash values are like the ones in tiles, using dirty bit 3.
+ *
  *   This completes the universe data structures.  Note that there is no
  *   limit (other than the size of a pointer and memory constraints) on
  *   the size of the universe.  For instance, using these data structures
  *   we can easily build a universe with elements separated by 2^200
  *   pixels.
  *
- *   The supertiles are 44 bytes each; they correspond to at least a
+ *   The supertiles are 60 bytes each; they correspond to at least a
  *   256x32 chunk of the universe, so the total memory consumption due to
  *   supertiles tends to be small.
  */
-struct supertile { /* 44 bytes */
+struct supertile { /* 60 bytes */
    struct supertile *d[8] ;
    int flags ;
    int pop[2] ;
+   phash hash[2] ;
+} ;
+/*
+ *   A timeline frame is a tree with the same shape as the supertile tree
+ *   holding copies of the bricks for the frame's generation (just the
+ *   eight slices for that parity); empty subtrees are null.  Most of the
+ *   universe doesn't change from one frame to the next, so a new frame
+ *   shares every brick, tile and supertile that is the same in the last
+ *   frame we made of the same parity (the parities are stored at
+ *   different offsets, so we can't share between them).  Thus the memory
+ *   needed for a frame depends on the activity rather than the population.
+ *   Frame nodes are reference counted.  Dirty bit 5 (6) of a tile is
+ *   cleared when we make an even (odd) frame, so if it's still clear
+ *   next time the tile hasn't changed.
+ */
+struct framebrick { /* 36 bytes */
+   int refs ;
+   unsigned int d[8] ;
+} ;
+struct framenode {
+   int refs ;
+   void *d[8] ;   // framenodes, or four framebricks at level 0
+} ;
+struct qframe {
+   framenode *root ;
+   int rootlev ;
+   bigint gen ;
 } ;
 /*
  *   This is a common header for chunks of memory linked together.
@@ -181,6 +215,9 @@ struct linkedmem {
  *   The emptybrick pointer points to the unique brick that is guaranteed
  *   to always be empty.  The emptytile pointer is similar.
  *
+ *   The timeline frames we have made are kept in allframes, so we can
+ *   free the ones that are dropped from the timeline.
+ *
  *   Finally, root is the top of the current life tree.  Nullroot is the
  *   topmost empty supertile allocated, and nullroots[] holds the empty
  *   supertiles at each level.  Setting this to 40 limits the number of
@@ -205,15 +242,19 @@ public:
    virtual void setGeneration(bigint gen) { generation = gen ; }
    virtual const bigint &getPopulation() ;
    virtual int isEmpty() ;
+   virtual int gethash() ;
    // can we do the gen count doubling? only hashlife
    virtual int hyperCapable() { return 0 ; }
    virtual void setMaxMemory(int m) ;
    virtual int getMaxMemory() { return (int)(maxmemory >> 20) ; }
+   virtual g_uintptr_t getMemoryUsed() { return usedmemory + framememory ; }
    virtual const char *setrule(const char *s) ;
    virtual const char *getrule() { return qliferules.getrule() ; }
    virtual void step() ;
-   virtual void* getcurrentstate() { return 0 ; }
-   virtual void setcurrentstate(void *) {}
+   virtual void* getcurrentstate() ;
+   virtual void setcurrentstate(void *) ;
+   virtual void releaseframes() ;
+   virtual int timelineCapable() { return 1 ; }
    virtual void draw(viewport &view, liferender &renderer) ;
    virtual void fit(viewport &view, int force) ;
    virtual void lowerRightPixel(bigint &x, bigint &y, int mag) ;
@@ -236,14 +277,25 @@ private:
    int p10(tile *plu, tile *pu, tile *pl, tile *p) ;
    G_INT64 find_set_bits(supertile *p, int lev, int gm1) ;
    int isEmpty(supertile *p, int lev, int gm1) ;
+   phash tilehash(tile *p, int gm1) ;
+   phash superhash(supertile *p, int lev, int gm1) ;
    supertile *mdelete(supertile *p, int lev) ;
+   framenode *snapshot(supertile *p, int lev, framenode *prev, int prevlev,
+                       int gm1) ;
+   supertile *restoreframe(framenode *f, int lev, int gm1) ;
+   void releasenode(framenode *f, int lev) ;
+   void freeframe(qframe *f) ;
    G_INT64 popcount() ;
    int uproot_needed() ;
    void dogen() ;
-   void renderbm(int x, int y) ;
    void renderbm(int x, int y, int xsize, int ysize) ;
+   void blitbm(int x, int y, int xsize, int ysize, unsigned char *pix) ;
    void BlitCells(supertile *p, int xoff, int yoff, int wd, int ht, int lev) ;
+   int FillCells(supertile *p, int xoff, int yoff) ;
    void ShrinkCells(supertile *p, int xoff, int yoff, int wd, int ht, int lev) ;
+   void drawchunks() ;
+   void drawchunkrange(int first, int step) ;
+   static void drawjob(void *arg, int i, int n) ;
    int nextcell(int x, int y, supertile *n, int lev) ;
    void fill_ll(int d) ;
    int lowsub(vector<supertile*> &src, vector<supertile*> &dst, int lev) ;
@@ -266,13 +318,16 @@ private:
    supertile *root, *nullroot, *nullroots[40] ;
    int cleandowncounter ;
    g_uintptr_t maxmemory, usedmemory ;
+   vector<qframe *> allframes ;   // every frame we've made and not freed
+   qframe *lastframe[2] ;         // the last even and odd frames
+   g_uintptr_t framememory ;
    char *ruletable ;
    // when drawing, these are used
    liferender *renderer ;
    viewport *view ;
    int uviewh, uvieww, viewh, vieww, mag, pmag, kadd ;
    int oddgen ;
-   int bmleft, bmtop, bmlev, shbmsize, logshbmsize ;
+   int bmlev, shbmsize, logshbmsize ;
    int quickb, deltaforward ;
    int llbits, llsize ;
    char *llxb, *llyb ;
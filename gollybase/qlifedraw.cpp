@@ -4,13 +4,18 @@
 #include "qlifealgo.h"
 #include <cstring>
 #include <cstdlib>
+#include <algorithm>
 #include "util.h"
 
 const int logbmsize = 8 ;                   // *must* be 8 in this code
 const int bmsize = (1<<logbmsize) ;
 const int ibufsize = (bmsize*bmsize/32) ;
+const int pixsize = (bmsize*bmsize*4) ;     // bytes in a 256x256 RGBA pixmap
 static unsigned int ibigbuf[ibufsize] ;     // shared buffer for 256x256 pixels
-static unsigned char *bigbuf = (unsigned char *)ibigbuf ;
+// the bitmap this thread is drawing into (ibigbuf or a chunk's)
+static thread_local unsigned char *bigbuf = (unsigned char *)ibigbuf ;
+// where ShrinkCells' bitmap is on the screen
+static thread_local int bmleft, bmtop ;
 
 // AKT: 256x256 pixmap where each pixel is 4 RGBA bytes
 static unsigned char pixbuf[bmsize*bmsize*4];
@@ -22,28 +27,49 @@ static unsigned char liver, liveg, liveb, livea;
 // rowett: RGBA view of cell states
 static unsigned int liveRGBA, deadRGBA;
 
-void qlifealgo::renderbm(int x, int y) {
-   renderbm(x, y, bmsize, bmsize) ;
-}
+// one state byte per pixel rather than RGBA?
+static bool statepix ;
 
-void qlifealgo::renderbm(int x, int y, int xsize, int ysize) {
-   // x,y is lower left corner
-   int rx = x ;
-   int ry = y ;
-   int rw = xsize ;
-   int rh = ysize ;
-   if (pmag > 1) {
-      rx *= pmag ;
-      ry *= pmag ;
-      rw *= pmag ;
-      rh *= pmag ;
-   }
-   ry = uviewh - ry - rh ;
+/*
+ *   As in hlifedraw.cpp, BlitCells and ShrinkCells just queue the
+ *   256x256 supertiles (or the bitmaps ShrinkCells shrinks into) that
+ *   are on the screen.  Then a batch at a time the chunks are drawn
+ *   into their own bitmaps and turned into pixels (using the job pool
+ *   if we can; nothing changes the universe while we draw), and handed
+ *   to the renderer in order.
+ */
+struct qdrawchunk {
+   supertile *p ;
+   int xoff, yoff, wd, ht ;   // as passed to BlitCells or ShrinkCells
+   int live ;                 // were any cells drawn?
+} ;
+const int maxbatch = 32 ;                 // chunks drawn before blitting
+static vector<qdrawchunk> chunks ;
+static int batchstart, batchend ;         // the chunks being drawn
+static vector<unsigned int> chunkbits ;   // ibufsize words per chunk
+static vector<unsigned char> chunkpix ;   // pixsize bytes per chunk
+static bool queueing ;                    // ShrinkCells should queue bitmaps
 
-   unsigned char *bigptr = bigbuf;
-   if (renderer->justState() || pmag > 1) {
+static void queuechunk(supertile *p, int xoff, int yoff, int wd, int ht) {
+   qdrawchunk c ;
+   c.p = p ;
+   c.xoff = xoff ;
+   c.yoff = yoff ;
+   c.wd = wd ;
+   c.ht = ht ;
+   c.live = 0 ;
+   chunks.push_back(c) ;
+}
+
+/*
+ *   Turn a bitmap into pixels for the renderer, one state byte per
+ *   pixel or RGBA, and clear the bitmap for next time.
+ */
+static void expandbm(unsigned char *bigptr, unsigned char *pix) {
+   unsigned char *bits = bigptr ;
+   if (statepix) {
       // convert each bigbuf byte into 8 bytes of state data
-      unsigned char *pixptr = pixbuf;
+      unsigned char *pixptr = pix;
 
       for (int i = 0; i < ibufsize * 4; i++) {
          unsigned char byte = *bigptr++;
@@ -59,7 +85,7 @@ void qlifealgo::renderbm(int x, int y, int xsize, int ysize) {
    } else {
       // convert each bigbuf byte into 32 bytes of pixel data (8 * RGBA)
       // get RGBA view of pixel buffer
-      unsigned int *pixptr = (unsigned int *)pixbuf;
+      unsigned int *pixptr = (unsigned int *)pix;
 
       for (int i = 0; i < ibufsize * 4; i++) {
          unsigned char byte = *bigptr++;
@@ -73,12 +99,31 @@ void qlifealgo::renderbm(int x, int y, int xsize, int ysize) {
          *pixptr++ = (byte & 1) ? liveRGBA : deadRGBA;
       }
    }
+   memset(bits, 0, sizeof(ibigbuf)) ;
+}
+
+void qlifealgo::renderbm(int x, int y, int xsize, int ysize) {
+   expandbm(bigbuf, pixbuf) ;
+   blitbm(x, y, xsize, ysize, pixbuf) ;
+}
+
+void qlifealgo::blitbm(int x, int y, int xsize, int ysize, unsigned char *pix) {
+   // x,y is lower left corner
+   int rx = x ;
+   int ry = y ;
+   int rw = xsize ;
+   int rh = ysize ;
+   if (pmag > 1) {
+      rx *= pmag ;
+      ry *= pmag ;
+      rw *= pmag ;
+      rh *= pmag ;
+   }
+   ry = uviewh - ry - rh ;
    if (renderer->justState())
-      renderer->stateblit(rx, ry, rw, rh, pixbuf) ;
+      renderer->stateblit(rx, ry, rw, rh, pix) ;
    else
-      renderer->pixblit(rx, ry, rw, rh, pixbuf, pmag);
-
-   memset(bigbuf, 0, sizeof(ibigbuf)) ;
+      renderer->pixblit(rx, ry, rw, rh, pix, pmag);
 }
 
 static int minlevel;
@@ -88,8 +133,7 @@ static int minlevel;
  */
 void qlifealgo::BlitCells(supertile *p,
                           int xoff, int yoff, int wd, int ht, int lev) {
-   int i, xinc=0, yinc=0, ypos, x, yy;
-   int liveseen = 0 ;
+   int i, xinc=0, yinc=0;
    
    if (xoff >= vieww || xoff + wd < 0 || yoff >= viewh || yoff + ht < 0)
       // no part of this supertile is visible
@@ -116,9 +160,17 @@ void qlifealgo::BlitCells(supertile *p,
       return;
    }
 
-   // walk a (probably) non-empty 256x256 supertile, finding all the 1 bits and
-   // setting corresponding bits in the bitmap (bigbuf)
-   liveseen = 0 ;
+   queuechunk(p, xoff, yoff, wd, ht) ;
+}
+
+/*
+ *   Walk a (probably) non-empty 256x256 supertile, finding all the 1 bits
+ *   and setting corresponding bits in the bitmap (bigbuf).  Return
+ *   nonzero if we set any.
+ */
+int qlifealgo::FillCells(supertile *p, int xoff, int yoff) {
+   int i, ypos, x, yy;
+   int liveseen = 0 ;
    ypos = yoff;
    // examine the 8 vertically stacked subtiles in this 256x256 supertile (at level 2)
    for (yy=0; yy<8; yy++) {
@@ -169,18 +221,12 @@ void qlifealgo::BlitCells(supertile *p,
       ypos += 32;   // down to next subtile
    }
 
-   if (liveseen == 0) {
-      return;                  // no live cells seen
-   }
-
    // performance:  if we want, liveseen now contains eight bits
    // corresponding to whether those respective 256x32 rectangles
    // contain set pixels or not.  We should trim the bitmap
    // to only render those portions that need to be rendered
    // (using this information).   -tom
-   //
-   // draw the non-empty bitmap, scaling up if pmag > 1
-   renderbm(xoff, yoff) ;
+   return liveseen ;
 }
 
 // This pattern drawing routine is used when mag > 0.
@@ -201,6 +247,10 @@ void qlifealgo::ShrinkCells(supertile *p,
          return ;
       }
       if (lev == bmlev) {
+         if (queueing) {
+            queuechunk(p, xoff, yoff, wd, ht) ;
+            return ;
+         }
          bmleft = xoff ;
          bmtop = yoff ;
       }
@@ -274,8 +324,6 @@ void qlifealgo::ShrinkCells(supertile *p,
             xxinc += xinc ;
             yyinc += yinc ;
          }
-         if (lev == bmlev)
-            renderbm(bmleft, bmtop, shbmsize, shbmsize) ;
       }
    } else if (mag > 4) {
       if (lev > 0) {
@@ -415,6 +463,52 @@ void qlifealgo::ShrinkCells(supertile *p,
     }
    }
 }
+/*
+ *   Draw every step'th chunk of the batch starting at first, and turn
+ *   the ones with live cells into pixels.
+ */
+void qlifealgo::drawchunkrange(int first, int step) {
+   for (int i=batchstart+first; i<batchend; i+=step) {
+      qdrawchunk &c = chunks[i] ;
+      bigbuf = (unsigned char *)&chunkbits[(i - batchstart) * ibufsize] ;
+      if (mag > 0) {
+         ShrinkCells(c.p, c.xoff, c.yoff, c.wd, c.ht, bmlev) ;
+         c.live = 1 ;
+      } else {
+         c.live = FillCells(c.p, c.xoff, c.yoff) ;
+      }
+      if (c.live)
+         expandbm(bigbuf, &chunkpix[(size_t)(i - batchstart) * pixsize]) ;
+   }
+   bigbuf = (unsigned char *)ibigbuf ;
+}
+
+void qlifealgo::drawjob(void *arg, int i, int n) {
+   ((qlifealgo *)arg)->drawchunkrange(i, n) ;
+}
+
+/*
+ *   Draw the queued chunks and pass them to the renderer.
+ */
+void qlifealgo::drawchunks() {
+   int nchunks = (int)chunks.size() ;
+   int nbatch = std::min(nchunks, maxbatch) ;
+   if (chunkbits.size() < (size_t)nbatch * ibufsize) {
+      chunkbits.resize((size_t)nbatch * ibufsize, 0) ;
+      chunkpix.resize((size_t)nbatch * pixsize) ;
+   }
+   int size = (mag > 0 ? shbmsize : bmsize) ;
+   for (batchstart=0; batchstart<nchunks; batchstart=batchend) {
+      batchend = std::min(nchunks, batchstart + maxbatch) ;
+      int njobs = jobcount(batchend - batchstart, 2) ;
+      runjobs(drawjob, this, njobs) ;
+      for (int i=batchstart; i<batchend; i++)
+         if (chunks[i].live)
+            blitbm(chunks[i].xoff, chunks[i].yoff, size, size,
+                   &chunkpix[(size_t)(i - batchstart) * pixsize]) ;
+   }
+   chunks.clear() ;
+}
 /*
  *   Fill in the llxb and llyb bits from the viewport information.
  *   Allocate if necessary.  This arithmetic should be done carefully.
@@ -496,6 +590,7 @@ void qlifealgo::draw(viewport &viewarg, liferender &renderarg) {
       viewh = uviewh ;
       vieww = uvieww ;
    }
+   statepix = renderer->justState() || pmag > 1 ;
    if (root == nullroots[rootlev]) {
       renderer = 0 ;
       view = 0 ;
@@ -616,18 +711,25 @@ void qlifealgo::draw(viewport &viewarg, liferender &renderarg) {
       }
       bmleft = xoff ;
       bmtop = yoff ;
+      // if the whole thing fits in one bitmap we draw it here, else
+      // the bitmaps are queued
+      queueing = (bmlev <= curlev) ;
       ShrinkCells(sw, xoff, yoff, levsize, levsize, curlev);
       ShrinkCells(se, xoff+levsize, yoff, levsize, levsize, curlev);
       ShrinkCells(nw, xoff, yoff+levsize, levsize, levsize, curlev);
       ShrinkCells(ne, xoff+levsize, yoff+levsize, levsize, levsize, curlev);
+      queueing = false ;
       if (bmlev > curlev)
          renderbm(bmleft, bmtop, shbmsize, shbmsize) ;
+      else
+         drawchunks() ;
    } else {
       // recurse down to 256x256 supertiles and use bitmap blitting
       BlitCells(sw, xoff, yoff, levsize, levsize, curlev);
       BlitCells(se, xoff+levsize, yoff, levsize, levsize, curlev);
       BlitCells(nw, xoff, yoff+levsize, levsize, levsize, curlev);
       BlitCells(ne, xoff+levsize, yoff+levsize, levsize, levsize, curlev);
+      drawchunks() ;
    }
    renderer = 0 ;
    view = 0 ;
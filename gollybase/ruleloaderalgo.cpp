@@ -7,6 +7,9 @@
 
 #include <string.h>     // for strcmp, strchr
 #include <string>       // for std::string
+#include <list>         // for std::list
+#include <vector>       // for std::vector
+#include <sys/stat.h>   // for stat
 
 const char* noTABLEorTREE = "No @TABLE or @TREE section found in .rule file.";
 
@@ -18,18 +21,127 @@ int ruleloaderalgo::NumCellStates()
         return LocalRuleTree->NumCellStates();
 }
 
-static FILE* OpenRuleFile(std::string& rulename, const char* dir)
+static std::string RulePath(const std::string& rulename, const char* dir, const char* ext)
 {
-    // try to open rulename.rule in given dir
     std::string path = dir;
     int istart = (int)path.size();
-    path += rulename + ".rule";
+    path += rulename + ext;
     // change "dangerous" characters to underscores
     for (unsigned int i=istart; i<path.size(); i++)
         if (path[i] == '/' || path[i] == '\\') path[i] = '_';
-    return fopen(path.c_str(), "rt");
+    return path;
+}
+
+static FILE* OpenRuleFile(std::string& rulename, const char* dir)
+{
+    // try to open rulename.rule in given dir
+    return fopen(RulePath(rulename, dir, ".rule").c_str(), "rt");
+}
+
+// -----------------------------------------------------------------------------
+
+// Reading a big .rule file (and packing its table) can take a while, and
+// the same rule is set again whenever a layer is cloned or an undo step
+// or a script creates a temporary universe, so we keep the compiled forms
+// of the most recently loaded rules.  A compiled rule is only used if the
+// file it came from is still the one setrule would find and it hasn't been
+// changed since (same size and modification time).
+
+struct filestamp {
+    std::string path;
+    time_t mtime;
+    long size;
+};
+
+static bool GetFileStamp(const std::string& path, filestamp& fs)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+    fs.path = path;
+    fs.mtime = st.st_mtime;
+    fs.size = (long)st.st_size;
+    return true;
 }
 
+struct cachedrule {
+    std::string rulename;               // rule name without any suffix
+    std::vector<filestamp> files;       // files the rule was read from
+    bool istable;                       // compiled table or tree?
+    ruletable_algo::compiledtable table;
+    ruletreealgo::compiledtree tree;
+};
+
+static std::list<cachedrule> rulecache;      // most recently used first
+static const unsigned int MAXCACHEDRULES = 16;
+
+// return the path of rulename+ext in the user's rules dir or else in
+// Golly's rules dir, or an empty string if there's no such file
+static std::string FindRuleFile(const std::string& rulename, const char* ext)
+{
+    filestamp fs;
+    if (GetFileStamp(RulePath(rulename, lifegetuserrules(), ext), fs) ||
+        GetFileStamp(RulePath(rulename, lifegetrulesdir(), ext), fs))
+        return fs.path;
+    return "";
+}
+
+// return the first file setrule would open for the given rule
+static std::string FirstRuleFile(const std::string& rulename)
+{
+    std::string path = FindRuleFile(rulename, ".rule");
+    if (path.empty()) path = FindRuleFile(rulename, ".table");
+    if (path.empty()) path = FindRuleFile(rulename, ".tree");
+    return path;
+}
+
+static cachedrule* FindCachedRule(const std::string& rulename)
+{
+    std::list<cachedrule>::iterator it;
+    for (it = rulecache.begin(); it != rulecache.end(); it++) {
+        if (it->rulename == rulename) break;
+    }
+    if (it == rulecache.end()) return NULL;
+    
+    // check the files haven't changed
+    bool uptodate = FirstRuleFile(rulename) == it->files[0].path;
+    for (unsigned int i = 0; uptodate && i < it->files.size(); i++) {
+        filestamp fs;
+        uptodate = GetFileStamp(it->files[i].path, fs) &&
+                   fs.mtime == it->files[i].mtime && fs.size == it->files[i].size;
+    }
+    if (!uptodate) {
+        rulecache.erase(it);
+        return NULL;
+    }
+    
+    // move it to the front
+    rulecache.splice(rulecache.begin(), rulecache, it);
+    return &rulecache.front();
+}
+
+void ruleloaderalgo::CacheRule(const std::string& rulename, const std::vector<std::string>& paths)
+{
+    cachedrule cr;
+    cr.rulename = rulename;
+    for (unsigned int i = 0; i < paths.size(); i++) {
+        filestamp fs;
+        if (!GetFileStamp(paths[i], fs)) return;
+        cr.files.push_back(fs);
+    }
+    if (cr.files.empty()) return;
+    
+    cr.istable = (rule_type == TABLE);
+    rulecache.push_front(cr);
+    if (cr.istable)
+        LocalRuleTable->SaveCompiled(rulecache.front().table);
+    else
+        LocalRuleTree->SaveCompiled(rulecache.front().tree);
+    
+    if (rulecache.size() > MAXCACHEDRULES) rulecache.pop_back();
+}
+
+// -----------------------------------------------------------------------------
+
 void ruleloaderalgo::SetAlgoVariables(RuleTypes ruletype)
 {
     // yuk -- we wouldn't need to copy all these variables if we merged
@@ -130,6 +242,24 @@ const char* ruleloaderalgo::setrule(const char* s)
         return NULL;
     }
     
+    // use the compiled rule if we've already loaded it
+    cachedrule* cr = FindCachedRule(rulename);
+    if (cr) {
+        if (cr->istable) {
+            err = LocalRuleTable->UseCompiled(cr->table, s);
+            if (err) return err;
+            SetAlgoVariables(TABLE);
+        } else {
+            err = LocalRuleTree->UseCompiled(cr->tree, s);
+            if (err) return err;
+            SetAlgoVariables(TREE);
+        }
+        return NULL;
+    }
+    
+    // remember which files we read so the cached rule can be checked later
+    std::vector<std::string> paths;
+    
     // look for .rule file in user's rules dir then in Golly's rules dir
     bool inuser = true;
     FILE* rulefile = OpenRuleFile(rulename, lifegetuserrules());
@@ -138,6 +268,7 @@ const char* ruleloaderalgo::setrule(const char* s)
         rulefile = OpenRuleFile(rulename, lifegetrulesdir());
     }
     if (rulefile) {
+        paths.push_back(RulePath(rulename, inuser ? lifegetuserrules() : lifegetrulesdir(), ".rule"));
         err = LoadTableOrTree(rulefile, s);
         if (inuser && err && (strcmp(err, noTABLEorTREE) == 0)) {
             // if .rule file was found in user's rules dir but had no
@@ -145,8 +276,12 @@ const char* ruleloaderalgo::setrule(const char* s)
             // (this lets user override the colors/icons in a supplied .rule
             // file without having to copy the entire file)
             rulefile = OpenRuleFile(rulename, lifegetrulesdir());
-            if (rulefile) err = LoadTableOrTree(rulefile, s);
+            if (rulefile) {
+                paths.push_back(RulePath(rulename, lifegetrulesdir(), ".rule"));
+                err = LoadTableOrTree(rulefile, s);
+            }
         }
+        if (err == NULL) CacheRule(rulename, paths);
         return err;
     }
 
@@ -154,6 +289,8 @@ const char* ruleloaderalgo::setrule(const char* s)
     err = LocalRuleTable->setrule(s);
     if (err == NULL) {
         SetAlgoVariables(TABLE);
+        paths.push_back(FindRuleFile(rulename, ".table"));
+        CacheRule(rulename, paths);
         return NULL;
     }
     
@@ -161,6 +298,8 @@ const char* ruleloaderalgo::setrule(const char* s)
     err = LocalRuleTree->setrule(s);
     if (err == NULL) {
         SetAlgoVariables(TREE);
+        paths.push_back(FindRuleFile(rulename, ".tree"));
+        CacheRule(rulename, paths);
         return NULL;
     }
     
@@ -32,6 +32,7 @@ protected:
     
     void SetAlgoVariables(RuleTypes ruletype);
     const char* LoadTableOrTree(FILE* rulefile, const char* rule);
+    void CacheRule(const std::string& rulename, const std::vector<std::string>& paths);
 };
 
 extern const char* noTABLEorTREE;
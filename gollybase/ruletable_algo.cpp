@@ -74,7 +74,37 @@ const char* ruletable_algo::setrule(const char* s)
 
       return ret.c_str();
    }
-   
+
+   return SetRuleName(s);
+}
+
+void ruletable_algo::SaveCompiled(compiledtable& ct)
+{
+   ct.n_states = this->n_states;
+   ct.neighborhood = this->neighborhood;
+   ct.lut = this->lut;
+   ct.n_compressed_rules = this->n_compressed_rules;
+   ct.output = this->output;
+}
+
+const char* ruletable_algo::UseCompiled(const compiledtable& ct, const char* s)
+{
+   this->n_states = ct.n_states;
+   this->neighborhood = ct.neighborhood;
+   this->lut = ct.lut;
+   this->n_compressed_rules = ct.n_compressed_rules;
+   this->output = ct.output;
+   return SetRuleName(s);
+}
+
+// finish setting a rule once its table is loaded
+const char* ruletable_algo::SetRuleName(const char* s)
+{
+   const char *colonptr = strchr(s, ':');
+   string rule_name(s);
+   if (colonptr) 
+      rule_name.assign(s,colonptr);
+
    // check for rule suffix like ":T200,100" to specify a bounded universe
    if (colonptr) {
       const char* err = setgridsize(colonptr);
@@ -28,9 +28,16 @@ public:
    bool IsDefaultRule(const char* rulename);
    const char* LoadTable(FILE* rulefile, int lineno, char endchar, const char* s);
 
+   // RuleLoader keeps the compiled form of the tables it has loaded so
+   // setting the same rule again doesn't have to reread and repack it
+   struct compiledtable;
+   void SaveCompiled(compiledtable& ct);
+   const char* UseCompiled(const compiledtable& ct, const char* s);
+
 protected:
 
    std::string LoadRuleTable(std::string filename);
+   const char* SetRuleName(const char* s);
    void PackTransitions(const std::string& symmetries, int n_inputs, 
                         const std::vector< std::pair< std::vector< std::vector<state> >, state> > & transition_table);
    void PackTransition(const std::vector< std::vector<state> > & inputs, state output);
@@ -50,4 +57,12 @@ protected:
    std::vector<state> output; // state output[n_rules];
 
 };
+
+struct ruletable_algo::compiledtable {
+   unsigned int n_states;
+   TNeighborhood neighborhood;
+   std::vector< std::vector< std::vector<TBits> > > lut;
+   unsigned int n_compressed_rules;
+   std::vector<state> output;
+};
 #endif
@@ -191,6 +191,13 @@ const char* ruletreealgo::setrule(const char* s) {
       return "Bad count of values in tree data" ;
    if (lev != mnum_neighbors + 1)
       return "Bad last node (wrong level)" ;
+   return SetTree(dat, datb, noff[noff.size()-1], mnum_nodes, mnum_states,
+                  mnum_neighbors, rule_name) ;
+}
+
+const char* ruletreealgo::SetTree(const vector<int>& dat, const vector<state>& datb,
+                                  int newbase, int nodes, int states, int neighbors,
+                                  const string& rule_name) {
    int *na = (int*)calloc(sizeof(int), dat.size()) ;
    state *nb = (state*)calloc(sizeof(state), datb.size()) ;
    if (na == 0 || nb == 0)
@@ -199,16 +206,19 @@ const char* ruletreealgo::setrule(const char* s) {
       free(a) ;
    if (b)
       free(b) ;
-   num_nodes = mnum_nodes ;
-   num_states = mnum_states ;
-   num_neighbors = mnum_neighbors ;
+   num_nodes = nodes ;
+   num_states = states ;
+   num_neighbors = neighbors ;
    for (unsigned int i=0; i<dat.size(); i++)
       na[i] = dat[i] ;
    for (unsigned int i=0; i<datb.size(); i++)
       nb[i] = datb[i] ;
    a = na ;
    b = nb ;
-   base = noff[noff.size()-1] ;
+   asize = (int)dat.size() ;
+   bsize = (int)datb.size() ;
+   base = newbase ;
+   FlattenTree() ;
    maxCellStates = num_states ;
    ghashbase::setrule(rule_name.c_str()) ;
    
@@ -226,6 +236,79 @@ const char* ruletreealgo::setrule(const char* s) {
    return 0 ;
 }
 
+// the flattened table is kept to 1K entries (4KB) so it stays in L1 cache
+static const int MAXFLATBITS = 10 ;
+
+void ruletreealgo::FlattenTree() {
+   if (flat) {
+      free(flat) ;
+      flat = 0 ;
+   }
+   flatlevels = 0 ;
+   flatbits = 1 ;
+   while ((1 << flatbits) < num_states)
+      flatbits++ ;
+   // slowcalc has straight-line code for flattening the first two
+   // levels, or the first four of an 8-neighbor tree
+   if (num_neighbors == 8 && 4 * flatbits <= MAXFLATBITS)
+      flatlevels = 4 ;
+   else if (2 * flatbits <= MAXFLATBITS)
+      flatlevels = 2 ;
+   else
+      return ;
+   int entries = 1 << (flatlevels * flatbits) ;
+   flat = (int *)calloc(sizeof(int), entries) ;
+   if (flat == 0) {
+      flatlevels = 0 ;
+      return ;
+   }
+   int mask = (1 << flatbits) - 1 ;
+   for (int i=0; i<entries; i++) {
+      int x = base ;
+      int shift = flatlevels * flatbits ;
+      for (int lev=0; lev<flatlevels; lev++) {
+         shift -= flatbits ;
+         int v = (i >> shift) & mask ;
+         if (v >= num_states) {
+            // no cell has this state, so the entry is never used
+            x = 0 ;
+            break ;
+         }
+         x = a[x+v] ;
+      }
+      flat[i] = x ;
+   }
+}
+
+void ruletreealgo::SaveCompiled(compiledtree& ct) {
+   ct.a.assign(a, a + asize) ;
+   ct.b.assign(b, b + bsize) ;
+   ct.base = base ;
+   ct.num_neighbors = num_neighbors ;
+   ct.num_states = num_states ;
+   ct.num_nodes = num_nodes ;
+}
+
+const char* ruletreealgo::UseCompiled(const compiledtree& ct, const char* s) {
+   const char *colonptr = strchr(s, ':');
+   string rule_name(s);
+   if (colonptr)
+      rule_name.assign(s,colonptr);
+
+   // check for rule suffix like ":T200,100" to specify a bounded universe
+   if (colonptr) {
+      const char* err = setgridsize(colonptr);
+      if (err) return err;
+   } else {
+      // universe is unbounded
+      gridwd = 0;
+      gridht = 0;
+   }
+
+   return SetTree(ct.a, ct.b, ct.base, ct.num_nodes, ct.num_states,
+                  ct.num_neighbors, rule_name) ;
+}
+
 const char* ruletreealgo::getrule() {
    return rule ;
 }
@@ -235,8 +318,9 @@ const char* ruletreealgo::DefaultRule() {
 }
 
 ruletreealgo::ruletreealgo() : ghashbase(), a(0), base(0), b(0),
-                               num_neighbors(0),
-                               num_states(0), num_nodes(0) {
+                               asize(0), bsize(0), num_neighbors(0),
+                               num_states(0), num_nodes(0), flat(0),
+                               flatlevels(0), flatbits(0) {
    rule[0] = 0 ;
 }
 
@@ -249,10 +333,23 @@ ruletreealgo::~ruletreealgo() {
       free(b) ;
       b = 0 ;
    }
+   if (flat != 0) {
+      free(flat) ;
+      flat = 0 ;
+   }
 }
 
 state ruletreealgo::slowcalc(state nw, state n, state ne, state w, state c, state e,
                         state sw, state s, state se) {
+   if (flatlevels == 4)
+      return b[a[a[a[a[flat[(((((nw << flatbits) | ne) << flatbits) | sw)
+                                << flatbits) | se]+n]+w]+e]+s]+c] ;
+   if (flatlevels == 2) {
+      if (num_neighbors == 4)
+         return b[a[a[flat[(n << flatbits) | w]+e]+s]+c] ;
+      else
+         return b[a[a[a[a[a[a[flat[(nw << flatbits) | ne]+sw]+se]+n]+w]+e]+s]+c] ;
+   }
    if (num_neighbors == 4)
      return b[a[a[a[a[base+n]+w]+e]+s]+c] ;
    else
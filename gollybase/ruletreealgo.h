@@ -4,6 +4,8 @@
 #ifndef RULETREEALGO_H
 #define RULETREEALGO_H
 #include "ghashbase.h"
+#include <string>
+#include <vector>
 /**
  *   An algorithm that uses an n-dary decision diagram.
  */
@@ -23,10 +25,35 @@ public:
    bool IsDefaultRule(const char* rulename);
    const char* LoadTree(FILE* rulefile, int lineno, char endchar, const char* s);
 
+   // RuleLoader keeps the compiled form of the trees it has loaded so
+   // setting the same rule again doesn't have to reread it
+   struct compiledtree {
+      std::vector<int> a ;
+      std::vector<state> b ;
+      int base, num_neighbors, num_states, num_nodes ;
+   } ;
+   void SaveCompiled(compiledtree& ct) ;
+   const char* UseCompiled(const compiledtree& ct, const char* s) ;
+
 private:
    int *a, base ;
    state *b ;
+   int asize, bsize ;     // number of entries in a and b
    int num_neighbors, num_states, num_nodes ;
    char rule[MAXRULESIZE] ;
+
+   // slowcalc walks one level of the tree per neighbor, and every step
+   // has to wait for the load before it.  To cut that chain short, the
+   // first flatlevels levels are flattened into one table indexed by
+   // those neighbors' states, flatbits bits apiece; each entry is where
+   // the walk would be after those levels.  flat is 0 if the rule has
+   // too many states for this to pay.
+   int *flat ;
+   int flatlevels, flatbits ;
+   void FlattenTree() ;
+
+   const char* SetTree(const std::vector<int>& dat, const std::vector<state>& datb,
+                       int newbase, int nodes, int states, int neighbors,
+                       const std::string& rule_name) ;
 };
 #endif
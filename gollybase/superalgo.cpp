@@ -47,6 +47,13 @@ static const int alive13or15or17or19or21or23or25 = (1 << 13) | (1 << 15) | (1 <<
 static const int alive9or11 = (1 << 9) | (1 << 11) ;
 static const int alive1or3or5or13or15or17or19or21or23or25 = (1 << 1) | (1 << 3) | (1 << 5) | (1 << 13) | (1 << 15) | (1 << 17) | (1 << 19) | (1 << 21) | (1 << 23) | (1 << 25) ;
 
+// neighboring cell states that need more than the plaincalc table
+static const int superSpecial = (1 << 3) | (1 << 5) | (1 << 6) | (1 << 7) | alive9to25 ;
+static const int historySpecial = (1 << 6) ;
+
+// plaincalc entry for center states that always need the full calculation
+static const state notplain = 255 ;
+
 // XPM data for the 31x31 icons
 static const char* super31x31[] = {
 /* width height num_colors chars_per_pixel */
@@ -1493,16 +1500,7 @@ static int bitcount(int v) {
 
 state superalgo::slowcalc(state nw, state n, state ne, state w, state c,
                                 state e, state sw, state s, state se) {
-   // result
-   state result = 0 ;
    int typeMask = 0 ;
-   int calc = 0 ;
-   bool process = true ;
-
-   // get the lookup table
-   char *lookup = rule3x3 ;
-
-   result = c ;
 
    // typemask has a bit set per state in the neighbouring cells
    switch (neighbormask) {
@@ -1520,6 +1518,31 @@ state superalgo::slowcalc(state nw, state n, state ne, state w, state c,
          break ;
    }
 
+   // create lookup index for next generation
+   int index = ((nw & 1) << 8) | ((n & 1) << 7) | ((ne & 1) << 6)
+      | ((w & 1) << 5) | ((c & 1) << 4) | ((e & 1) << 3)
+      | ((sw & 1) << 2) | ((s & 1) << 1) | (se & 1) ;
+
+   // without any special neighbors the new state only depends on the
+   // center state and which cells are alive
+   if ((typeMask & specialmask) == 0) {
+      state result = plaincalc[c][index] ;
+      if (result != notplain) return result ;
+   }
+   return fullcalc(c, typeMask, index) ;
+}
+
+state superalgo::fullcalc(state c, int typeMask, int index) {
+   // result
+   state result = 0 ;
+   int calc = 0 ;
+   bool process = true ;
+
+   // get the lookup table
+   char *lookup = rule3x3 ;
+
+   result = c ;
+
    // check rule type
    if (is_history) {
       // [R]History
@@ -1545,11 +1568,6 @@ state superalgo::slowcalc(state nw, state n, state ne, state w, state c,
 
       // check whether state still needs processing
       if (process) {
-         // create lookup index for next generation
-         int index = ((nw & 1) << 8) | ((n & 1) << 7) | ((ne & 1) << 6)
-            | ((w & 1) << 5) | ((c & 1) << 4) | ((e & 1) << 3)
-            | ((sw & 1) << 2) | ((s & 1) << 1) | (se & 1) ;
-
          // get cell state
          if (lookup[index]) {
             // cell alive
@@ -1618,11 +1636,6 @@ state superalgo::slowcalc(state nw, state n, state ne, state w, state c,
 
       // check whether state still needs processing
       if (process) {
-         // create lookup index for next generation
-         int index = ((nw & 1) << 8) | ((n & 1) << 7) | ((ne & 1) << 6)
-            | ((w & 1) << 5) | ((c & 1) << 4) | ((e & 1) << 3)
-            | ((sw & 1) << 2) | ((s & 1) << 1) | (se & 1) ;
-
          // get cell state
          if (lookup[index]) {
             // cell alive
@@ -2886,6 +2899,22 @@ const char *superalgo::setrule(const char *rulestring) {
    }
    is_history = history ;
 
+   // build the table slowcalc uses when there are no special neighbors;
+   // the typemask only needs to say whether any neighbors are 0 or 1
+   specialmask = history ? historySpecial : superSpecial ;
+   int nbrmask = neighbormask & ~0x10 ;
+   for (int c = 0 ; c < maxCellStates ; c++) {
+      for (int i = 0 ; i < ALL3X3 ; i++) {
+         if (!history && c > 14 && (c & 1) == 0) {
+            // dead states 16..24 check which states their neighbors are in
+            plaincalc[c][i] = notplain ;
+         } else {
+            int typeMask = ((i & nbrmask) ? (1 << 1) : 0) | ((~i & nbrmask) ? (1 << 0) : 0) ;
+            plaincalc[c][i] = fullcalc((state) c, typeMask, i) ;
+         }
+      }
+   }
+
    // set grid_type
    if (neighbormask == HEXAGONAL)
       grid_type = HEX_GRID;
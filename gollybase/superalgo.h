@@ -47,7 +47,10 @@ private:
    char rule3x3[ALL3X3] ;             // all 3x3 cell mappings 012345678->4'
    const char *base64_characters ;    // base 64 encoding characters
    bool is_history ;                  // whether rule is [R]History (true) or [R]Super (false)
+   int specialmask ;                  // neighbor states that need fullcalc
+   state plaincalc[26][ALL3X3] ;      // new state for each center state and 3x3 map index
 
+   state fullcalc(state c, int typeMask, int index) ;
    void initRule() ;
    void setTotalistic(int value, bool survival) ;
    int flipBits(int x) ;
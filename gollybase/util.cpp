@@ -10,6 +10,19 @@
 #else
 #include <sys/time.h>
 #endif
+#ifndef __EMSCRIPTEN__
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#define JOB_THREADS
+#endif
+#ifdef __linux__
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 /**
  *   For now error just uses stderr.
@@ -240,12 +253,245 @@ void hperf::reportStep(hperf &mark, hperf &ratemark, double newGen, int verbose)
       double nodespergen = nodeCount / inc ;
       double fps = (frames - mark.frames) / elapsed ;
       sprintf(perfstatusline,
-          "PERF gps %g nps %g fps %g depth %g half %g npg %g nodes %g",
+          "PERF gps %g nps %g fps %g depth %g half %g npg %g nodes %g%s",
           genspersec, nodeCount/elapsed, fps, 1+depthDelta/nodeCount, halfFrac,
-          nodespergen, nodeCount) ;
+          nodespergen, nodeCount, bigallocstats(0)) ;
       lifestatus(perfstatusline) ;
    }
    genval = newGen ;
    mark = *this ;
    ratemark = *this ;
 }
+/*
+ *   Big allocations; see util.h.  We only count what is in the huge
+ *   page arenas; whether the kernel actually gave us huge pages for
+ *   them is in /proc/self/smaps_rollup.
+ */
+static int bigallocmode = BIGALLOC_PLAIN ;
+static size_t arenabytes ;
+static char bigstatsline[120] ;
+void setbigallocmode(int mode) {
+   if (mode < BIGALLOC_PLAIN || mode > BIGALLOC_HUGENUMA)
+      mode = BIGALLOC_PLAIN ;
+   bigallocmode = mode ;
+}
+int getbigallocmode() {
+   return bigallocmode ;
+}
+#ifdef __linux__
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MPOL_INTERLEAVE
+#define MPOL_INTERLEAVE 3
+#endif
+static size_t hugeround(size_t bytes) {
+   return (bytes + BIGALLOC_HUGEPAGE - 1) & ~(BIGALLOC_HUGEPAGE - 1) ;
+}
+/*
+ *   Spread the pages of a new mapping over all the online memory nodes.
+ *   This is just a hint to the kernel, so we ignore any failure.  We go
+ *   straight to the system call so we don't need libnuma.
+ */
+static void interleave(void *p, size_t bytes) {
+#ifdef SYS_mbind
+   const int LONGBITS = 8 * sizeof(unsigned long) ;
+   static unsigned long nodemask[1024 / (8 * sizeof(unsigned long))] ;
+   static int maxnode = -1 ;
+   if (maxnode < 0) {
+      maxnode = 0 ;
+      // the online nodes are listed like "0-1" or "0,2-3"
+      FILE *nf = fopen("/sys/devices/system/node/online", "r") ;
+      if (nf) {
+         int lo, hi, sep ;
+         while (fscanf(nf, "%d", &lo) == 1) {
+            hi = lo ;
+            sep = getc(nf) ;
+            if (sep == '-') {
+               if (fscanf(nf, "%d", &hi) != 1)
+                  break ;
+               sep = getc(nf) ;
+            }
+            for (int n=lo; n<=hi && n<1024; n++) {
+               nodemask[n / LONGBITS] |= 1UL << (n % LONGBITS) ;
+               if (n + 1 > maxnode)
+                  maxnode = n + 1 ;
+            }
+            if (sep != ',')
+               break ;
+         }
+         fclose(nf) ;
+      }
+   }
+   if (maxnode > 1)
+      syscall(SYS_mbind, p, bytes, MPOL_INTERLEAVE, nodemask, maxnode + 1, 0) ;
+#endif
+}
+/*
+ *   Map an arena (bytes is already a multiple of the huge page size).
+ *   Explicit huge pages are reserved when they're mapped, so if the
+ *   pool is too small we find out here and fall back to ordinary pages
+ *   aligned so transparent huge pages can be used.  Either way the
+ *   memory comes to us zeroed.
+ */
+static void *hugealloc(size_t bytes, int numa) {
+   void *p = mmap(0, bytes, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                  (21 << MAP_HUGE_SHIFT), -1, 0) ;
+   if (p == MAP_FAILED) {
+      size_t len = bytes + BIGALLOC_HUGEPAGE ;
+      char *q = (char *)mmap(0, len, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) ;
+      if (q == MAP_FAILED)
+         return 0 ;
+      size_t head = (BIGALLOC_HUGEPAGE - ((size_t)q & (BIGALLOC_HUGEPAGE - 1)))
+                    & (BIGALLOC_HUGEPAGE - 1) ;
+      if (head)
+         munmap(q, head) ;
+      munmap(q + head + bytes, len - head - bytes) ;
+      p = q + head ;
+#ifdef MADV_HUGEPAGE
+      madvise(p, bytes, MADV_HUGEPAGE) ;
+#endif
+   }
+   if (numa)
+      interleave(p, bytes) ;
+   arenabytes += bytes ;
+   return p ;
+}
+#endif
+void *bigalloc(size_t bytes, int mode) {
+#ifdef __linux__
+   if (mode != BIGALLOC_PLAIN && bytes >= BIGALLOC_HUGEPAGE / 2)
+      return hugealloc(hugeround(bytes), mode == BIGALLOC_HUGENUMA) ;
+#endif
+   return calloc(bytes, 1) ;
+}
+void bigfree(void *p, size_t bytes, int mode) {
+   if (p == 0)
+      return ;
+#ifdef __linux__
+   if (mode != BIGALLOC_PLAIN && bytes >= BIGALLOC_HUGEPAGE / 2) {
+      bytes = hugeround(bytes) ;
+      munmap(p, bytes) ;
+      arenabytes -= bytes ;
+      return ;
+   }
+#endif
+   free(p) ;
+}
+const char *bigallocstats(int checkkernel) {
+   bigstatsline[0] = 0 ;
+   if (arenabytes == 0)
+      return bigstatsline ;
+   sprintf(bigstatsline, " arenas %gM", arenabytes / 1048576.0) ;
+#ifdef __linux__
+   FILE *sf = checkkernel ? fopen("/proc/self/smaps_rollup", "r") : 0 ;
+   if (sf) {
+      char line[256] ;
+      double kb, thp = 0, hugetlb = 0 ;
+      while (fgets(line, sizeof(line), sf)) {
+         if (sscanf(line, "AnonHugePages: %lf", &kb) == 1)
+            thp += kb ;
+         else if (sscanf(line, "Private_Hugetlb: %lf", &kb) == 1 ||
+                  sscanf(line, "Shared_Hugetlb: %lf", &kb) == 1)
+            hugetlb += kb ;
+      }
+      fclose(sf) ;
+      sprintf(bigstatsline + strlen(bigstatsline), " thp %gM hugetlb %gM",
+              thp / 1024, hugetlb / 1024) ;
+   }
+#endif
+   return bigstatsline ;
+}
+/**
+ *   The job pool.  Each thread waits for the round number to change,
+ *   runs its job if there is one for it this round, and counts itself
+ *   out.  The pool is a static object, so its threads are stopped and
+ *   joined at exit.
+ */
+const int maxjobs = 8 ;
+#ifdef JOB_THREADS
+class jobpool {
+public:
+   jobpool() : job(0), arg(0), njobs(0), round(0), busy(0), quit(0) {}
+   ~jobpool() {
+      {
+         std::lock_guard<std::mutex> lk(m) ;
+         quit = 1 ;
+      }
+      wake.notify_all() ;
+      for (int i=0; i<(int)threads.size(); i++)
+         threads[i].join() ;
+   }
+   void run(void (*j)(void *, int, int), void *a, int n) {
+      // only this thread changes round, so it's safe to read it here
+      while ((int)threads.size() < n - 1)
+         threads.push_back(std::thread(&jobpool::work, this,
+                                       (int)threads.size() + 1, round)) ;
+      {
+         std::lock_guard<std::mutex> lk(m) ;
+         job = j ;
+         arg = a ;
+         njobs = n ;
+         busy = n - 1 ;
+         round++ ;
+      }
+      wake.notify_all() ;
+      j(a, 0, n) ;
+      std::unique_lock<std::mutex> lk(m) ;
+      while (busy)
+         done.wait(lk) ;
+   }
+private:
+   void work(int i, unsigned int seen) {
+      std::unique_lock<std::mutex> lk(m) ;
+      for (;;) {
+         while (!quit && round == seen)
+            wake.wait(lk) ;
+         if (quit)
+            return ;
+         seen = round ;
+         if (i < njobs) {
+            lk.unlock() ;
+            job(arg, i, njobs) ;
+            lk.lock() ;
+            if (--busy == 0)
+               done.notify_one() ;
+         }
+      }
+   }
+   std::vector<std::thread> threads ;
+   std::mutex m ;
+   std::condition_variable wake, done ;
+   void (*job)(void *, int, int) ;
+   void *arg ;
+   int njobs ;
+   unsigned int round ;
+   int busy, quit ;
+} ;
+static jobpool jobpool ;
+#endif
+int jobcount(int items, int minper) {
+   int n = 1 ;
+#ifdef JOB_THREADS
+   n = (int)std::thread::hardware_concurrency() ;
+   if (n > maxjobs)
+      n = maxjobs ;
+   if (n > items / minper)
+      n = items / minper ;
+   if (n < 1)
+      n = 1 ;
+#endif
+   return n ;
+}
+void runjobs(void (*job)(void *arg, int i, int n), void *arg, int n) {
+#ifdef JOB_THREADS
+   if (n > 1) {
+      jobpool.run(job, arg, n) ;
+      return ;
+   }
+#endif
+   for (int i=0; i<n; i++)
+      job(arg, i, n) ;
+}
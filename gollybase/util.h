@@ -7,6 +7,7 @@
 #ifndef UTIL_H
 #define UTIL_H
 #include <cstdio> // for FILE *
+#include <cstddef> // for size_t
 
 void lifefatal(const char *s) ;
 void lifewarning(const char *s) ;
@@ -109,4 +110,38 @@ struct hperf {
    static int reportMask ;
    static double reportInterval ;
 } ;
+/**
+ *   Big zeroed allocations, for the node blocks and hash tables of the
+ *   hashing algorithms.  Normally these are just calloc and free.  In
+ *   the huge page modes (Linux only; elsewhere they act like plain
+ *   mode) anything of at least half of BIGALLOC_HUGEPAGE bytes is
+ *   rounded up to a multiple of that and mapped on its own, aligned so that it can be
+ *   backed by huge pages: explicit ones (MAP_HUGETLB) if the system has
+ *   a pool of them, else transparent ones (MADV_HUGEPAGE).  The NUMA
+ *   mode also interleaves those pages across all memory nodes.  The mode
+ *   is the caller's to remember; bigfree must get the same size and mode
+ *   the memory was allocated with.
+ */
+enum { BIGALLOC_PLAIN, BIGALLOC_HUGE, BIGALLOC_HUGENUMA } ;
+const size_t BIGALLOC_HUGEPAGE = 2 << 20 ;
+void setbigallocmode(int mode) ;   // mode for universes created later
+int getbigallocmode() ;
+void *bigalloc(size_t bytes, int mode) ;
+void bigfree(void *p, size_t bytes, int mode) ;
+// a short summary of huge page use for verbose output; it's empty if
+// nothing has been allocated in a huge page mode; if checkkernel is
+// set we also ask the kernel how much is actually in huge pages
+const char *bigallocstats(int checkkernel) ;
+/**
+ *   A small pool of threads for splitting up the drawing of a frame.
+ *   runjobs(job, arg, n) calls job(arg, i, n) for each i from 0 to n-1,
+ *   i = 0 on the calling thread and the others on the pool's threads,
+ *   and returns when they have all finished.  The threads are started
+ *   the first time they're needed and then wait for the next frame, so
+ *   we don't pay for creating them every time.  jobcount(items, minper)
+ *   suggests how many jobs to split items up into so that each gets at
+ *   least minper of them; it's always 1 where we have no threads.
+ */
+int jobcount(int items, int minper) ;
+void runjobs(void (*job)(void *arg, int i, int n), void *arg, int n) ;
 #endif
@@ -80,7 +80,26 @@ void viewport::unzoom(int xx, int yy) {
       if (ydrift != 0) move(0, -ydrift.toint() << mag);
    }
 }
+/**
+ *   Most patterns are nowhere near 2^62 cells from the origin, so at
+ *   and screenPosOf first try doing their arithmetic in 64-bit ints,
+ *   and only fall back to bigint arithmetic when they must.  Either
+ *   way they give exactly the same results.
+ */
 pair<bigint, bigint> viewport::at(int x, int y) {
+   G_INT64 x0i, y0i ;
+   if (mag >= -30 && x0.toint64(x0i) && y0.toint64(y0i)) {
+      // |x << 30| < 2^61, so the sums can't overflow
+      G_INT64 rx = x, ry = y ;
+      if (mag > 0) {
+         rx >>= mag ;
+         ry >>= mag ;
+      } else {
+         rx *= G_MAKEINT64(1) << -mag ;
+         ry *= G_MAKEINT64(1) << -mag ;
+      }
+      return pair<bigint, bigint>(bigint(rx + x0i), bigint(ry + y0i)) ;
+   }
    bigint rx = x ;
    bigint ry = y ;
    rx.mulpow2(-mag) ;
@@ -92,6 +111,25 @@ pair<bigint, bigint> viewport::at(int x, int y) {
 pair<double, double> viewport::atf(int x, int y) {
    return pair<double, double>(x0f + x * xymf, y0f + y * xymf) ;
 }
+// scale a cell offset (less than 2^63) to pixels, clamped to an int
+static int topixels(G_INT64 d, int mag) {
+   if (mag > 0) {
+      if (d > (INT_MAX >> mag))
+         return INT_MAX ;
+      if (d < (INT_MIN >> mag))
+         return INT_MIN ;
+      return (int)d * (1 << mag) ;
+   }
+   if (mag < -62)
+      d = (d < 0) ? -1 : 0 ;
+   else
+      d >>= -mag ;
+   if (d > INT_MAX)
+      return INT_MAX ;
+   if (d < INT_MIN)
+      return INT_MIN ;
+   return (int)d ;
+}
 /**
  *   Returns the screen position of a particular pixel.  Note that this
  *   is a tiny bit more complicated than you might expect, because it
@@ -102,19 +140,23 @@ pair<double, double> viewport::atf(int x, int y) {
  *   the upper left pixel; it's up to the caller to adjust when
  *   mag<0.
  */
-pair<int,int> viewport::screenPosOf(bigint x, bigint y, lifealgo *algo) {
-   if (mag < 0) {
-      bigint xx0 = x0 ;
-      bigint yy0 = y0 ;
+pair<int,int> viewport::screenPosOf(const bigint &x, const bigint &y, lifealgo *algo) {
+   bigint xx0 = x0 ;
+   bigint yy0 = y0 ;
+   if (mag < 0)
       algo->lowerRightPixel(xx0, yy0, mag) ;
-      y -= yy0 ;
-      x -= xx0 ;
-   } else {
-      x -= x0 ;
-      y -= y0 ;
-   }
-   x.mulpow2(mag) ;
-   y.mulpow2(mag) ;
+
+   G_INT64 xi, yi, x0i, y0i ;
+   if (mag < 31 && x.toint64(xi) && y.toint64(yi) &&
+       xx0.toint64(x0i) && yy0.toint64(y0i))
+      return pair<int,int>(topixels(xi - x0i, mag), topixels(yi - y0i, mag)) ;
+
+   bigint bx = x ;
+   bigint by = y ;
+   bx -= xx0 ;
+   by -= yy0 ;
+   bx.mulpow2(mag) ;
+   by.mulpow2(mag) ;
 
    int xx = 0 ;
    int yy = 0 ;
@@ -136,19 +178,19 @@ pair<int,int> viewport::screenPosOf(bigint x, bigint y, lifealgo *algo) {
      yy = y.toint() ;
 */
    
-   if (x > bigint::maxint)
+   if (bx > bigint::maxint)
       xx = INT_MAX ;
-   else if (x < bigint::minint)
+   else if (bx < bigint::minint)
       xx = INT_MIN ;
    else
-      xx = x.toint() ;
+      xx = bx.toint() ;
    
-   if (y > bigint::maxint)
+   if (by > bigint::maxint)
       yy = INT_MAX ;
-   else if (y < bigint::minint)
+   else if (by < bigint::minint)
       yy = INT_MIN ;
    else
-      yy = y.toint() ;
+      yy = by.toint() ;
      
    return pair<int,int>(xx,yy) ;
 }
@@ -30,7 +30,7 @@ public:
    void center() ;
    pair<bigint, bigint> at(int x, int y) ;
    pair<double, double> atf(int x, int y) ;
-   pair<int,int> screenPosOf(bigint x, bigint y, lifealgo *algo) ;
+   pair<int,int> screenPosOf(const bigint &x, const bigint &y, lifealgo *algo) ;
    void resize(int newwidth, int newheight) ;
    void move(int dx, int dy) ;   // dx and dy are given in pixels
    int getmag() const { return mag ; }
@@ -97,7 +97,9 @@ bool SaveStartingPattern()
     currlayer->startfile = currlayer->tempstart;     // ResetPattern will load tempstart
 
     // save starting pattern in tempstart file
-    if ( currlayer->algo->hyperCapable() ) {
+    if ( KeepPattern(currlayer->tempstart) ) {
+        // no need to write the file unless the universe is deleted
+    } else if ( currlayer->algo->hyperCapable() ) {
         // much faster to save pattern in a macrocell file
         const char* err = WritePattern(currlayer->tempstart.c_str(), MC_format,
                                        no_compression, 0, 0, 0, 0);
@@ -224,8 +226,10 @@ void ResetPattern(bool resetundo)
     // first restore algorithm
     currlayer->algtype = currlayer->startalgo;
 
-    // restore starting pattern
-    LoadPattern(currlayer->startfile.c_str(), "");
+    // restore starting pattern (the algorithm might still have it in memory)
+    if (currlayer->algtype != oldalgo || !RestoreKeptPattern(currlayer->startfile)) {
+        LoadPattern(currlayer->startfile.c_str(), "");
+    }
 
     if (currlayer->algo->getGeneration() != currlayer->startgen) {
         // LoadPattern failed to reset the gen count to startgen
@@ -300,8 +304,10 @@ void RestorePattern(bigint& gen, const char* filename,
         // restore starting pattern (false means don't call SyncUndoHistory)
         ResetPattern(false);
     } else {
-        // restore pattern in given filename
-        LoadPattern(filename, "");
+        // restore pattern in given filename (unless the algorithm kept it)
+        if (!RestoreKeptPattern(filename)) {
+            LoadPattern(filename, "");
+        }
 
         if (currlayer->algo->getGeneration() != gen) {
             // best to clear the pattern and set the expected gen count
@@ -381,6 +387,7 @@ const char* ChangeGenCount(const char* genstring, bool inundoredo)
             return "Failed to copy pattern.";
         }
         // switch to new universe
+        SaveKeptPatterns();
         delete currlayer->algo;
         currlayer->algo = newalgo;
         SetGenIncrement();
@@ -551,6 +558,9 @@ void NextGeneration(bool useinc)
         curralgo->setIncrement(saveinc);
     }
 
+    // don't let patterns kept for undo/reset pin too much memory
+    SpillKeptPatterns();
+
     if (!generating) {
         if (showtiming && useinc && curralgo->getIncrement() > bigint::one) DisplayTimingInfo();
         lifealgo::setVerbose(0);
@@ -980,6 +990,7 @@ void ChangeAlgorithm(algo_type newalgotype, const char* newrule, bool inundoredo
     }
 
     // delete old universe and point current universe to new universe
+    SaveKeptPatterns();
     delete currlayer->algo;
     currlayer->algo = newalgo;
     SetGenIncrement();
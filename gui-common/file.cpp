@@ -91,6 +91,7 @@ void CreateUniverse()
     std::string oldrule = currlayer->algo->getrule();
 
     // delete old universe and create new one of same type
+    SaveKeptPatterns();
     delete currlayer->algo;
     currlayer->algo = CreateNewUniverse(currlayer->algtype);
 
@@ -165,6 +166,7 @@ bool LoadPattern(const char* path, const char* newtitle)
         currlayer->savestart = false;
         currlayer->startfile = path;
         currlayer->currfile = path;
+        ForgetKeptPattern(path);        // path might be tempstart
 
         // reset step size
         currlayer->currbase = algoinfo[currlayer->algtype]->defbase;
@@ -183,6 +185,7 @@ bool LoadPattern(const char* path, const char* newtitle)
     std::string oldrule = currlayer->algo->getrule();
 
     // delete old universe and create new one of same type
+    SaveKeptPatterns();
     delete currlayer->algo;
     currlayer->algo = CreateNewUniverse(currlayer->algtype);
 
@@ -1952,6 +1952,9 @@ Layer::Layer()
             }
 
             // tempstart file must remain unique in duplicate layer
+            // (and any files the old universe is keeping in memory must
+            // be written so they can be copied by DuplicateHistory)
+            SaveKeptPatterns();
             if ( FileExists(currlayer->tempstart) ) {
                 if ( !CopyFile(currlayer->tempstart, tempstart) ) {
                     Warning("Could not copy tempstart file!");
@@ -2006,6 +2009,7 @@ Layer::~Layer()
         delete undoredo;
 
         // delete tempstart file if it exists
+        ForgetKeptPattern(tempstart);
         if (FileExists(tempstart)) RemoveFile(tempstart);
 
         // delete any icons
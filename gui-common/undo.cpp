@@ -1,14 +1,17 @@
 // This file is part of Golly.
 // See docs/License.html for the copyright notice.
 
+#include <algorithm>         // for std::find
+
 #include "bigint.h"
 #include "lifealgo.h"
 #include "writepattern.h"   // for MC_format, XRLE_format
+#include "readpattern.h"    // for readpattern
 
 #include "select.h"         // for Selection
 #include "view.h"           // for OutsideLimits, nopattupdate, etc
 #include "utils.h"          // for Warning, Fatal, etc
-#include "algos.h"          // for algo_type
+#include "algos.h"          // for algo_type, CreateNewUniverse
 #include "layer.h"          // for currlayer, numclones, MarkLayerDirty, etc
 #include "prefs.h"          // for allowundo, etc
 #include "control.h"        // for RestorePattern
@@ -28,6 +31,240 @@ const char* dupe3_prefix = "g3_";
 const char* dupe4_prefix = "g4_";
 const char* dupe5_prefix = "g5_";
 const char* dupe6_prefix = "g6_";
+const char* region_prefix = "gu_";
+
+// -----------------------------------------------------------------------------
+
+// patterns that are being kept in memory rather than in temporary files
+
+typedef struct {
+    std::string path;   // the file this pattern would be saved in
+    int ticket;         // returned by lifealgo::keepstate
+    bigint gen;         // the pattern's generation count
+} kept_pattern;
+
+static std::vector<kept_pattern> keptpatterns;
+
+static int FindKeptPattern(const std::string& path)
+{
+    for (size_t i = 0; i < keptpatterns.size(); i++) {
+        if (keptpatterns[i].path == path) return (int)i;
+    }
+    return -1;
+}
+
+// -----------------------------------------------------------------------------
+
+bool KeepPattern(const std::string& path)
+{
+    ForgetKeptPattern(path);
+    if (!currlayer->algo->hyperCapable()) return false;
+
+    int ticket = currlayer->algo->keepstate();
+    if (ticket == 0) {
+        // make room for patterns kept from now on
+        SpillKeptPatterns(true);
+        return false;
+    }
+
+    kept_pattern kp;
+    kp.path = path;
+    kp.ticket = ticket;
+    kp.gen = currlayer->algo->getGeneration();
+    keptpatterns.push_back(kp);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+bool RestoreKeptPattern(const std::string& path)
+{
+    int i = FindKeptPattern(path);
+    if (i < 0 || !currlayer->algo->restorestate(keptpatterns[i].ticket)) return false;
+    currlayer->algo->setGeneration(keptpatterns[i].gen);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void ForgetKeptPattern(const std::string& path)
+{
+    int i = FindKeptPattern(path);
+    if (i >= 0) {
+        lifealgo::forgetstate(keptpatterns[i].ticket);
+        keptpatterns.erase(keptpatterns.begin() + i);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+static void WriteKeptPatterns(int count)
+{
+    // write the oldest count patterns kept by the current universe to their files
+    lifealgo* algo = currlayer->algo;
+    void* currstate = NULL;
+    bigint currgen;
+    size_t i = 0;
+    while (i < keptpatterns.size() && count > 0) {
+        kept_pattern& kp = keptpatterns[i];
+        if (!algo->ownsstate(kp.ticket)) {
+            i++;
+            continue;
+        }
+        count--;
+        if (currstate == NULL) {
+            currstate = algo->getcurrentstate();
+            currgen = algo->getGeneration();
+        }
+        // temporarily switch to the kept pattern and save it in a macrocell file
+        algo->restorestate(kp.ticket);
+        algo->setGeneration(kp.gen);
+        const char* err = WritePattern(kp.path.c_str(), MC_format, no_compression, 0, 0, 0, 0);
+        if (err) Warning(err);
+        lifealgo::forgetstate(kp.ticket);
+        keptpatterns.erase(keptpatterns.begin() + i);
+    }
+    if (currstate) {
+        algo->setcurrentstate(currstate);
+        algo->setGeneration(currgen);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void SaveKeptPatterns()
+{
+    WriteKeptPatterns((int)keptpatterns.size());
+}
+
+// -----------------------------------------------------------------------------
+
+void SpillKeptPatterns(bool force)
+{
+    if (!currlayer->algo->keptstatesoverbudget() && !force) return;
+
+    // write the older half of the current universe's kept patterns to their
+    // files so the next gc can free the nodes only they were using
+    int owned = 0;
+    for (size_t i = 0; i < keptpatterns.size(); i++) {
+        if (currlayer->algo->ownsstate(keptpatterns[i].ticket)) owned++;
+    }
+    if (owned > 0) WriteKeptPatterns((owned + 1) / 2);
+}
+
+// -----------------------------------------------------------------------------
+
+// Region changes save the cells in the changed rectangle in universes of
+// their own.  All these copies together are kept within max_region_mem;
+// once they go over it the least recently used ones are written to
+// temporary files (macrocell files for hash-based algorithms, XRLE files
+// otherwise) and only read back when an undo or redo needs them.
+
+const g_uintptr_t max_region_mem = (g_uintptr_t)256 << 20;
+
+class RegionCopy {
+public:
+    RegionCopy(lifealgo* cells, algo_type algotype, int top, int left, int bottom, int right);
+    ~RegionCopy();
+
+    lifealgo* GetCells();
+    // return the saved cells, reading them back from their file if
+    // necessary; return NULL if the file couldn't be read
+
+    bool Spill();
+    // write the cells to a temporary file (unless that was done before)
+    // and delete their universe; return false if the file couldn't be written
+
+    g_uintptr_t MemoryUsed() { return cells ? cells->getMemoryUsed() : 0; }
+
+private:
+    lifealgo* cells;            // NULL if the cells are only in the file
+    algo_type algotype;         // algorithm used by cells
+    int top, left, bottom, right;   // edges of the region
+    std::string path;           // temporary file, or empty if not written yet
+};
+
+static std::vector<RegionCopy*> regioncopies;   // in memory, least recently used first
+
+static void LimitRegionMemory(RegionCopy* keep)
+{
+    // spill the least recently used region copies (other than keep)
+    // until the ones left in memory fit within max_region_mem
+    g_uintptr_t total = 0;
+    for (size_t i = 0; i < regioncopies.size(); i++) total += regioncopies[i]->MemoryUsed();
+    size_t i = 0;
+    while (total > max_region_mem && i < regioncopies.size()) {
+        RegionCopy* r = regioncopies[i];
+        g_uintptr_t used = r->MemoryUsed();
+        if (r != keep && r->Spill()) {
+            // Spill removed r from regioncopies
+            total -= used;
+        } else {
+            i++;
+        }
+    }
+}
+
+RegionCopy::RegionCopy(lifealgo* cells, algo_type algotype,
+                       int top, int left, int bottom, int right)
+    : cells(cells), algotype(algotype), top(top), left(left), bottom(bottom), right(right)
+{
+    regioncopies.push_back(this);
+    LimitRegionMemory(this);
+}
+
+RegionCopy::~RegionCopy()
+{
+    if (cells) {
+        delete cells;
+        regioncopies.erase(std::find(regioncopies.begin(), regioncopies.end(), this));
+    }
+    if (!path.empty() && FileExists(path)) RemoveFile(path);
+}
+
+lifealgo* RegionCopy::GetCells()
+{
+    if (cells) {
+        // now the most recently used copy
+        regioncopies.erase(std::find(regioncopies.begin(), regioncopies.end(), this));
+        regioncopies.push_back(this);
+        return cells;
+    }
+
+    lifealgo* newcells = CreateNewUniverse(algotype);
+    // readpattern will call setrule
+    const char* err = readpattern(path.c_str(), *newcells);
+    if (err) {
+        Warning(err);
+        delete newcells;
+        return NULL;
+    }
+    cells = newcells;
+    regioncopies.push_back(this);
+    LimitRegionMemory(this);
+    return cells;
+}
+
+bool RegionCopy::Spill()
+{
+    if (cells == NULL) return true;
+    if (path.empty()) {
+        // the cells never change, so once written the file can be reused
+        path = CreateTempFileName(region_prefix);
+        pattern_format format = cells->hyperCapable() ? MC_format : XRLE_format;
+        const char* err = writepattern(path.c_str(), *cells, format,
+                                       no_compression, top, left, bottom, right);
+        if (err) {
+            if (FileExists(path)) RemoveFile(path);
+            path.clear();
+            return false;
+        }
+    }
+    delete cells;
+    cells = NULL;
+    regioncopies.erase(std::find(regioncopies.begin(), regioncopies.end(), this));
+    return true;
+}
 
 // -----------------------------------------------------------------------------
 
@@ -178,6 +415,7 @@ typedef enum {
     rotateacw,           // selection was rotated anticlockwise
     rotatepattcw,        // pattern was rotated clockwise
     rotatepattacw,       // pattern was rotated anticlockwise
+    randfill,            // selection was randomly filled
     namechange,          // layer name was changed
 
     // WARNING: code in UndoChange/RedoChange assumes only changes < selchange
@@ -205,6 +443,13 @@ public:
     void ChangeCells(bool undo);
     // change cell states using cellinfo
 
+    void RestoreRegion(RegionCopy* region);
+    // copy all the cells in the region from the given copy
+
+    bool FillCells(bool undo);
+    // restore the selection's old cells or repeat the random fill;
+    // return false if user aborts a lengthy fill
+
     change_type changeid;                   // specifies the type of change
     bool olddirty;                          // layer's dirty state before change
     bool newdirty;                          // layer's dirty state after change
@@ -216,6 +461,17 @@ public:
     // rotatecw/rotateacw/selchange info
     Selection oldsel, newsel;               // old and new selections
 
+    // region info (for cellstates/rotatecw/rotateacw/randfill)
+    RegionCopy* oldcells;                   // region's cells before the change
+    RegionCopy* newcells;                   // region's cells after the change
+    int regtop, regleft, regbottom, regright;   // region's edges
+    // also uses oldalgo
+
+    // randfill info
+    unsigned int fillseed;                  // seed used for the fill
+    int fillperc;                           // density used for the fill
+    // also uses oldsel and region info
+
     // genchange info
     bool scriptgen;                         // gen change was done by script?
     std::string oldfile, newfile;           // old and new pattern files
@@ -260,6 +516,8 @@ ChangeNode::ChangeNode(change_type id)
     whichlayer = NULL;      // simplifies UndoRedo::DeletingClone
     cellinfo = NULL;
     cellcount = 0;
+    oldcells = NULL;
+    newcells = NULL;
     oldfile.clear();
     newfile.clear();
     oldtempstart.clear();
@@ -276,15 +534,19 @@ ChangeNode::~ChangeNode()
 {
     if (startinfo) delete startinfo;
     if (cellinfo) free(cellinfo);
+    if (oldcells) delete oldcells;
+    if (newcells) delete newcells;
     
     // it's always ok to delete oldfile and newfile if they exist
 
-    if (!oldfile.empty() && FileExists(oldfile)) {
-        RemoveFile(oldfile);
+    if (!oldfile.empty()) {
+        ForgetKeptPattern(oldfile);
+        if (FileExists(oldfile)) RemoveFile(oldfile);
     }
     
-    if (!newfile.empty() && FileExists(newfile)) {
-        RemoveFile(newfile);
+    if (!newfile.empty()) {
+        ForgetKeptPattern(newfile);
+        if (FileExists(newfile)) RemoveFile(newfile);
     }
 
     if (delete_all_temps) {
@@ -294,21 +556,25 @@ ChangeNode::~ChangeNode()
         
         if (!oldtempstart.empty() && FileExists(oldtempstart) &&
             oldtempstart.compare(0,tempdir.length(),tempdir) == 0 && oldtempstart != currlayer->startfile) {
+            ForgetKeptPattern(oldtempstart);
             RemoveFile(oldtempstart);
         }
         
         if (!newtempstart.empty() && FileExists(newtempstart) &&
             newtempstart.compare(0,tempdir.length(),tempdir) == 0 && newtempstart != currlayer->startfile) {
+            ForgetKeptPattern(newtempstart);
             RemoveFile(newtempstart);
         }
         
         if (!oldstartfile.empty() && FileExists(oldstartfile) &&
             oldstartfile.compare(0,tempdir.length(),tempdir) == 0 && oldstartfile != currlayer->startfile) {
+            ForgetKeptPattern(oldstartfile);
             RemoveFile(oldstartfile);
         }
         
         if (!newstartfile.empty() && FileExists(newstartfile) &&
             newstartfile.compare(0,tempdir.length(),tempdir) == 0 && newstartfile != currlayer->startfile) {
+            ForgetKeptPattern(newstartfile);
             RemoveFile(newstartfile);
         }
     }
@@ -323,6 +589,8 @@ void ChangeNode::ChangeCells(bool undo)
 
     // change state of cell(s) stored in cellinfo array
     if (undo) {
+        // a region change is always saved after any cell changes
+        if (oldcells) RestoreRegion(oldcells);
         // we must undo the cell changes in reverse order in case
         // a script has changed the same cell more than once
         unsigned int i = cellcount;
@@ -336,6 +604,7 @@ void ChangeNode::ChangeCells(bool undo)
             currlayer->algo->setcell(cellinfo[i].x, cellinfo[i].y, cellinfo[i].newstate);
             i++;
         }
+        if (newcells) RestoreRegion(newcells);
     }
     if (cellcount > 0) currlayer->algo->endofpattern();
 
@@ -344,11 +613,32 @@ void ChangeNode::ChangeCells(bool undo)
 
 // -----------------------------------------------------------------------------
 
+void ChangeNode::RestoreRegion(RegionCopy* region)
+{
+    lifealgo* cells = region->GetCells();
+    if (cells == NULL) return;
+    CopyAllRect(regtop, regleft, regbottom, regright, cells, currlayer->algo,
+                "Restoring cells");
+}
+
+// -----------------------------------------------------------------------------
+
+bool ChangeNode::FillCells(bool undo)
+{
+    if (!undo && oldsel.RandomFillRect(currlayer->algo, fillperc, fillseed))
+        return true;
+    // put back the old cells (also done if user aborted the fill)
+    RestoreRegion(oldcells);
+    return undo;
+}
+
+// -----------------------------------------------------------------------------
+
 bool ChangeNode::DoChange(bool undo)
 {
     switch (changeid) {
         case cellstates:
-            if (cellcount > 0) ChangeCells(undo);
+            if (cellcount > 0 || oldcells) ChangeCells(undo);
             break;
 
         case fliptb:
@@ -363,9 +653,13 @@ bool ChangeNode::DoChange(bool undo)
             if (!RotateSelection(changeid == rotatepattcw ? !undo : undo, true)) return false;
             break;
 
+        case randfill:
+            if (!FillCells(undo)) return false;
+            break;
+
         case rotatecw:
         case rotateacw:
-            if (cellcount > 0) ChangeCells(undo);
+            if (cellcount > 0 || oldcells) ChangeCells(undo);
             // rotate selection edges
             if (undo) {
                 currlayer->currsel = oldsel;
@@ -489,6 +783,8 @@ UndoRedo::UndoRedo()
     maxchanges = 0;               // ditto
     badalloc = false;             // true if malloc/realloc fails
     cellarray = NULL;             // play safe
+    oldregion = NULL;             // no region change is pending
+    newregion = NULL;             // ditto
     savecellchanges = false;      // no script cell changes are pending
     savegenchanges = false;       // no script gen changes are pending
     doingscriptchanges = false;   // not undoing/redoing script changes
@@ -575,14 +871,20 @@ void UndoRedo::ForgetCellChanges()
         maxchanges = 0;      // ditto
         badalloc = false;
     }
+    if (oldregion) {
+        delete oldregion;
+        if (newregion) delete newregion;
+        oldregion = NULL;
+        newregion = NULL;
+    }
 }
 
 // -----------------------------------------------------------------------------
 
 bool UndoRedo::RememberCellChanges(const char* action, bool olddirty)
 {
-    if (numchanges > 0) {
-        if (numchanges < maxchanges) {
+    if (numchanges > 0 || oldregion) {
+        if (numchanges > 0 && numchanges < maxchanges) {
             // reduce size of cellarray
             cell_change* newptr =
             (cell_change*) realloc(cellarray, numchanges * sizeof(cell_change));
@@ -597,8 +899,11 @@ bool UndoRedo::RememberCellChanges(const char* action, bool olddirty)
         ChangeNode* change = new ChangeNode(cellstates);
         if (change == NULL) Fatal("Failed to create cellstates node!");
 
-        change->cellinfo = cellarray;
-        change->cellcount = numchanges;
+        if (numchanges > 0) {
+            change->cellinfo = cellarray;
+            change->cellcount = numchanges;
+        }
+        TakeRegionChange(change);
         change->olddirty = olddirty;
         change->newdirty = true;
 
@@ -618,6 +923,95 @@ bool UndoRedo::RememberCellChanges(const char* action, bool olddirty)
 
 // -----------------------------------------------------------------------------
 
+bool UndoRedo::UseRegionChange(int top, int left, int bottom, int right)
+{
+    // only one region can be saved per change
+    if (oldregion) return false;
+
+    // each region copy is a separate universe with its own hash table and
+    // node blocks (about 50K bytes even when nearly empty), and a change saves
+    // two of them, so a region only pays off when the rectangle could hold
+    // more changed cells than that; algorithms that can copy whole subtrees
+    // only visit the part of the pattern inside the rectangle, so for them
+    // a region is worth it sooner than for algorithms that copy cell by cell
+    double cells = (double)(bottom - top + 1) * (double)(right - left + 1);
+    if (currlayer->algo->rectCapable()) return cells >= 16384.0;
+    return cells >= 65536.0;
+}
+
+// -----------------------------------------------------------------------------
+
+static lifealgo* CopyRegion(lifealgo* srcalgo, algo_type algotype,
+                            int top, int left, int bottom, int right)
+{
+    // return a new universe containing the cells in the given rectangle of
+    // srcalgo (or an empty universe if srcalgo is NULL); return NULL if
+    // the user aborted a lengthy copy
+    lifealgo* region = CreateNewUniverse(algotype);
+    if (region->setrule(srcalgo ? srcalgo->getrule() : currlayer->algo->getrule()))
+        region->setrule(region->DefaultRule());
+    if ( srcalgo && !CopyRect(top, left, bottom, right, srcalgo, region, false,
+                              "Saving cell changes") ) {
+        delete region;
+        return NULL;
+    }
+    return region;
+}
+
+// -----------------------------------------------------------------------------
+
+bool UndoRedo::SaveRegionChange(lifealgo* oldalgo, lifealgo* newalgo,
+                                int top, int left, int bottom, int right)
+{
+    oldregion = CopyRegion(oldalgo, currlayer->algtype, top, left, bottom, right);
+    if (oldregion == NULL) return false;
+    if (newalgo) {
+        newregion = CopyRegion(newalgo, currlayer->algtype, top, left, bottom, right);
+        if (newregion == NULL) {
+            delete oldregion;
+            oldregion = NULL;
+            return false;
+        }
+    }
+    regiontop = top;
+    regionleft = left;
+    regionbottom = bottom;
+    regionright = right;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void UndoRedo::TakeRegionChange(ChangeNode* change)
+{
+    if (oldregion == NULL) return;
+
+    if (newregion == NULL) {
+        // copy the changed rectangle from the current universe
+        newregion = CopyRegion(currlayer->algo, currlayer->algtype,
+                               regiontop, regionleft, regionbottom, regionright);
+        if (newregion == NULL) {
+            // user aborted the copy, so redo will leave the rectangle empty
+            newregion = CopyRegion(NULL, currlayer->algtype, 0, 0, 0, 0);
+        }
+    }
+
+    change->oldcells = new RegionCopy(oldregion, currlayer->algtype,
+                                      regiontop, regionleft, regionbottom, regionright);
+    change->newcells = new RegionCopy(newregion, currlayer->algtype,
+                                      regiontop, regionleft, regionbottom, regionright);
+    change->oldalgo = currlayer->algtype;
+    change->regtop = regiontop;
+    change->regleft = regionleft;
+    change->regbottom = regionbottom;
+    change->regright = regionright;
+
+    oldregion = NULL;
+    newregion = NULL;
+}
+
+// -----------------------------------------------------------------------------
+
 void UndoRedo::RememberFlip(bool topbot, bool olddirty)
 {
     ClearRedoHistory();
@@ -634,6 +1028,35 @@ void UndoRedo::RememberFlip(bool topbot, bool olddirty)
 
 // -----------------------------------------------------------------------------
 
+void UndoRedo::RememberRandomFill(Selection& sel, lifealgo* oldcells,
+                                  unsigned int seed, int percentage, bool olddirty)
+{
+    ClearRedoHistory();
+
+    // add randfill node to head of undo list
+    ChangeNode* change = new ChangeNode(randfill);
+    if (change == NULL) Fatal("Failed to create random fill node!");
+
+    change->oldsel = sel;
+    change->oldalgo = currlayer->algtype;
+    int x, y, wd, ht;
+    sel.GetRect(&x, &y, &wd, &ht);
+    change->regtop = y;
+    change->regleft = x;
+    change->regbottom = y + ht - 1;
+    change->regright = x + wd - 1;
+    change->oldcells = new RegionCopy(oldcells, currlayer->algtype, change->regtop,
+                                      change->regleft, change->regbottom, change->regright);
+    change->fillseed = seed;
+    change->fillperc = percentage;
+    change->olddirty = olddirty;
+    change->newdirty = true;
+
+    undolist.push_front(change);
+}
+
+// -----------------------------------------------------------------------------
+
 void UndoRedo::RememberRotation(bool clockwise, bool olddirty)
 {
     ClearRedoHistory();
@@ -664,6 +1087,8 @@ void UndoRedo::RememberRotation(bool clockwise, Selection& oldsel, Selection& ne
     change->olddirty = olddirty;
     change->newdirty = true;
 
+    TakeRegionChange(change);
+
     // if numchanges == 0 we still need to rotate selection edges
     if (numchanges > 0) {
         if (numchanges < maxchanges) {
@@ -772,6 +1197,9 @@ void UndoRedo::RememberGenStart()
         // save starting pattern in a unique temporary file
         prevfile = CreateTempFileName(genchange_prefix);
 
+        // the file won't be written if the algorithm can keep the pattern
+        if (KeepPattern(prevfile)) return;
+
         // if head of undo list is a genchange node then we can copy that
         // change node's newfile to prevfile; this makes consecutive generating
         // runs faster (setting prevfile to newfile would be even faster but it's
@@ -779,7 +1207,7 @@ void UndoRedo::RememberGenStart()
         if (!undolist.empty()) {
             std::list<ChangeNode*>::iterator node = undolist.begin();
             ChangeNode* change = *node;
-            if (change->changeid == genchange) {
+            if (change->changeid == genchange && FindKeptPattern(change->newfile) < 0) {
                 if (CopyFile(change->newfile, prevfile)) {
                     return;
                 } else {
@@ -812,8 +1240,9 @@ void UndoRedo::RememberGenFinish()
     // generation count might not have changed (can happen in Linux app and iOS Golly)
     if (prevgen == currlayer->algo->getGeneration()) {
         // delete prevfile created by RememberGenStart
-        if (!prevfile.empty() && FileExists(prevfile)) {
-            RemoveFile(prevfile);
+        if (!prevfile.empty()) {
+            ForgetKeptPattern(prevfile);
+            if (FileExists(prevfile)) RemoveFile(prevfile);
         }
         prevfile.clear();
         return;
@@ -826,7 +1255,7 @@ void UndoRedo::RememberGenFinish()
     } else {
         // save finishing pattern in a unique temporary file
         fpath = CreateTempFileName(genchange_prefix);
-        SaveCurrentPattern(fpath.c_str());
+        if (!KeepPattern(fpath)) SaveCurrentPattern(fpath.c_str());
     }
 
     ClearRedoHistory();
@@ -1324,8 +1753,9 @@ void UndoRedo::ClearUndoRedo()
 
     if (startcount > 0) {
         // RememberGenStart was not followed by RememberGenFinish
-        if (!prevfile.empty() && FileExists(prevfile)) {
-            RemoveFile(prevfile);
+        if (!prevfile.empty()) {
+            ForgetKeptPattern(prevfile);
+            if (FileExists(prevfile)) RemoveFile(prevfile);
         }
         prevfile.clear();
         startcount = 0;
@@ -1425,6 +1855,34 @@ bool CopyTempFiles(ChangeNode* srcnode, ChangeNode* destnode, const char* tempst
 
 // -----------------------------------------------------------------------------
 
+static bool CopyRegions(ChangeNode* srcnode, ChangeNode* destnode)
+{
+    // copy the universes holding a change's region (deep copy)
+    int t = srcnode->regtop;
+    int l = srcnode->regleft;
+    int b = srcnode->regbottom;
+    int r = srcnode->regright;
+    destnode->oldcells = NULL;
+    destnode->newcells = NULL;
+    if (srcnode->oldcells) {
+        lifealgo* srccells = srcnode->oldcells->GetCells();
+        if (srccells == NULL) return false;
+        lifealgo* cells = CopyRegion(srccells, srcnode->oldalgo, t, l, b, r);
+        if (cells == NULL) return false;
+        destnode->oldcells = new RegionCopy(cells, srcnode->oldalgo, t, l, b, r);
+    }
+    if (srcnode->newcells) {
+        lifealgo* srccells = srcnode->newcells->GetCells();
+        if (srccells == NULL) return false;
+        lifealgo* cells = CopyRegion(srccells, srcnode->oldalgo, t, l, b, r);
+        if (cells == NULL) return false;
+        destnode->newcells = new RegionCopy(cells, srcnode->oldalgo, t, l, b, r);
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
 void UndoRedo::DuplicateHistory(Layer* oldlayer, Layer* newlayer)
 {
     UndoRedo* history = oldlayer->undoredo;
@@ -1506,6 +1964,12 @@ void UndoRedo::DuplicateHistory(Layer* oldlayer, Layer* newlayer)
             newchange->startinfo = new StartingInfo(change->startinfo, oldlayer, newlayer);
         }
 
+        if (!CopyRegions(change, newchange)) {
+            Warning("Failed to copy cell changes in undolist!");
+            ClearUndoHistory();
+            return;
+        }
+
         // if node is a name change then update whichlayer
         if (newchange->changeid == namechange) {
             if (change->whichlayer == oldlayer) {
@@ -1557,6 +2021,12 @@ void UndoRedo::DuplicateHistory(Layer* oldlayer, Layer* newlayer)
             newchange->startinfo = new StartingInfo(change->startinfo, oldlayer, newlayer);
         }
 
+        if (!CopyRegions(change, newchange)) {
+            Warning("Failed to copy cell changes in redolist!");
+            ClearRedoHistory();
+            return;
+        }
+
         // if node is a name change then update whichlayer to point to new layer
         if (newchange->changeid == namechange) {
             if (change->whichlayer == oldlayer) {
@@ -54,7 +54,7 @@ void CopySelection();
 void ClearSelection();
 void ClearOutsideSelection();
 void ShrinkSelection(bool fit);
-void RandomFill();
+void RandomFill(bool useseed = false, unsigned int seed = 0);
 bool FlipSelection(bool topbottom, bool inundoredo = false);
 bool RotateSelection(bool clockwise, bool inundoredo = false);
 bool ClipboardContainsRule();
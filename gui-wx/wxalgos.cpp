@@ -13,6 +13,7 @@
 #include "qlifealgo.h"
 #include "hlifealgo.h"
 #include "generationsalgo.h"
+#include "qgenalgo.h"
 #include "ltlalgo.h"
 #include "jvnalgo.h"
 #include "superalgo.h"
@@ -726,6 +727,7 @@ void InitAlgorithms()
     
     // these algos can be in any order
     generationsalgo::doInitializeAlgoInfo(AlgoData::tick());
+    qgenalgo::doInitializeAlgoInfo(AlgoData::tick());
     ltlalgo::doInitializeAlgoInfo(AlgoData::tick());
     jvnalgo::doInitializeAlgoInfo(AlgoData::tick());
     superalgo::doInitializeAlgoInfo(AlgoData::tick());
@@ -90,7 +90,9 @@ bool MainFrame::SaveStartingPattern()
     currlayer->startfile = currlayer->tempstart;     // ResetPattern will load tempstart
 
     // save starting pattern in tempstart file
-    if ( currlayer->algo->hyperCapable() ) {
+    if ( KeepPattern(currlayer->tempstart) ) {
+        // no need to write the file unless the universe is deleted
+    } else if ( currlayer->algo->hyperCapable() ) {
         // much faster to save pattern in a macrocell file
         const char* err = WritePattern(currlayer->tempstart, MC_format,
                                        no_compression, 0, 0, 0, 0);
@@ -167,8 +169,10 @@ void MainFrame::ResetPattern(bool resetundo)
     // first restore algorithm
     currlayer->algtype = currlayer->startalgo;
     
-    // restore starting pattern
-    LoadPattern(currlayer->startfile, wxEmptyString);
+    // restore starting pattern (the algorithm might still have it in memory)
+    if (currlayer->algtype != oldalgo || !RestoreKeptPattern(currlayer->startfile)) {
+        LoadPattern(currlayer->startfile, wxEmptyString);
+    }
     
     if (currlayer->algo->getGeneration() != currlayer->startgen) {
         // LoadPattern failed to reset the gen count to startgen
@@ -246,9 +250,11 @@ void MainFrame::RestorePattern(bigint& gen, const wxString& filename,
         // restore starting pattern (false means don't call SyncUndoHistory)
         ResetPattern(false);
     } else {
-        // restore pattern in given filename;
+        // restore pattern in given filename (unless the algorithm kept it);
         // false means don't update status bar (algorithm should NOT change)
-        LoadPattern(filename, wxEmptyString, false);
+        if (!RestoreKeptPattern(filename)) {
+            LoadPattern(filename, wxEmptyString, false);
+        }
         
         if (currlayer->algo->getGeneration() != gen) {
             // best to clear the pattern and set the expected gen count
@@ -326,6 +332,7 @@ const char* MainFrame::ChangeGenCount(const char* genstring, bool inundoredo)
             return "Failed to copy pattern.";
         }
         // switch to new universe
+        SaveKeptPatterns();
         delete currlayer->algo;
         currlayer->algo = newalgo;
         SetGenIncrement();
@@ -607,6 +614,9 @@ bool MainFrame::StepPattern()
         if (curralgo->isrecording()) curralgo->extendtimeline();
     }
     
+    // don't let patterns kept for undo/reset pin too much memory
+    SpillKeptPatterns();
+    
     if (currlayer->autofit) viewptr->FitInView(0);
     
     if (!IsIconized()) DisplayPattern();
@@ -903,7 +913,7 @@ void MainFrame::OnGenTimer(wxTimerEvent& WXUNUSED(event))
     
     if (currlayer->algo->isrecording()) {
         if (showtimeline) UpdateTimelineBar();
-        if (currlayer->algo->getframecount() == MAX_FRAME_COUNT) {
+        if (currlayer->algo->istimelinefull()) {
             if (generating) {
                 // call StopGenerating() to stop gentimer
                 Stop();
@@ -911,9 +921,7 @@ void MainFrame::OnGenTimer(wxTimerEvent& WXUNUSED(event))
                 // StopGenerating() was called while in Yield()
                 FinishUp();
             }
-            wxString msg;
-            msg.Printf(_("No more frames can be recorded (maximum = %d)."), MAX_FRAME_COUNT);
-            Warning(msg);
+            Warning(_("No more frames can be recorded (not enough memory)."));
             in_timer = false;
             return;
         }
@@ -1576,6 +1584,7 @@ void MainFrame::ChangeAlgorithm(algo_type newalgotype, const wxString& newrule,
     }
     
     // delete old universe and point current universe to new universe
+    SaveKeptPatterns();
     delete currlayer->algo;
     currlayer->algo = newalgo;   
     SetGenIncrement();
@@ -118,6 +118,7 @@ void MainFrame::CreateUniverse()
     wxString oldrule = wxString(currlayer->algo->getrule(), wxConvLocal);
     
     // delete old universe and create new one of same type
+    SaveKeptPatterns();
     delete currlayer->algo;
     currlayer->algo = CreateNewUniverse(currlayer->algtype);
     
@@ -261,6 +262,7 @@ void MainFrame::LoadPattern(const wxString& path, const wxString& newtitle,
         if (inscript) stop_after_script = true;
         currlayer->savestart = false;
         currlayer->startfile = path;
+        ForgetKeptPattern(path);        // path might be tempstart
         currlayer->currfile = path;
         
         // reset step size now in case UpdateStatus is called below
@@ -297,6 +299,7 @@ void MainFrame::LoadPattern(const wxString& path, const wxString& newtitle,
     wxString oldrule = wxString(currlayer->algo->getrule(), wxConvLocal);
     
     // delete old universe and create new one of same type
+    SaveKeptPatterns();
     delete currlayer->algo;
     currlayer->algo = CreateNewUniverse(currlayer->algtype);
     
@@ -2910,6 +2910,9 @@ Layer::Layer()
             }
             
             // tempstart file must remain unique in duplicate layer
+            // (and any files the old universe is keeping in memory must
+            // be written so they can be copied by DuplicateHistory)
+            SaveKeptPatterns();
             if ( wxFileExists(currlayer->tempstart) ) {
                 if ( !wxCopyFile(currlayer->tempstart, tempstart, true) ) {
                     Warning(_("Could not copy tempstart file!"));
@@ -2964,6 +2967,7 @@ Layer::~Layer()
         delete undoredo;
         
         // delete tempstart file if it exists
+        ForgetKeptPattern(tempstart);
         if (wxFileExists(tempstart)) wxRemoveFile(tempstart);
         
         // delete any icons
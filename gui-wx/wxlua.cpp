@@ -135,6 +135,350 @@ static bool CheckBoolean(lua_State* L, int arg)
 
 // -----------------------------------------------------------------------------
 
+static bool LuaScriptAborted()
+{
+    // passed to GSF_* routines that can take a long time; if this returns true
+    // then the routine returns abortmsg which we pass to GollyError
+    if (allowcheck) wxGetApp().Poller()->checkevents();
+    return aborted && insideYield == 0;
+}
+
+// -----------------------------------------------------------------------------
+
+// A packed cell array is a userdata holding a GSF_cells struct (see wxscript.h).
+// It can be used wherever putcells, getcells, evolve, transform, join and store
+// expect a cell array, and # and [] work like they do for a table (but the ints
+// can't be changed).  Those commands return a packed array if given one.
+
+static const char* PACKED_CELLS = "golly.packedcells";     // metatable name
+
+static GSF_cells* NewPackedCells(lua_State* L)
+{
+    // push a new packed cell array with no ints
+    GSF_cells* cells = (GSF_cells*) lua_newuserdata(L, sizeof(GSF_cells));
+    GSF_initcells(*cells);
+    luaL_setmetatable(L, PACKED_CELLS);
+    return cells;
+}
+
+// -----------------------------------------------------------------------------
+
+static int packed_gc(lua_State* L)
+{
+    GSF_cells* cells = (GSF_cells*) luaL_checkudata(L, 1, PACKED_CELLS);
+    GSF_freecells(*cells);
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+
+static int packed_len(lua_State* L)
+{
+    GSF_cells* cells = (GSF_cells*) luaL_checkudata(L, 1, PACKED_CELLS);
+    lua_pushinteger(L, cells->numints);
+    return 1;
+}
+
+// -----------------------------------------------------------------------------
+
+static int packed_index(lua_State* L)
+{
+    GSF_cells* cells = (GSF_cells*) luaL_checkudata(L, 1, PACKED_CELLS);
+    lua_Integer i = luaL_checkinteger(L, 2);
+    if (i >= 1 && i <= cells->numints) {
+        lua_pushinteger(L, cells->ints[i-1]);
+    } else {
+        lua_pushnil(L);
+    }
+    return 1;
+}
+
+static const struct luaL_Reg packedfuncs [] = {
+    { "__gc",       packed_gc },
+    { "__len",      packed_len },
+    { "__index",    packed_index },
+    {NULL, NULL}
+};
+
+// -----------------------------------------------------------------------------
+
+static GSF_cells* CheckCells(lua_State* L, int arg, bool* packed = NULL)
+{
+    // return the ints in the given cell array; a table's ints are copied into
+    // a new packed array which is left on the stack (so call this after getting
+    // any optional args) and will be garbage collected
+    GSF_cells* cells = (GSF_cells*) luaL_testudata(L, arg, PACKED_CELLS);
+    if (packed) *packed = cells != NULL;
+    if (cells) return cells;
+    
+    luaL_checktype(L, arg, LUA_TTABLE);
+    int numints = luaL_len(L, arg);
+    cells = NewPackedCells(L);
+    if (!GSF_reservecells(*cells, numints)) {
+        GollyError(L, "Not enough memory for cell array.");
+    }
+    for (int i = 0; i < numints; i++) {
+        lua_rawgeti(L, arg, i+1); cells->ints[i] = lua_tointeger(L,-1); lua_pop(L,1);
+    }
+    cells->numints = numints;
+    return cells;
+}
+
+// -----------------------------------------------------------------------------
+
+static void PushCellTable(lua_State* L, GSF_cells* cells)
+{
+    // push a table with the same ints as the given packed cell array
+    lua_createtable(L, cells->numints, 0);
+    for (int i = 0; i < cells->numints; i++) {
+        lua_pushinteger(L, cells->ints[i]); lua_rawseti(L, -2, i+1);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// A pattern object is a userdata holding a GSF_pattern struct (see wxscript.h).
+// Patterns can't be changed; the operators and methods return new patterns:
+// P + Q (or), P * Q (and), P - Q (not), P ~ Q (xor), P:transform(x, y, ...)
+// and P:evolve(gens).  Bigint args can be integers or strings.
+
+static const char* PATTERN = "golly.pattern";     // metatable name
+
+static GSF_pattern* NewPattern(lua_State* L)
+{
+    // a pattern's userdata is tiny but the nodes it keeps alive may not be,
+    // so tell the collector how much the memory used by patterns has grown
+    static size_t patternmemory = 0;
+    size_t newmemory = GSF_patternmemory();
+    if (newmemory > patternmemory) lua_gc(L, LUA_GCSTEP, (int)((newmemory - patternmemory) >> 10));
+    patternmemory = newmemory;
+    
+    // push a new pattern object with no universe
+    GSF_pattern* pat = (GSF_pattern*) lua_newuserdata(L, sizeof(GSF_pattern));
+    pat->store = NULL;
+    luaL_setmetatable(L, PATTERN);
+    return pat;
+}
+
+// -----------------------------------------------------------------------------
+
+static GSF_pattern* CheckPattern(lua_State* L, int arg)
+{
+    GSF_pattern* pat = (GSF_pattern*) luaL_checkudata(L, arg, PATTERN);
+    if (pat->store == NULL) GollyError(L, "pattern error: pattern was not created.");
+    return pat;
+}
+
+// -----------------------------------------------------------------------------
+
+static bigint CheckBigint(lua_State* L, int arg)
+{
+    // a bigint arg can be an integer or a string (see GSF_bigint)
+    if (lua_type(L, arg) == LUA_TNUMBER) return bigint((G_INT64) luaL_checkinteger(L, arg));
+    bigint value;
+    const char* err = GSF_bigint(luaL_checkstring(L, arg), value);
+    if (err) GollyError(L, err);
+    return value;
+}
+
+// -----------------------------------------------------------------------------
+
+static int pattern_gc(lua_State* L)
+{
+    GSF_pattern* pat = (GSF_pattern*) luaL_checkudata(L, 1, PATTERN);
+    GSF_freepattern(*pat);
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+
+static int CombinePatterns(lua_State* L, const char* mode)
+{
+    AUTORELEASE_POOL
+    CheckEvents(L);
+    
+    GSF_pattern* pat1 = CheckPattern(L, 1);
+    GSF_pattern* pat2 = CheckPattern(L, 2);
+    GSF_pattern* result = NewPattern(L);
+    const char* err = GSF_copypattern(*pat1, *result);
+    if (!err) err = GSF_combinepattern(*result, *pat2, mode, LuaScriptAborted);
+    if (err) GollyError(L, err);
+    
+    return 1;   // result is a pattern
+}
+
+static int pattern_or(lua_State* L)  { return CombinePatterns(L, "or"); }
+static int pattern_and(lua_State* L) { return CombinePatterns(L, "and"); }
+static int pattern_not(lua_State* L) { return CombinePatterns(L, "not"); }
+static int pattern_xor(lua_State* L) { return CombinePatterns(L, "xor"); }
+
+// -----------------------------------------------------------------------------
+
+static int pattern_transform(lua_State* L)
+{
+    AUTORELEASE_POOL
+    CheckEvents(L);
+    
+    GSF_pattern* pat = CheckPattern(L, 1);
+    bigint x0 = CheckBigint(L, 2);
+    bigint y0 = CheckBigint(L, 3);
+    
+    // defaults for optional params
+    int axx = 1;
+    int axy = 0;
+    int ayx = 0;
+    int ayy = 1;
+    
+    if (lua_gettop(L) > 3) axx = luaL_checkinteger(L, 4);
+    if (lua_gettop(L) > 4) axy = luaL_checkinteger(L, 5);
+    if (lua_gettop(L) > 5) ayx = luaL_checkinteger(L, 6);
+    if (lua_gettop(L) > 6) ayy = luaL_checkinteger(L, 7);
+    
+    GSF_pattern* result = NewPattern(L);
+    const char* err = GSF_copypattern(*pat, *result);
+    if (!err) err = GSF_transformpattern(*result, x0, y0, axx, axy, ayx, ayy);
+    if (err) GollyError(L, err);
+    
+    return 1;   // result is a pattern
+}
+
+// -----------------------------------------------------------------------------
+
+static int pattern_evolve(lua_State* L)
+{
+    AUTORELEASE_POOL
+    CheckEvents(L);
+    
+    GSF_pattern* pat = CheckPattern(L, 1);
+    bigint ngens = CheckBigint(L, 2);
+    
+    GSF_pattern* result = NewPattern(L);
+    const char* err = GSF_copypattern(*pat, *result);
+    if (!err) err = GSF_evolvepattern(*result, ngens, LuaScriptAborted);
+    if (err) GollyError(L, err);
+    
+    return 1;   // result is a pattern
+}
+
+// -----------------------------------------------------------------------------
+
+static int pattern_put(lua_State* L)
+{
+    AUTORELEASE_POOL
+    CheckEvents(L);
+    
+    GSF_pattern* pat = CheckPattern(L, 1);
+    
+    // defaults for optional params
+    bigint x0 = bigint::zero;
+    bigint y0 = bigint::zero;
+    const char* mode = "or";
+    
+    if (lua_gettop(L) > 1) x0 = CheckBigint(L, 2);
+    if (lua_gettop(L) > 2) y0 = CheckBigint(L, 3);
+    if (lua_gettop(L) > 3) mode = luaL_checkstring(L, 4);
+    
+    const char* err = GSF_putpattern(*pat, x0, y0, mode, LuaScriptAborted);
+    if (err) GollyError(L, err);
+    
+    return 0;   // no result
+}
+
+// -----------------------------------------------------------------------------
+
+static int pattern_getpop(lua_State* L)
+{
+    AUTORELEASE_POOL
+    CheckEvents(L);
+    
+    GSF_pattern* pat = CheckPattern(L, 1);
+    
+    char sepchar = '\0';
+    if (lua_gettop(L) > 1) {
+        const char* s = luaL_checkstring(L, 2);
+        sepchar = s[0];
+    }
+    
+    lua_pushstring(L, GSF_patternalgo(*pat)->getPopulation().tostring(sepchar));
+    
+    return 1;   // result is a string
+}
+
+// -----------------------------------------------------------------------------
+
+static int pattern_getrect(lua_State* L)
+{
+    AUTORELEASE_POOL
+    CheckEvents(L);
+    
+    GSF_pattern* pat = CheckPattern(L, 1);
+    
+    lua_newtable(L);
+    
+    lifealgo* algo = GSF_patternalgo(*pat);
+    if (!algo->isEmpty()) {
+        bigint top, left, bottom, right;
+        algo->findedges(&top, &left, &bottom, &right);
+        if (viewptr->OutsideLimits(top, left, bottom, right)) {
+            GollyError(L, "getrect error: pattern is too big.");
+        }
+        
+        int x = left.toint();
+        int y = top.toint();
+        int wd = right.toint() - x + 1;
+        int ht = bottom.toint() - y + 1;
+        
+        lua_pushinteger(L, x);  lua_rawseti(L, -2, 1);
+        lua_pushinteger(L, y);  lua_rawseti(L, -2, 2);
+        lua_pushinteger(L, wd); lua_rawseti(L, -2, 3);
+        lua_pushinteger(L, ht); lua_rawseti(L, -2, 4);
+    }
+    
+    return 1;   // result is a table (empty or with 4 ints)
+}
+
+// -----------------------------------------------------------------------------
+
+static int pattern_getcells(lua_State* L)
+{
+    AUTORELEASE_POOL
+    CheckEvents(L);
+    
+    GSF_pattern* pat = CheckPattern(L, 1);
+    
+    // optional param says whether to return a packed cell array
+    bool packed = false;
+    if (lua_gettop(L) > 1) packed = CheckBoolean(L, 2);
+    
+    GSF_cells* cells = NewPackedCells(L);
+    const char* err = GSF_extractcells(GSF_patternalgo(*pat), false, *cells, LuaScriptAborted);
+    if (err) GollyError(L, err);
+    if (!packed) PushCellTable(L, cells);
+    
+    return 1;   // result is a cell array
+}
+
+static const struct luaL_Reg patternfuncs [] = {
+    { "__gc",       pattern_gc },
+    { "__add",      pattern_or },
+    { "__mul",      pattern_and },
+    { "__sub",      pattern_not },
+    { "__bxor",     pattern_xor },
+    {NULL, NULL}
+};
+
+static const struct luaL_Reg patternmethods [] = {
+    { "transform",  pattern_transform },
+    { "evolve",     pattern_evolve },
+    { "put",        pattern_put },
+    { "getpop",     pattern_getpop },
+    { "getrect",    pattern_getrect },
+    { "getcells",   pattern_getcells },
+    {NULL, NULL}
+};
+
+// -----------------------------------------------------------------------------
+
 static int g_open(lua_State* L)
 {
     AUTORELEASE_POOL
@@ -258,50 +602,10 @@ static int g_savedialog(lua_State* L)
 static const char* ExtractCellArray(lua_State* L, lifealgo* universe, bool shift = false)
 {
     // extract cell array from given universe
-    lua_newtable(L);
-    if ( !universe->isEmpty() ) {
-        bigint top, left, bottom, right;
-        universe->findedges(&top, &left, &bottom, &right);
-        if ( viewptr->OutsideLimits(top, left, bottom, right) ) {
-            return "Universe is too big to extract all cells!";
-        }
-        bool multistate = universe->NumCellStates() > 2;
-        int itop = top.toint();
-        int ileft = left.toint();
-        int ibottom = bottom.toint();
-        int iright = right.toint();
-        int cx, cy;
-        int v = 0;
-        int arraylen = 0;
-        for ( cy=itop; cy<=ibottom; cy++ ) {
-            for ( cx=ileft; cx<=iright; cx++ ) {
-                int skip = universe->nextcell(cx, cy, v);
-                if (skip >= 0) {
-                    // found next live cell in this row
-                    cx += skip;
-                    if (shift) {
-                        // shift cells so that top left cell of bounding box is at 0,0
-                        lua_pushinteger(L, cx - ileft); lua_rawseti(L, -2, ++arraylen);
-                        lua_pushinteger(L, cy - itop ); lua_rawseti(L, -2, ++arraylen);
-                    } else {
-                        lua_pushinteger(L, cx); lua_rawseti(L, -2, ++arraylen);
-                        lua_pushinteger(L, cy); lua_rawseti(L, -2, ++arraylen);
-                    }
-                    if (multistate) {
-                        lua_pushinteger(L, v); lua_rawseti(L, -2, ++arraylen);
-                    }
-                } else {
-                    cx = iright;  // done this row
-                }
-            }
-        }
-        if (multistate && arraylen > 0 && (arraylen & 1) == 0) {
-            // add padding zero so the cell array has an odd number of ints
-            // (this is how we distinguish multi-state arrays from one-state arrays;
-            // the latter always have an even number of ints)
-            lua_pushinteger(L, 0); lua_rawseti(L, -2, ++arraylen);
-        }
-    }
+    GSF_cells* cells = NewPackedCells(L);
+    const char* err = GSF_extractcells(universe, shift, *cells, NULL);
+    if (err) return err;
+    PushCellTable(L, cells);
     return NULL;
 }
 
@@ -353,11 +657,11 @@ static int g_store(lua_State* L)
     AUTORELEASE_POOL
     CheckEvents(L);
     
-    luaL_checktype(L, 1, LUA_TTABLE);   // cell array
-    int len = luaL_len(L, 1);
-    
     const char* filename = luaL_checkstring(L, 2);
     
+    GSF_cells* cells = CheckCells(L, 1);
+    int len = cells->numints;
+    
     // create temporary universe of same type as current universe
     lifealgo* tempalgo = CreateNewUniverse(currlayer->algtype, false);
     const char* err = tempalgo->setrule(currlayer->algo->getrule());
@@ -373,9 +677,9 @@ static int g_store(lua_State* L)
     int ints_per_cell = multistate ? 3 : 2;
     int num_cells = len / ints_per_cell;
     for (int n = 0; n < num_cells; n++) {
-        int item = ints_per_cell * n;
-        lua_rawgeti(L, 1, item+1); int x = lua_tointeger(L,-1); lua_pop(L,1);
-        lua_rawgeti(L, 1, item+2); int y = lua_tointeger(L,-1); lua_pop(L,1);
+        const int* cell = cells->ints + ints_per_cell * n;
+        int x = cell[0];
+        int y = cell[1];
         
         // check if x,y is outside bounded grid
         err = GSF_checkpos(tempalgo, x, y);
@@ -385,8 +689,7 @@ static int g_store(lua_State* L)
         }
         
         if (multistate) {
-            lua_rawgeti(L, 1, item+3); int state = lua_tointeger(L,-1); lua_pop(L,1);
-            if (tempalgo->setcell(x, y, state) < 0) {
+            if (tempalgo->setcell(x, y, cell[2]) < 0) {
                 tempalgo->endofpattern();
                 delete tempalgo;
                 GollyError(L, "store error: state value is out of range.");
@@ -626,6 +929,9 @@ static int g_randfill(lua_State* L)
     CheckEvents(L);
     
     int perc = luaL_checkinteger(L, 1);
+    bool useseed = lua_gettop(L) > 1;
+    unsigned int seed = 0;
+    if (useseed) seed = (unsigned int)luaL_checkinteger(L, 2);
 
     if (perc < 1 || perc > 100) {
         GollyError(L, "randfill error: percentage must be from 1 to 100.");
@@ -634,7 +940,7 @@ static int g_randfill(lua_State* L)
     if (viewptr->SelectionExists()) {
         int oldperc = randomfill;
         randomfill = perc;
-        viewptr->RandomFill();
+        viewptr->RandomFill(useseed, seed);
         randomfill = oldperc;
         DoAutoUpdate();
     } else {
@@ -804,8 +1110,6 @@ static int g_transform(lua_State* L)
     AUTORELEASE_POOL
     CheckEvents(L);
 
-    luaL_checktype(L, 1, LUA_TTABLE);   // cell array
-
     int x0 = luaL_checkinteger(L, 2);
     int y0 = luaL_checkinteger(L, 3);
     
@@ -820,115 +1124,67 @@ static int g_transform(lua_State* L)
     if (lua_gettop(L) > 5) ayx = luaL_checkinteger(L, 6);
     if (lua_gettop(L) > 6) ayy = luaL_checkinteger(L, 7);
 
-    lua_newtable(L);
-    int arraylen = 0;
-
-    bool multistate = (luaL_len(L, 1) & 1) == 1;
-    int ints_per_cell = multistate ? 3 : 2;
-    int num_cells = luaL_len(L, 1) / ints_per_cell;
-    for (int n = 0; n < num_cells; n++) {
-        int item = ints_per_cell * n;
-        lua_rawgeti(L, 1, item+1); int x = lua_tointeger(L,-1); lua_pop(L,1);
-        lua_rawgeti(L, 1, item+2); int y = lua_tointeger(L,-1); lua_pop(L,1);
-        
-        lua_pushinteger(L, x0 + x * axx + y * axy); lua_rawseti(L, -2, ++arraylen);
-        lua_pushinteger(L, y0 + x * ayx + y * ayy); lua_rawseti(L, -2, ++arraylen);
-        if (multistate) {
-            lua_rawgeti(L, 1, item+3); int state = lua_tointeger(L,-1); lua_pop(L,1);
-            lua_pushinteger(L, state); lua_rawseti(L, -2, ++arraylen);
-        }
-    }
-    if (multistate && arraylen > 0 && (arraylen & 1) == 0) {
-        // add padding zero
-        lua_pushinteger(L, 0); lua_rawseti(L, -2, ++arraylen);
-    }
+    bool packed;
+    GSF_cells* incells = CheckCells(L, 1, &packed);
+    GSF_cells* outcells = NewPackedCells(L);
+    const char* err = GSF_transform(incells->ints, incells->numints,
+                                    x0, y0, axx, axy, ayx, ayy, *outcells);
+    if (err) GollyError(L, err);
+    if (!packed) PushCellTable(L, outcells);
     
     return 1;   // result is a cell array
 }
 
 // -----------------------------------------------------------------------------
 
+static void EvolveCells(lua_State* L, int arg, int ngens)
+{
+    // push the result of evolving the cell array at the given stack index
+    bool packed;
+    GSF_cells* incells = CheckCells(L, arg, &packed);
+    GSF_cells* outcells = NewPackedCells(L);
+    const char* err = GSF_evolve(incells->ints, incells->numints, ngens, false,
+                                 *outcells, LuaScriptAborted);
+    if (err) GollyError(L, err);
+    if (!packed) PushCellTable(L, outcells);
+}
+
+// -----------------------------------------------------------------------------
+
 static int g_evolve(lua_State* L)
 {
     AUTORELEASE_POOL
     CheckEvents(L);
     
-    luaL_checktype(L, 1, LUA_TTABLE);   // cell array
-    
     int ngens = luaL_checkinteger(L, 2);
-    if (ngens < 0) {
-        GollyError(L, "evolve error: number of generations is negative.");
-    }
     
-    // create a temporary universe of same type as current universe
-    lifealgo* tempalgo = CreateNewUniverse(currlayer->algtype, false);
-    const char* err = tempalgo->setrule(currlayer->algo->getrule());
-    if (err) tempalgo->setrule(tempalgo->DefaultRule());
-    
-    // copy cell array into temporary universe
-    bool multistate = (luaL_len(L, 1) & 1) == 1;
-    int ints_per_cell = multistate ? 3 : 2;
-    int num_cells = luaL_len(L, 1) / ints_per_cell;
-    for (int n = 0; n < num_cells; n++) {
-        int item = ints_per_cell * n;
-        lua_rawgeti(L, 1, item+1); int x = lua_tointeger(L,-1); lua_pop(L,1);
-        lua_rawgeti(L, 1, item+2); int y = lua_tointeger(L,-1); lua_pop(L,1);
-        // check if x,y is outside bounded grid
-        err = GSF_checkpos(tempalgo, x, y);
-        if (err) {
-            delete tempalgo;
-            GollyError(L, err);
+    // if given a table of cell arrays then return a table with each one evolved
+    if (lua_istable(L, 1) && (lua_rawgeti(L, 1, 1) == LUA_TTABLE ||
+                              luaL_testudata(L, -1, PACKED_CELLS))) {
+        int numarrays = luaL_len(L, 1);
+        lua_createtable(L, numarrays, 0);
+        int results = lua_gettop(L);
+        for (int i = 1; i <= numarrays; i++) {
+            lua_rawgeti(L, 1, i);
+            EvolveCells(L, results + 1, ngens);
+            lua_rawseti(L, results, i);
+            lua_settop(L, results);
         }
-        if (multistate) {
-            lua_rawgeti(L, 1, item+3); int state = lua_tointeger(L,-1); lua_pop(L,1);
-            if (tempalgo->setcell(x, y, state) < 0) {
-                tempalgo->endofpattern();
-                delete tempalgo;
-                GollyError(L, "evolve error: state value is out of range.");
-            }
-        } else {
-            tempalgo->setcell(x, y, 1);
-        }
-    }
-    tempalgo->endofpattern();
-    
-    // advance pattern by ngens
-    mainptr->generating = true;
-    if (tempalgo->unbounded && (tempalgo->gridwd > 0 || tempalgo->gridht > 0)) {
-        // a bounded grid must use an increment of 1 so we can call
-        // CreateBorderCells and DeleteBorderCells around each step()
-        tempalgo->setIncrement(1);
-        while (ngens > 0) {
-            if (!tempalgo->CreateBorderCells()) break;
-            tempalgo->step();
-            if (!tempalgo->DeleteBorderCells()) break;
-            ngens--;
-        }
-    } else {
-        tempalgo->setIncrement(ngens);
-        tempalgo->step();
+        return 1;   // result is a table of cell arrays
     }
-    mainptr->generating = false;
     
-    // convert new pattern into a cell array    
-    err = ExtractCellArray(L, tempalgo);
-    delete tempalgo;
-    if (err) GollyError(L, err);
+    EvolveCells(L, 1, ngens);
     
     return 1;   // result is a cell array
 }
 
 // -----------------------------------------------------------------------------
 
-static const char* BAD_STATE = "putcells error: state value is out of range.";
-
 static int g_putcells(lua_State* L)
 {
     AUTORELEASE_POOL
     CheckEvents(L);
     
-    luaL_checktype(L, 1, LUA_TTABLE);   // cell array
-
     // defaults for optional params
     int x0  = 0;
     int y0  = 0;
@@ -936,10 +1192,6 @@ static int g_putcells(lua_State* L)
     int axy = 0;
     int ayx = 0;
     int ayy = 1;
-    // default for mode is 'or'; 'xor' mode is also supported;
-    // for a one-state array 'copy' mode currently has the same effect as 'or' mode
-    // because there is no bounding box to set dead cells, but a multi-state array can
-    // have dead cells so in that case 'copy' mode is not the same as 'or' mode
     const char* mode = "or";
     
     if (lua_gettop(L) > 1) x0 = luaL_checkinteger(L, 2);
@@ -949,140 +1201,10 @@ static int g_putcells(lua_State* L)
     if (lua_gettop(L) > 5) ayx = luaL_checkinteger(L, 6);
     if (lua_gettop(L) > 6) ayy = luaL_checkinteger(L, 7);
     if (lua_gettop(L) > 7) mode = luaL_checkstring(L, 8);
-        
-    wxString modestr = wxString(mode, LUA_ENC);
-    if ( !(   modestr.IsSameAs(wxT("or"), false)
-           || modestr.IsSameAs(wxT("xor"), false)
-           || modestr.IsSameAs(wxT("copy"), false)
-           || modestr.IsSameAs(wxT("and"), false)
-           || modestr.IsSameAs(wxT("not"), false)) ) {
-        GollyError(L, "putcells error: unknown mode.");
-    }
-    
-    // save cell changes if undo/redo is enabled and script isn't constructing a pattern
-    bool savecells = allowundo && !currlayer->stayclean;
-    // use ChangeCell below and combine all changes due to consecutive setcell/putcells
-    // if (savecells) SavePendingChanges();
-    
-    bool multistate = (luaL_len(L, 1) & 1) == 1;
-    int ints_per_cell = multistate ? 3 : 2;
-    int num_cells = luaL_len(L, 1) / ints_per_cell;
-    const char* err = NULL;
-    bool pattchanged = false;
-    lifealgo* curralgo = currlayer->algo;
-    
-    if (modestr.IsSameAs(wxT("copy"), false)) {
-        // TODO: find bounds of cell array and call ClearRect here (to be added to wxedit.cpp)
-    }
-    
-    if (modestr.IsSameAs(wxT("and"), false)) {
-        if (!curralgo->isEmpty()) {
-            int newstate = 1;
-            for (int n = 0; n < num_cells; n++) {
-                int item = ints_per_cell * n;
-                lua_rawgeti(L, 1, item+1); int x = lua_tointeger(L,-1); lua_pop(L,1);
-                lua_rawgeti(L, 1, item+2); int y = lua_tointeger(L,-1); lua_pop(L,1);
-                int newx = x0 + x * axx + y * axy;
-                int newy = y0 + x * ayx + y * ayy;
-                // check if newx,newy is outside bounded grid
-                err = GSF_checkpos(curralgo, newx, newy);
-                if (err) break;
-                int oldstate = curralgo->getcell(newx, newy);
-                if (multistate) {
-                    // multi-state arrays can contain dead cells so newstate might be 0
-                    lua_rawgeti(L, 1, item+3); newstate = lua_tointeger(L,-1); lua_pop(L,1);
-                }
-                if (newstate != oldstate && oldstate > 0) {
-                    curralgo->setcell(newx, newy, 0);
-                    if (savecells) ChangeCell(newx, newy, oldstate, 0);
-                    pattchanged = true;
-                }
-            }
-        }
-    } else if (modestr.IsSameAs(wxT("xor"), false)) {
-        // loop code is duplicated here to allow 'or' case to execute faster
-        int numstates = curralgo->NumCellStates();
-        for (int n = 0; n < num_cells; n++) {
-            int item = ints_per_cell * n;
-            lua_rawgeti(L, 1, item+1); int x = lua_tointeger(L,-1); lua_pop(L,1);
-            lua_rawgeti(L, 1, item+2); int y = lua_tointeger(L,-1); lua_pop(L,1);
-            int newx = x0 + x * axx + y * axy;
-            int newy = y0 + x * ayx + y * ayy;
-            // check if newx,newy is outside bounded grid
-            err = GSF_checkpos(curralgo, newx, newy);
-            if (err) break;
-            int oldstate = curralgo->getcell(newx, newy);
-            int newstate;
-            if (multistate) {
-                // multi-state arrays can contain dead cells so newstate might be 0
-                lua_rawgeti(L, 1, item+3); newstate = lua_tointeger(L,-1); lua_pop(L,1);
-                if (newstate == oldstate) {
-                    if (oldstate != 0) newstate = 0;
-                } else {
-                    newstate = newstate ^ oldstate;
-                    // if xor overflows then don't change current state
-                    if (newstate >= numstates) newstate = oldstate;
-                }
-                if (newstate != oldstate) {
-                    // paste (possibly transformed) cell into current universe
-                    if (curralgo->setcell(newx, newy, newstate) < 0) {
-                        err = BAD_STATE;
-                        break;
-                    }
-                    if (savecells) ChangeCell(newx, newy, oldstate, newstate);
-                    pattchanged = true;
-                }
-            } else {
-                // one-state arrays only contain live cells
-                newstate = 1 - oldstate;
-                // paste (possibly transformed) cell into current universe
-                if (curralgo->setcell(newx, newy, newstate) < 0) {
-                    err = BAD_STATE;
-                    break;
-                }
-                if (savecells) ChangeCell(newx, newy, oldstate, newstate);
-                pattchanged = true;
-            }
-        }
-    } else {
-        bool notmode = modestr.IsSameAs(wxT("not"), false);
-        bool ormode = modestr.IsSameAs(wxT("or"), false);
-        int newstate = notmode ? 0 : 1;
-        int maxstate = curralgo->NumCellStates() - 1;
-        for (int n = 0; n < num_cells; n++) {
-            int item = ints_per_cell * n;
-            lua_rawgeti(L, 1, item+1); int x = lua_tointeger(L,-1); lua_pop(L,1);
-            lua_rawgeti(L, 1, item+2); int y = lua_tointeger(L,-1); lua_pop(L,1);
-            int newx = x0 + x * axx + y * axy;
-            int newy = y0 + x * ayx + y * ayy;
-            // check if newx,newy is outside bounded grid
-            err = GSF_checkpos(curralgo, newx, newy);
-            if (err) break;
-            int oldstate = curralgo->getcell(newx, newy);
-            if (multistate) {
-                // multi-state arrays can contain dead cells so newstate might be 0
-                lua_rawgeti(L, 1, item+3); newstate = lua_tointeger(L,-1); lua_pop(L,1);
-                if (notmode) newstate = maxstate - newstate;
-                if (ormode && newstate == 0) newstate = oldstate;
-            }
-            if (newstate != oldstate) {
-                // paste (possibly transformed) cell into current universe
-                if (curralgo->setcell(newx, newy, newstate) < 0) {
-                    err = BAD_STATE;
-                    break;
-                }
-                if (savecells) ChangeCell(newx, newy, oldstate, newstate);
-                pattchanged = true;
-            }
-        }
-    }
-    
-    if (pattchanged) {
-        curralgo->endofpattern();
-        MarkLayerDirty();
-        DoAutoUpdate();
-    }
     
+    GSF_cells* cells = CheckCells(L, 1);
+    const char* err = GSF_putcells(cells->ints, cells->numints, x0, y0, axx, axy, ayx, ayy,
+                                   mode, LuaScriptAborted);
     if (err) GollyError(L, err);
     
     return 0;   // no result
@@ -1096,9 +1218,12 @@ static int g_getcells(lua_State* L)
     CheckEvents(L);
 
     luaL_checktype(L, 1, LUA_TTABLE);   // rect array with 0 or 4 ints
+    
+    // optional param says whether to return a packed cell array
+    bool packed = false;
+    if (lua_gettop(L) > 1) packed = CheckBoolean(L, 2);
 
-    lua_newtable(L);
-    int arraylen = 0;
+    GSF_cells* cells = NewPackedCells(L);
     
     int numints = luaL_len(L, 1);
     if (numints == 0) {
@@ -1112,37 +1237,12 @@ static int g_getcells(lua_State* L)
         const char* err = GSF_checkrect(ileft, itop, wd, ht);
         if (err) GollyError(L, err);
         
-        int iright = ileft + wd - 1;
-        int ibottom = itop + ht - 1;
-        int cx, cy;
-        int v = 0;
-        lifealgo* curralgo = currlayer->algo;
-        bool multistate = curralgo->NumCellStates() > 2;
-        for ( cy=itop; cy<=ibottom; cy++ ) {
-            for ( cx=ileft; cx<=iright; cx++ ) {
-                int skip = curralgo->nextcell(cx, cy, v);
-                if (skip >= 0) {
-                    // found next live cell in this row
-                    cx += skip;
-                    if (cx <= iright) {
-                        lua_pushinteger(L, cx); lua_rawseti(L, -2, ++arraylen);
-                        lua_pushinteger(L, cy); lua_rawseti(L, -2, ++arraylen);
-                        if (multistate) {
-                            lua_pushinteger(L, v); lua_rawseti(L, -2, ++arraylen);
-                        }
-                    }
-                } else {
-                    cx = iright;  // done this row
-                }
-            }
-        }
-        if (multistate && arraylen > 0 && (arraylen & 1) == 0) {
-            // add padding zero
-            lua_pushinteger(L, 0); lua_rawseti(L, -2, ++arraylen);
-        }
+        err = GSF_getcells(currlayer->algo, ileft, itop, wd, ht, false, *cells, LuaScriptAborted);
+        if (err) GollyError(L, err);
     } else {
         GollyError(L, "getcells error: array must be {} or {x,y,wd,ht}.");
     }
+    if (!packed) PushCellTable(L, cells);
     
     return 1;   // result is a cell array
 }
@@ -1225,62 +1325,94 @@ static int g_join(lua_State* L)
     AUTORELEASE_POOL
     CheckEvents(L);
 
-    luaL_checktype(L, 1, LUA_TTABLE);
-    luaL_checktype(L, 2, LUA_TTABLE);
+    bool packed1, packed2;
+    GSF_cells* cells1 = CheckCells(L, 1, &packed1);
+    GSF_cells* cells2 = CheckCells(L, 2, &packed2);
+    GSF_cells* outcells = NewPackedCells(L);
+    const char* err = GSF_join(cells1->ints, cells1->numints,
+                               cells2->ints, cells2->numints, *outcells);
+    if (err) GollyError(L, err);
+    if (!packed1 && !packed2) PushCellTable(L, outcells);
     
-    bool multi1 = (luaL_len(L, 1) & 1) == 1;
-    bool multi2 = (luaL_len(L, 2) & 1) == 1;
-    bool multiout = multi1 || multi2;
-    int ints_per_cell, num_cells;
-    int x, y, state;
+    return 1;   // result is a cell array
+}
+
+// -----------------------------------------------------------------------------
+
+static int g_packcells(lua_State* L)
+{
+    AUTORELEASE_POOL
+    CheckEvents(L);
     
-    lua_newtable(L);
-    int arraylen = 0;
+    bool packed;
+    CheckCells(L, 1, &packed);
+    if (packed) lua_pushvalue(L, 1);
+    
+    return 1;   // result is a packed cell array
+}
 
-    // append 1st array
-    ints_per_cell = multi1 ? 3 : 2;
-    num_cells = luaL_len(L, 1) / ints_per_cell;
-    for (int n = 0; n < num_cells; n++) {
-        int item = ints_per_cell * n;
-        lua_rawgeti(L, 1, item+1); x = lua_tointeger(L,-1); lua_pop(L,1);
-        lua_rawgeti(L, 1, item+2); y = lua_tointeger(L,-1); lua_pop(L,1);
-        if (multi1) {
-            lua_rawgeti(L, 1, item+3); state = lua_tointeger(L,-1); lua_pop(L,1);
-        } else {
-            state = 1;
-        }
-        lua_pushinteger(L, x); lua_rawseti(L, -2, ++arraylen);
-        lua_pushinteger(L, y); lua_rawseti(L, -2, ++arraylen);
-        if (multiout) {
-            lua_pushinteger(L, state); lua_rawseti(L, -2, ++arraylen);
-        }
-    }
+// -----------------------------------------------------------------------------
+
+static int g_unpackcells(lua_State* L)
+{
+    AUTORELEASE_POOL
+    CheckEvents(L);
     
-    // append 2nd array
-    ints_per_cell = multi2 ? 3 : 2;
-    num_cells = luaL_len(L, 2) / ints_per_cell;
-    for (int n = 0; n < num_cells; n++) {
-        int item = ints_per_cell * n;
-        lua_rawgeti(L, 2, item+1); x = lua_tointeger(L,-1); lua_pop(L,1);
-        lua_rawgeti(L, 2, item+2); y = lua_tointeger(L,-1); lua_pop(L,1);
-        if (multi2) {
-            lua_rawgeti(L, 2, item+3); state = lua_tointeger(L,-1); lua_pop(L,1);
-        } else {
-            state = 1;
-        }
-        lua_pushinteger(L, x); lua_rawseti(L, -2, ++arraylen);
-        lua_pushinteger(L, y); lua_rawseti(L, -2, ++arraylen);
-        if (multiout) {
-            lua_pushinteger(L, state); lua_rawseti(L, -2, ++arraylen);
+    GSF_cells* cells = (GSF_cells*) luaL_checkudata(L, 1, PACKED_CELLS);
+    PushCellTable(L, cells);
+    
+    return 1;   // result is a cell array
+}
+
+// -----------------------------------------------------------------------------
+
+static int g_pattern(lua_State* L)
+{
+    AUTORELEASE_POOL
+    CheckEvents(L);
+    
+    // optional param is a cell array
+    GSF_cells* cells = NULL;
+    if (lua_gettop(L) > 0) cells = CheckCells(L, 1);
+    
+    GSF_pattern* pat = NewPattern(L);
+    const char* err = GSF_newpattern(cells ? cells->ints : NULL, cells ? cells->numints : 0,
+                                     *pat, LuaScriptAborted);
+    if (err) GollyError(L, err);
+    
+    return 1;   // result is a pattern
+}
+
+// -----------------------------------------------------------------------------
+
+static int g_getpattern(lua_State* L)
+{
+    AUTORELEASE_POOL
+    CheckEvents(L);
+    
+    // optional param is a rect array with 0 or 4 ints
+    int x = 0, y = 0, wd = 0, ht = 0;
+    if (lua_gettop(L) > 0) {
+        luaL_checktype(L, 1, LUA_TTABLE);
+        int numints = luaL_len(L, 1);
+        if (numints == 4) {
+            lua_rawgeti(L, 1, 1); x  = luaL_checkinteger(L,-1); lua_pop(L,1);
+            lua_rawgeti(L, 1, 2); y  = luaL_checkinteger(L,-1); lua_pop(L,1);
+            lua_rawgeti(L, 1, 3); wd = luaL_checkinteger(L,-1); lua_pop(L,1);
+            lua_rawgeti(L, 1, 4); ht = luaL_checkinteger(L,-1); lua_pop(L,1);
+            
+            const char* err = GSF_checkrect(x, y, wd, ht);
+            if (err) GollyError(L, err);
+        } else if (numints != 0) {
+            GollyError(L, "getpattern error: array must be {} or {x,y,wd,ht}.");
         }
     }
     
-    if (multiout && arraylen > 0 && (arraylen & 1) == 0) {
-        // add padding zero
-        lua_pushinteger(L, 0); lua_rawseti(L, -2, ++arraylen);
-    }
+    GSF_pattern* pat = NewPattern(L);
+    const char* err = GSF_getpattern(x, y, wd, ht, *pat, LuaScriptAborted);
+    if (err) GollyError(L, err);
     
-    return 1;   // result is a cell array
+    return 1;   // result is a pattern
 }
 
 // -----------------------------------------------------------------------------
@@ -1313,6 +1445,28 @@ static int g_hash(lua_State* L)
 
 // -----------------------------------------------------------------------------
 
+static int g_oscar(lua_State* L)
+{
+    AUTORELEASE_POOL
+    CheckEvents(L);
+    
+    int maxgens = luaL_checkinteger(L, 1);
+    if (maxgens < 0) {
+        GollyError(L, "oscar error: number of gens must be >= 0.");
+    }
+    
+    int period, dx, dy;
+    GSF_oscar(maxgens, &period, &dx, &dy);
+    
+    lua_pushinteger(L, period);
+    lua_pushinteger(L, dx);
+    lua_pushinteger(L, dy);
+    
+    return 3;   // result is period, dx, dy
+}
+
+// -----------------------------------------------------------------------------
+
 static int g_getclip(lua_State* L)
 {
     AUTORELEASE_POOL
@@ -3059,7 +3213,12 @@ static const struct luaL_Reg gollyfuncs [] = {
     { "getcells",     g_getcells },     // return cell array in given rectangle
     // { "getcells2",     g_getcells2 },     // experimental version (needs more thought!!!)
     { "join",         g_join },         // return concatenation of given cell arrays
+    { "packcells",    g_packcells },    // return packed copy of given cell array
+    { "unpackcells",  g_unpackcells },  // return cell array with ints in given packed array
+    { "pattern",      g_pattern },      // return pattern object with cells in given cell array
+    { "getpattern",   g_getpattern },   // return pattern object with cells in given rectangle
     { "hash",         g_hash },         // return hash value for pattern in given rectangle
+    { "oscar",        g_oscar },        // run pattern until period is found and return period, dx, dy
     { "getclip",      g_getclip },      // return pattern in clipboard (as wd, ht, cell array)
     { "select",       g_select },       // select {x, y, wd, ht} rectangle or remove if {}
     { "getrect",      g_getrect },      // return pattern rectangle as {} or {x, y, wd, ht}
@@ -3151,6 +3310,18 @@ static const struct luaL_Reg gollyfuncs [] = {
 
 static int create_golly_table(lua_State* L)
 {
+    // create the metatable for packed cell arrays (if not done yet)
+    if (luaL_newmetatable(L, PACKED_CELLS)) luaL_setfuncs(L, packedfuncs, 0);
+    lua_pop(L, 1);
+    
+    // ditto for pattern objects, whose methods are found via __index
+    if (luaL_newmetatable(L, PATTERN)) {
+        luaL_setfuncs(L, patternfuncs, 0);
+        luaL_newlib(L, patternmethods);
+        lua_setfield(L, -2, "__index");
+    }
+    lua_pop(L, 1);
+    
     // create a table with our g_* functions and register them
     luaL_newlib(L, gollyfuncs);
     return 1;
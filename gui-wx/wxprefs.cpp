@@ -1489,6 +1489,11 @@ void SavePrefs()
     fprintf(f, "hyperspeed=%d\n", currlayer->hyperspeed ? 1 : 0);
     fprintf(f, "hash_info=%d\n", currlayer->showhashinfo ? 1 : 0);
     fprintf(f, "show_population=%d\n", showpopulation ? 1 : 0);
+    fprintf(f, "hash_load=%d (10..1600 percent)\n",
+            (int)(lifealgo::getMaxLoadFactor() * 100.0 + 0.5));
+    fprintf(f, "hash_gc=%d\n", lifealgo::getGCBeforeResize());
+    fprintf(f, "hash_adapt=%d\n", lifealgo::getAdaptiveLoad());
+    fprintf(f, "huge_pages=%d (0..2)\n", getbigallocmode());
 
     fputs("\n", f);
 
@@ -2085,6 +2090,23 @@ void GetPrefs()
         } else if (strcmp(keyword, "show_population") == 0) {
             showpopulation = value[0] == '1';
 
+        } else if (strcmp(keyword, "hash_load") == 0) {
+            int percent;
+            sscanf(value, "%d", &percent);
+            lifealgo::setMaxLoadFactor(percent / 100.0);
+
+        } else if (strcmp(keyword, "hash_gc") == 0) {
+            lifealgo::setGCBeforeResize(value[0] == '1' ? 1 : 0);
+
+        } else if (strcmp(keyword, "hash_adapt") == 0) {
+            lifealgo::setAdaptiveLoad(value[0] == '1' ? 1 : 0);
+
+        } else if (strcmp(keyword, "huge_pages") == 0) {
+            // only affects HashLife universes created from now on
+            int mode;
+            sscanf(value, "%d", &mode);
+            setbigallocmode(mode);
+
         } else if (strcmp(keyword, "max_hash_mem") == 0) {       // deprecated
             int maxmem;
             sscanf(value, "%d", &maxmem);
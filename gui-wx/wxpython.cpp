@@ -117,12 +117,27 @@ extern "C"
     PyObject*(*G_PyList_GetItem)(PyObject*, int) = NULL;
     int(*G_PyList_Append)(PyObject*, PyObject*) = NULL;
 
+    // bytes (used for packed cell lists)
+    PyTypeObject *G_PyBytes_Type = NULL;
+    char*(*G_PyBytes_AsString)(PyObject*) = NULL;
+    Py_ssize_t(*G_PyBytes_Size)(PyObject*) = NULL;
+    PyObject*(*G_PyBytes_FromStringAndSize)(const char*, Py_ssize_t) = NULL;
+
     // parsing arguments and building values
     int(*G_PyArg_ParseTuple)(PyObject*, char*, ...) = NULL;
     PyObject*(*G_Py_BuildValue)(const char*, ...) = NULL;
 
+    // capsules (used for pattern objects)
+    PyObject*(*G_PyCapsule_New)(void*, const char*, PyCapsule_Destructor) = NULL;
+    void*(*G_PyCapsule_GetPointer)(PyObject*, const char*) = NULL;
+    int(*G_PyCapsule_IsValid)(PyObject*, const char*) = NULL;
+    Py_ssize_t(*G_PyGC_Collect)(void) = NULL;
+
     // general objects
     PyObject*(*G_PyObject_GetAttrString)(PyObject*, const char*) = NULL;
+    int(*G_PyObject_IsInstance)(PyObject*, PyObject*) = NULL;
+    PyObject*(*G_PyObject_Str)(PyObject*) = NULL;
+    PyObject*(*G_PyUnicode_AsUTF8String)(PyObject*) = NULL;
 
     // Modules
     int(*G_PyImport_AppendInittab)(const char*, PyObject*(*)(void)) = NULL;
@@ -250,9 +265,20 @@ static bool LoadPythonLib()
         LOAD_PYTHON_SYMBOL(PyList_Append);
         LOAD_PYTHON_SYMBOL(PyList_GetItem);
         LOAD_PYTHON_SYMBOL(PyList_Size);
+        LOAD_PYTHON_SYMBOL(PyBytes_Type);
+        LOAD_PYTHON_SYMBOL(PyBytes_AsString);
+        LOAD_PYTHON_SYMBOL(PyBytes_Size);
+        LOAD_PYTHON_SYMBOL(PyBytes_FromStringAndSize);
         LOAD_PYTHON_SYMBOL(Py_BuildValue);
         LOAD_PYTHON_SYMBOL(PyArg_ParseTuple);
         LOAD_PYTHON_SYMBOL(PyObject_GetAttrString);
+        LOAD_PYTHON_SYMBOL(PyObject_IsInstance);
+        LOAD_PYTHON_SYMBOL(PyObject_Str);
+        LOAD_PYTHON_SYMBOL(PyUnicode_AsUTF8String);
+        LOAD_PYTHON_SYMBOL(PyCapsule_New);
+        LOAD_PYTHON_SYMBOL(PyCapsule_GetPointer);
+        LOAD_PYTHON_SYMBOL(PyCapsule_IsValid);
+        LOAD_PYTHON_SYMBOL(PyGC_Collect);
         LOAD_PYTHON_SYMBOL(PyImport_ImportModule);
         LOAD_PYTHON_SYMBOL(PyImport_AppendInittab);
         LOAD_PYTHON_SYMBOL(PyModule_Create2);
@@ -404,45 +430,151 @@ static void AddCellColor(PyObject* list, long s, long r, long g, long b)
 
 // -----------------------------------------------------------------------------
 
-static bool ExtractCellList(PyObject* list, lifealgo* universe, bool shift = false)
+// A packed cell list is a bytes object holding a cell list's ints in native
+// format (like a GSF_cells struct; see wxscript.h).  It can be used wherever
+// putcells, getcells, evolve, transform, join and store expect a cell list,
+// and those commands return a packed list if given one.
+
+static bool GetCellInts(PyObject* obj, GSF_cells& copy, const int*& ints, int& numints,
+                        bool* packed = NULL)
 {
-    // extract cell list from given universe
-    if ( !universe->isEmpty() ) {
-        bigint top, left, bottom, right;
-        universe->findedges(&top, &left, &bottom, &right);
-        if ( viewptr->OutsideLimits(top, left, bottom, right) ) {
-            G_PyErr_SetString(G_PyExc_RuntimeError, "Universe is too big to extract all cells!");
-            return false;
-        }
-        bool multistate = universe->NumCellStates() > 2;
-        int itop = top.toint();
-        int ileft = left.toint();
-        int ibottom = bottom.toint();
-        int iright = right.toint();
-        int cx, cy;
-        int v = 0;
-        int cntr = 0;
-        for ( cy=itop; cy<=ibottom; cy++ ) {
-            for ( cx=ileft; cx<=iright; cx++ ) {
-                int skip = universe->nextcell(cx, cy, v);
-                if (skip >= 0) {
-                    // found next live cell in this row
-                    cx += skip;
-                    if (shift) {
-                        // shift cells so that top left cell of bounding box is at 0,0
-                        AddTwoInts(list, cx - ileft, cy - itop);
-                    } else {
-                        AddTwoInts(list, cx, cy);
-                    }
-                    if (multistate) AddState(list, v);
-                } else {
-                    cx = iright;  // done this row
-                }
-                cntr++;
-                if ((cntr % 4096) == 0 && PythonScriptAborted()) return false;
-            }
-        }
-        if (multistate) AddPadding(list);
+    // get the ints in the given cell list; a packed list's ints are used in place
+    // but a list's ints are copied into the given cell array (which the caller
+    // must free); if this returns false then a Python exception has been set
+    if (G_PyObject_IsInstance(obj, (PyObject*)G_PyBytes_Type) == 1) {
+        if (packed) *packed = true;
+        ints = (const int*) G_PyBytes_AsString(obj);
+        numints = (int)(G_PyBytes_Size(obj) / sizeof(int));
+        return true;
+    }
+    if (packed) *packed = false;
+    if (G_PyObject_IsInstance(obj, (PyObject*)G_PyList_Type) != 1) {
+        G_PyErr_SetString(G_PyExc_RuntimeError, "cell list must be a list or a packed list.");
+        return false;
+    }
+    numints = G_PyList_Size(obj);
+    if (!GSF_reservecells(copy, numints)) {
+        G_PyErr_SetString(G_PyExc_RuntimeError, "Not enough memory for cell list.");
+        return false;
+    }
+    for (int i = 0; i < numints; i++) {
+        copy.ints[i] = G_PyLong_AsLong( G_PyList_GetItem(obj, i) );
+    }
+    copy.numints = numints;
+    ints = copy.ints;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* NewCellList(const GSF_cells& cells, bool packed)
+{
+    // return a new list (or packed list) with the given cell array's ints
+    if (packed) {
+        return G_PyBytes_FromStringAndSize((const char*)cells.ints, cells.numints * sizeof(int));
+    }
+    PyObject* list = G_PyList_New(0);
+    for (int i = 0; i < cells.numints; i++) {
+        PyObject* io = G_PyLong_FromLong(cells.ints[i]);
+        G_PyList_Append(list, io);
+        G_Py_DecRef(io);
+    }
+    return list;
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* CellsError(const char* err)
+{
+    // if err is abortmsg then PythonScriptAborted has already raised an exception
+    if (!G_PyErr_Occurred()) G_PyErr_SetString(G_PyExc_RuntimeError, err);
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* ExtractCellList(lifealgo* universe, bool shift = false)
+{
+    // return cell list with the cells in the given universe
+    GSF_cells cells;
+    GSF_initcells(cells);
+    const char* err = GSF_extractcells(universe, shift, cells, PythonScriptAborted);
+    PyObject* list = err ? CellsError(err) : NewCellList(cells, false);
+    GSF_freecells(cells);
+    return list;
+}
+
+// -----------------------------------------------------------------------------
+
+// A pattern object is a capsule holding a GSF_pattern struct (see wxscript.h).
+// The limited API can't define new types, so patterns are passed to the
+// pat* functions rather than having methods, and they can't be changed.
+// Bigint params can be ints or strings.
+
+static const char* PATTERN = "golly.pattern";     // capsule name
+
+static void FreePatternCapsule(PyObject* capsule)
+{
+    GSF_pattern* pat = (GSF_pattern*) G_PyCapsule_GetPointer(capsule, PATTERN);
+    if (pat) {
+        GSF_freepattern(*pat);
+        delete pat;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+static GSF_pattern* GetPattern(PyObject* obj)
+{
+    // if this returns NULL then a Python exception has been set
+    if (!G_PyCapsule_IsValid(obj, PATTERN)) {
+        G_PyErr_SetString(G_PyExc_RuntimeError, "arg must be a pattern.");
+        return NULL;
+    }
+    return (GSF_pattern*) G_PyCapsule_GetPointer(obj, PATTERN);
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* NewPatternObject(GSF_pattern* pat, const char* err)
+{
+    // return a capsule owning the given pattern, or raise err
+    if (err) {
+        GSF_freepattern(*pat);
+        delete pat;
+        return CellsError(err);
+    }
+    
+    // capsules are freed as soon as their last reference goes, but patterns
+    // caught in reference cycles wait for the cyclic collector, which knows
+    // nothing of the nodes they keep alive; so run it whenever the memory
+    // used by patterns has grown a lot since the last run
+    static size_t collected = 0;
+    size_t patternmemory = GSF_patternmemory();
+    if (patternmemory < collected) collected = patternmemory;
+    if (patternmemory > 2 * collected + (16 << 20)) {
+        G_PyGC_Collect();
+        collected = GSF_patternmemory();
+    }
+    return G_PyCapsule_New(pat, PATTERN, FreePatternCapsule);
+}
+
+// -----------------------------------------------------------------------------
+
+static bool GetBigint(PyObject* obj, bigint& value)
+{
+    // get an int of any size (or a string like "2^100"); if this returns
+    // false then a Python exception has been set
+    PyObject* str = G_PyObject_Str(obj);
+    if (str == NULL) return false;
+    PyObject* bytes = G_PyUnicode_AsUTF8String(str);
+    G_Py_DecRef(str);
+    if (bytes == NULL) return false;
+    const char* err = GSF_bigint(G_PyBytes_AsString(bytes), value);
+    G_Py_DecRef(bytes);
+    if (err) {
+        G_PyErr_SetString(G_PyExc_RuntimeError, err);
+        return false;
     }
     return true;
 }
@@ -599,13 +731,8 @@ static PyObject* py_load(PyObject* self, PyObject* args)
     
     // convert pattern into a cell list, shifting cell coords so that the
     // bounding box's top left cell is at 0,0
-    PyObject* outlist = G_PyList_New(0);
-    bool done = ExtractCellList(outlist, tempalgo, true);
+    PyObject* outlist = ExtractCellList(tempalgo, true);
     delete tempalgo;
-    if (!done) {
-        G_Py_DecRef(outlist);
-        return NULL;
-    }
     
     return outlist;
 }
@@ -621,9 +748,18 @@ static PyObject* py_store(PyObject* self, PyObject* args)
     const char* filename;
     const char* description = NULL; // ignored
     
-    if (!G_PyArg_ParseTuple(args, (char*)"O!s|s", G_PyList_Type, &inlist, &filename, &description))
+    if (!G_PyArg_ParseTuple(args, (char*)"Os|s", &inlist, &filename, &description))
         return NULL;
     
+    GSF_cells copy;
+    GSF_initcells(copy);
+    const int* ints;
+    int numints;
+    if (!GetCellInts(inlist, copy, ints, numints)) {
+        GSF_freecells(copy);
+        return NULL;
+    }
+    
     // create temporary universe of same type as current universe
     lifealgo* tempalgo = CreateNewUniverse(currlayer->algtype, allowcheck);
     const char* err = tempalgo->setrule(currlayer->algo->getrule());
@@ -635,32 +771,32 @@ static PyObject* py_store(PyObject* self, PyObject* args)
     }
     
     // copy cell list into temporary universe
-    bool multistate = (G_PyList_Size(inlist) & 1) == 1;
+    bool multistate = (numints & 1) == 1;
     int ints_per_cell = multistate ? 3 : 2;
-    int num_cells = G_PyList_Size(inlist) / ints_per_cell;
+    int num_cells = numints / ints_per_cell;
     for (int n = 0; n < num_cells; n++) {
-        int item = ints_per_cell * n;
-        long x = G_PyLong_AsLong( G_PyList_GetItem(inlist, item) );
-        long y = G_PyLong_AsLong( G_PyList_GetItem(inlist, item + 1) );
+        const int* cell = ints + ints_per_cell * n;
         // check if x,y is outside bounded grid
-        const char* err = GSF_checkpos(tempalgo, x, y);
-        if (err) { delete tempalgo; PYTHON_ERROR(err); }
+        const char* err = GSF_checkpos(tempalgo, cell[0], cell[1]);
+        if (err) { delete tempalgo; GSF_freecells(copy); PYTHON_ERROR(err); }
         if (multistate) {
-            long state = G_PyLong_AsLong( G_PyList_GetItem(inlist, item + 2) );
-            if (tempalgo->setcell(x, y, state) < 0) {
+            if (tempalgo->setcell(cell[0], cell[1], cell[2]) < 0) {
                 tempalgo->endofpattern();
                 delete tempalgo;
+                GSF_freecells(copy);
                 PYTHON_ERROR("store error: state value is out of range.");
             }
         } else {
-            tempalgo->setcell(x, y, 1);
+            tempalgo->setcell(cell[0], cell[1], 1);
         }
         if ((n % 4096) == 0 && PythonScriptAborted()) {
             tempalgo->endofpattern();
             delete tempalgo;
+            GSF_freecells(copy);
             return NULL;
         }
     }
+    GSF_freecells(copy);
     tempalgo->endofpattern();
     
     // write pattern to given file in RLE/XRLE format
@@ -871,8 +1007,9 @@ static PyObject* py_randfill(PyObject* self, PyObject* args)
     if (PythonScriptAborted()) return NULL;
     wxUnusedVar(self);
     int perc;
+    long long seed = -1;
     
-    if (!G_PyArg_ParseTuple(args, (char*)"i", &perc)) return NULL;
+    if (!G_PyArg_ParseTuple(args, (char*)"i|L", &perc, &seed)) return NULL;
     
     if (perc < 1 || perc > 100) {
         PYTHON_ERROR("randfill error: percentage must be from 1 to 100.");
@@ -881,7 +1018,7 @@ static PyObject* py_randfill(PyObject* self, PyObject* args)
     if (viewptr->SelectionExists()) {
         int oldperc = randomfill;
         randomfill = perc;
-        viewptr->RandomFill();
+        viewptr->RandomFill(seed >= 0, (unsigned int)seed);
         randomfill = oldperc;
         DoAutoUpdate();
     } else {
@@ -1052,37 +1189,50 @@ static PyObject* py_transform(PyObject* self, PyObject* args)
     long ayx = 0;
     long ayy = 1;
     
-    if (!G_PyArg_ParseTuple(args, (char*)"O!ll|llll",
-                          G_PyList_Type, &inlist, &x0, &y0, &axx, &axy, &ayx, &ayy))
+    if (!G_PyArg_ParseTuple(args, (char*)"Oll|llll",
+                          &inlist, &x0, &y0, &axx, &axy, &ayx, &ayy))
         return NULL;
     
-    PyObject* outlist = G_PyList_New(0);
-    
-    bool multistate = (G_PyList_Size(inlist) & 1) == 1;
-    int ints_per_cell = multistate ? 3 : 2;
-    int num_cells = G_PyList_Size(inlist) / ints_per_cell;
-    for (int n = 0; n < num_cells; n++) {
-        int item = ints_per_cell * n;
-        long x = G_PyLong_AsLong( G_PyList_GetItem(inlist, item) );
-        long y = G_PyLong_AsLong( G_PyList_GetItem(inlist, item + 1) );
-        AddTwoInts(outlist, x0 + x * axx + y * axy,
-                   y0 + x * ayx + y * ayy);
-        if (multistate) {
-            long state = G_PyLong_AsLong( G_PyList_GetItem(inlist, item + 2) );
-            AddState(outlist, state);
-        }
-        if ((n % 4096) == 0 && PythonScriptAborted()) {
-            G_Py_DecRef(outlist);
-            return NULL;
-        }
+    GSF_cells copy, cells;
+    GSF_initcells(copy);
+    GSF_initcells(cells);
+    const int* ints;
+    int numints;
+    bool packed;
+    PyObject* outlist = NULL;
+    if (GetCellInts(inlist, copy, ints, numints, &packed)) {
+        const char* err = GSF_transform(ints, numints, x0, y0, axx, axy, ayx, ayy, cells);
+        outlist = err ? CellsError(err) : NewCellList(cells, packed);
     }
-    if (multistate) AddPadding(outlist);
+    GSF_freecells(copy);
+    GSF_freecells(cells);
     
     return outlist;
 }
 
 // -----------------------------------------------------------------------------
 
+static PyObject* EvolveCellList(PyObject* inlist, int ngens)
+{
+    // return the result of evolving the given cell list
+    GSF_cells copy, cells;
+    GSF_initcells(copy);
+    GSF_initcells(cells);
+    const int* ints;
+    int numints;
+    bool packed;
+    PyObject* outlist = NULL;
+    if (GetCellInts(inlist, copy, ints, numints, &packed)) {
+        const char* err = GSF_evolve(ints, numints, ngens, allowcheck, cells, PythonScriptAborted);
+        outlist = err ? CellsError(err) : NewCellList(cells, packed);
+    }
+    GSF_freecells(copy);
+    GSF_freecells(cells);
+    return outlist;
+}
+
+// -----------------------------------------------------------------------------
+
 static PyObject* py_evolve(PyObject* self, PyObject* args)
 {
     AUTORELEASE_POOL
@@ -1091,85 +1241,33 @@ static PyObject* py_evolve(PyObject* self, PyObject* args)
     int ngens = 0;
     PyObject* inlist;
     
-    if (!G_PyArg_ParseTuple(args, (char*)"O!i", G_PyList_Type, &inlist, &ngens)) return NULL;
-    
-    if (ngens < 0) {
-        PYTHON_ERROR("evolve error: number of generations is negative.");
-    }
-    
-    // create a temporary universe of same type as current universe
-    lifealgo* tempalgo = CreateNewUniverse(currlayer->algtype, allowcheck);
-    const char* err = tempalgo->setrule(currlayer->algo->getrule());
-    if (err) tempalgo->setrule(tempalgo->DefaultRule());
-    
-    // copy cell list into temporary universe
-    bool multistate = (G_PyList_Size(inlist) & 1) == 1;
-    int ints_per_cell = multistate ? 3 : 2;
-    int num_cells = G_PyList_Size(inlist) / ints_per_cell;
-    for (int n = 0; n < num_cells; n++) {
-        int item = ints_per_cell * n;
-        long x = G_PyLong_AsLong( G_PyList_GetItem(inlist, item) );
-        long y = G_PyLong_AsLong( G_PyList_GetItem(inlist, item + 1) );
-        // check if x,y is outside bounded grid
-        const char* err = GSF_checkpos(tempalgo, x, y);
-        if (err) { delete tempalgo; PYTHON_ERROR(err); }
-        if (multistate) {
-            long state = G_PyLong_AsLong( G_PyList_GetItem(inlist, item + 2) );
-            if (tempalgo->setcell(x, y, state) < 0) {
-                tempalgo->endofpattern();
-                delete tempalgo;
-                PYTHON_ERROR("evolve error: state value is out of range.");
-            }
-        } else {
-            tempalgo->setcell(x, y, 1);
-        }
-        if ((n % 4096) == 0 && PythonScriptAborted()) {
-            tempalgo->endofpattern();
-            delete tempalgo;
-            return NULL;
-        }
-    }
-    tempalgo->endofpattern();
-    
-    // advance pattern by ngens
-    mainptr->generating = true;
-    if (tempalgo->unbounded && (tempalgo->gridwd > 0 || tempalgo->gridht > 0)) {
-        // a bounded grid must use an increment of 1 so we can call
-        // CreateBorderCells and DeleteBorderCells around each step()
-        tempalgo->setIncrement(1);
-        while (ngens > 0) {
-            if (PythonScriptAborted()) {
-                mainptr->generating = false;
-                delete tempalgo;
-                return NULL;
+    if (!G_PyArg_ParseTuple(args, (char*)"Oi", &inlist, &ngens)) return NULL;
+    
+    // if given a list of cell lists then return a list with each one evolved
+    if (G_PyObject_IsInstance(inlist, (PyObject*)G_PyList_Type) == 1 && G_PyList_Size(inlist) > 0) {
+        PyObject* first = G_PyList_GetItem(inlist, 0);
+        if (G_PyObject_IsInstance(first, (PyObject*)G_PyList_Type) == 1 ||
+            G_PyObject_IsInstance(first, (PyObject*)G_PyBytes_Type) == 1) {
+            int numlists = G_PyList_Size(inlist);
+            PyObject* outlists = G_PyList_New(0);
+            for (int i = 0; i < numlists; i++) {
+                PyObject* outlist = EvolveCellList(G_PyList_GetItem(inlist, i), ngens);
+                if (outlist == NULL) {
+                    G_Py_DecRef(outlists);
+                    return NULL;
+                }
+                G_PyList_Append(outlists, outlist);
+                G_Py_DecRef(outlist);
             }
-            if (!tempalgo->CreateBorderCells()) break;
-            tempalgo->step();
-            if (!tempalgo->DeleteBorderCells()) break;
-            ngens--;
+            return outlists;
         }
-    } else {
-        tempalgo->setIncrement(ngens);
-        tempalgo->step();
     }
-    mainptr->generating = false;
     
-    // convert new pattern into a new cell list
-    PyObject* outlist = G_PyList_New(0);
-    bool done = ExtractCellList(outlist, tempalgo);
-    delete tempalgo;
-    if (!done) {
-        G_Py_DecRef(outlist);
-        return NULL;
-    }
-    
-    return outlist;
+    return EvolveCellList(inlist, ngens);
 }
 
 // -----------------------------------------------------------------------------
 
-static const char* BAD_STATE = "putcells error: state value is out of range.";
-
 static PyObject* py_putcells(PyObject* self, PyObject* args)
 {
     AUTORELEASE_POOL
@@ -1184,167 +1282,24 @@ static PyObject* py_putcells(PyObject* self, PyObject* args)
     long axy = 0;
     long ayx = 0;
     long ayy = 1;
-    // default for mode is 'or'; 'xor' mode is also supported;
-    // for a one-state list 'copy' mode currently has the same effect as 'or' mode
-    // because there is no bounding box to set dead cells, but a multi-state list can
-    // have dead cells so in that case 'copy' mode is not the same as 'or' mode
     const char* mode = "or";
     
-    if (!G_PyArg_ParseTuple(args, (char*)"O!|lllllls", G_PyList_Type, &list,
+    if (!G_PyArg_ParseTuple(args, (char*)"O|lllllls", &list,
                           &x0, &y0, &axx, &axy, &ayx, &ayy, &mode))
         return NULL;
     
-    wxString modestr = wxString(mode, PY_ENC);
-    if ( !(  modestr.IsSameAs(wxT("or"), false)
-           || modestr.IsSameAs(wxT("xor"), false)
-           || modestr.IsSameAs(wxT("copy"), false)
-           || modestr.IsSameAs(wxT("and"), false)
-           || modestr.IsSameAs(wxT("not"), false)) ) {
-        PYTHON_ERROR("putcells error: unknown mode.");
-    }
-    
-    // save cell changes if undo/redo is enabled and script isn't constructing a pattern
-    bool savecells = allowundo && !currlayer->stayclean;
-    // use ChangeCell below and combine all changes due to consecutive setcell/putcells
-    // if (savecells) SavePendingChanges();
-    
-    bool multistate = (G_PyList_Size(list) & 1) == 1;
-    int ints_per_cell = multistate ? 3 : 2;
-    int num_cells = G_PyList_Size(list) / ints_per_cell;
-    bool abort = false;
-    const char* err = NULL;
-    bool pattchanged = false;
-    lifealgo* curralgo = currlayer->algo;
-    
-    if (modestr.IsSameAs(wxT("copy"), false)) {
-        // TODO: find bounds of cell list and call ClearRect here (to be added to wxedit.cpp)
-    }
-    
-    if (modestr.IsSameAs(wxT("and"), false)) {
-        if (!curralgo->isEmpty()) {
-            int newstate = 1;
-            for (int n = 0; n < num_cells; n++) {
-                int item = ints_per_cell * n;
-                long x = G_PyLong_AsLong( G_PyList_GetItem(list, item) );
-                long y = G_PyLong_AsLong( G_PyList_GetItem(list, item + 1) );
-                int newx = x0 + x * axx + y * axy;
-                int newy = y0 + x * ayx + y * ayy;
-                // check if newx,newy is outside bounded grid
-                err = GSF_checkpos(curralgo, newx, newy);
-                if (err) break;
-                int oldstate = curralgo->getcell(newx, newy);
-                if (multistate) {
-                    // multi-state lists can contain dead cells so newstate might be 0
-                    newstate = G_PyLong_AsLong( G_PyList_GetItem(list, item + 2) );
-                }
-                if (newstate != oldstate && oldstate > 0) {
-                    curralgo->setcell(newx, newy, 0);
-                    if (savecells) ChangeCell(newx, newy, oldstate, 0);
-                    pattchanged = true;
-                }
-                if ((n % 4096) == 0 && PythonScriptAborted()) {
-                    abort = true;
-                    break;
-                }
-            }
-        }
-    } else if (modestr.IsSameAs(wxT("xor"), false)) {
-        // loop code is duplicated here to allow 'or' case to execute faster
-        int numstates = curralgo->NumCellStates();
-        for (int n = 0; n < num_cells; n++) {
-            int item = ints_per_cell * n;
-            long x = G_PyLong_AsLong( G_PyList_GetItem(list, item) );
-            long y = G_PyLong_AsLong( G_PyList_GetItem(list, item + 1) );
-            int newx = x0 + x * axx + y * axy;
-            int newy = y0 + x * ayx + y * ayy;
-            // check if newx,newy is outside bounded grid
-            err = GSF_checkpos(curralgo, newx, newy);
-            if (err) break;
-            int oldstate = curralgo->getcell(newx, newy);
-            int newstate;
-            if (multistate) {
-                // multi-state lists can contain dead cells so newstate might be 0
-                newstate = G_PyLong_AsLong( G_PyList_GetItem(list, item + 2) );
-                if (newstate == oldstate) {
-                    if (oldstate != 0) newstate = 0;
-                } else {
-                    newstate = newstate ^ oldstate;
-                    // if xor overflows then don't change current state
-                    if (newstate >= numstates) newstate = oldstate;
-                }
-                if (newstate != oldstate) {
-                    // paste (possibly transformed) cell into current universe
-                    if (curralgo->setcell(newx, newy, newstate) < 0) {
-                        G_PyErr_SetString(G_PyExc_RuntimeError, BAD_STATE);
-                        abort = true;
-                        break;
-                    }
-                    if (savecells) ChangeCell(newx, newy, oldstate, newstate);
-                    pattchanged = true;
-                }
-            } else {
-                // one-state lists only contain live cells
-                newstate = 1 - oldstate;
-                // paste (possibly transformed) cell into current universe
-                if (curralgo->setcell(newx, newy, newstate) < 0) {
-                    G_PyErr_SetString(G_PyExc_RuntimeError, BAD_STATE);
-                    abort = true;
-                    break;
-                }
-                if (savecells) ChangeCell(newx, newy, oldstate, newstate);
-                pattchanged = true;
-            }
-            if ((n % 4096) == 0 && PythonScriptAborted()) {
-                abort = true;
-                break;
-            }
-        }
-    } else {
-        bool notmode = modestr.IsSameAs(wxT("not"), false);
-        bool ormode = modestr.IsSameAs(wxT("or"), false);
-        int newstate = notmode ? 0 : 1;
-        int maxstate = curralgo->NumCellStates() - 1;
-        for (int n = 0; n < num_cells; n++) {
-            int item = ints_per_cell * n;
-            long x = G_PyLong_AsLong( G_PyList_GetItem(list, item) );
-            long y = G_PyLong_AsLong( G_PyList_GetItem(list, item + 1) );
-            int newx = x0 + x * axx + y * axy;
-            int newy = y0 + x * ayx + y * ayy;
-            // check if newx,newy is outside bounded grid
-            err = GSF_checkpos(curralgo, newx, newy);
-            if (err) break;
-            int oldstate = curralgo->getcell(newx, newy);
-            if (multistate) {
-                // multi-state lists can contain dead cells so newstate might be 0
-                newstate = G_PyLong_AsLong( G_PyList_GetItem(list, item + 2) );
-                if (notmode) newstate = maxstate - newstate;
-                if (ormode && newstate == 0) newstate = oldstate;
-            }
-            if (newstate != oldstate) {
-                // paste (possibly transformed) cell into current universe
-                if (curralgo->setcell(newx, newy, newstate) < 0) {
-                    G_PyErr_SetString(G_PyExc_RuntimeError, BAD_STATE);
-                    abort = true;
-                    break;
-                }
-                if (savecells) ChangeCell(newx, newy, oldstate, newstate);
-                pattchanged = true;
-            }
-            if ((n % 4096) == 0 && PythonScriptAborted()) {
-                abort = true;
-                break;
-            }
-        }
-    }
-    
-    if (pattchanged) {
-        curralgo->endofpattern();
-        MarkLayerDirty();
-        DoAutoUpdate();
+    GSF_cells copy;
+    GSF_initcells(copy);
+    const int* ints;
+    int numints;
+    if (!GetCellInts(list, copy, ints, numints)) {
+        GSF_freecells(copy);
+        return NULL;
     }
-    
-    if (err) PYTHON_ERROR(err);
-    if (abort) return NULL;
+    const char* err = GSF_putcells(ints, numints, x0, y0, axx, axy, ayx, ayy, mode,
+                                   PythonScriptAborted);
+    GSF_freecells(copy);
+    if (err) return CellsError(err);
     
     G_Py_RETURN_NONE;
 }
@@ -1357,11 +1312,13 @@ static PyObject* py_getcells(PyObject* self, PyObject* args)
     if (PythonScriptAborted()) return NULL;
     wxUnusedVar(self);
     PyObject* rect_list;
+    int packed = 0;     // optional param says whether to return a packed cell list
     
-    if (!G_PyArg_ParseTuple(args, (char*)"O!", G_PyList_Type, &rect_list)) return NULL;
+    if (!G_PyArg_ParseTuple(args, (char*)"O!|i", G_PyList_Type, &rect_list, &packed)) return NULL;
     
     // convert pattern in given rect into a cell list
-    PyObject* outlist = G_PyList_New(0);
+    GSF_cells cells;
+    GSF_initcells(cells);
     
     int numitems = G_PyList_Size(rect_list);
     if (numitems == 0) {
@@ -1372,43 +1329,19 @@ static PyObject* py_getcells(PyObject* self, PyObject* args)
         int wd = G_PyLong_AsLong( G_PyList_GetItem(rect_list, 2) );
         int ht = G_PyLong_AsLong( G_PyList_GetItem(rect_list, 3) );
         const char* err = GSF_checkrect(ileft, itop, wd, ht);
+        if (err) PYTHON_ERROR(err);
+        err = GSF_getcells(currlayer->algo, ileft, itop, wd, ht, false, cells, PythonScriptAborted);
         if (err) {
-            G_Py_DecRef(outlist);
-            PYTHON_ERROR(err);
-        }
-        int iright = ileft + wd - 1;
-        int ibottom = itop + ht - 1;
-        int cx, cy;
-        int v = 0;
-        int cntr = 0;
-        lifealgo* curralgo = currlayer->algo;
-        bool multistate = curralgo->NumCellStates() > 2;
-        for ( cy=itop; cy<=ibottom; cy++ ) {
-            for ( cx=ileft; cx<=iright; cx++ ) {
-                int skip = curralgo->nextcell(cx, cy, v);
-                if (skip >= 0) {
-                    // found next live cell in this row
-                    cx += skip;
-                    if (cx <= iright) {
-                        AddTwoInts(outlist, cx, cy);
-                        if (multistate) AddState(outlist, v);
-                    }
-                } else {
-                    cx = iright;  // done this row
-                }
-                cntr++;
-                if ((cntr % 4096) == 0 && PythonScriptAborted()) {
-                    G_Py_DecRef(outlist);
-                    return NULL;
-                }
-            }
+            GSF_freecells(cells);
+            return CellsError(err);
         }
-        if (multistate) AddPadding(outlist);
     } else {
-        G_Py_DecRef(outlist);
         PYTHON_ERROR("getcells error: arg must be [] or [x,y,wd,ht].");
     }
     
+    PyObject* outlist = NewCellList(cells, packed != 0);
+    GSF_freecells(cells);
+    
     return outlist;
 }
 
@@ -1422,57 +1355,315 @@ static PyObject* py_join(PyObject* self, PyObject* args)
     PyObject* inlist1;
     PyObject* inlist2;
     
-    if (!G_PyArg_ParseTuple(args, (char*)"O!O!", G_PyList_Type, &inlist1, G_PyList_Type, &inlist2))
-        return NULL;
+    if (!G_PyArg_ParseTuple(args, (char*)"OO", &inlist1, &inlist2)) return NULL;
+    
+    GSF_cells copy1, copy2, cells;
+    GSF_initcells(copy1);
+    GSF_initcells(copy2);
+    GSF_initcells(cells);
+    const int* ints1;
+    const int* ints2;
+    int numints1, numints2;
+    bool packed1, packed2;
+    PyObject* outlist = NULL;
+    if (GetCellInts(inlist1, copy1, ints1, numints1, &packed1) &&
+        GetCellInts(inlist2, copy2, ints2, numints2, &packed2)) {
+        const char* err = GSF_join(ints1, numints1, ints2, numints2, cells);
+        outlist = err ? CellsError(err) : NewCellList(cells, packed1 || packed2);
+    }
+    GSF_freecells(copy1);
+    GSF_freecells(copy2);
+    GSF_freecells(cells);
     
-    bool multi1 = (G_PyList_Size(inlist1) & 1) == 1;
-    bool multi2 = (G_PyList_Size(inlist2) & 1) == 1;
-    bool multiout = multi1 || multi2;
-    int ints_per_cell, num_cells;
-    long x, y, state;
-    PyObject* outlist = G_PyList_New(0);
+    return outlist;
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* py_packcells(PyObject* self, PyObject* args)
+{
+    AUTORELEASE_POOL
+    if (PythonScriptAborted()) return NULL;
+    wxUnusedVar(self);
+    PyObject* inlist;
     
-    // append 1st list
-    ints_per_cell = multi1 ? 3 : 2;
-    num_cells = G_PyList_Size(inlist1) / ints_per_cell;
-    for (int n = 0; n < num_cells; n++) {
-        int item = ints_per_cell * n;
-        x = G_PyLong_AsLong( G_PyList_GetItem(inlist1, item) );
-        y = G_PyLong_AsLong( G_PyList_GetItem(inlist1, item + 1) );
-        if (multi1) {
-            state = G_PyLong_AsLong( G_PyList_GetItem(inlist1, item + 2) );
+    if (!G_PyArg_ParseTuple(args, (char*)"O", &inlist)) return NULL;
+    
+    GSF_cells copy;
+    GSF_initcells(copy);
+    const int* ints;
+    int numints;
+    bool packed;
+    PyObject* outlist = NULL;
+    if (GetCellInts(inlist, copy, ints, numints, &packed)) {
+        if (packed) {
+            // packed lists are immutable so just return the given list
+            G_Py_IncRef(inlist);
+            outlist = inlist;
         } else {
-            state = 1;
-        }
-        AddTwoInts(outlist, x, y);
-        if (multiout) AddState(outlist, state);
-        if ((n % 4096) == 0 && PythonScriptAborted()) {
-            G_Py_DecRef(outlist);
-            return NULL;
+            outlist = NewCellList(copy, true);
         }
     }
+    GSF_freecells(copy);
     
-    // append 2nd list
-    ints_per_cell = multi2 ? 3 : 2;
-    num_cells = G_PyList_Size(inlist2) / ints_per_cell;
-    for (int n = 0; n < num_cells; n++) {
-        int item = ints_per_cell * n;
-        x = G_PyLong_AsLong( G_PyList_GetItem(inlist2, item) );
-        y = G_PyLong_AsLong( G_PyList_GetItem(inlist2, item + 1) );
-        if (multi2) {
-            state = G_PyLong_AsLong( G_PyList_GetItem(inlist2, item + 2) );
-        } else {
-            state = 1;
-        }
-        AddTwoInts(outlist, x, y);
-        if (multiout) AddState(outlist, state);
-        if ((n % 4096) == 0 && PythonScriptAborted()) {
+    return outlist;
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* py_unpackcells(PyObject* self, PyObject* args)
+{
+    AUTORELEASE_POOL
+    if (PythonScriptAborted()) return NULL;
+    wxUnusedVar(self);
+    PyObject* inlist;
+    
+    if (!G_PyArg_ParseTuple(args, (char*)"O!", G_PyBytes_Type, &inlist)) return NULL;
+    
+    GSF_cells cells;
+    cells.ints = (int*) G_PyBytes_AsString(inlist);
+    cells.numints = (int)(G_PyBytes_Size(inlist) / sizeof(int));
+    cells.maxints = cells.numints;
+    
+    return NewCellList(cells, false);
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* py_makepattern(PyObject* self, PyObject* args)
+{
+    AUTORELEASE_POOL
+    if (PythonScriptAborted()) return NULL;
+    wxUnusedVar(self);
+    PyObject* inlist = NULL;    // optional param is a cell list
+    
+    if (!G_PyArg_ParseTuple(args, (char*)"|O", &inlist)) return NULL;
+    
+    GSF_cells copy;
+    GSF_initcells(copy);
+    const int* ints = NULL;
+    int numints = 0;
+    if (inlist && !GetCellInts(inlist, copy, ints, numints)) return NULL;
+    
+    GSF_pattern* pat = new GSF_pattern;
+    const char* err = GSF_newpattern(ints, numints, *pat, PythonScriptAborted);
+    GSF_freecells(copy);
+    
+    return NewPatternObject(pat, err);
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* py_getpattern(PyObject* self, PyObject* args)
+{
+    AUTORELEASE_POOL
+    if (PythonScriptAborted()) return NULL;
+    wxUnusedVar(self);
+    PyObject* rect_list = NULL;     // optional param is [] or [x,y,wd,ht]
+    
+    if (!G_PyArg_ParseTuple(args, (char*)"|O!", G_PyList_Type, &rect_list)) return NULL;
+    
+    int x = 0, y = 0, wd = 0, ht = 0;
+    int numitems = rect_list ? G_PyList_Size(rect_list) : 0;
+    if (numitems == 4) {
+        x = G_PyLong_AsLong( G_PyList_GetItem(rect_list, 0) );
+        y = G_PyLong_AsLong( G_PyList_GetItem(rect_list, 1) );
+        wd = G_PyLong_AsLong( G_PyList_GetItem(rect_list, 2) );
+        ht = G_PyLong_AsLong( G_PyList_GetItem(rect_list, 3) );
+        const char* err = GSF_checkrect(x, y, wd, ht);
+        if (err) PYTHON_ERROR(err);
+    } else if (numitems != 0) {
+        PYTHON_ERROR("getpattern error: arg must be [] or [x,y,wd,ht].");
+    }
+    
+    GSF_pattern* pat = new GSF_pattern;
+    const char* err = GSF_getpattern(x, y, wd, ht, *pat, PythonScriptAborted);
+    
+    return NewPatternObject(pat, err);
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* py_putpattern(PyObject* self, PyObject* args)
+{
+    AUTORELEASE_POOL
+    if (PythonScriptAborted()) return NULL;
+    wxUnusedVar(self);
+    PyObject* patobj;
+    PyObject* xobj = NULL;
+    PyObject* yobj = NULL;
+    const char* mode = "or";
+    
+    if (!G_PyArg_ParseTuple(args, (char*)"O|OOs", &patobj, &xobj, &yobj, &mode)) return NULL;
+    
+    GSF_pattern* pat = GetPattern(patobj);
+    if (pat == NULL) return NULL;
+    bigint x0 = bigint::zero;
+    bigint y0 = bigint::zero;
+    if (xobj && !GetBigint(xobj, x0)) return NULL;
+    if (yobj && !GetBigint(yobj, y0)) return NULL;
+    
+    const char* err = GSF_putpattern(*pat, x0, y0, mode, PythonScriptAborted);
+    if (err) return CellsError(err);
+    
+    G_Py_RETURN_NONE;
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* py_patcombine(PyObject* self, PyObject* args)
+{
+    AUTORELEASE_POOL
+    if (PythonScriptAborted()) return NULL;
+    wxUnusedVar(self);
+    PyObject* patobj1;
+    PyObject* patobj2;
+    const char* mode;
+    
+    if (!G_PyArg_ParseTuple(args, (char*)"OOs", &patobj1, &patobj2, &mode)) return NULL;
+    
+    GSF_pattern* pat1 = GetPattern(patobj1);
+    if (pat1 == NULL) return NULL;
+    GSF_pattern* pat2 = GetPattern(patobj2);
+    if (pat2 == NULL) return NULL;
+    
+    GSF_pattern* result = new GSF_pattern;
+    const char* err = GSF_copypattern(*pat1, *result);
+    if (!err) err = GSF_combinepattern(*result, *pat2, mode, PythonScriptAborted);
+    
+    return NewPatternObject(result, err);
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* py_pattransform(PyObject* self, PyObject* args)
+{
+    AUTORELEASE_POOL
+    if (PythonScriptAborted()) return NULL;
+    wxUnusedVar(self);
+    PyObject* patobj;
+    PyObject* xobj;
+    PyObject* yobj;
+    
+    // defaults for optional params
+    int axx = 1;
+    int axy = 0;
+    int ayx = 0;
+    int ayy = 1;
+    
+    if (!G_PyArg_ParseTuple(args, (char*)"OOO|iiii", &patobj, &xobj, &yobj,
+                            &axx, &axy, &ayx, &ayy)) return NULL;
+    
+    GSF_pattern* pat = GetPattern(patobj);
+    if (pat == NULL) return NULL;
+    bigint x0, y0;
+    if (!GetBigint(xobj, x0) || !GetBigint(yobj, y0)) return NULL;
+    
+    GSF_pattern* result = new GSF_pattern;
+    const char* err = GSF_copypattern(*pat, *result);
+    if (!err) err = GSF_transformpattern(*result, x0, y0, axx, axy, ayx, ayy);
+    
+    return NewPatternObject(result, err);
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* py_patevolve(PyObject* self, PyObject* args)
+{
+    AUTORELEASE_POOL
+    if (PythonScriptAborted()) return NULL;
+    wxUnusedVar(self);
+    PyObject* patobj;
+    PyObject* gensobj;
+    
+    if (!G_PyArg_ParseTuple(args, (char*)"OO", &patobj, &gensobj)) return NULL;
+    
+    GSF_pattern* pat = GetPattern(patobj);
+    if (pat == NULL) return NULL;
+    bigint ngens;
+    if (!GetBigint(gensobj, ngens)) return NULL;
+    
+    GSF_pattern* result = new GSF_pattern;
+    const char* err = GSF_copypattern(*pat, *result);
+    if (!err) err = GSF_evolvepattern(*result, ngens, PythonScriptAborted);
+    
+    return NewPatternObject(result, err);
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* py_patpop(PyObject* self, PyObject* args)
+{
+    AUTORELEASE_POOL
+    if (PythonScriptAborted()) return NULL;
+    wxUnusedVar(self);
+    PyObject* patobj;
+    char sepchar = '\0';
+    
+    if (!G_PyArg_ParseTuple(args, (char*)"O|c", &patobj, &sepchar)) return NULL;
+    
+    GSF_pattern* pat = GetPattern(patobj);
+    if (pat == NULL) return NULL;
+    
+    return G_Py_BuildValue((char*)"s", GSF_patternalgo(*pat)->getPopulation().tostring(sepchar));
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* py_patrect(PyObject* self, PyObject* args)
+{
+    AUTORELEASE_POOL
+    if (PythonScriptAborted()) return NULL;
+    wxUnusedVar(self);
+    PyObject* patobj;
+    
+    if (!G_PyArg_ParseTuple(args, (char*)"O", &patobj)) return NULL;
+    
+    GSF_pattern* pat = GetPattern(patobj);
+    if (pat == NULL) return NULL;
+    
+    PyObject* outlist = G_PyList_New(0);
+    
+    lifealgo* algo = GSF_patternalgo(*pat);
+    if (!algo->isEmpty()) {
+        bigint top, left, bottom, right;
+        algo->findedges(&top, &left, &bottom, &right);
+        if ( viewptr->OutsideLimits(top, left, bottom, right) ) {
             G_Py_DecRef(outlist);
-            return NULL;
+            PYTHON_ERROR("patrect error: pattern is too big.");
         }
+        long x = left.toint();
+        long y = top.toint();
+        long wd = right.toint() - x + 1;
+        long ht = bottom.toint() - y + 1;
+        
+        AddTwoInts(outlist, x, y);
+        AddTwoInts(outlist, wd, ht);
     }
     
-    if (multiout) AddPadding(outlist);
+    return outlist;
+}
+
+// -----------------------------------------------------------------------------
+
+static PyObject* py_patcells(PyObject* self, PyObject* args)
+{
+    AUTORELEASE_POOL
+    if (PythonScriptAborted()) return NULL;
+    wxUnusedVar(self);
+    PyObject* patobj;
+    int packed = 0;     // optional param says whether to return a packed cell list
+    
+    if (!G_PyArg_ParseTuple(args, (char*)"O|i", &patobj, &packed)) return NULL;
+    
+    GSF_pattern* pat = GetPattern(patobj);
+    if (pat == NULL) return NULL;
+    
+    GSF_cells cells;
+    GSF_initcells(cells);
+    const char* err = GSF_extractcells(GSF_patternalgo(*pat), false, cells, PythonScriptAborted);
+    PyObject* outlist = err ? CellsError(err) : NewCellList(cells, packed != 0);
+    GSF_freecells(cells);
     
     return outlist;
 }
@@ -1507,6 +1698,27 @@ static PyObject* py_hash(PyObject* self, PyObject* args)
 
 // -----------------------------------------------------------------------------
 
+static PyObject* py_oscar(PyObject* self, PyObject* args)
+{
+    AUTORELEASE_POOL
+    if (PythonScriptAborted()) return NULL;
+    wxUnusedVar(self);
+    int maxgens;
+    
+    if (!G_PyArg_ParseTuple(args, (char*)"i", &maxgens)) return NULL;
+    
+    if (maxgens < 0) {
+        PYTHON_ERROR("oscar error: number of gens must be >= 0.");
+    }
+    
+    int period, dx, dy;
+    GSF_oscar(maxgens, &period, &dx, &dy);
+    
+    return G_Py_BuildValue((char*)"(iii)", period, dx, dy);
+}
+
+// -----------------------------------------------------------------------------
+
 static PyObject* py_getclip(PyObject* self, PyObject* args)
 {
     AUTORELEASE_POOL
@@ -3123,7 +3335,19 @@ static PyMethodDef py_methods[] = {
     { "putcells",     py_putcells,   METH_VARARGS, "paste given cell list into current universe" },
     { "getcells",     py_getcells,   METH_VARARGS, "return cell list in given rectangle" },
     { "join",         py_join,       METH_VARARGS, "return concatenation of given cell lists" },
+    { "packcells",    py_packcells,  METH_VARARGS, "return packed copy of given cell list" },
+    { "unpackcells",  py_unpackcells, METH_VARARGS, "return cell list with ints in given packed list" },
+    { "makepattern",  py_makepattern, METH_VARARGS, "return pattern object with cells in given cell list" },
+    { "getpattern",   py_getpattern, METH_VARARGS, "return pattern object with cells in given rectangle" },
+    { "putpattern",   py_putpattern, METH_VARARGS, "paste given pattern object into current universe" },
+    { "patcombine",   py_patcombine, METH_VARARGS, "return or/and/xor/not combination of given patterns" },
+    { "pattransform", py_pattransform, METH_VARARGS, "return pattern moved and rotated/flipped by multiples of 90 deg" },
+    { "patevolve",    py_patevolve,  METH_VARARGS, "return given pattern advanced by given number of gens" },
+    { "patpop",       py_patpop,     METH_VARARGS, "return population of given pattern as string" },
+    { "patrect",      py_patrect,    METH_VARARGS, "return rectangle of given pattern as [] or [x, y, wd, ht]" },
+    { "patcells",     py_patcells,   METH_VARARGS, "return cell list with cells in given pattern" },
     { "hash",         py_hash,       METH_VARARGS, "return hash value for pattern in given rectangle" },
+    { "oscar",        py_oscar,      METH_VARARGS, "run pattern until period is found and return (period, dx, dy)" },
     { "getclip",      py_getclip,    METH_VARARGS, "return pattern in clipboard (as cell list)" },
     { "select",       py_select,     METH_VARARGS, "select [x, y, wd, ht] rectangle or remove if []" },
     { "getrect",      py_getrect,    METH_VARARGS, "return pattern rectangle as [] or [x, y, wd, ht]" },
@@ -8,7 +8,9 @@
     #include "wx/wx.h"     // for all others include the necessary headers
 #endif
 
-#include <limits.h>        // for INT_MAX
+#include <limits.h>        // for INT_MAX, INT_MIN
+#include <vector>          // for std::vector
+#include <algorithm>       // for std::sort, std::binary_search
 #include "wx/filename.h"   // for wxFileName
 
 #include "wxgolly.h"       // for wxGetApp, mainptr, viewptr, statusptr
@@ -27,6 +29,8 @@
 #include "wxperl.h"        // for RunPerlScript, AbortPerlScript
 #include "wxpython.h"      // for RunPythonScript, AbortPythonScript
 #include "wxoverlay.h"     // for curroverlay
+#include "oscar.h"         // for oscar
+#include "patternhash.h"   // for patternhash
 #include "wxscript.h"
 
 // =============================================================================
@@ -645,41 +649,1146 @@ const char* GSF_checkrect(int x, int y, int wd, int ht)
 
 // -----------------------------------------------------------------------------
 
-int GSF_hash(int x, int y, int wd, int ht)
+void GSF_initcells(GSF_cells& cells)
 {
-    // calculate a hash value for pattern in given rect
-    int hash = 31415962;
-    int right = x + wd - 1;
-    int bottom = y + ht - 1;
+    cells.ints = NULL;
+    cells.numints = 0;
+    cells.maxints = 0;
+}
+
+// -----------------------------------------------------------------------------
+
+void GSF_freecells(GSF_cells& cells)
+{
+    if (cells.ints) free(cells.ints);
+    GSF_initcells(cells);
+}
+
+// -----------------------------------------------------------------------------
+
+bool GSF_reservecells(GSF_cells& cells, int numints)
+{
+    // make sure there's room for the given number of ints
+    if (numints <= cells.maxints) return true;
+    int* newints = (int*) realloc(cells.ints, (size_t)numints * sizeof(int));
+    if (newints == NULL) return false;
+    cells.ints = newints;
+    cells.maxints = numints;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+static const char* NO_CELL_MEMORY = "Not enough memory for cell array.";
+
+static bool AddCellInt(GSF_cells& cells, int i)
+{
+    if (cells.numints == cells.maxints) {
+        // double the size of the array (starting with room for 1024 ints)
+        if (cells.maxints > INT_MAX / 2) return false;
+        if (!GSF_reservecells(cells, cells.maxints < 512 ? 1024 : cells.maxints * 2))
+            return false;
+    }
+    cells.ints[cells.numints++] = i;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+static bool AddCellPadding(GSF_cells& cells)
+{
+    // add a padding zero if necessary so a multi-state cell array has an odd
+    // number of ints (this is how we distinguish multi-state arrays from
+    // one-state arrays; the latter always have an even number of ints)
+    if (cells.numints > 0 && (cells.numints & 1) == 0) return AddCellInt(cells, 0);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+static const char* BAD_STATE = "putcells error: state value is out of range.";
+
+const char* GSF_putcells(const int* ints, int numints, int x0, int y0,
+                         int axx, int axy, int ayx, int ayy, const char* mode,
+                         bool (*aborted)())
+{
+    // default for mode is 'or'; 'xor' mode is also supported;
+    // 'copy' mode kills any live cells in the (transformed) bounding box
+    // of the array that aren't in the array, then sets the array's cells
+    // (a multi-state array can also contain dead cells)
+    wxString modestr = wxString(mode, wxConvUTF8);
+    if ( !(   modestr.IsSameAs(wxT("or"), false)
+           || modestr.IsSameAs(wxT("xor"), false)
+           || modestr.IsSameAs(wxT("copy"), false)
+           || modestr.IsSameAs(wxT("and"), false)
+           || modestr.IsSameAs(wxT("not"), false)) ) {
+        return "putcells error: unknown mode.";
+    }
+    
+    // save cell changes if undo/redo is enabled and script isn't constructing a pattern
+    bool savecells = allowundo && !currlayer->stayclean;
+    // use ChangeCell below and combine all changes due to consecutive setcell/putcells
+    // if (savecells) SavePendingChanges();
+    
+    bool multistate = (numints & 1) == 1;
+    int ints_per_cell = multistate ? 3 : 2;
+    int num_cells = numints / ints_per_cell;
+    const char* err = NULL;
+    bool pattchanged = false;
+    lifealgo* curralgo = currlayer->algo;
+    
+    if (modestr.IsSameAs(wxT("copy"), false) && num_cells > 0) {
+        // find the bounding box of the transformed cells and remember their
+        // positions so we only kill live cells that aren't in the array
+        std::vector< std::pair<int,int> > arraycells;
+        arraycells.reserve(num_cells);
+        int top = INT_MAX, left = INT_MAX, bottom = INT_MIN, right = INT_MIN;
+        for (int n = 0; n < num_cells; n++) {
+            const int* cell = ints + ints_per_cell * n;
+            int newx = x0 + cell[0] * axx + cell[1] * axy;
+            int newy = y0 + cell[0] * ayx + cell[1] * ayy;
+            // check for cells outside bounded grid before changing anything
+            err = GSF_checkpos(curralgo, newx, newy);
+            if (err) return err;
+            arraycells.push_back(std::make_pair(newy, newx));
+            if (newy < top) top = newy;
+            if (newy > bottom) bottom = newy;
+            if (newx < left) left = newx;
+            if (newx > right) right = newx;
+        }
+        std::sort(arraycells.begin(), arraycells.end());
+        
+        int cx, cy, v;
+        for (cy = top; cy <= bottom && !err; cy++) {
+            for (cx = left; cx <= right; cx++) {
+                int skip = curralgo->nextcell(cx, cy, v);
+                if (skip < 0 || skip + cx > right) break;   // no more live cells in this row
+                cx += skip;
+                if (!std::binary_search(arraycells.begin(), arraycells.end(),
+                                        std::make_pair(cy, cx))) {
+                    curralgo->setcell(cx, cy, 0);
+                    if (savecells) ChangeCell(cx, cy, v, 0);
+                    pattchanged = true;
+                }
+            }
+            if (aborted && aborted()) err = abortmsg;
+        }
+    }
+    
+    if (err) {
+        // script was aborted while clearing cells for 'copy' mode
+    } else if (modestr.IsSameAs(wxT("and"), false)) {
+        if (!curralgo->isEmpty()) {
+            int newstate = 1;
+            for (int n = 0; n < num_cells; n++) {
+                const int* cell = ints + ints_per_cell * n;
+                int newx = x0 + cell[0] * axx + cell[1] * axy;
+                int newy = y0 + cell[0] * ayx + cell[1] * ayy;
+                // check if newx,newy is outside bounded grid
+                err = GSF_checkpos(curralgo, newx, newy);
+                if (err) break;
+                int oldstate = curralgo->getcell(newx, newy);
+                if (multistate) {
+                    // multi-state arrays can contain dead cells so newstate might be 0
+                    newstate = cell[2];
+                }
+                if (newstate != oldstate && oldstate > 0) {
+                    curralgo->setcell(newx, newy, 0);
+                    if (savecells) ChangeCell(newx, newy, oldstate, 0);
+                    pattchanged = true;
+                }
+                if ((n % 4096) == 0 && aborted && aborted()) {
+                    err = abortmsg;
+                    break;
+                }
+            }
+        }
+    } else if (modestr.IsSameAs(wxT("xor"), false)) {
+        // loop code is duplicated here to allow 'or' case to execute faster
+        int numstates = curralgo->NumCellStates();
+        for (int n = 0; n < num_cells; n++) {
+            const int* cell = ints + ints_per_cell * n;
+            int newx = x0 + cell[0] * axx + cell[1] * axy;
+            int newy = y0 + cell[0] * ayx + cell[1] * ayy;
+            // check if newx,newy is outside bounded grid
+            err = GSF_checkpos(curralgo, newx, newy);
+            if (err) break;
+            int oldstate = curralgo->getcell(newx, newy);
+            int newstate;
+            if (multistate) {
+                // multi-state arrays can contain dead cells so newstate might be 0
+                newstate = cell[2];
+                if (newstate == oldstate) {
+                    if (oldstate != 0) newstate = 0;
+                } else {
+                    newstate = newstate ^ oldstate;
+                    // if xor overflows then don't change current state
+                    if (newstate >= numstates) newstate = oldstate;
+                }
+                if (newstate != oldstate) {
+                    // paste (possibly transformed) cell into current universe
+                    if (curralgo->setcell(newx, newy, newstate) < 0) {
+                        err = BAD_STATE;
+                        break;
+                    }
+                    if (savecells) ChangeCell(newx, newy, oldstate, newstate);
+                    pattchanged = true;
+                }
+            } else {
+                // one-state arrays only contain live cells
+                newstate = 1 - oldstate;
+                // paste (possibly transformed) cell into current universe
+                if (curralgo->setcell(newx, newy, newstate) < 0) {
+                    err = BAD_STATE;
+                    break;
+                }
+                if (savecells) ChangeCell(newx, newy, oldstate, newstate);
+                pattchanged = true;
+            }
+            if ((n % 4096) == 0 && aborted && aborted()) {
+                err = abortmsg;
+                break;
+            }
+        }
+    } else {
+        bool notmode = modestr.IsSameAs(wxT("not"), false);
+        bool ormode = modestr.IsSameAs(wxT("or"), false);
+        int newstate = notmode ? 0 : 1;
+        int maxstate = curralgo->NumCellStates() - 1;
+        for (int n = 0; n < num_cells; n++) {
+            const int* cell = ints + ints_per_cell * n;
+            int newx = x0 + cell[0] * axx + cell[1] * axy;
+            int newy = y0 + cell[0] * ayx + cell[1] * ayy;
+            // check if newx,newy is outside bounded grid
+            err = GSF_checkpos(curralgo, newx, newy);
+            if (err) break;
+            int oldstate = curralgo->getcell(newx, newy);
+            if (multistate) {
+                // multi-state arrays can contain dead cells so newstate might be 0
+                newstate = cell[2];
+                if (notmode) newstate = maxstate - newstate;
+                if (ormode && newstate == 0) newstate = oldstate;
+            }
+            if (newstate != oldstate) {
+                // paste (possibly transformed) cell into current universe
+                if (curralgo->setcell(newx, newy, newstate) < 0) {
+                    err = BAD_STATE;
+                    break;
+                }
+                if (savecells) ChangeCell(newx, newy, oldstate, newstate);
+                pattchanged = true;
+            }
+            if ((n % 4096) == 0 && aborted && aborted()) {
+                err = abortmsg;
+                break;
+            }
+        }
+    }
+    
+    if (pattchanged) {
+        curralgo->endofpattern();
+        MarkLayerDirty();
+        DoAutoUpdate();
+    }
+    
+    return err;
+}
+
+// -----------------------------------------------------------------------------
+
+const char* GSF_getcells(lifealgo* algo, int x, int y, int wd, int ht, bool shift,
+                         GSF_cells& cells, bool (*aborted)())
+{
+    // append the live cells in the given rect to the given cell array,
+    // relative to the rect's top left cell if shift is true
+    int iright = x + wd - 1;
+    int ibottom = y + ht - 1;
     int cx, cy;
     int v = 0;
+    int cntr = 0;
+    bool multistate = algo->NumCellStates() > 2;
+    for ( cy=y; cy<=ibottom; cy++ ) {
+        for ( cx=x; cx<=iright; cx++ ) {
+            int skip = algo->nextcell(cx, cy, v);
+            if (skip >= 0) {
+                // found next live cell in this row
+                cx += skip;
+                if (cx <= iright) {
+                    bool added = shift ? AddCellInt(cells, cx - x) && AddCellInt(cells, cy - y)
+                                       : AddCellInt(cells, cx) && AddCellInt(cells, cy);
+                    if (added && multistate) added = AddCellInt(cells, v);
+                    if (!added) return NO_CELL_MEMORY;
+                }
+            } else {
+                cx = iright;  // done this row
+            }
+            cntr++;
+            if ((cntr % 4096) == 0 && aborted && aborted()) return abortmsg;
+        }
+    }
+    if (multistate && !AddCellPadding(cells)) return NO_CELL_MEMORY;
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+
+const char* GSF_extractcells(lifealgo* algo, bool shift, GSF_cells& cells,
+                             bool (*aborted)())
+{
+    // extract all the live cells in the given universe
+    if (algo->isEmpty()) return NULL;
+    bigint top, left, bottom, right;
+    algo->findedges(&top, &left, &bottom, &right);
+    if ( viewptr->OutsideLimits(top, left, bottom, right) ) {
+        return "Universe is too big to extract all cells!";
+    }
+    int itop = top.toint();
+    int ileft = left.toint();
+    return GSF_getcells(algo, ileft, itop, right.toint() - ileft + 1,
+                        bottom.toint() - itop + 1, shift, cells, aborted);
+}
+
+// -----------------------------------------------------------------------------
+
+const char* GSF_transform(const int* ints, int numints, int x0, int y0,
+                          int axx, int axy, int ayx, int ayy, GSF_cells& cells)
+{
+    // append an affine transformation of the given cell array
+    bool multistate = (numints & 1) == 1;
+    int ints_per_cell = multistate ? 3 : 2;
+    int num_cells = numints / ints_per_cell;
+    if (!GSF_reservecells(cells, cells.numints + numints)) return NO_CELL_MEMORY;
+    int* out = cells.ints + cells.numints;
+    for (int n = 0; n < num_cells; n++) {
+        const int* cell = ints + ints_per_cell * n;
+        *out++ = x0 + cell[0] * axx + cell[1] * axy;
+        *out++ = y0 + cell[0] * ayx + cell[1] * ayy;
+        if (multistate) *out++ = cell[2];
+    }
+    cells.numints = (int)(out - cells.ints);
+    if (multistate && !AddCellPadding(cells)) return NO_CELL_MEMORY;
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+
+const char* GSF_join(const int* ints1, int numints1, const int* ints2, int numints2,
+                     GSF_cells& cells)
+{
+    // append the concatenation of the given cell arrays; the result is
+    // a multi-state array if either array is multi-state
+    bool multi1 = (numints1 & 1) == 1;
+    bool multi2 = (numints2 & 1) == 1;
+    bool multiout = multi1 || multi2;
+    for (int i = 0; i < 2; i++) {
+        const int* ints = i == 0 ? ints1 : ints2;
+        bool multi = i == 0 ? multi1 : multi2;
+        int ints_per_cell = multi ? 3 : 2;
+        int num_cells = (i == 0 ? numints1 : numints2) / ints_per_cell;
+        for (int n = 0; n < num_cells; n++) {
+            const int* cell = ints + ints_per_cell * n;
+            if ( !AddCellInt(cells, cell[0]) || !AddCellInt(cells, cell[1]) ||
+                 (multiout && !AddCellInt(cells, multi ? cell[2] : 1)) ) {
+                return NO_CELL_MEMORY;
+            }
+        }
+    }
+    if (multiout && !AddCellPadding(cells)) return NO_CELL_MEMORY;
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+
+// GSF_evolve keeps scratch universes for the last few rules it was used with.
+// Algorithms that memoize (ie. hyperCapable ones) keep their hash tables from
+// one call to the next, so a script that evolves lots of small patterns can
+// reuse results computed for earlier ones.  Clearing a universe keeps its
+// nodes, so if the pooled universes together use more than one universe's
+// memory limit the least recently used ones are deleted.  The universes are
+// deleted when the script finishes.
+
+const int MAX_SCRATCH = 4;
+
+struct ScratchUniverse {
+    lifealgo* algo;
+    algo_type algtype;
+    wxString rule;
+};
+
+static ScratchUniverse scratch[MAX_SCRATCH];    // most recently used first
+static int numscratch = 0;
+
+static lifealgo* GetScratchUniverse(bool checkevents)
+{
+    // return an empty universe using the current layer's algorithm and rule
+    wxString rule = wxString(currlayer->algo->getrule(), wxConvLocal);
+    for (int i = 0; i < numscratch; i++) {
+        if (scratch[i].algtype == currlayer->algtype && scratch[i].rule == rule) {
+            ScratchUniverse found = scratch[i];
+            for (int j = i; j > 0; j--) scratch[j] = scratch[j-1];
+            scratch[0] = found;
+            found.algo->setpoll(checkevents ? wxGetApp().Poller() : &default_poller);
+            return found.algo;
+        }
+    }
+    
+    lifealgo* tempalgo = CreateNewUniverse(currlayer->algtype, checkevents);
+    const char* err = tempalgo->setrule(currlayer->algo->getrule());
+    if (err) tempalgo->setrule(tempalgo->DefaultRule());
+    
+    if (tempalgo->hyperCapable()) {
+        if (numscratch == MAX_SCRATCH) delete scratch[--numscratch].algo;
+        for (int j = numscratch; j > 0; j--) scratch[j] = scratch[j-1];
+        scratch[0].algo = tempalgo;
+        scratch[0].algtype = currlayer->algtype;
+        scratch[0].rule = rule;
+        numscratch++;
+    }
+    return tempalgo;
+}
+
+// -----------------------------------------------------------------------------
+
+static void ReleaseScratchUniverse(lifealgo* tempalgo)
+{
+    // clear a pooled universe ready for the next GSF_evolve call;
+    // any other universe is deleted
+    if (numscratch > 0 && scratch[0].algo == tempalgo) {
+        tempalgo->clearall();
+        
+        // bound the memory held by the whole pool
+        g_uintptr_t limit = (g_uintptr_t)tempalgo->getMaxMemory() << 20;
+        if (limit == 0) return;
+        g_uintptr_t total = 0;
+        for (int i = 0; i < numscratch; i++) total += scratch[i].algo->getMemoryUsed();
+        while (total > limit && numscratch > 1) {
+            numscratch--;
+            total -= scratch[numscratch].algo->getMemoryUsed();
+            delete scratch[numscratch].algo;
+        }
+    } else {
+        delete tempalgo;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+static void FreeScratchUniverses()
+{
+    while (numscratch > 0) delete scratch[--numscratch].algo;
+}
+
+// -----------------------------------------------------------------------------
+
+const char* GSF_evolve(const int* ints, int numints, int ngens, bool checkevents,
+                       GSF_cells& cells, bool (*aborted)())
+{
+    if (ngens < 0) return "evolve error: number of generations is negative.";
+    
+    // get an empty universe of same type as current universe
+    lifealgo* tempalgo = GetScratchUniverse(checkevents);
+    const char* err;
+    
+    // copy cell array into temporary universe
+    bool multistate = (numints & 1) == 1;
+    int ints_per_cell = multistate ? 3 : 2;
+    int num_cells = numints / ints_per_cell;
+    for (int n = 0; n < num_cells; n++) {
+        const int* cell = ints + ints_per_cell * n;
+        // check if x,y is outside bounded grid
+        err = GSF_checkpos(tempalgo, cell[0], cell[1]);
+        if (err) {
+            ReleaseScratchUniverse(tempalgo);
+            return err;
+        }
+        if (tempalgo->setcell(cell[0], cell[1], multistate ? cell[2] : 1) < 0) {
+            tempalgo->endofpattern();
+            ReleaseScratchUniverse(tempalgo);
+            return "evolve error: state value is out of range.";
+        }
+        if ((n % 4096) == 0 && aborted && aborted()) {
+            tempalgo->endofpattern();
+            ReleaseScratchUniverse(tempalgo);
+            return abortmsg;
+        }
+    }
+    tempalgo->endofpattern();
+    
+    // advance pattern by ngens
+    mainptr->generating = true;
+    if (tempalgo->unbounded && (tempalgo->gridwd > 0 || tempalgo->gridht > 0)) {
+        // a bounded grid must use an increment of 1 so we can call
+        // CreateBorderCells and DeleteBorderCells around each step()
+        tempalgo->setIncrement(1);
+        while (ngens > 0) {
+            if (aborted && aborted()) {
+                mainptr->generating = false;
+                ReleaseScratchUniverse(tempalgo);
+                return abortmsg;
+            }
+            if (!tempalgo->CreateBorderCells()) break;
+            tempalgo->step();
+            if (!tempalgo->DeleteBorderCells()) break;
+            ngens--;
+        }
+    } else {
+        tempalgo->setIncrement(ngens);
+        tempalgo->step();
+    }
+    mainptr->generating = false;
+    
+    // convert new pattern into a cell array
+    err = GSF_extractcells(tempalgo, false, cells, aborted);
+    ReleaseScratchUniverse(tempalgo);
+    return err;
+}
+
+// -----------------------------------------------------------------------------
+
+// All the patterns with the same algorithm and rule live in one universe
+// (a pattern store) as kept states (see lifealgo::keepstate), so they share
+// nodes and the algorithm's memos; eg. evolving a pattern and then a copy of
+// it costs little more than evolving it once.  A store is deleted when its
+// last pattern is freed.  If a store's algorithm would rather not keep any
+// more states then new patterns go in a new store.
+
+struct GSF_patternstore {
+    lifealgo* algo;
+    algo_type algtype;
+    int numpatterns;
+    bool full;                  // algo won't keep more states
+    GSF_patternstore* next;
+};
+
+static GSF_patternstore* patternstores = NULL;
+
+static const char* NewPatternStore(algo_type algtype, const char* rule,
+                                   GSF_patternstore** store)
+{
+    lifealgo* algo = CreateNewUniverse(algtype);
+    if (algo->setrule(rule)) {
+        delete algo;
+        static std::string err;
+        err = "pattern error: ";
+        err += GetAlgoName(algtype);
+        err += " doesn't support the current rule.";
+        return err.c_str();
+    }
+    GSF_patternstore* s = new GSF_patternstore;
+    s->algo = algo;
+    s->algtype = algtype;
+    s->numpatterns = 0;
+    s->full = false;
+    s->next = patternstores;
+    patternstores = s;
+    *store = s;
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+
+static const char* GetPatternStore(algo_type algtype, const char* rule,
+                                   GSF_patternstore** store)
+{
+    // find or create a store for the given algorithm and rule; its universe
+    // is left empty, ready for building a new pattern
+    GSF_patternstore* s;
+    for (s = patternstores; s; s = s->next) {
+        if (!s->full && s->algtype == algtype && strcmp(s->algo->getrule(), rule) == 0) break;
+    }
+    if (s == NULL) {
+        const char* err = NewPatternStore(algtype, rule, &s);
+        if (err) return err;
+    }
+    s->algo->clearall();
+    *store = s;
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+
+static void FreePatternStore(GSF_patternstore* store)
+{
+    GSF_patternstore** p = &patternstores;
+    while (*p != store) p = &(*p)->next;
+    *p = store->next;
+    delete store->algo;
+    delete store;
+}
+
+// -----------------------------------------------------------------------------
+
+static const char* KeepPattern(GSF_patternstore* store, GSF_pattern& pat)
+{
+    // make pat refer to the current pattern in the given store
+    lifealgo* algo = store->algo;
+    int ticket = algo->keepstate();
+    if (ticket == 0) {
+        // copy the pattern into a new store
+        store->full = true;
+        GSF_patternstore* newstore;
+        const char* err = NewPatternStore(store->algtype, algo->getrule(), &newstore);
+        if (err) return err;
+        if (!algo->isEmpty()) {
+            bigint top, left, bottom, right;
+            algo->findedges(&top, &left, &bottom, &right);
+            newstore->algo->copyrect(algo, top, left, bottom, right, 0);
+        }
+        ticket = newstore->algo->keepstate();
+        if (ticket == 0) {
+            FreePatternStore(newstore);
+            return "pattern error: not enough memory to keep the pattern.";
+        }
+        store = newstore;
+    }
+    store->numpatterns++;
+    pat.store = store;
+    pat.ticket = ticket;
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+
+static const char* UpdatePattern(GSF_pattern& pat)
+{
+    // make pat refer to its store's current pattern (after an edit)
+    GSF_pattern newpat;
+    const char* err = KeepPattern(pat.store, newpat);
+    if (err) return err;
+    GSF_freepattern(pat);
+    pat = newpat;
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+
+static const char* NewPattern(GSF_patternstore** store)
+{
+    // get an empty universe for a new pattern using the current rule;
+    // patterns need an algorithm that can edit whole subtrees so use
+    // HashLife if the current algorithm can't
     lifealgo* curralgo = currlayer->algo;
-    bool multistate = curralgo->NumCellStates() > 2;
+    algo_type algtype = curralgo->rectCapable() ? currlayer->algtype : (algo_type)HLIFE_ALGO;
+    return GetPatternStore(algtype, curralgo->getrule(), store);
+}
+
+// -----------------------------------------------------------------------------
 
-    for ( cy=y; cy<=bottom; cy++ ) {
-        int yshift = cy - y;
-        for ( cx=x; cx<=right; cx++ ) {
-            int skip = curralgo->nextcell(cx, cy, v);
+lifealgo* GSF_patternalgo(GSF_pattern& pat)
+{
+    lifealgo* algo = pat.store->algo;
+    algo->restorestate(pat.ticket);
+    return algo;
+}
+
+// -----------------------------------------------------------------------------
+
+size_t GSF_patternmemory()
+{
+    size_t total = 0;
+    for (GSF_patternstore* s = patternstores; s; s = s->next) {
+        total += s->algo->getMemoryUsed();
+    }
+    return total;
+}
+
+// -----------------------------------------------------------------------------
+
+const char* GSF_bigint(const char* s, bigint& value)
+{
+    // allow an optional minus sign, or 2^ for a power of 2, then only digits
+    const char* p = s;
+    if (p[0] == '-') p++;
+    else if (p[0] == '2' && p[1] == '^') p += 2;
+    if (*p == 0) return "Number has no digits.";
+    for ( ; *p; p++)
+        if (*p < '0' || *p > '9') return "Illegal character in number.";
+    value = bigint(s);
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+
+void GSF_freepattern(GSF_pattern& pat)
+{
+    if (pat.store == NULL) return;
+    lifealgo::forgetstate(pat.ticket);
+    if (--pat.store->numpatterns == 0) FreePatternStore(pat.store);
+    pat.store = NULL;
+}
+
+// -----------------------------------------------------------------------------
+
+const char* GSF_newpattern(const int* ints, int numints, GSF_pattern& pat,
+                           bool (*aborted)())
+{
+    pat.store = NULL;
+    GSF_patternstore* store;
+    const char* err = NewPattern(&store);
+    if (err) return err;
+    
+    // copy cell array into the store's empty universe
+    lifealgo* algo = store->algo;
+    bool multistate = (numints & 1) == 1;
+    int ints_per_cell = multistate ? 3 : 2;
+    int num_cells = numints / ints_per_cell;
+    for (int n = 0; n < num_cells; n++) {
+        const int* cell = ints + ints_per_cell * n;
+        err = GSF_checkpos(algo, cell[0], cell[1]);
+        if (!err && algo->setcell(cell[0], cell[1], multistate ? cell[2] : 1) < 0)
+            err = "pattern error: state value is out of range.";
+        if (!err && (n % 4096) == 0 && aborted && aborted()) err = abortmsg;
+        if (err) {
+            algo->endofpattern();
+            return err;
+        }
+    }
+    algo->endofpattern();
+    return KeepPattern(store, pat);
+}
+
+// -----------------------------------------------------------------------------
+
+const char* GSF_copypattern(GSF_pattern& src, GSF_pattern& pat)
+{
+    // the copy is just another ticket for the same state
+    pat.store = NULL;
+    GSF_patternalgo(src);
+    return KeepPattern(src.store, pat);
+}
+
+// -----------------------------------------------------------------------------
+
+static const char* CopyCells(lifealgo* srcalgo, lifealgo* destalgo,
+                             int top, int left, int bottom, int right, bool savecells,
+                             bool (*aborted)())
+{
+    // copy the live cells in the given rect of srcalgo into destalgo,
+    // calling ChangeCell for each changed cell if savecells is true
+    int cx, cy;
+    int v = 0;
+    int cntr = 0;
+    for ( cy=top; cy<=bottom; cy++ ) {
+        for ( cx=left; cx<=right; cx++ ) {
+            int skip = srcalgo->nextcell(cx, cy, v);
             if (skip >= 0) {
-                // found next live cell in this row (v is >= 1 if multistate)
+                // found next live cell in this row
                 cx += skip;
                 if (cx <= right) {
-                    // need to use a good hash function for patterns like AlienCounter.rle
-                    hash = (hash * 1000003) ^ yshift;
-                    hash = (hash * 1000003) ^ (cx - x);
-                    if (multistate) hash = (hash * 1000003) ^ v;
+                    int oldstate = destalgo->getcell(cx, cy);
+                    if (oldstate != v) {
+                        if (destalgo->setcell(cx, cy, v) < 0) {
+                            destalgo->endofpattern();
+                            return "pattern error: state value is out of range.";
+                        }
+                        if (savecells) ChangeCell(cx, cy, oldstate, v);
+                    }
                 }
             } else {
                 cx = right;  // done this row
             }
+            cntr++;
+            if ((cntr % 4096) == 0 && aborted && aborted()) {
+                destalgo->endofpattern();
+                return abortmsg;
+            }
         }
     }
+    destalgo->endofpattern();
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
 
+const char* GSF_getpattern(int x, int y, int wd, int ht, GSF_pattern& pat,
+                           bool (*aborted)())
+{
+    pat.store = NULL;
+    GSF_patternstore* store;
+    const char* err = NewPattern(&store);
+    if (err) return err;
+    
+    lifealgo* curralgo = currlayer->algo;
+    if (curralgo->isEmpty()) return KeepPattern(store, pat);
+    bigint top, left, bottom, right;
+    if (wd > 0) {
+        top = y;
+        left = x;
+        bottom = y + ht - 1;
+        right = x + wd - 1;
+    } else {
+        curralgo->findedges(&top, &left, &bottom, &right);
+    }
+    
+    // copyrect imports only the subtrees inside the rect
+    if (!store->algo->copyrect(curralgo, top, left, bottom, right, 0)) {
+        if (viewptr->OutsideLimits(top, left, bottom, right)) {
+            return "getpattern error: pattern is too big.";
+        }
+        err = CopyCells(curralgo, store->algo, top.toint(), left.toint(),
+                        bottom.toint(), right.toint(), false, aborted);
+        if (err) return err;
+    }
+    return KeepPattern(store, pat);
+}
+
+// -----------------------------------------------------------------------------
+
+const char* GSF_putpattern(GSF_pattern& pat, const bigint& x, const bigint& y,
+                           const char* mode, bool (*aborted)())
+{
+    wxString modestr = wxString(mode, wxConvUTF8);
+    bool copymode = modestr.IsSameAs(wxT("copy"), false);
+    if (!copymode && !modestr.IsSameAs(wxT("or"), false)) {
+        return "putpattern error: unknown mode.";
+    }
+    lifealgo* patalgo = GSF_patternalgo(pat);
+    if (patalgo->isEmpty()) return NULL;
+    
+    // find where the pattern's bounding box will go
+    bigint ptop, pleft, pbottom, pright;
+    patalgo->findedges(&ptop, &pleft, &pbottom, &pright);
+    bigint top = ptop;
+    top += y;
+    bigint left = pleft;
+    left += x;
+    bigint bottom = pbottom;
+    bottom += y;
+    bigint right = pright;
+    right += x;
+    if (viewptr->OutsideLimits(top, left, bottom, right)) {
+        return "putpattern error: pattern is outside editing limits.";
+    }
+    lifealgo* curralgo = currlayer->algo;
+    if ( (curralgo->gridwd > 0 && (left < curralgo->gridleft || right > curralgo->gridright)) ||
+         (curralgo->gridht > 0 && (top < curralgo->gridtop || bottom > curralgo->gridbottom)) ) {
+        return "putpattern error: pattern is outside grid boundary.";
+    }
+    int itop = top.toint();
+    int ileft = left.toint();
+    int ibottom = bottom.toint();
+    int iright = right.toint();
+    
+    // save the changed rectangle rather than each changed cell if we can
+    bool savecells = allowundo && !currlayer->stayclean;
+    if (savecells) SavePendingChanges();
+    bool saveregion = savecells &&
+                      currlayer->undoredo->UseRegionChange(itop, ileft, ibottom, iright);
+    if (saveregion && !currlayer->undoredo->SaveRegionChange(curralgo, NULL,
+                                                             itop, ileft, ibottom, iright)) {
+        return abortmsg;
+    }
+    bool olddirty = currlayer->dirty;
+    
+    // move the pattern into place so the current algorithm can copy its
+    // subtrees (this only changes the store's current pattern, not pat)
+    bool moved = x != bigint::zero || y != bigint::zero;
+    if (moved) patalgo->transformrect(lifealgo::MOVE_ONLY, ptop, pleft, pbottom, pright, top, left);
+    const char* err = NULL;
+    if ( (savecells && !saveregion) ||
+         !curralgo->copyrect(patalgo, top, left, bottom, right, copymode ? 1 : 0) ) {
+        if (copymode) {
+            // kill the live cells that aren't in the pattern
+            int cx, cy;
+            int v = 0;
+            for ( cy=itop; cy<=ibottom && !err; cy++ ) {
+                for ( cx=ileft; cx<=iright; cx++ ) {
+                    int skip = curralgo->nextcell(cx, cy, v);
+                    if (skip < 0) break;
+                    cx += skip;
+                    if (cx > iright) break;
+                    if (patalgo->getcell(cx, cy) == 0) {
+                        curralgo->setcell(cx, cy, 0);
+                        if (savecells && !saveregion) ChangeCell(cx, cy, v, 0);
+                    }
+                }
+                if (aborted && aborted()) err = abortmsg;
+            }
+        }
+        if (!err) err = CopyCells(patalgo, curralgo, itop, ileft, ibottom, iright,
+                                  savecells && !saveregion, aborted);
+    }
+    
+    if (saveregion) {
+        currlayer->undoredo->RememberCellChanges(_("bug3"), olddirty);
+        // action string should never be seen
+    }
+    MarkLayerDirty();
+    DoAutoUpdate();
+    return err;
+}
+
+// -----------------------------------------------------------------------------
+
+static int CombineStates(int a, int b, lifealgo::TCombineOp op)
+{
+    // the state of a cell in a combination of patterns; as in
+    // ghashbase::combinenode a live cell keeps its own state
+    switch (op) {
+        case lifealgo::COMBINE_AND: return b ? a : 0;
+        case lifealgo::COMBINE_XOR: return a ? (b ? 0 : a) : b;
+        case lifealgo::COMBINE_SUBTRACT: return b ? 0 : a;
+        case lifealgo::COMBINE_OR: return b ? b : a;
+    }
+    return a;
+}
+
+// -----------------------------------------------------------------------------
+
+const char* GSF_combinepattern(GSF_pattern& pat, GSF_pattern& other, const char* mode,
+                               bool (*aborted)())
+{
+    wxString modestr = wxString(mode, wxConvUTF8);
+    lifealgo::TCombineOp op;
+    if (modestr.IsSameAs(wxT("and"), false)) {
+        op = lifealgo::COMBINE_AND;
+    } else if (modestr.IsSameAs(wxT("xor"), false)) {
+        op = lifealgo::COMBINE_XOR;
+    } else if (modestr.IsSameAs(wxT("not"), false)) {
+        op = lifealgo::COMBINE_SUBTRACT;
+    } else if (modestr.IsSameAs(wxT("or"), false)) {
+        op = lifealgo::COMBINE_OR;
+    } else {
+        return "pattern error: unknown mode.";
+    }
+    
+    // patterns in the same store are combined without copying any nodes
+    if (other.store == pat.store) {
+        if (GSF_patternalgo(pat)->combinekept(other.ticket, op)) return UpdatePattern(pat);
+        return "pattern error: these patterns can't be combined.";
+    }
+    lifealgo* otheralgo = GSF_patternalgo(other);
+    lifealgo* patalgo = GSF_patternalgo(pat);
+    if (patalgo->combine(otheralgo, op)) return UpdatePattern(pat);
+    
+    // patterns using different algorithms (or rules with more states) have to
+    // be combined a cell at a time, so build the result in a new universe
+    bigint top, left, bottom, right;
+    if (!patalgo->isEmpty()) {
+        patalgo->findedges(&top, &left, &bottom, &right);
+        if (viewptr->OutsideLimits(top, left, bottom, right))
+            return "pattern error: pattern is too big.";
+    }
+    if (!otheralgo->isEmpty()) {
+        otheralgo->findedges(&top, &left, &bottom, &right);
+        if (viewptr->OutsideLimits(top, left, bottom, right))
+            return "pattern error: pattern is too big.";
+    }
+    lifealgo* tempalgo = CreateNewUniverse(pat.store->algtype);
+    tempalgo->setrule(patalgo->getrule());
+    const char* err = NULL;
+    for (int i = 0; i < 2 && !err; i++) {
+        // visit the live cells in pat, then the live cells in other
+        lifealgo* algo = i == 0 ? patalgo : otheralgo;
+        if (algo->isEmpty()) continue;
+        algo->findedges(&top, &left, &bottom, &right);
+        int itop = top.toint();
+        int ileft = left.toint();
+        int ibottom = bottom.toint();
+        int iright = right.toint();
+        int cx, cy;
+        int v = 0;
+        for ( cy=itop; cy<=ibottom && !err; cy++ ) {
+            for ( cx=ileft; cx<=iright; cx++ ) {
+                int skip = algo->nextcell(cx, cy, v);
+                if (skip < 0) break;
+                cx += skip;
+                if (cx > iright) break;
+                int a = i == 0 ? v : patalgo->getcell(cx, cy);
+                int b = i == 0 ? otheralgo->getcell(cx, cy) : v;
+                int newstate = CombineStates(a, b, op);
+                if (newstate > 0 && tempalgo->setcell(cx, cy, newstate) < 0) {
+                    err = "pattern error: state value is out of range.";
+                    break;
+                }
+            }
+            if (aborted && aborted()) err = abortmsg;
+        }
+    }
+    tempalgo->endofpattern();
+    if (!err) {
+        // replace the store's current pattern with the result
+        patalgo->clearall();
+        if (!tempalgo->isEmpty()) {
+            tempalgo->findedges(&top, &left, &bottom, &right);
+            patalgo->copyrect(tempalgo, top, left, bottom, right, 0);
+        }
+        err = UpdatePattern(pat);
+    }
+    delete tempalgo;
+    return err;
+}
+
+// -----------------------------------------------------------------------------
+
+const char* GSF_transformpattern(GSF_pattern& pat, const bigint& x0, const bigint& y0,
+                                 int axx, int axy, int ayx, int ayy)
+{
+    // only flips and rotations keep cells a subtree apart, so the
+    // transformation must be a multiple of 90 degrees with or without a flip
+    lifealgo::TRectOp ops[2];
+    int numops;
+    if      (axx ==  1 && axy ==  0 && ayx ==  0 && ayy ==  1) { numops = 0; }
+    else if (axx == -1 && axy ==  0 && ayx ==  0 && ayy ==  1) { numops = 1; ops[0] = lifealgo::FLIP_LEFT_RIGHT; }
+    else if (axx ==  1 && axy ==  0 && ayx ==  0 && ayy == -1) { numops = 1; ops[0] = lifealgo::FLIP_TOP_BOTTOM; }
+    else if (axx ==  0 && axy == -1 && ayx ==  1 && ayy ==  0) { numops = 1; ops[0] = lifealgo::ROTATE_CW; }
+    else if (axx ==  0 && axy ==  1 && ayx == -1 && ayy ==  0) { numops = 1; ops[0] = lifealgo::ROTATE_ACW; }
+    else if (axx == -1 && axy ==  0 && ayx ==  0 && ayy == -1) { numops = 2; ops[0] = lifealgo::FLIP_LEFT_RIGHT;
+                                                                              ops[1] = lifealgo::FLIP_TOP_BOTTOM; }
+    else if (axx ==  0 && axy ==  1 && ayx ==  1 && ayy ==  0) { numops = 2; ops[0] = lifealgo::ROTATE_CW;
+                                                                              ops[1] = lifealgo::FLIP_LEFT_RIGHT; }
+    else if (axx ==  0 && axy == -1 && ayx == -1 && ayy ==  0) { numops = 2; ops[0] = lifealgo::ROTATE_CW;
+                                                                              ops[1] = lifealgo::FLIP_TOP_BOTTOM; }
+    else return "transform error: the matrix must rotate and/or flip by multiples of 90 degrees.";
+    
+    lifealgo* algo = GSF_patternalgo(pat);
+    if (algo->isEmpty()) return NULL;
+    bigint top, left, bottom, right;
+    algo->findedges(&top, &left, &bottom, &right);
+    
+    // find the top left corner of the transformed bounding box
+    bigint newleft = x0;
+    bigint newtop = y0;
+    if (axx == 1) newleft += left; else if (axx == -1) newleft -= right;
+    if (axy == 1) newleft += top;  else if (axy == -1) newleft -= bottom;
+    if (ayx == 1) newtop += left;  else if (ayx == -1) newtop -= right;
+    if (ayy == 1) newtop += top;   else if (ayy == -1) newtop -= bottom;
+    
+    if (numops == 0) {
+        algo->transformrect(lifealgo::MOVE_ONLY, top, left, bottom, right, newtop, newleft);
+        return UpdatePattern(pat);
+    }
+    for (int i = 0; i < numops; i++) {
+        if (i > 0) algo->findedges(&top, &left, &bottom, &right);
+        // the last op also moves the result into place
+        if (i < numops - 1) {
+            algo->transformrect(ops[i], top, left, bottom, right, top, left);
+        } else {
+            algo->transformrect(ops[i], top, left, bottom, right, newtop, newleft);
+        }
+    }
+    return UpdatePattern(pat);
+}
+
+// -----------------------------------------------------------------------------
+
+const char* GSF_evolvepattern(GSF_pattern& pat, const bigint& ngens, bool (*aborted)())
+{
+    if (ngens < bigint::zero) return "evolve error: number of generations is negative.";
+    lifealgo* algo = GSF_patternalgo(pat);
+    if (ngens == bigint::zero || algo->isEmpty()) return NULL;
+    
+    if (algo->unbounded && (algo->gridwd > 0 || algo->gridht > 0)) {
+        // a bounded grid must use an increment of 1 so we can call
+        // CreateBorderCells and DeleteBorderCells around each step()
+        if (ngens > bigint(INT_MAX)) {
+            return "evolve error: too many generations for a bounded grid.";
+        }
+        int gens = ngens.toint();
+        mainptr->generating = true;
+        algo->setIncrement(1);
+        while (gens > 0) {
+            if (aborted && aborted()) {
+                mainptr->generating = false;
+                return abortmsg;
+            }
+            if (!algo->CreateBorderCells()) break;
+            algo->step();
+            if (!algo->DeleteBorderCells()) break;
+            gens--;
+        }
+    } else {
+        mainptr->generating = true;
+        algo->setIncrement(ngens);
+        algo->step();
+    }
+    mainptr->generating = false;
+    return UpdatePattern(pat);
+}
+
+// -----------------------------------------------------------------------------
+
+int GSF_hash(int x, int y, int wd, int ht)
+{
+    // calculate a hash value for the pattern in the given rect: the
+    // translation-invariant hash of its live cells (see patternhash.h)
+    // mixed with the offset of their bounding box from the rect's top left
+    // corner, so the same cells at the same place in the rect always give
+    // the same value whichever way it's computed
+    int right = x + wd - 1;
+    int bottom = y + ht - 1;
+    lifealgo* curralgo = currlayer->algo;
+    if (curralgo->isEmpty()) return 31415962;
+    
+    int hash, dx, dy;
+    bigint top, left, bot, rt;
+    curralgo->findedges(&top, &left, &bot, &rt);
+    if (left >= bigint(x) && top >= bigint(y) && rt <= bigint(right) && bot <= bigint(bottom)) {
+        // the rect encloses the entire pattern so use the algorithm's hash,
+        // which doesn't need to visit every cell
+        hash = curralgo->gethash();
+        dx = left.toint() - x;
+        dy = top.toint() - y;
+    } else {
+        // visit the live cells in the rect, hashing them relative to its
+        // top left corner, then move the origin to their bounding box
+        phash h = 0;
+        phash yw = 1;
+        int minx = INT_MAX;
+        int miny = INT_MAX;
+        int cx, cy;
+        int v = 0;
+        for ( cy=y; cy<=bottom; cy++ ) {
+            int lastx = x;
+            phash xw = yw;
+            for ( cx=x; cx<=right; cx++ ) {
+                int skip = curralgo->nextcell(cx, cy, v);
+                if (skip < 0) break;
+                cx += skip;
+                if (cx > right) break;
+                xw = patternhash::mul(xw, patternhash::pow(patternhash::X, (unsigned int)(cx - lastx)));
+                lastx = cx;
+                h = patternhash::add(h, patternhash::mul(xw, v));
+                if (cx < minx) minx = cx;
+                if (cy < miny) miny = cy;
+            }
+            yw = patternhash::mul(yw, patternhash::Y);
+        }
+        if (minx == INT_MAX) return 31415962;
+        dx = minx - x;
+        dy = miny - y;
+        h = patternhash::mul(h, patternhash::pow(patternhash::X, bigint(-dx)));
+        h = patternhash::mul(h, patternhash::pow(patternhash::Y, bigint(-dy)));
+        hash = patternhash::fold(h);
+    }
+    hash = (hash * 1000003) ^ dy;
+    hash = (hash * 1000003) ^ dx;
     return hash;
 }
 
 // -----------------------------------------------------------------------------
 
+const char* GSF_oscar(int maxgens, int* period, int* dx, int* dy)
+{
+    // run the current pattern one gen at a time until it is found to be empty,
+    // stable, oscillating or moving, or until maxgens gens have been done
+    static oscar detector;
+    detector.reset();
+    for (int i = 0; ; i++) {
+        if (detector.check(*currlayer->algo) || i >= maxgens) break;
+        mainptr->NextGeneration(false);
+        if (wxGetApp().Poller()->isInterrupted()) break;
+    }
+    DoAutoUpdate();
+    
+    *period = detector.period;
+    *dx = detector.dx;
+    *dy = detector.dy;
+    return detector.describe();
+}
+
+// -----------------------------------------------------------------------------
+
 void GSF_select(int x, int y, int wd, int ht)
 {
     if (wd < 1 || ht < 1) {
@@ -739,6 +1848,24 @@ bool GSF_setoption(const char* optname, int newval, int* oldval)
             DoAutoUpdate();
         }
 
+    } else if (strcmp(optname, "hashadapt") == 0) {
+        *oldval = lifealgo::getAdaptiveLoad();
+        if (*oldval != newval)
+            lifealgo::setAdaptiveLoad(newval ? 1 : 0);
+
+    } else if (strcmp(optname, "hashgc") == 0) {
+        *oldval = lifealgo::getGCBeforeResize();
+        if (*oldval != newval)
+            lifealgo::setGCBeforeResize(newval ? 1 : 0);
+
+    } else if (strcmp(optname, "hashload") == 0) {
+        // max load factor of the hash tables, in percent
+        *oldval = (int)(lifealgo::getMaxLoadFactor() * 100.0 + 0.5);
+        if (newval < (int)(MIN_LOAD_FACTOR * 100)) newval = (int)(MIN_LOAD_FACTOR * 100);
+        if (newval > (int)(MAX_LOAD_FACTOR * 100)) newval = (int)(MAX_LOAD_FACTOR * 100);
+        if (*oldval != newval)
+            lifealgo::setMaxLoadFactor(newval / 100.0);
+
     } else if (strcmp(optname, "hyperspeed") == 0) {
         *oldval = currlayer->hyperspeed ? 1 : 0;
         if (*oldval != newval)
@@ -1004,6 +2131,9 @@ bool GSF_getoption(const char* optname, int* optval)
     else if (strcmp(optname, "boldspacing") == 0)       *optval = boldspacing;
     else if (strcmp(optname, "drawingstate") == 0)      *optval = currlayer->drawingstate;
     else if (strcmp(optname, "fullscreen") == 0)        *optval = mainptr->fullscreen ? 1 : 0;
+    else if (strcmp(optname, "hashadapt") == 0)         *optval = lifealgo::getAdaptiveLoad();
+    else if (strcmp(optname, "hashgc") == 0)            *optval = lifealgo::getGCBeforeResize();
+    else if (strcmp(optname, "hashload") == 0)          *optval = (int)(lifealgo::getMaxLoadFactor() * 100.0 + 0.5);
     else if (strcmp(optname, "hyperspeed") == 0)        *optval = currlayer->hyperspeed ? 1 : 0;
     else if (strcmp(optname, "mindelay") == 0)          *optval = mindelay;
     else if (strcmp(optname, "maxdelay") == 0)          *optval = maxdelay;
@@ -2044,6 +3174,10 @@ void RunScript(const wxString& filename)
     } else {
         // already_inscript is false
 
+        // delete the universes kept by GSF_evolve so they don't use
+        // memory between scripts
+        FreeScratchUniverses();
+
         // tidy up the undo/redo history for each layer; note that some calls
         // use currlayer (eg. RememberGenFinish) so we temporarily set currlayer
         // to each layer -- this is a bit yukky but should be safe as long as we
@@ -5,6 +5,7 @@
 #define _WXSCRIPT_H_
 
 #include "lifealgo.h"   // for lifealgo class
+#include "wxalgos.h"    // for algo_type
 
 extern bool inscript;
 // Is a script currently running?  We allow access to this flag
@@ -97,7 +98,77 @@ const char* GSF_setcell(int x, int y, int newstate);
 const char* GSF_paste(int x, int y, const char* mode);
 const char* GSF_checkpos(lifealgo* algo, int x, int y);
 const char* GSF_checkrect(int x, int y, int wd, int ht);
+
+// A cell array packed into a block of ints: x,y pairs for a one-state array,
+// or x,y,state triples plus a padding 0 if needed for a multi-state array.
+// Scripts can pass packed arrays to putcells, getcells, evolve, etc so big
+// patterns don't need a Lua/Python integer for every coordinate and state.
+struct GSF_cells {
+    int* ints;          // allocated with malloc/realloc
+    int numints;        // number of ints in use (including any padding)
+    int maxints;        // number of ints allocated
+};
+
+void GSF_initcells(GSF_cells& cells);
+void GSF_freecells(GSF_cells& cells);
+bool GSF_reservecells(GSF_cells& cells, int numints);
+// The following routines append their results to the given cell array.
+// The aborted routine (if not NULL) is called now and then; if it returns
+// true then the GSF_* routine stops and returns abortmsg.
+const char* GSF_putcells(const int* ints, int numints, int x0, int y0,
+                         int axx, int axy, int ayx, int ayy, const char* mode,
+                         bool (*aborted)());
+const char* GSF_getcells(lifealgo* algo, int x, int y, int wd, int ht, bool shift,
+                         GSF_cells& cells, bool (*aborted)());
+const char* GSF_extractcells(lifealgo* algo, bool shift, GSF_cells& cells,
+                             bool (*aborted)());
+const char* GSF_transform(const int* ints, int numints, int x0, int y0,
+                          int axx, int axy, int ayx, int ayy, GSF_cells& cells);
+const char* GSF_join(const int* ints1, int numints1, const int* ints2, int numints2,
+                     GSF_cells& cells);
+const char* GSF_evolve(const int* ints, int numints, int ngens, bool checkevents,
+                       GSF_cells& cells, bool (*aborted)());
+
+// A pattern object is held by a universe that can edit whole subtrees (see
+// lifealgo::rectCapable), so scripts can combine, move, transform and evolve
+// big patterns a subtree at a time rather than a cell at a time.  Patterns
+// use the current algorithm if it can edit whole subtrees, otherwise HashLife
+// with the same rule; patterns with the same algorithm and rule share one
+// universe, so they share nodes.  Coordinates and generation counts can be
+// bigints.
+struct GSF_patternstore;
+struct GSF_pattern {
+    GSF_patternstore* store;    // NULL if not created yet or freed
+    int ticket;                 // the pattern's kept state in store's universe
+};
+
+// return the universe holding the given pattern, with that pattern as its
+// current pattern (valid until the next GSF_*pattern call)
+lifealgo* GSF_patternalgo(GSF_pattern& pat);
+// return the bytes used by all patterns, so scripts can tell their
+// garbage collectors about it
+size_t GSF_patternmemory();
+
+// convert a string like "-12345678901234567890" or "2^100" to a bigint
+const char* GSF_bigint(const char* s, bigint& value);
+void GSF_freepattern(GSF_pattern& pat);
+const char* GSF_newpattern(const int* ints, int numints, GSF_pattern& pat,
+                           bool (*aborted)());
+const char* GSF_copypattern(GSF_pattern& src, GSF_pattern& pat);
+// if wd is 0 then getpattern copies the entire current pattern
+const char* GSF_getpattern(int x, int y, int wd, int ht, GSF_pattern& pat,
+                           bool (*aborted)());
+const char* GSF_putpattern(GSF_pattern& pat, const bigint& x, const bigint& y,
+                           const char* mode, bool (*aborted)());
+// The following routines change the given pattern.
+const char* GSF_combinepattern(GSF_pattern& pat, GSF_pattern& other, const char* mode,
+                               bool (*aborted)());
+const char* GSF_transformpattern(GSF_pattern& pat, const bigint& x0, const bigint& y0,
+                                 int axx, int axy, int ayx, int ayy);
+const char* GSF_evolvepattern(GSF_pattern& pat, const bigint& ngens, bool (*aborted)());
+
 int GSF_hash(int x, int y, int wd, int ht);
+const char* GSF_oscar(int maxgens, int* period, int* dx, int* dy);
 bool GSF_setoption(const char* optname, int newval, int* oldval);
 bool GSF_getoption(const char* optname, int* optval);
 bool GSF_setcolor(const char* colname, wxColor& newcol, wxColor& oldcol);
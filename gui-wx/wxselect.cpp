@@ -313,6 +313,11 @@ bool Selection::SaveDifferences(lifealgo* oldalgo, lifealgo* newalgo,
     int cntr = 0;
     bool abort = false;
 
+    // it's much quicker to save copies of a big rectangle than to compare
+    // every cell (and the copies use less memory)
+    if (currlayer->undoredo->UseRegionChange(itop, ileft, ibottom, iright))
+        return currlayer->undoredo->SaveRegionChange(oldalgo, newalgo, itop, ileft, ibottom, iright);
+
     // compare patterns in given algos and call SaveCellChange for each different cell
     BeginProgress(_("Saving cell changes"));
     for ( cy=itop; cy<=ibottom; cy++ ) {
@@ -399,8 +404,11 @@ void Selection::Advance()
     if (selbottom < bottom) bottom = selbottom;
     if (selright < right) right = selright;
 
-    // check that intersection is within setcell/getcell limits
-    if ( viewptr->OutsideLimits(top, left, bottom, right) ) {
+    // hashing algorithms can copy the selection to and from a temporary universe
+    // a subtree at a time, so the intersection only needs to be within
+    // setcell/getcell limits if the cell changes must be saved
+    bool userect = currlayer->algo->rectCapable() != 0;
+    if ( (savecells || !userect) && viewptr->OutsideLimits(top, left, bottom, right) ) {
         statusptr->ErrorMessage(selection_too_big);
         return;
     }
@@ -411,8 +419,10 @@ void Selection::Advance()
         tempalgo->setrule(tempalgo->DefaultRule());
 
     // copy live cells in selection to temporary universe
-    if ( !viewptr->CopyRect(top.toint(), left.toint(), bottom.toint(), right.toint(),
-                            currlayer->algo, tempalgo, false, _("Saving selection")) ) {
+    if (userect) {
+        tempalgo->copyrect(currlayer->algo, top, left, bottom, right, 0);
+    } else if ( !viewptr->CopyRect(top.toint(), left.toint(), bottom.toint(), right.toint(),
+                                   currlayer->algo, tempalgo, false, _("Saving selection")) ) {
         delete tempalgo;
         return;
     }
@@ -466,8 +476,12 @@ void Selection::Advance()
     }
 
     // copy all cells in new selection from tempalgo to currlayer->algo
-    viewptr->CopyAllRect(top.toint(), left.toint(), bottom.toint(), right.toint(),
-                         tempalgo, currlayer->algo, _("Copying advanced selection"));
+    if (userect) {
+        currlayer->algo->copyrect(tempalgo, top, left, bottom, right, 1);
+    } else {
+        viewptr->CopyAllRect(top.toint(), left.toint(), bottom.toint(), right.toint(),
+                             tempalgo, currlayer->algo, _("Copying advanced selection"));
+    }
 
     delete tempalgo;
     MarkLayerDirty();
@@ -531,8 +545,11 @@ void Selection::AdvanceOutside()
         return;
     }
 
-    // check that pattern is within setcell/getcell limits
-    if ( viewptr->OutsideLimits(top, left, bottom, right) ) {
+    // hashing algorithms can split and merge the pattern a subtree at a time,
+    // so the pattern only needs to be within setcell/getcell limits if the
+    // cell changes must be saved
+    bool userect = currlayer->algo->rectCapable() != 0;
+    if ( (savecells || !userect) && viewptr->OutsideLimits(top, left, bottom, right) ) {
         statusptr->ErrorMessage(_("Pattern is outside +/- 10^9 boundary."));
         return;
     }
@@ -563,9 +580,12 @@ void Selection::AdvanceOutside()
     int iselleft   = selleft.toint();
     int iselbottom = selbottom.toint();
     int iselright  = selright.toint();
-    if ( !viewptr->CopyRect(iseltop, iselleft, iselbottom, iselright,
-                            currlayer->algo, newalgo, true,
-                            _("Saving and erasing selection")) ) {
+    if (userect) {
+        newalgo->copyrect(currlayer->algo, seltop, selleft, selbottom, selright, 0);
+        currlayer->algo->clearrect(seltop, selleft, selbottom, selright);
+    } else if ( !viewptr->CopyRect(iseltop, iselleft, iselbottom, iselright,
+                                   currlayer->algo, newalgo, true,
+                                   _("Saving and erasing selection")) ) {
         // aborted, so best to restore selection
         if ( !newalgo->isEmpty() ) {
             newalgo->findedges(&top, &left, &bottom, &right);
@@ -588,7 +608,17 @@ void Selection::AdvanceOutside()
     if (boundedgrid) currlayer->algo->DeleteBorderCells();
     mainptr->generating = false;
 
-    if ( !currlayer->algo->isEmpty() ) {
+    if ( userect ) {
+        // kill any cells born in the selection and add the rest of the
+        // advanced pattern to the new universe (which holds the original
+        // selection) a subtree at a time
+        currlayer->algo->clearrect(seltop, selleft, selbottom, selright);
+        if ( !currlayer->algo->isEmpty() ) {
+            bigint t, l, b, r;
+            currlayer->algo->findedges(&t, &l, &b, &r);
+            newalgo->copyrect(currlayer->algo, t, l, b, r, 0);
+        }
+    } else if ( !currlayer->algo->isEmpty() ) {
         // find new edges and copy current pattern to new universe,
         // except for any cells that were created in selection
         // (newalgo contains the original selection)
@@ -645,6 +675,7 @@ void Selection::AdvanceOutside()
         if (abort && savecells) {
             // revert back to pattern saved in oldalgo
             delete newalgo;
+            SaveKeptPatterns();
             delete currlayer->algo;
             currlayer->algo = oldalgo;
             mainptr->SetGenIncrement();
@@ -654,6 +685,7 @@ void Selection::AdvanceOutside()
     }
 
     // switch to new universe (best to do this even if aborted)
+    SaveKeptPatterns();
     delete currlayer->algo;
     currlayer->algo = newalgo;
     mainptr->SetGenIncrement();
@@ -1127,8 +1159,24 @@ void Selection::Clear()
     int v = 0;
     bool abort = false;
     bool selchanged = false;
-    BeginProgress(_("Clearing selection"));
     lifealgo* curralgo = currlayer->algo;
+
+    // for a big selection save the cells in it rather than each cell change
+    bool saveregion = savecells &&
+                      currlayer->undoredo->UseRegionChange(itop, ileft, ibottom, iright);
+    if (saveregion) {
+        if (!currlayer->undoredo->SaveRegionChange(curralgo, NULL, itop, ileft, ibottom, iright))
+            return;
+        // hashing algorithms can clear whole subtrees at once
+        if (curralgo->clearrect(top, left, bottom, right)) {
+            currlayer->undoredo->RememberCellChanges(_("Clear"), currlayer->dirty);
+            MarkLayerDirty();
+            mainptr->UpdatePatternAndStatus();
+            return;
+        }
+    }
+
+    BeginProgress(_("Clearing selection"));
     for ( cy=itop; cy<=ibottom; cy++ ) {
         for ( cx=ileft; cx<=iright; cx++ ) {
             int skip = curralgo->nextcell(cx, cy, v);
@@ -1139,7 +1187,7 @@ void Selection::Clear()
                 cx += skip;
                 curralgo->setcell(cx, cy, 0);
                 selchanged = true;
-                if (savecells) currlayer->undoredo->SaveCellChange(cx, cy, v, 0);
+                if (savecells && !saveregion) currlayer->undoredo->SaveCellChange(cx, cy, v, 0);
             } else {
                 cx = iright + 1;     // done this row
             }
@@ -1160,6 +1208,8 @@ void Selection::Clear()
         if (savecells) currlayer->undoredo->RememberCellChanges(_("Clear"), currlayer->dirty);
         MarkLayerDirty();
         mainptr->UpdatePatternAndStatus();
+    } else if (saveregion) {
+        currlayer->undoredo->ForgetCellChanges();
     }
 }
 
@@ -1260,8 +1310,17 @@ void Selection::ClearOutside()
     if (savecells && inscript) SavePendingChanges();
 
     if (savecells) {
-        // save live cells outside selection
-        if ( !SaveOutside(top, left, bottom, right) ) {
+        if ( !viewptr->OutsideLimits(top, left, bottom, right) &&
+             currlayer->undoredo->UseRegionChange(top.toint(), left.toint(),
+                                                  bottom.toint(), right.toint()) ) {
+            // save the pattern's bounding box rather than each live cell outside selection
+            if ( !currlayer->undoredo->SaveRegionChange(currlayer->algo, NULL,
+                                                        top.toint(), left.toint(),
+                                                        bottom.toint(), right.toint()) ) {
+                return;
+            }
+        } else if ( !SaveOutside(top, left, bottom, right) ) {
+            // save live cells outside selection
             return;
         }
     } else {
@@ -1297,6 +1356,7 @@ void Selection::ClearOutside()
     if ( viewptr->CopyRect(top.toint(), left.toint(), bottom.toint(), right.toint(),
                            currlayer->algo, newalgo, false, _("Saving selection")) ) {
         // delete old universe and point currlayer->algo at new universe
+        SaveKeptPatterns();
         delete currlayer->algo;
         currlayer->algo = newalgo;
         mainptr->SetGenIncrement();
@@ -1436,6 +1496,16 @@ void Selection::CopyToClipboard(bool cut)
     double maxcount = (double)wd * (double)ht;
     int cntr = 0;
     bool abort = false;
+
+    // for a big selection save the cells in it rather than each cell change
+    bool saveregion = cut && savecells &&
+                      currlayer->undoredo->UseRegionChange(itop, ileft, ibottom, iright);
+    if (saveregion && !currlayer->undoredo->SaveRegionChange(currlayer->algo, NULL,
+                                                             itop, ileft, ibottom, iright)) {
+        free(textptr);
+        return;
+    }
+
     if (cut)
         BeginProgress(_("Cutting selection"));
     else
@@ -1468,7 +1538,7 @@ void Selection::CopyToClipboard(bool cut)
                 livecount++;
                 if (cut) {
                     curralgo->setcell(cx, cy, 0);
-                    if (savecells) currlayer->undoredo->SaveCellChange(cx, cy, v, 0);
+                    if (savecells && !saveregion) currlayer->undoredo->SaveCellChange(cx, cy, v, 0);
                 }
                 if (laststate == v) {
                     orun++;
@@ -1543,6 +1613,8 @@ void Selection::CopyToClipboard(bool cut)
         // update currlayer->dirty AFTER RememberCellChanges
         MarkLayerDirty();
         mainptr->UpdatePatternAndStatus();
+    } else if (saveregion) {
+        currlayer->undoredo->ForgetCellChanges();
     }
 
     wxString text = wxString(textptr,wxConvLocal);
@@ -1567,11 +1639,108 @@ bool Selection::CanPaste(const bigint& wd, const bigint& ht, bigint& top, bigint
 
 // -----------------------------------------------------------------------------
 
-void Selection::RandomFill()
+// a small fast generator (xorshift64*) so a random fill can be redone
+// from its seed and only needs one call for every 64 cells
+
+static unsigned long long NextRandom(unsigned long long& s)
+{
+    s ^= s >> 12;
+    s ^= s << 25;
+    s ^= s >> 27;
+    return s * 2685821657736338717ULL;
+}
+
+// -----------------------------------------------------------------------------
+
+static unsigned long long RandomBits(unsigned long long& s, int percentage)
+{
+    // return 64 random bits, each set with the given probability; each bit
+    // of the density (as a 16-bit fraction, least significant first) either
+    // ORs or ANDs in another random word, which halves the probability so
+    // far and then adds 1/2 if the bit is set
+    unsigned int p = (percentage * 65536 + 50) / 100;
+    if (p >= 65536) return ~0ULL;
+    unsigned long long r = 0;
+    int i = 0;
+    while (((p >> i) & 1) == 0) i++;
+    for ( ; i < 16; i++) {
+        if ((p >> i) & 1)
+            r |= NextRandom(s);
+        else
+            r &= NextRandom(s);
+    }
+    return r;
+}
+
+// -----------------------------------------------------------------------------
+
+bool Selection::RandomFillRect(lifealgo* algo, int percentage, unsigned int seed)
+{
+    int itop = seltop.toint();
+    int ileft = selleft.toint();
+    int ibottom = selbottom.toint();
+    int iright = selright.toint();
+    int wd = iright - ileft + 1;
+    int ht = ibottom - itop + 1;
+    int livestates = algo->NumRandomizedCellStates() - 1;    // don't count dead state
+
+    // fill a band of rows at a time so the buffer stays small
+    int bandht = (4 << 20) / wd;
+    if (bandht < 1) bandht = 1;
+    if (bandht > ht) bandht = ht;
+    unsigned char* cells = (unsigned char*) malloc((size_t)wd * bandht);
+    if (cells == NULL) {
+        Warning(_("Not enough memory for random fill!"));
+        return false;
+    }
+
+    // the generator's state must never be 0
+    unsigned long long s = ((unsigned long long)seed << 32) ^ 0x9E3779B97F4A7C15ULL;
+    bool abort = false;
+    BeginProgress(_("Randomly filling selection"));
+    for (int cy = itop; cy <= ibottom; cy += bandht) {
+        int rows = ibottom - cy + 1 < bandht ? ibottom - cy + 1 : bandht;
+        size_t count = (size_t)wd * rows;
+        for (size_t i = 0; i < count; i += 64) {
+            unsigned long long bits = RandomBits(s, percentage);
+            size_t n = count - i < 64 ? count - i : 64;
+            for (size_t k = 0; k < n; k++)
+                cells[i + k] = (unsigned char)((bits >> k) & 1);
+        }
+        if (livestates >= 2) {
+            // pick each live cell's state from 16 random bits
+            unsigned long long r = 0;
+            int unused = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (cells[i]) {
+                    if (unused == 0) {
+                        r = NextRandom(s);
+                        unused = 4;
+                    }
+                    cells[i] = (unsigned char)(1 + (((r & 0xFFFF) * livestates) >> 16));
+                    r >>= 16;
+                    unused--;
+                }
+            }
+        }
+        algo->setcells(cells, ileft, cy, wd, rows);
+        abort = AbortProgress((double)(cy + rows - itop) / (double)ht, wxEmptyString);
+        if (abort) break;
+    }
+    algo->endofpattern();
+    EndProgress();
+    free(cells);
+
+    return !abort;
+}
+
+// -----------------------------------------------------------------------------
+
+void Selection::RandomFill(bool useseed, unsigned int seed)
 {
     if (!exists) return;
 
-    // can only use getcell/setcell in limited domain
+    // can only use setcells in limited domain
     if (TooBig()) {
         statusptr->ErrorMessage(selection_too_big);
         return;
@@ -1588,82 +1757,41 @@ void Selection::RandomFill()
     bool savecells = allowundo && !currlayer->stayclean;
     if (savecells && inscript) SavePendingChanges();
 
-    // no need to kill cells if selection is empty
-    bool killcells = !currlayer->algo->isEmpty();
-    if ( killcells ) {
-        // find pattern edges and compare with selection edges
-        bigint top, left, bottom, right;
-        currlayer->algo->findedges(&top, &left, &bottom, &right);
-        if (Contains(top, left, bottom, right)) {
-            // selection encloses entire pattern so create empty universe
-            if (savecells) {
-                // don't kill pattern otherwise we can't use SaveCellChange below
-            } else {
-                EmptyUniverse();
-                killcells = false;
-            }
-        } else if (Outside(top, left, bottom, right)) {
-            // selection is completely outside pattern edges
-            killcells = false;
-        }
-    }
+    if (!useseed) seed = ((unsigned int)rand() << 16) ^ (unsigned int)rand();
 
     int itop = seltop.toint();
     int ileft = selleft.toint();
     int ibottom = selbottom.toint();
     int iright = selright.toint();
-    int wd = iright - ileft + 1;
-    int ht = ibottom - itop + 1;
-    double maxcount = (double)wd * (double)ht;
-    int cntr = 0;
-    bool abort = false;
-    BeginProgress(_("Randomly filling selection"));
-    int cx, cy;
-    lifealgo* curralgo = currlayer->algo;
-    int livestates = curralgo->NumRandomizedCellStates() - 1;    // don't count dead state
 
-    for ( cy=itop; cy<=ibottom; cy++ ) {
-        for ( cx=ileft; cx<=iright; cx++ ) {
-            // randomfill is from 1..100
-            if (savecells) {
-                // remember cell change only if state changes
-                int oldstate = curralgo->getcell(cx, cy);
-                if ((rand() % 100) < randomfill) {
-                    int newstate = livestates < 2 ? 1 : 1 + (rand() % livestates);
-                    if (oldstate != newstate) {
-                        curralgo->setcell(cx, cy, newstate);
-                        currlayer->undoredo->SaveCellChange(cx, cy, oldstate, newstate);
-                    }
-                } else if (killcells && oldstate > 0) {
-                    curralgo->setcell(cx, cy, 0);
-                    currlayer->undoredo->SaveCellChange(cx, cy, oldstate, 0);
-                }
-            } else {
-                if ((rand() % 100) < randomfill) {
-                    if (livestates < 2) {
-                        curralgo->setcell(cx, cy, 1);
-                    } else {
-                        curralgo->setcell(cx, cy, 1 + (rand() % livestates));
-                    }
-                } else if (killcells) {
-                    curralgo->setcell(cx, cy, 0);
-                }
-            }
-            cntr++;
-            if ((cntr % 4096) == 0) {
-                abort = AbortProgress((double)cntr / maxcount, wxEmptyString);
-                if (abort) break;
-            }
+    // rather than remember every changed cell, undo keeps a copy of the
+    // cells that were in the selection and redo repeats the seeded fill
+    lifealgo* oldcells = NULL;
+    if (savecells) {
+        oldcells = CreateNewUniverse(currlayer->algtype);
+        if (oldcells->setrule(currlayer->algo->getrule()))
+            oldcells->setrule(oldcells->DefaultRule());
+        if ( !viewptr->CopyRect(itop, ileft, ibottom, iright, currlayer->algo, oldcells,
+                                false, _("Saving selection")) ) {
+            delete oldcells;
+            return;
         }
-        if (abort) break;
     }
 
-    currlayer->algo->endofpattern();
-    EndProgress();
+    if ( !RandomFillRect(currlayer->algo, randomfill, seed) && savecells ) {
+        // user aborted so put back the old cells
+        viewptr->CopyAllRect(itop, ileft, ibottom, iright, oldcells, currlayer->algo,
+                             _("Restoring selection"));
+        delete oldcells;
+        mainptr->UpdatePatternAndStatus();
+        return;
+    }
 
-    if (savecells) currlayer->undoredo->RememberCellChanges(_("Random Fill"), currlayer->dirty);
+    if (savecells)
+        currlayer->undoredo->RememberRandomFill(*this, oldcells, seed, randomfill,
+                                                currlayer->dirty);
 
-    // update currlayer->dirty AFTER RememberCellChanges
+    // update currlayer->dirty AFTER RememberRandomFill
     MarkLayerDirty();
     mainptr->UpdatePatternAndStatus();
 }
@@ -1749,6 +1877,19 @@ bool Selection::Flip(bool topbottom, bool inundoredo)
 
     if (currlayer->algo->isEmpty()) return true;
 
+    if (currlayer->algo->rectCapable()) {
+        // hashing algorithms can flip the selection in place, whatever its size
+        currlayer->algo->transformrect(topbottom ? lifealgo::FLIP_TOP_BOTTOM : lifealgo::FLIP_LEFT_RIGHT,
+                                       seltop, selleft, selbottom, selright, seltop, selleft);
+        if (allowundo && !currlayer->stayclean && !inundoredo) {
+            if (inscript) SavePendingChanges();
+            currlayer->undoredo->RememberFlip(topbottom, currlayer->dirty);
+        }
+        if (!inundoredo) MarkLayerDirty();
+        mainptr->UpdatePatternAndStatus();
+        return true;
+    }
+
     bigint top, left, bottom, right;
     currlayer->algo->findedges(&top, &left, &bottom, &right);
 
@@ -1814,6 +1955,7 @@ bool Selection::Flip(bool topbottom, bool inundoredo)
 
         if ( FlipRect(topbottom, currlayer->algo, newalgo, false, itop, ileft, ibottom, iright) ) {
             // switch to newalgo
+            SaveKeptPatterns();
             delete currlayer->algo;
             currlayer->algo = newalgo;
             mainptr->SetGenIncrement();
@@ -1932,6 +2074,25 @@ bool Selection::RotatePattern(bool clockwise,
                               bigint& newleft, bigint& newright,
                               bool inundoredo)
 {
+    if (currlayer->algo->rectCapable()) {
+        // hashing algorithms rotate just the selection in place, so in this case
+        // the selection needn't enclose the entire pattern (see Rotate)
+        currlayer->algo->transformrect(clockwise ? lifealgo::ROTATE_CW : lifealgo::ROTATE_ACW,
+                                       seltop, selleft, selbottom, selright, newtop, newleft);
+        seltop    = newtop;
+        selbottom = newbottom;
+        selleft   = newleft;
+        selright  = newright;
+        viewptr->DisplaySelectionSize();
+        if (allowundo && !currlayer->stayclean && !inundoredo) {
+            if (inscript) SavePendingChanges();
+            currlayer->undoredo->RememberRotation(clockwise, currlayer->dirty);
+        }
+        if (!inundoredo) MarkLayerDirty();
+        mainptr->UpdatePatternAndStatus();
+        return true;
+    }
+
     // create new universe of same type as current universe
     lifealgo* newalgo = CreateNewUniverse(currlayer->algtype);
     if (newalgo->setrule(currlayer->algo->getrule()))
@@ -2007,6 +2168,7 @@ bool Selection::RotatePattern(bool clockwise,
         selright  = newright;
 
         // switch to new universe and display results
+        SaveKeptPatterns();
         delete currlayer->algo;
         currlayer->algo = newalgo;
         mainptr->SetGenIncrement();
@@ -2091,6 +2253,17 @@ bool Selection::Rotate(bool clockwise, bool inundoredo)
         return true;
     }
 
+    // save cell changes if undo/redo is enabled and script isn't constructing a pattern
+    // and we're not undoing/redoing an earlier rotation
+    bool savecells = allowundo && !currlayer->stayclean && !inundoredo;
+
+    // hashing algorithms can rotate a selection of any size in place, but if it
+    // only encloses part of the pattern then undo needs the changed cells
+    bool wholepattern = Contains(top, left, bottom, right);
+    if (currlayer->algo->rectCapable() && (wholepattern || !savecells)) {
+        return RotatePattern(clockwise, newtop, newbottom, newleft, newright, inundoredo);
+    }
+
     // can only use nextcell/getcell/setcell in limited domain
     if (TooBig()) {
         statusptr->ErrorMessage(selection_too_big);
@@ -2103,8 +2276,40 @@ bool Selection::Rotate(bool clockwise, bool inundoredo)
         return false;
     }
 
+    // hashing algorithms can also rotate part of the pattern in place if undo
+    // saves a compact copy of the union of the old and new selection rects
+    int otop    = seltop.toint();
+    int oleft   = selleft.toint();
+    int obottom = selbottom.toint();
+    int oright  = selright.toint();
+    if (otop > newtop.toint()) otop = newtop.toint();
+    if (oleft > newleft.toint()) oleft = newleft.toint();
+    if (obottom < newbottom.toint()) obottom = newbottom.toint();
+    if (oright < newright.toint()) oright = newright.toint();
+    if (currlayer->algo->rectCapable() && !wholepattern &&
+        currlayer->undoredo->UseRegionChange(otop, oleft, obottom, oright)) {
+        Selection oldsel(seltop.toint(), selleft.toint(), selbottom.toint(), selright.toint());
+        Selection newsel(newtop.toint(), newleft.toint(), newbottom.toint(), newright.toint());
+        if (inscript) SavePendingChanges();
+        if ( !currlayer->undoredo->SaveRegionChange(currlayer->algo, NULL,
+                                                    otop, oleft, obottom, oright) ) {
+            return false;
+        }
+        currlayer->algo->transformrect(clockwise ? lifealgo::ROTATE_CW : lifealgo::ROTATE_ACW,
+                                       seltop, selleft, selbottom, selright, newtop, newleft);
+        seltop    = newtop;
+        selbottom = newbottom;
+        selleft   = newleft;
+        selright  = newright;
+        currlayer->undoredo->RememberRotation(clockwise, oldsel, newsel, currlayer->dirty);
+        viewptr->DisplaySelectionSize();
+        MarkLayerDirty();
+        mainptr->UpdatePatternAndStatus();
+        return true;
+    }
+    
     // use faster method if selection encloses entire pattern
-    if (Contains(top, left, bottom, right)) {
+    if (wholepattern) {
         return RotatePattern(clockwise, newtop, newbottom, newleft, newright, inundoredo);
     }
 
@@ -2118,16 +2323,13 @@ bool Selection::Rotate(bool clockwise, bool inundoredo)
     int nbottom = newbottom.toint();
     int nright  = newright.toint();
 
-    // save cell changes if undo/redo is enabled and script isn't constructing a pattern
-    // and we're not undoing/redoing an earlier rotation
-    bool savecells = allowundo && !currlayer->stayclean && !inundoredo;
     if (savecells && inscript) SavePendingChanges();
 
     lifealgo* oldalgo = NULL;
-    int otop = itop;
-    int oleft = ileft;
-    int obottom = ibottom;
-    int oright = iright;
+    otop = itop;
+    oleft = ileft;
+    obottom = ibottom;
+    oright = iright;
 
     if (savecells) {
         // copy current pattern to oldalgo using union of old and new selection rects
@@ -2190,7 +2392,7 @@ bool Selection::Rotate(bool clockwise, bool inundoredo)
         viewptr->CopyRect(ntop, nleft, nbottom, nright,
                           tempalgo, currlayer->algo, false, _("Adding rotated selection"));
     } else {
-        // have to use slow getcell calls
+        // have to kill the cells already in the new selection rect
         viewptr->CopyAllRect(ntop, nleft, nbottom, nright,
                              tempalgo, currlayer->algo, _("Pasting rotated selection"));
     }
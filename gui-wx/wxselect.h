@@ -95,8 +95,13 @@ public:
     // return true if the selection fits inside a rectangle of size ht x wd;
     // if so then top and left are set to the selection's top left corner
     
-    void RandomFill();
-    // randomly fill the selection
+    void RandomFill(bool useseed = false, unsigned int seed = 0);
+    // randomly fill the selection; the same seed always gives the same
+    // fill (for a given selection, percentage and rule)
+    
+    bool RandomFillRect(lifealgo* algo, int percentage, unsigned int seed);
+    // replace all the cells in the selection by a random fill with the
+    // given density; return false only if user aborts lengthy fill
     
     bool Flip(bool topbottom, bool inundoredo);
     // return true if selection was successfully flipped
@@ -343,7 +343,7 @@ void TimelineBar::DrawTimelineBar(wxDC& dc, int wd, int ht)
     dc.DrawLine(0, 0, r.width, 0);
     dc.SetPen(wxNullPen);
     
-    if (currlayer->algo->hyperCapable()) {
+    if (currlayer->algo->timelineCapable()) {
         bool canplay = TimelineExists() && !currlayer->algo->isrecording();
         tlbutt[RECORD_BUTT]->Show(true);
         tlbutt[BACKWARDS_BUTT]->Show(canplay);
@@ -823,7 +823,7 @@ void UpdateTimelineBar()
         // may need to change bitmaps in some buttons
         tbarptr->UpdateButtons();
         
-        tbarptr->EnableButton(RECORD_BUTT, active && currlayer->algo->hyperCapable());
+        tbarptr->EnableButton(RECORD_BUTT, active && currlayer->algo->timelineCapable());
         
         // note that slider, scroll bar and some buttons are only shown if there is
         // a timeline and we're not recording (see DrawTimelineBar)
@@ -885,7 +885,7 @@ void ToggleTimelineBar()
 
 void StartStopRecording()
 {
-    if (!inscript && currlayer->algo->hyperCapable()) {
+    if (!inscript && currlayer->algo->timelineCapable()) {
         if (currlayer->algo->isrecording()) {
             mainptr->Stop();
             // StopGenerating() has called currlayer->algo->stoprecording()
@@ -900,14 +900,6 @@ void StartStopRecording()
             
             if (!showtimeline) ToggleTimelineBar();
             
-            if (currlayer->algo->getframecount() == MAX_FRAME_COUNT) {
-                wxString msg;
-                msg.Printf(_("The timeline can't be extended any further (max frames = %d)."),
-                           MAX_FRAME_COUNT);
-                statusptr->ErrorMessage(msg);
-                return;
-            }
-            
             // record a new timeline, or extend the existing one
             if (currlayer->algo->startrecording(currlayer->currbase, currlayer->currexpo) > 0) {
                 if (currlayer->algo->getGeneration() == currlayer->startgen) {
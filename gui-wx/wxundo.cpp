@@ -8,9 +8,12 @@
 
 #include "wx/filename.h"   // for wxFileName
 
+#include <algorithm>       // for std::find
+
 #include "bigint.h"
 #include "lifealgo.h"
 #include "writepattern.h"  // for MC_format, XRLE_format
+#include "readpattern.h"   // for readpattern
 
 #include "wxgolly.h"       // for mainptr, viewptr
 #include "wxmain.h"        // for mainptr->...
@@ -18,7 +21,7 @@
 #include "wxview.h"        // for viewptr->...
 #include "wxutils.h"       // for Warning, Fatal
 #include "wxscript.h"      // for inscript
-#include "wxalgos.h"       // for algo_type
+#include "wxalgos.h"       // for algo_type, CreateNewUniverse
 #include "wxlayer.h"       // for currlayer, numclones, MarkLayerDirty, etc
 #include "wxprefs.h"       // for allowundo, GetAccelerator, etc
 #include "wxundo.h"
@@ -38,6 +41,247 @@ const wxString dupe3_prefix = wxT("g3_");
 const wxString dupe4_prefix = wxT("g4_");
 const wxString dupe5_prefix = wxT("g5_");
 const wxString dupe6_prefix = wxT("g6_");
+const wxString region_prefix = wxT("gu_");
+
+// -----------------------------------------------------------------------------
+
+// patterns that are being kept in memory rather than in temporary files
+
+typedef struct {
+    wxString path;      // the file this pattern would be saved in
+    int ticket;         // returned by lifealgo::keepstate
+    bigint gen;         // the pattern's generation count
+} kept_pattern;
+
+static std::vector<kept_pattern> keptpatterns;
+
+static int FindKeptPattern(const wxString& path)
+{
+    for (size_t i = 0; i < keptpatterns.size(); i++) {
+        if (keptpatterns[i].path == path) return (int)i;
+    }
+    return -1;
+}
+
+// -----------------------------------------------------------------------------
+
+bool KeepPattern(const wxString& path)
+{
+    ForgetKeptPattern(path);
+    if (!currlayer->algo->hyperCapable()) return false;
+    
+    int ticket = currlayer->algo->keepstate();
+    if (ticket == 0) {
+        // make room for patterns kept from now on
+        SpillKeptPatterns(true);
+        return false;
+    }
+    
+    kept_pattern kp;
+    kp.path = path;
+    kp.ticket = ticket;
+    kp.gen = currlayer->algo->getGeneration();
+    keptpatterns.push_back(kp);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+bool RestoreKeptPattern(const wxString& path)
+{
+    int i = FindKeptPattern(path);
+    if (i < 0 || !currlayer->algo->restorestate(keptpatterns[i].ticket)) return false;
+    currlayer->algo->setGeneration(keptpatterns[i].gen);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void ForgetKeptPattern(const wxString& path)
+{
+    int i = FindKeptPattern(path);
+    if (i >= 0) {
+        lifealgo::forgetstate(keptpatterns[i].ticket);
+        keptpatterns.erase(keptpatterns.begin() + i);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+static void WriteKeptPatterns(int count)
+{
+    // write the oldest count patterns kept by the current universe to their files
+    lifealgo* algo = currlayer->algo;
+    void* currstate = NULL;
+    bigint currgen;
+    size_t i = 0;
+    while (i < keptpatterns.size() && count > 0) {
+        kept_pattern& kp = keptpatterns[i];
+        if (!algo->ownsstate(kp.ticket)) {
+            i++;
+            continue;
+        }
+        count--;
+        if (currstate == NULL) {
+            currstate = algo->getcurrentstate();
+            currgen = algo->getGeneration();
+        }
+        // temporarily switch to the kept pattern and save it in a macrocell file
+        algo->restorestate(kp.ticket);
+        algo->setGeneration(kp.gen);
+        const char* err = mainptr->WritePattern(kp.path, MC_format, no_compression, 0, 0, 0, 0);
+        if (err) Warning(wxString(err,wxConvLocal));
+        lifealgo::forgetstate(kp.ticket);
+        keptpatterns.erase(keptpatterns.begin() + i);
+    }
+    if (currstate) {
+        algo->setcurrentstate(currstate);
+        algo->setGeneration(currgen);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void SaveKeptPatterns()
+{
+    WriteKeptPatterns((int)keptpatterns.size());
+}
+
+// -----------------------------------------------------------------------------
+
+void SpillKeptPatterns(bool force)
+{
+    if (!currlayer->algo->keptstatesoverbudget() && !force) return;
+    
+    // write the older half of the current universe's kept patterns to their
+    // files so the next gc can free the nodes only they were using
+    int owned = 0;
+    for (size_t i = 0; i < keptpatterns.size(); i++) {
+        if (currlayer->algo->ownsstate(keptpatterns[i].ticket)) owned++;
+    }
+    if (owned > 0) WriteKeptPatterns((owned + 1) / 2);
+}
+
+// -----------------------------------------------------------------------------
+
+// Region changes save the cells in the changed rectangle in universes of
+// their own.  All these copies together are kept within max_region_mem;
+// once they go over it the least recently used ones are written to
+// temporary files (macrocell files for hash-based algorithms, XRLE files
+// otherwise) and only read back when an undo or redo needs them.
+
+const g_uintptr_t max_region_mem = (g_uintptr_t)256 << 20;
+
+#ifdef __WXMAC__
+    // convert path to decomposed UTF8 so fopen will work
+    #define FILEPATH path.fn_str()
+#else
+    #define FILEPATH path.mb_str(wxConvLocal)
+#endif
+
+class RegionCopy {
+public:
+    RegionCopy(lifealgo* cells, algo_type algotype, int top, int left, int bottom, int right);
+    ~RegionCopy();
+    
+    lifealgo* GetCells();
+    // return the saved cells, reading them back from their file if
+    // necessary; return NULL if the file couldn't be read
+    
+    bool Spill();
+    // write the cells to a temporary file (unless that was done before)
+    // and delete their universe; return false if the file couldn't be written
+    
+    g_uintptr_t MemoryUsed() { return cells ? cells->getMemoryUsed() : 0; }
+    
+private:
+    lifealgo* cells;            // NULL if the cells are only in the file
+    algo_type algotype;         // algorithm used by cells
+    int top, left, bottom, right;   // edges of the region
+    wxString path;              // temporary file, or empty if not written yet
+};
+
+static std::vector<RegionCopy*> regioncopies;   // in memory, least recently used first
+
+static void LimitRegionMemory(RegionCopy* keep)
+{
+    // spill the least recently used region copies (other than keep)
+    // until the ones left in memory fit within max_region_mem
+    g_uintptr_t total = 0;
+    for (size_t i = 0; i < regioncopies.size(); i++) total += regioncopies[i]->MemoryUsed();
+    size_t i = 0;
+    while (total > max_region_mem && i < regioncopies.size()) {
+        RegionCopy* r = regioncopies[i];
+        g_uintptr_t used = r->MemoryUsed();
+        if (r != keep && r->Spill()) {
+            // Spill removed r from regioncopies
+            total -= used;
+        } else {
+            i++;
+        }
+    }
+}
+
+RegionCopy::RegionCopy(lifealgo* cells, algo_type algotype,
+                       int top, int left, int bottom, int right)
+    : cells(cells), algotype(algotype), top(top), left(left), bottom(bottom), right(right)
+{
+    regioncopies.push_back(this);
+    LimitRegionMemory(this);
+}
+
+RegionCopy::~RegionCopy()
+{
+    if (cells) {
+        delete cells;
+        regioncopies.erase(std::find(regioncopies.begin(), regioncopies.end(), this));
+    }
+    if (!path.IsEmpty() && wxFileExists(path)) wxRemoveFile(path);
+}
+
+lifealgo* RegionCopy::GetCells()
+{
+    if (cells) {
+        // now the most recently used copy
+        regioncopies.erase(std::find(regioncopies.begin(), regioncopies.end(), this));
+        regioncopies.push_back(this);
+        return cells;
+    }
+    
+    lifealgo* newcells = CreateNewUniverse(algotype);
+    // readpattern will call setrule
+    const char* err = readpattern(FILEPATH, *newcells);
+    if (err) {
+        Warning(wxString(err,wxConvLocal));
+        delete newcells;
+        return NULL;
+    }
+    cells = newcells;
+    regioncopies.push_back(this);
+    LimitRegionMemory(this);
+    return cells;
+}
+
+bool RegionCopy::Spill()
+{
+    if (cells == NULL) return true;
+    if (path.IsEmpty()) {
+        // the cells never change, so once written the file can be reused
+        path = wxFileName::CreateTempFileName(tempdir + region_prefix);
+        pattern_format format = cells->hyperCapable() ? MC_format : XRLE_format;
+        const char* err = writepattern(FILEPATH, *cells, format,
+                                       no_compression, top, left, bottom, right);
+        if (err) {
+            if (wxFileExists(path)) wxRemoveFile(path);
+            path = wxEmptyString;
+            return false;
+        }
+    }
+    delete cells;
+    cells = NULL;
+    regioncopies.erase(std::find(regioncopies.begin(), regioncopies.end(), this));
+    return true;
+}
 
 // -----------------------------------------------------------------------------
 
@@ -188,6 +432,7 @@ typedef enum {
     rotateacw,           // selection was rotated anticlockwise
     rotatepattcw,        // pattern was rotated clockwise
     rotatepattacw,       // pattern was rotated anticlockwise
+    randfill,            // selection was randomly filled
     namechange,          // layer name was changed
     scriptstart,         // later changes were made by script
     scriptfinish,        // earlier changes were made by script
@@ -215,6 +460,13 @@ public:
     void ChangeCells(bool undo);
     // change cell states using cellinfo
     
+    void RestoreRegion(RegionCopy* region);
+    // copy all the cells in the region from the given copy
+    
+    bool FillCells(bool undo);
+    // restore the selection's old cells or repeat the random fill;
+    // return false if user aborts a lengthy fill
+    
     change_type changeid;                   // specifies the type of change
     wxString suffix;                        // action string for Undo/Redo item
     bool olddirty;                          // layer's dirty state before change
@@ -227,6 +479,17 @@ public:
     // rotatecw/rotateacw/selchange info
     Selection oldsel, newsel;               // old and new selections
     
+    // region info (for cellstates/rotatecw/rotateacw/randfill)
+    RegionCopy* oldcells;                   // region's cells before the change
+    RegionCopy* newcells;                   // region's cells after the change
+    int regtop, regleft, regbottom, regright;   // region's edges
+    // also uses oldalgo
+    
+    // randfill info
+    unsigned int fillseed;                  // seed used for the fill
+    int fillperc;                           // density used for the fill
+    // also uses oldsel and region info
+    
     // genchange info
     bool scriptgen;                         // gen change was done by script?
     wxString oldfile, newfile;              // old and new pattern files
@@ -272,6 +535,8 @@ ChangeNode::ChangeNode(change_type id)
     whichlayer = NULL;      // simplifies UndoRedo::DeletingClone
     cellinfo = NULL;
     cellcount = 0;
+    oldcells = NULL;
+    newcells = NULL;
     oldfile = wxEmptyString;
     newfile = wxEmptyString;
     oldtempstart = wxEmptyString;
@@ -288,15 +553,19 @@ ChangeNode::~ChangeNode()
 {
     if (startinfo) delete startinfo;
     if (cellinfo) free(cellinfo);
+    if (oldcells) delete oldcells;
+    if (newcells) delete newcells;
     
     // it's always ok to delete oldfile and newfile if they exist
     
-    if (!oldfile.IsEmpty() && wxFileExists(oldfile)) {
-        wxRemoveFile(oldfile);
+    if (!oldfile.IsEmpty()) {
+        ForgetKeptPattern(oldfile);
+        if (wxFileExists(oldfile)) wxRemoveFile(oldfile);
     }
     
-    if (!newfile.IsEmpty() && wxFileExists(newfile)) {
-        wxRemoveFile(newfile);
+    if (!newfile.IsEmpty()) {
+        ForgetKeptPattern(newfile);
+        if (wxFileExists(newfile)) wxRemoveFile(newfile);
     }
 
     if (delete_all_temps) {
@@ -306,24 +575,28 @@ ChangeNode::~ChangeNode()
         
         if (!oldtempstart.IsEmpty() && wxFileExists(oldtempstart) &&
             oldtempstart.StartsWith(tempdir) && oldtempstart != currlayer->startfile) {
+            ForgetKeptPattern(oldtempstart);
             wxRemoveFile(oldtempstart);
             //printf("removed oldtempstart: %s\n", (const char*)oldtempstart.mb_str(wxConvLocal)); fflush(stdout);
         }
         
         if (!newtempstart.IsEmpty() && wxFileExists(newtempstart) &&
             newtempstart.StartsWith(tempdir) && newtempstart != currlayer->startfile) {
+            ForgetKeptPattern(newtempstart);
             wxRemoveFile(newtempstart);
             //printf("removed newtempstart: %s\n", (const char*)newtempstart.mb_str(wxConvLocal)); fflush(stdout);
         }
         
         if (!oldstartfile.IsEmpty() && wxFileExists(oldstartfile) &&
             oldstartfile.StartsWith(tempdir) && oldstartfile != currlayer->startfile) {
+            ForgetKeptPattern(oldstartfile);
             wxRemoveFile(oldstartfile);
             //printf("removed oldstartfile: %s\n", (const char*)oldstartfile.mb_str(wxConvLocal)); fflush(stdout);
         }
         
         if (!newstartfile.IsEmpty() && wxFileExists(newstartfile) &&
             newstartfile.StartsWith(tempdir) && newstartfile != currlayer->startfile) {
+            ForgetKeptPattern(newstartfile);
             wxRemoveFile(newstartfile);
             //printf("removed newstartfile: %s\n", (const char*)newstartfile.mb_str(wxConvLocal)); fflush(stdout);
         }
@@ -339,6 +612,8 @@ void ChangeNode::ChangeCells(bool undo)
 
     // change state of cell(s) stored in cellinfo array
     if (undo) {
+        // a region change is always saved after any cell changes
+        if (oldcells) RestoreRegion(oldcells);
         // we must undo the cell changes in reverse order in case
         // a script has changed the same cell more than once
         unsigned int i = cellcount;
@@ -352,6 +627,7 @@ void ChangeNode::ChangeCells(bool undo)
             currlayer->algo->setcell(cellinfo[i].x, cellinfo[i].y, cellinfo[i].newstate);
             i++;
         }
+        if (newcells) RestoreRegion(newcells);
     }
     if (cellcount > 0) currlayer->algo->endofpattern();
     
@@ -360,11 +636,32 @@ void ChangeNode::ChangeCells(bool undo)
 
 // -----------------------------------------------------------------------------
 
+void ChangeNode::RestoreRegion(RegionCopy* region)
+{
+    lifealgo* cells = region->GetCells();
+    if (cells == NULL) return;
+    viewptr->CopyAllRect(regtop, regleft, regbottom, regright, cells, currlayer->algo,
+                         _("Restoring cells"));
+}
+
+// -----------------------------------------------------------------------------
+
+bool ChangeNode::FillCells(bool undo)
+{
+    if (!undo && oldsel.RandomFillRect(currlayer->algo, fillperc, fillseed))
+        return true;
+    // put back the old cells (also done if user aborted the fill)
+    RestoreRegion(oldcells);
+    return undo;
+}
+
+// -----------------------------------------------------------------------------
+
 bool ChangeNode::DoChange(bool undo)
 {
     switch (changeid) {
         case cellstates:
-            if (cellcount > 0) {
+            if (cellcount > 0 || oldcells) {
                 ChangeCells(undo);
                 mainptr->UpdatePatternAndStatus();
             }
@@ -384,9 +681,15 @@ bool ChangeNode::DoChange(bool undo)
                 return false;
             break;
             
+        case randfill:
+            if (!FillCells(undo))
+                return false;
+            mainptr->UpdatePatternAndStatus();
+            break;
+            
         case rotatecw:
         case rotateacw:
-            if (cellcount > 0) {
+            if (cellcount > 0 || oldcells) {
                 ChangeCells(undo);
             }
             // rotate selection edges
@@ -528,6 +831,8 @@ UndoRedo::UndoRedo()
     maxchanges = 0;               // ditto
     badalloc = false;             // true if malloc/realloc fails
     cellarray = NULL;             // play safe
+    oldregion = NULL;             // no region change is pending
+    newregion = NULL;             // ditto
     savecellchanges = false;      // no script cell changes are pending
     savegenchanges = false;       // no script gen changes are pending
     doingscriptchanges = false;   // not undoing/redoing script changes
@@ -593,14 +898,20 @@ void UndoRedo::ForgetCellChanges()
         maxchanges = 0;      // ditto
         badalloc = false;
     }
+    if (oldregion) {
+        delete oldregion;
+        if (newregion) delete newregion;
+        oldregion = NULL;
+        newregion = NULL;
+    }
 }
 
 // -----------------------------------------------------------------------------
 
 bool UndoRedo::RememberCellChanges(const wxString& action, bool olddirty)
 {
-    if (numchanges > 0) {
-        if (numchanges < maxchanges) {
+    if (numchanges > 0 || oldregion) {
+        if (numchanges > 0 && numchanges < maxchanges) {
             // reduce size of cellarray
             cell_change* newptr = (cell_change*) realloc(cellarray, numchanges * sizeof(cell_change));
             if (newptr != NULL) cellarray = newptr;
@@ -617,8 +928,11 @@ bool UndoRedo::RememberCellChanges(const wxString& action, bool olddirty)
         if (change == NULL) Fatal(_("Failed to create cellstates node!"));
         
         change->suffix = action;
-        change->cellinfo = cellarray;
-        change->cellcount = numchanges;
+        if (numchanges > 0) {
+            change->cellinfo = cellarray;
+            change->cellcount = numchanges;
+        }
+        TakeRegionChange(change);
         change->olddirty = olddirty;
         change->newdirty = true;
         
@@ -641,6 +955,95 @@ bool UndoRedo::RememberCellChanges(const wxString& action, bool olddirty)
 
 // -----------------------------------------------------------------------------
 
+bool UndoRedo::UseRegionChange(int top, int left, int bottom, int right)
+{
+    // only one region can be saved per change
+    if (oldregion) return false;
+    
+    // each region copy is a separate universe with its own hash table and
+    // node blocks (about 50K bytes even when nearly empty), and a change saves
+    // two of them, so a region only pays off when the rectangle could hold
+    // more changed cells than that; algorithms that can copy whole subtrees
+    // only visit the part of the pattern inside the rectangle, so for them
+    // a region is worth it sooner than for algorithms that copy cell by cell
+    double cells = (double)(bottom - top + 1) * (double)(right - left + 1);
+    if (currlayer->algo->rectCapable()) return cells >= 16384.0;
+    return cells >= 65536.0;
+}
+
+// -----------------------------------------------------------------------------
+
+static lifealgo* CopyRegion(lifealgo* srcalgo, algo_type algotype,
+                            int top, int left, int bottom, int right)
+{
+    // return a new universe containing the cells in the given rectangle of
+    // srcalgo (or an empty universe if srcalgo is NULL); return NULL if
+    // the user aborted a lengthy copy
+    lifealgo* region = CreateNewUniverse(algotype);
+    if (region->setrule(srcalgo ? srcalgo->getrule() : currlayer->algo->getrule()))
+        region->setrule(region->DefaultRule());
+    if ( srcalgo && !viewptr->CopyRect(top, left, bottom, right, srcalgo, region, false,
+                                       _("Saving cell changes")) ) {
+        delete region;
+        return NULL;
+    }
+    return region;
+}
+
+// -----------------------------------------------------------------------------
+
+bool UndoRedo::SaveRegionChange(lifealgo* oldalgo, lifealgo* newalgo,
+                                int top, int left, int bottom, int right)
+{
+    oldregion = CopyRegion(oldalgo, currlayer->algtype, top, left, bottom, right);
+    if (oldregion == NULL) return false;
+    if (newalgo) {
+        newregion = CopyRegion(newalgo, currlayer->algtype, top, left, bottom, right);
+        if (newregion == NULL) {
+            delete oldregion;
+            oldregion = NULL;
+            return false;
+        }
+    }
+    regiontop = top;
+    regionleft = left;
+    regionbottom = bottom;
+    regionright = right;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void UndoRedo::TakeRegionChange(ChangeNode* change)
+{
+    if (oldregion == NULL) return;
+    
+    if (newregion == NULL) {
+        // copy the changed rectangle from the current universe
+        newregion = CopyRegion(currlayer->algo, currlayer->algtype,
+                               regiontop, regionleft, regionbottom, regionright);
+        if (newregion == NULL) {
+            // user aborted the copy, so redo will leave the rectangle empty
+            newregion = CopyRegion(NULL, currlayer->algtype, 0, 0, 0, 0);
+        }
+    }
+    
+    change->oldcells = new RegionCopy(oldregion, currlayer->algtype,
+                                      regiontop, regionleft, regionbottom, regionright);
+    change->newcells = new RegionCopy(newregion, currlayer->algtype,
+                                      regiontop, regionleft, regionbottom, regionright);
+    change->oldalgo = currlayer->algtype;
+    change->regtop = regiontop;
+    change->regleft = regionleft;
+    change->regbottom = regionbottom;
+    change->regright = regionright;
+    
+    oldregion = NULL;
+    newregion = NULL;
+}
+
+// -----------------------------------------------------------------------------
+
 void UndoRedo::RememberFlip(bool topbot, bool olddirty)
 {
     // clear the redo history
@@ -663,6 +1066,41 @@ void UndoRedo::RememberFlip(bool topbot, bool olddirty)
 
 // -----------------------------------------------------------------------------
 
+void UndoRedo::RememberRandomFill(Selection& sel, lifealgo* oldcells,
+                                  unsigned int seed, int percentage, bool olddirty)
+{
+    // clear the redo history
+    WX_CLEAR_LIST(wxList, redolist);
+    UpdateRedoItem(wxEmptyString);
+    
+    // add randfill node to head of undo list
+    ChangeNode* change = new ChangeNode(randfill);
+    if (change == NULL) Fatal(_("Failed to create random fill node!"));
+    
+    change->suffix = _("Random Fill");
+    change->oldsel = sel;
+    change->oldalgo = currlayer->algtype;
+    int x, y, wd, ht;
+    sel.GetRect(&x, &y, &wd, &ht);
+    change->regtop = y;
+    change->regleft = x;
+    change->regbottom = y + ht - 1;
+    change->regright = x + wd - 1;
+    change->oldcells = new RegionCopy(oldcells, currlayer->algtype, change->regtop,
+                                      change->regleft, change->regbottom, change->regright);
+    change->fillseed = seed;
+    change->fillperc = percentage;
+    change->olddirty = olddirty;
+    change->newdirty = true;
+    
+    undolist.Insert(change);
+    
+    // update Undo item in Edit menu
+    UpdateUndoItem(change->suffix);
+}
+
+// -----------------------------------------------------------------------------
+
 void UndoRedo::RememberRotation(bool clockwise, bool olddirty)
 {
     // clear the redo history
@@ -702,6 +1140,8 @@ void UndoRedo::RememberRotation(bool clockwise, Selection& oldsel, Selection& ne
     change->olddirty = olddirty;
     change->newdirty = true;
     
+    TakeRegionChange(change);
+    
     // if numchanges == 0 we still need to rotate selection edges
     if (numchanges > 0) {
         if (numchanges < maxchanges) {
@@ -828,6 +1268,9 @@ void UndoRedo::RememberGenStart()
         // save current pattern in a unique temporary file
         prevfile = wxFileName::CreateTempFileName(tempdir + genchange_prefix);
         
+        // the file won't be written if the algorithm can keep the pattern
+        if (KeepPattern(prevfile)) return;
+        
         // if head of undo list is a genchange node then we can copy that
         // change node's newfile to prevfile; this makes consecutive generating
         // runs faster (setting prevfile to newfile would be even faster but it's
@@ -835,7 +1278,7 @@ void UndoRedo::RememberGenStart()
         if (!undolist.IsEmpty()) {
             wxList::compatibility_iterator node = undolist.GetFirst();
             ChangeNode* change = (ChangeNode*) node->GetData();
-            if (change->changeid == genchange) {
+            if (change->changeid == genchange && FindKeptPattern(change->newfile) < 0) {
                 if (wxCopyFile(change->newfile, prevfile, true)) {
                     return;
                 } else {
@@ -868,8 +1311,9 @@ void UndoRedo::RememberGenFinish()
     // generation count might not have changed (can happen in Linux app)
     if (prevgen == currlayer->algo->getGeneration()) {
         // delete prevfile created by RememberGenStart
-        if (!prevfile.IsEmpty() && wxFileExists(prevfile)) {
-            wxRemoveFile(prevfile);
+        if (!prevfile.IsEmpty()) {
+            ForgetKeptPattern(prevfile);
+            if (wxFileExists(prevfile)) wxRemoveFile(prevfile);
         }
         prevfile = wxEmptyString;
         return;
@@ -890,7 +1334,7 @@ void UndoRedo::RememberGenFinish()
     } else {
         // save finishing pattern in a unique temporary file
         fpath = wxFileName::CreateTempFileName(tempdir + genchange_prefix);
-        SaveCurrentPattern(fpath);
+        if (!KeepPattern(fpath)) SaveCurrentPattern(fpath);
     }
     
     // clear the redo history
@@ -1553,8 +1997,9 @@ void UndoRedo::ClearUndoRedo()
     
     if (startcount > 0) {
         // RememberGenStart was not followed by RememberGenFinish
-        if (!prevfile.IsEmpty() && wxFileExists(prevfile)) {
-            wxRemoveFile(prevfile);
+        if (!prevfile.IsEmpty()) {
+            ForgetKeptPattern(prevfile);
+            if (wxFileExists(prevfile)) wxRemoveFile(prevfile);
         }
         prevfile = wxEmptyString;
         startcount = 0;
@@ -1657,6 +2102,34 @@ bool CopyTempFiles(ChangeNode* srcnode, ChangeNode* destnode, const wxString& te
 
 // -----------------------------------------------------------------------------
 
+static bool CopyRegions(ChangeNode* srcnode, ChangeNode* destnode)
+{
+    // copy the universes holding a change's region (deep copy)
+    int t = srcnode->regtop;
+    int l = srcnode->regleft;
+    int b = srcnode->regbottom;
+    int r = srcnode->regright;
+    destnode->oldcells = NULL;
+    destnode->newcells = NULL;
+    if (srcnode->oldcells) {
+        lifealgo* srccells = srcnode->oldcells->GetCells();
+        if (srccells == NULL) return false;
+        lifealgo* cells = CopyRegion(srccells, srcnode->oldalgo, t, l, b, r);
+        if (cells == NULL) return false;
+        destnode->oldcells = new RegionCopy(cells, srcnode->oldalgo, t, l, b, r);
+    }
+    if (srcnode->newcells) {
+        lifealgo* srccells = srcnode->newcells->GetCells();
+        if (srccells == NULL) return false;
+        lifealgo* cells = CopyRegion(srccells, srcnode->oldalgo, t, l, b, r);
+        if (cells == NULL) return false;
+        destnode->newcells = new RegionCopy(cells, srcnode->oldalgo, t, l, b, r);
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
 void UndoRedo::DuplicateHistory(Layer* oldlayer, Layer* newlayer)
 {
     UndoRedo* history = oldlayer->undoredo;
@@ -1738,6 +2211,12 @@ void UndoRedo::DuplicateHistory(Layer* oldlayer, Layer* newlayer)
             newchange->startinfo = new StartingInfo(change->startinfo, oldlayer, newlayer);
         }
         
+        if (!CopyRegions(change, newchange)) {
+            Warning(_("Failed to copy cell changes in undolist!"));
+            WX_CLEAR_LIST(wxList, undolist);
+            return;
+        }
+        
         // if node is a name change then update whichlayer
         if (newchange->changeid == namechange) {
             if (change->whichlayer == oldlayer) {
@@ -1789,6 +2268,12 @@ void UndoRedo::DuplicateHistory(Layer* oldlayer, Layer* newlayer)
             newchange->startinfo = new StartingInfo(change->startinfo, oldlayer, newlayer);
         }
         
+        if (!CopyRegions(change, newchange)) {
+            Warning(_("Failed to copy cell changes in redolist!"));
+            WX_CLEAR_LIST(wxList, redolist);
+            return;
+        }
+        
         // if node is a name change then update whichlayer
         if (newchange->changeid == namechange) {
             if (change->whichlayer == oldlayer) {
@@ -7,6 +7,7 @@
 #include "bigint.h"     // for bigint class
 #include "wxselect.h"   // for Selection class
 class Layer;            // need this because wxlayer.h includes wxundo.h
+class ChangeNode;
 #include "wxlayer.h"    // for Layer class
 #include "wxalgos.h"    // for algo_type
 
@@ -31,21 +32,39 @@ public:
     // ignore cell changes made by any previous SaveCellChange calls
     
     bool RememberCellChanges(const wxString& action, bool olddirty);
-    // remember cell changes made by any previous SaveCellChange calls,
+    // remember cell changes made by any previous SaveCellChange calls
+    // (and any SaveRegionChange call),
     // and the state of the layer's dirty flag BEFORE the change;
     // the given action string will be appended to the Undo/Redo items;
     // return true if one or more cells changed state, false otherwise
     
+    bool UseRegionChange(int top, int left, int bottom, int right);
+    // return true if a change to the given rectangle should be saved by
+    // SaveRegionChange rather than by calling SaveCellChange for each cell
+    
+    bool SaveRegionChange(lifealgo* oldalgo, lifealgo* newalgo,
+                          int top, int left, int bottom, int right);
+    // save copies of the given rectangle in the universes before and after
+    // a change; if newalgo is NULL then the rectangle is copied from the
+    // current universe by the next RememberCellChanges or RememberRotation
+    // call; return false if the user aborted a lengthy copy
+    
     void RememberFlip(bool topbot, bool olddirty);
     // remember flip's direction
     
+    void RememberRandomFill(Selection& sel, lifealgo* oldcells,
+                            unsigned int seed, int percentage, bool olddirty);
+    // remember a random fill of the given selection; oldcells holds the
+    // cells that were in the selection and will be deleted by UndoRedo
+    
     void RememberRotation(bool clockwise, bool olddirty);
     // remember simple rotation (selection includes entire pattern)
     
     void RememberRotation(bool clockwise, Selection& oldsel, Selection& newsel,
                           bool olddirty);
     // remember rotation's direction and old and new selections;
-    // this variant assumes SaveCellChange may have been called
+    // this variant assumes SaveCellChange or SaveRegionChange may have
+    // been called
     
     void RememberSelection(const wxString& action);
     // remember selection change (no-op if selection hasn't changed)
@@ -116,6 +135,14 @@ private:
     unsigned int maxchanges;      // number allocated
     bool badalloc;                // malloc/realloc failed?
     
+    lifealgo* oldregion;          // cells in changed rectangle before change
+    lifealgo* newregion;          // cells in changed rectangle after change
+    int regiontop, regionleft;    // edges of changed rectangle
+    int regionbottom, regionright;
+    
+    void TakeRegionChange(ChangeNode* change);
+    // move any region saved by SaveRegionChange to the given change
+    
     wxString prevfile;            // for saving pattern at start of gen change
     bigint prevgen;               // generation count at start of gen change
     bigint prevx, prevy;          // viewport position at start of gen change
@@ -133,4 +160,30 @@ private:
     // update the Undo/Redo items in the Edit menu
 };
 
+// Hash-based algorithms can keep earlier patterns in memory (see
+// lifealgo::keepstate), so the temporary files used by undo/redo and
+// ResetPattern are only written if the current universe is about to
+// be deleted or the algorithm has run out of room for kept patterns.
+
+bool KeepPattern(const wxString& path);
+// if possible, remember the current pattern and gen count as the contents
+// of the given temporary file and return true; otherwise return false
+// (and the caller must write the file)
+
+bool RestoreKeptPattern(const wxString& path);
+// if the current universe is keeping the pattern for the given file then
+// restore it and its gen count and return true; otherwise return false
+
+void ForgetKeptPattern(const wxString& path);
+// the given file is being deleted or rewritten, so forget any kept pattern
+
+void SaveKeptPatterns();
+// write all the patterns kept by the current universe to their files;
+// must be called before currlayer->algo is deleted
+
+void SpillKeptPatterns(bool force = false);
+// if a gc found the current universe's kept patterns pinning too much of
+// its memory (or force is true) then write the oldest half of them to
+// their files and forget them; called after stepping the pattern
+
 #endif
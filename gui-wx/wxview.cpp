@@ -132,6 +132,12 @@ bool PatternView::CopyRect(int itop, int ileft, int ibottom, int iright,
     int v = 0;
     bool abort = false;
     
+    // hashing algorithms can copy whole subtrees at once
+    if (destalgo->copyrect(srcalgo, itop, ileft, ibottom, iright, 0)) {
+        if (erasesrc) srcalgo->clearrect(itop, ileft, ibottom, iright);
+        return true;
+    }
+    
     // copy (and erase if requested) live cells from given rect
     // in source universe to same rect in destination universe
     BeginProgress(progmsg);
@@ -171,25 +177,41 @@ void PatternView::CopyAllRect(int itop, int ileft, int ibottom, int iright,
                               lifealgo* srcalgo, lifealgo* destalgo,
                               const wxString& progmsg)
 {
-    int wd = iright - ileft + 1;
     int ht = ibottom - itop + 1;
     int cx, cy;
-    double maxcount = (double)wd * (double)ht;
     int cntr = 0;
     bool abort = false;
     
-    // copy all cells from given rect in srcalgo to same rect in destalgo
+    // hashing algorithms can copy whole subtrees at once
+    if (destalgo->copyrect(srcalgo, itop, ileft, ibottom, iright, 1)) return;
+    
+    // kill the live cells in the given rect of destalgo and then copy the
+    // live cells from the same rect in srcalgo; using nextcell means sparse
+    // rects are copied quickly (as when undoing a big change)
     BeginProgress(progmsg);
-    for ( cy=itop; cy<=ibottom; cy++ ) {
-        for ( cx=ileft; cx<=iright; cx++ ) {
-            destalgo->setcell(cx, cy, srcalgo->getcell(cx, cy));
-            cntr++;
-            if ((cntr % 4096) == 0) {
-                abort = AbortProgress((double)cntr / maxcount, wxEmptyString);
-                if (abort) break;
+    for (int pass = 0; pass < 2 && !abort; pass++) {
+        lifealgo* algo = pass == 0 ? destalgo : srcalgo;
+        for ( cy=itop; cy<=ibottom; cy++ ) {
+            for ( cx=ileft; cx<=iright; cx++ ) {
+                int v = 0;
+                int skip = algo->nextcell(cx, cy, v);
+                if (skip >= 0) {
+                    // found next live cell in this row
+                    cx += skip;
+                    if (cx > iright) break;     // next live cell is outside rect
+                    destalgo->setcell(cx, cy, pass == 0 ? 0 : v);
+                } else {
+                    cx = iright;                // done this row
+                }
+                cntr++;
+                if ((cntr % 4096) == 0) {
+                    double prog = ((double)pass * ht + (cy - itop)) / (2.0 * ht);
+                    abort = AbortProgress(prog, wxEmptyString);
+                    if (abort) break;
+                }
             }
+            if (abort) break;
         }
-        if (abort) break;
     }
     destalgo->endofpattern();
     EndProgress();
@@ -583,6 +605,18 @@ void PatternView::PasteTemporaryToCurrent(bool toselection,
     lifealgo* curralgo = currlayer->algo;
     int maxstate = curralgo->NumCellStates() - 1;
     
+    // for a big paste save the paste rectangle before and after the change
+    // rather than each changed cell
+    int pbottom = pastey + (ibottom - itop);
+    int pright = pastex + (iright - ileft);
+    bool saveregion = savecells &&
+                      currlayer->undoredo->UseRegionChange(pastey, pastex, pbottom, pright);
+    if (saveregion && !currlayer->undoredo->SaveRegionChange(curralgo, NULL,
+                                                             pastey, pastex, pbottom, pright)) {
+        return;
+    }
+    bool savechanges = savecells && !saveregion;
+    
     BeginProgress(_("Pasting pattern"));
     
     // we can speed up pasting sparse patterns by using nextcell in these cases:
@@ -623,7 +657,7 @@ void PatternView::PasteTemporaryToCurrent(bool toselection,
                             }
                             curralgo->setcell(cx, cy, newstate);
                             pattchanged = true;
-                            if (savecells) currlayer->undoredo->SaveCellChange(cx, cy, currstate, newstate);
+                            if (savechanges) currlayer->undoredo->SaveCellChange(cx, cy, currstate, newstate);
                         }
                     }
                     cx++;
@@ -657,7 +691,7 @@ void PatternView::PasteTemporaryToCurrent(bool toselection,
                             if (tempstate != currstate && currstate > 0) {
                                 curralgo->setcell(cx, cy, 0);
                                 pattchanged = true;
-                                if (savecells) currlayer->undoredo->SaveCellChange(cx, cy, currstate, 0);
+                                if (savechanges) currlayer->undoredo->SaveCellChange(cx, cy, currstate, 0);
                             }
                             break;
                         case Copy:
@@ -668,7 +702,7 @@ void PatternView::PasteTemporaryToCurrent(bool toselection,
                                 }
                                 curralgo->setcell(cx, cy, tempstate);
                                 pattchanged = true;
-                                if (savecells) currlayer->undoredo->SaveCellChange(cx, cy, currstate, tempstate);
+                                if (savechanges) currlayer->undoredo->SaveCellChange(cx, cy, currstate, tempstate);
                             }
                             break;
                         case Or:
@@ -680,7 +714,7 @@ void PatternView::PasteTemporaryToCurrent(bool toselection,
                                 if (currstate != 0) {
                                     curralgo->setcell(cx, cy, 0);
                                     pattchanged = true;
-                                    if (savecells) currlayer->undoredo->SaveCellChange(cx, cy, currstate, 0);
+                                    if (savechanges) currlayer->undoredo->SaveCellChange(cx, cy, currstate, 0);
                                 }
                             } else {
                                 // tempstate != currstate
@@ -690,7 +724,7 @@ void PatternView::PasteTemporaryToCurrent(bool toselection,
                                 if (currstate != newstate) {
                                     curralgo->setcell(cx, cy, newstate);
                                     pattchanged = true;
-                                    if (savecells) currlayer->undoredo->SaveCellChange(cx, cy, currstate, newstate);
+                                    if (savechanges) currlayer->undoredo->SaveCellChange(cx, cy, currstate, newstate);
                                 }
                             }
                             break;
@@ -717,6 +751,8 @@ void PatternView::PasteTemporaryToCurrent(bool toselection,
         if (savecells) currlayer->undoredo->RememberCellChanges(_("Paste"), currlayer->dirty);
         MarkLayerDirty();    // calls SetWindowTitle
         mainptr->UpdatePatternAndStatus();
+    } else if (saveregion) {
+        currlayer->undoredo->ForgetCellChanges();
     }
     
     if (reduced) statusptr->ErrorMessage(_("Some cell states were reduced."));
@@ -969,9 +1005,9 @@ void PatternView::ShrinkSelection(bool fit)
 
 // -----------------------------------------------------------------------------
 
-void PatternView::RandomFill()
+void PatternView::RandomFill(bool useseed, unsigned int seed)
 {
-    currlayer->currsel.RandomFill();
+    currlayer->currsel.RandomFill(useseed, seed);
 }
 
 // -----------------------------------------------------------------------------
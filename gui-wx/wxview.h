@@ -39,7 +39,7 @@ public:
     void SelectAll();
     void RemoveSelection();
     void ShrinkSelection(bool fit);
-    void RandomFill();
+    void RandomFill(bool useseed = false, unsigned int seed = 0);
     bool FlipSelection(bool topbottom, bool inundoredo = false);
     bool RotateSelection(bool clockwise, bool inundoredo = false);
     void SetCursorMode(wxCursor* curs);